@@ -33,6 +33,9 @@ void CsvWriter::writeHeader(const std::vector<std::string> &peer_ids)
       addString(id + "_" + col);
     }
   }
+  for (const auto &col : columns::groupColumns()) {
+    addString(col);
+  }
   endRow();
 }
 
@@ -30,6 +30,21 @@ inline const std::vector<std::string> &peerColumns()
       "ev_max_charge_w",
       "actual_charge_w",
       "soc",
+      "divert_pilot_changes",
+      "divert_pilot_changes_avoided",
+      "loadshare_allocated_w",
+  };
+  return cols;
+}
+
+// Site-wide columns, after all the per-peer ones.
+inline const std::vector<std::string> &groupColumns()
+{
+  static const std::vector<std::string> cols = {
+      "group_max_w",
+      "group_total_actual_w",
+      "group_total_demand_w",
+      "failsafe_active",
   };
   return cols;
 }
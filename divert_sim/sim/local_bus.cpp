@@ -0,0 +1,49 @@
+#include "local_bus.h"
+
+#include "peer.h"
+
+namespace sim {
+
+void LocalBus::attach(Peer &peer)
+{
+  _peers.push_back(&peer);
+  _online.push_back(false);
+  peer.loadBalancer().setPublisher([this, &peer](const String &payload) {
+    return publish(peer, payload);
+  });
+}
+
+bool LocalBus::publish(Peer &from, const String &payload)
+{
+  if (!from.online) {
+    return false;
+  }
+
+  if (payload.length() > 0) {
+    _retained[from.id()] = payload.c_str();
+  } else {
+    _retained.erase(from.id());
+  }
+
+  for (Peer *p : _peers) {
+    if (p->online) {
+      p->loadBalancer().receive(from.id().c_str(), payload.c_str(), payload.length());
+    }
+  }
+  return true;
+}
+
+void LocalBus::sync()
+{
+  for (size_t i = 0; i < _peers.size(); i++) {
+    Peer *p = _peers[i];
+    if (p->online && !_online[i]) {
+      for (const auto &kv : _retained) {
+        p->loadBalancer().receive(kv.first.c_str(), kv.second.c_str(), kv.second.size());
+      }
+    }
+    _online[i] = p->online;
+  }
+}
+
+} // namespace sim
@@ -0,0 +1,40 @@
+#ifndef _DIVERT_SIM_SIM_LOCAL_BUS_H
+#define _DIVERT_SIM_SIM_LOCAL_BUS_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+namespace sim {
+
+class Peer;
+
+// In-process stand-in for the MQTT broker the load balancer announces on.
+//
+// Announcements are retained per peer and delivered straight away to every
+// online peer, the sender included, like a broker echoing a subscribed
+// topic. An offline peer neither sends nor receives, and is given the
+// retained announcements when it comes back online.
+class LocalBus
+{
+public:
+  void attach(Peer &peer);
+
+  // Wire as the peer's LoadBalancerPublisher
+  bool publish(Peer &from, const String &payload);
+
+  // Deliver the retained announcements to peers that have come online since
+  // the last call. Call once per tick, after the scheduled events.
+  void sync();
+
+private:
+  std::vector<Peer *> _peers;
+  std::vector<bool> _online;
+  std::map<std::string, std::string> _retained;
+};
+
+} // namespace sim
+
+#endif // _DIVERT_SIM_SIM_LOCAL_BUS_H
@@ -12,7 +12,8 @@ Peer::Peer(const PeerScenario &scenario, EventLog &eventLog) :
     _evse(_stream, eventLog),
     _divert(_evse),
     _shaper(),
-    _manual(_evse)
+    _manual(_evse),
+    _balancer()
 {
   _sim.id = _scenario.id;
   _sim.voltage = _scenario.voltage;
@@ -51,6 +52,15 @@ void Peer::begin()
   _divert.setMode(eco ? DivertMode::Eco : DivertMode::Normal);
 
   _shaper.begin(_evse);
+
+  if (_scenario.load_balancing) {
+    _balancer.begin(_evse, _scenario.id.c_str());
+    _balancer.notifyConfigChanged(true,
+        (uint32_t) _scenario.load_balancing_budget,
+        _scenario.load_balancing_priority,
+        LoadShareAllocator::policyFromName(_scenario.load_balancing_policy.c_str()),
+        (uint32_t) _scenario.load_balancing_failsafe_current);
+  }
 }
 
 void Peer::applyInputs(long t_sec)
@@ -10,6 +10,7 @@
 #include "divert.h"
 #include "current_shaper.h"
 #include "manual.h"
+#include "load_balancer.h"
 #include "event_log.h"
 
 #include "scenario.h"
@@ -19,7 +20,7 @@
 namespace sim {
 
 // A simulated charge point: per-peer SimEvse + SimStream + EvseManager +
-// DivertTask + CurrentShaperTask + scenario reference.
+// DivertTask + CurrentShaperTask + LoadBalancerTask + scenario reference.
 //
 // All firmware modules are owned (not pointers to globals) so per-peer state
 // is independent. The global `evse`/`divert`/`shaper` symbols defined in
@@ -51,6 +52,7 @@ public:
   EvseManager &evse() { return _evse; }
   DivertTask &divert() { return _divert; }
   CurrentShaperTask &shaper() { return _shaper; }
+  LoadBalancerTask &loadBalancer() { return _balancer; }
 
   // Cached values used both for output and for load-share allocation.
   double last_solar_w = 0.0;
@@ -70,6 +72,7 @@ private:
   DivertTask _divert;
   CurrentShaperTask _shaper;
   ManualOverride _manual;
+  LoadBalancerTask _balancer;
 
   // Track which event-indices have already fired.
   size_t _next_event_idx = 0;
@@ -1,6 +1,7 @@
 #include "runner.h"
 
 #include <chrono>
+#include <algorithm>
 #include <cmath>
 #include <ctime>
 #include <iomanip>
@@ -17,6 +18,7 @@
 #include "openevse.h"
 
 #include "csv_writer.h"
+#include "local_bus.h"
 #include "peer.h"
 #include "scenario.h"
 
@@ -89,8 +91,12 @@ int run(const std::string &scenario_path,
   std::vector<std::string> peer_ids;
   peer_ids.reserve(scenario.peers.size());
 
+  // Stand-in for the MQTT broker the load balancers announce on
+  LocalBus bus;
+
   for (const auto &ps : scenario.peers) {
     auto p = std::make_unique<Peer>(ps, eventLog);
+    bus.attach(*p);
     p->begin();
     peer_ids.push_back(p->id());
     peers.push_back(std::move(p));
@@ -120,6 +126,7 @@ int run(const std::string &scenario_path,
       p->applyEvents(t_sec);
       p->applyInputs(t_sec);
     }
+    bus.sync();
 
     // 2. Advance the firmware task scheduler. Run several iterations so
     //    callbacks chained across multiple loops settle within one tick.
@@ -134,6 +141,10 @@ int run(const std::string &scenario_path,
 
     // 4. Emit a CSV row.
     writer.beginRow(formatTime(t_start + t_sec));
+    double group_max_w = 0.0;
+    double group_total_actual_w = 0.0;
+    double group_total_demand_w = 0.0;
+    bool failsafe_active = false;
     for (auto &p : peers) {
       const SimEvse &s = p->simEvse();
       double pilot_w = s.pilot * s.voltage;
@@ -156,7 +167,23 @@ int run(const std::string &scenario_path,
       writer.addDouble(ev_max_w, 1);
       writer.addDouble(actual_w, 1);
       writer.addDouble(s.soc, 2);
+      writer.addInt(p->divert().pilotChanges());
+      writer.addInt(p->divert().pilotChangesAvoided());
+      writer.addDouble(p->loadBalancer().getAllocation() * s.voltage, 1);
+
+      if (p->loadBalancer().isEnabled()) {
+        group_max_w = p->loadBalancer().getBudget() * scenario.nominal_voltage;
+        failsafe_active = failsafe_active || p->loadBalancer().isFailsafe();
+      }
+      group_total_actual_w += actual_w;
+      if (p->vehicle && s.soc < 100.0) {
+        group_total_demand_w += std::min(ev_max_w, s.max_current_hw * s.voltage);
+      }
     }
+    writer.addDouble(group_max_w, 1);
+    writer.addDouble(group_total_actual_w, 1);
+    writer.addDouble(group_total_demand_w, 1);
+    writer.addBool(failsafe_active);
     writer.endRow();
 
     fake_millis += (unsigned long) tick * 1000UL;
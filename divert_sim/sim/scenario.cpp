@@ -77,6 +77,8 @@ bool Scenario::loadFromFile(const std::string &path)
     config_json = cfg.str();
   }
 
+  JsonObjectConst site = root["load_balancing"].as<JsonObjectConst>();
+
   JsonArrayConst peerArr = root["peers"].as<JsonArrayConst>();
   if (peerArr.isNull() || peerArr.size() == 0) {
     std::cerr << "Scenario: no peers defined" << std::endl;
@@ -154,6 +156,16 @@ bool Scenario::loadFromFile(const std::string &path)
       p.shaper_enabled = pj["shaper_enabled"].as<bool>();
       p.shaper_enabled_set = true;
     }
+    if (!site.isNull()) {
+      p.load_balancing = true;
+      p.load_balancing_budget = site["budget"] | p.load_balancing_budget;
+      p.load_balancing_policy = site["policy"] | p.load_balancing_policy.c_str();
+      p.load_balancing_failsafe_current = site["failsafe_current"] | p.load_balancing_failsafe_current;
+      JsonObjectConst lb = pj["load_balancing"].as<JsonObjectConst>();
+      if (!lb.isNull()) {
+        p.load_balancing_priority = lb["priority"] | 0;
+      }
+    }
 
     JsonArrayConst events = pj["events"].as<JsonArrayConst>();
     if (!events.isNull()) {
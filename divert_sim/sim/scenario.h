@@ -49,6 +49,15 @@ struct PeerScenario
   bool shaper_enabled = false;
   bool shaper_enabled_set = false;
 
+  // Site load balancing, enabled for every peer when the scenario has a
+  // top-level "load_balancing" object. Priority is per peer, the rest is
+  // copied from the site settings.
+  bool load_balancing = false;
+  int load_balancing_priority = 0;
+  long load_balancing_budget = 32;       // A
+  std::string load_balancing_policy = "fair";
+  long load_balancing_failsafe_current = 0;
+
   std::vector<PeerEvent> events;
 };
 
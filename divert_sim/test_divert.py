@@ -69,3 +69,22 @@ def test_divert_stops_after_min_charge_time_when_power_stays_below_minimum():
     assert any(
         row.get("evse-001_state") != "charging" for row in low_power_tail
     ), "charging should stop once min charge time expires during sustained low power"
+
+
+def test_divert_pilot_planner_reduces_pilot_changes():
+    scenario = "data/scenarios/divert_day1_default.json"
+    planned = run_scenario(scenario)
+    unplanned = run_scenario(
+        scenario,
+        config_overrides={
+            "divert_pilot_hysteresis": 0,
+            "divert_pilot_interval": 0,
+            "divert_pilot_lookahead": 0,
+        },
+    )
+    assert "evse-001_divert_pilot_changes" in planned[0]
+
+    planned_changes = int(planned[-1]["evse-001_divert_pilot_changes"])
+    unplanned_changes = int(unplanned[-1]["evse-001_divert_pilot_changes"])
+    assert planned_changes <= unplanned_changes
+    assert int(unplanned[-1]["evse-001_divert_pilot_changes_avoided"]) == 0
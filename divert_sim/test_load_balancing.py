@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Scenario-driven site load balancing tests."""
+
+from run_simulations import run_scenario
+
+
+SCENARIO = "data/scenarios/loadbalance_fair_three_peers.json"
+VOLTAGE = 240
+
+
+def _f(row: dict, column: str) -> float:
+    return float(row.get(column, 0) or 0)
+
+
+def _at(rows: list[dict], index: int) -> dict:
+    # rows are one per 5 s tick from t=0
+    return rows[index // 5]
+
+
+def test_load_balancing_never_exceeds_site_budget():
+    rows = run_scenario(SCENARIO)
+    assert len(rows) > 100
+
+    for row in rows:
+        budget_w = _f(row, "group_max_w")
+        assert budget_w == 40 * VOLTAGE
+        allocated_w = sum(_f(row, f"{p}_loadshare_allocated_w") for p in ("evse-a", "evse-b", "evse-c"))
+        assert allocated_w <= budget_w
+        assert _f(row, "group_total_actual_w") <= budget_w + 1
+
+
+def test_load_balancing_reallocates_on_plug_in_and_unplug():
+    rows = run_scenario(SCENARIO)
+
+    # Two vehicles share the budget
+    before = _at(rows, 300)
+    assert _f(before, "evse-a_loadshare_allocated_w") == 20 * VOLTAGE
+    assert _f(before, "evse-b_loadshare_allocated_w") == 20 * VOLTAGE
+    assert _f(before, "evse-c_loadshare_allocated_w") == 0
+
+    # Within a tick of the third plugging in it has its share
+    plugged = _at(rows, 605)
+    shares = [_f(plugged, f"{p}_loadshare_allocated_w") / VOLTAGE for p in ("evse-a", "evse-b", "evse-c")]
+    assert sorted(shares) == [13, 13, 14]
+    assert all(_f(plugged, f"{p}_pilot_w") <= 14 * VOLTAGE for p in ("evse-a", "evse-b", "evse-c"))
+
+    # And the others pick up what is left when one unplugs
+    unplugged = _at(rows, 1805)
+    assert _f(unplugged, "evse-a_loadshare_allocated_w") == 0
+    assert _f(unplugged, "evse-b_loadshare_allocated_w") == 20 * VOLTAGE
+    assert _f(unplugged, "evse-c_loadshare_allocated_w") == 20 * VOLTAGE
+
+
+def test_load_balancing_failsafe_pauses_a_unit_that_loses_the_site():
+    rows = run_scenario(SCENARIO)
+
+    assert all(r["failsafe_active"] == "0" for r in rows[: 2400 // 5])
+
+    lost = _at(rows, 2450)
+    assert lost["failsafe_active"] == "1"
+    assert lost["evse-b_state"] == "disabled"
+    # The others keep to their shares until the lost unit times out ...
+    assert _f(lost, "evse-c_loadshare_allocated_w") == 20 * VOLTAGE
+
+    # ... then it is back once it hears itself again
+    back = _at(rows, 2730)
+    assert back["failsafe_active"] == "0"
+    assert _f(back, "evse-b_loadshare_allocated_w") == 20 * VOLTAGE
@@ -0,0 +1,300 @@
+#!/usr/bin/env python3
+"""
+Pack an OpenEVSE firmware image for a smaller OTA download.
+
+The output is understood by the gateway's OTA decoder (src/ota_decoder.h) and
+can be uploaded or fetched through /update exactly like a plain .bin:
+
+    output = header(48 bytes) || payload
+
+The payload is the new image, optionally expressed as a delta against the
+firmware currently running on the device (--base), and heatshrink compressed
+unless --no-compress is given. A delta only applies to a device running
+exactly the --base image; any other device rejects it before the update is
+committed, though not before the update partition is erased.
+
+Sign first, then pack: the signature trailer is part of the image the device
+reconstructs and verifies.
+
+Usage:
+    python pack_firmware.py firmware.bin firmware.oevz
+    python pack_firmware.py --base v5.1.0.bin firmware.bin v5.1.0-to-new.oevz
+
+Uses the heatshrink2 package for compression when it is installed
+(pip install heatshrink2), otherwise a slower built-in encoder.
+"""
+import argparse
+import hashlib
+import struct
+import sys
+
+MAGIC = b"OEVZ"
+VERSION = 1
+FLAG_HEATSHRINK = 1 << 0
+FLAG_DELTA = 1 << 1
+OP_COPY = 0x01
+OP_DATA = 0x02
+
+MAX_WINDOW_SZ2 = 12  # OTA_PACK_MAX_WINDOW_SZ2, bounds the decoder's RAM
+
+DELTA_BLOCK = 16     # bytes hashed when indexing the base image
+DELTA_STRIDE = 4     # index every n-th base offset
+DELTA_MIN_COPY = 24  # shorter matches are cheaper sent as data
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.count = 0
+
+    def write(self, value, bits):
+        self.acc = (self.acc << bits) | value
+        self.count += bits
+        while self.count >= 8:
+            self.count -= 8
+            self.out.append((self.acc >> self.count) & 0xFF)
+        self.acc &= (1 << self.count) - 1
+
+    def finish(self):
+        if self.count:
+            self.out.append((self.acc << (8 - self.count)) & 0xFF)
+            self.count = 0
+        return bytes(self.out)
+
+
+def heatshrink_encode(data, window_sz2, lookahead_sz2, chain_depth=16):
+    """Greedy heatshrink encoder, bit compatible with heatshrink's own."""
+    window = 1 << window_sz2
+    max_len = 1 << lookahead_sz2
+    min_len = (1 + window_sz2 + lookahead_sz2) // 9 + 1
+    bits = BitWriter()
+    chains = {}
+
+    def insert(pos):
+        key = data[pos:pos + min_len]
+        chain = chains.setdefault(key, [])
+        chain.append(pos)
+        if len(chain) > 2 * chain_depth:
+            del chain[:chain_depth]
+
+    i = 0
+    n = len(data)
+    while i < n:
+        best_len = 0
+        best_pos = 0
+        limit = min(max_len, n - i)
+        if limit >= min_len:
+            for p in reversed(chains.get(data[i:i + min_len], ())[-chain_depth:]):
+                if i - p > window:
+                    break
+                length = min_len
+                while length < limit and data[p + length] == data[i + length]:
+                    length += 1
+                if length > best_len:
+                    best_len, best_pos = length, p
+                    if length == limit:
+                        break
+
+        if best_len >= min_len:
+            bits.write(0, 1)
+            bits.write(i - best_pos - 1, window_sz2)
+            bits.write(best_len - 1, lookahead_sz2)
+            for p in range(i, i + best_len):
+                insert(p)
+            i += best_len
+        else:
+            bits.write(1, 1)
+            bits.write(data[i], 8)
+            insert(i)
+            i += 1
+
+    return bits.finish()
+
+
+def heatshrink_decode(data, window_sz2, lookahead_sz2):
+    """Reference decoder, used to check the output before it is written."""
+    out = bytearray()
+    value = int.from_bytes(data, "big")
+    pos = len(data) * 8
+
+    def take(bits):
+        nonlocal pos
+        if pos < bits:
+            raise EOFError
+        pos -= bits
+        return (value >> pos) & ((1 << bits) - 1)
+
+    try:
+        while True:
+            if take(1):
+                out.append(take(8))
+            else:
+                offset = take(window_sz2) + 1
+                count = take(lookahead_sz2) + 1
+                for _ in range(count):
+                    out.append(out[-offset] if offset <= len(out) else 0)
+    except EOFError:
+        pass
+    return bytes(out)
+
+
+def compress(data, window_sz2, lookahead_sz2):
+    try:
+        import heatshrink2
+        return heatshrink2.compress(data, window_sz2=window_sz2, lookahead_sz2=lookahead_sz2)
+    except ImportError:
+        return heatshrink_encode(data, window_sz2, lookahead_sz2)
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        b = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def delta_encode(base, new):
+    """Copy runs of the new image found in the base, send the rest as data."""
+    index = {}
+    for p in range(0, len(base) - DELTA_BLOCK + 1, DELTA_STRIDE):
+        index.setdefault(base[p:p + DELTA_BLOCK], p)
+
+    ops = bytearray()
+    literal_start = 0
+    copied = 0
+
+    def flush_data(end):
+        if end > literal_start:
+            ops.append(OP_DATA)
+            ops.extend(varint(end - literal_start))
+            ops.extend(new[literal_start:end])
+
+    i = 0
+    while i + DELTA_BLOCK <= len(new):
+        p = index.get(new[i:i + DELTA_BLOCK])
+        if p is None:
+            i += 1
+            continue
+
+        # Extend the match both ways, backwards only into pending data
+        start, src = i, p
+        while start > literal_start and src > 0 and new[start - 1] == base[src - 1]:
+            start -= 1
+            src -= 1
+        end = i + DELTA_BLOCK
+        while end < len(new) and src + (end - start) < len(base) and new[end] == base[src + (end - start)]:
+            end += 1
+
+        if end - start < DELTA_MIN_COPY:
+            i += 1
+            continue
+
+        flush_data(start)
+        ops.append(OP_COPY)
+        ops.extend(varint(end - start))
+        ops.extend(varint(src))
+        copied += end - start
+        literal_start = i = end
+
+    flush_data(len(new))
+    return bytes(ops), copied
+
+
+def delta_decode(base, ops):
+    out = bytearray()
+    i = 0
+
+    def read_varint():
+        nonlocal i
+        value = shift = 0
+        while True:
+            b = ops[i]
+            i += 1
+            value |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return value
+
+    while i < len(ops):
+        op = ops[i]
+        i += 1
+        length = read_varint()
+        if op == OP_COPY:
+            src = read_varint()
+            out.extend(base[src:src + length])
+        elif op == OP_DATA:
+            out.extend(ops[i:i + length])
+            i += length
+        else:
+            raise ValueError(f"bad op {op:#x}")
+    return bytes(out)
+
+
+def pack(new, base=None, compressed=True, window_sz2=12, lookahead_sz2=5):
+    flags = 0
+    payload = new
+    base_size = 0
+    base_hash = bytes(32)
+
+    if base is not None:
+        payload, copied = delta_encode(base, new)
+        flags |= FLAG_DELTA
+        base_size = len(base)
+        base_hash = hashlib.sha256(base).digest()
+        print(f"delta: {copied} of {len(new)} bytes copied from base", file=sys.stderr)
+        if delta_decode(base, payload) != new:
+            sys.exit("error: delta self-check failed")
+
+    if compressed:
+        encoded = compress(payload, window_sz2, lookahead_sz2)
+        if heatshrink_decode(encoded, window_sz2, lookahead_sz2)[:len(payload)] != payload:
+            sys.exit("error: compression self-check failed")
+        payload = encoded
+        flags |= FLAG_HEATSHRINK
+    else:
+        window_sz2 = lookahead_sz2 = 0
+
+    header = MAGIC + struct.pack("<BBBBII", VERSION, flags, window_sz2, lookahead_sz2,
+                                 len(new), base_size) + base_hash
+    assert len(header) == 48
+    return header + payload
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Pack an OpenEVSE firmware image for a smaller OTA download")
+    ap.add_argument("input", help="firmware .bin (signed, if the target requires it)")
+    ap.add_argument("output", help="packed image to write")
+    ap.add_argument("--base", help="firmware .bin the target is running, to build a delta against")
+    ap.add_argument("--no-compress", action="store_true", help="do not heatshrink compress the payload")
+    ap.add_argument("--window", type=int, default=12, help="heatshrink window, log2 bytes (4-%d)" % MAX_WINDOW_SZ2)
+    ap.add_argument("--lookahead", type=int, default=5, help="heatshrink lookahead, log2 bytes")
+    args = ap.parse_args()
+
+    if not 4 <= args.window <= MAX_WINDOW_SZ2:
+        sys.exit(f"error: --window must be between 4 and {MAX_WINDOW_SZ2}")
+    if not 3 <= args.lookahead < args.window:
+        sys.exit("error: --lookahead must be at least 3 and less than --window")
+
+    with open(args.input, "rb") as f:
+        new = f.read()
+    base = None
+    if args.base:
+        with open(args.base, "rb") as f:
+            base = f.read()
+
+    packed = pack(new, base, not args.no_compress, args.window, args.lookahead)
+    with open(args.output, "wb") as f:
+        f.write(packed)
+
+    print(f"{args.input}: {len(new)} -> {len(packed)} bytes ({100 * len(packed) / len(new):.1f}%)")
+    print(f"sha256 {hashlib.sha256(new).hexdigest()} (decoded image)")
+
+
+if __name__ == "__main__":
+    main()
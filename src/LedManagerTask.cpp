@@ -36,30 +36,21 @@ Adafruit_NeoPixel strip = Adafruit_NeoPixel(NEO_PIXEL_LENGTH, NEO_PIXEL_PIN, NEO
 #elif defined(NEO_PIXEL_PIN) && defined(NEO_PIXEL_LENGTH) && defined(ENABLE_WS2812FX)
 #include <WS2812FX.h>
 WS2812FX ws2812fx = WS2812FX(NEO_PIXEL_LENGTH, NEO_PIXEL_PIN, NEO_GRB + NEO_KHZ800);
+#define LED_FX 1
+#endif
 
-// True once ws2812fx.init() has run. WS2812FX::setBrightness() calls show(),
-// and a show() before init() breaks the strip on core 3: NeoPixel's espShow()
-// caches the pin it has RMT-initialised, then init()'s pinMode(OUTPUT) makes
-// the Peripheral Manager destroy that RMT channel, and every later show()
-// trusts the stale cache, skips re-init and dies silently in rmtWrite().
-// config_load_settings() calls setBrightness() before setup() runs, so the
-// pre-init forward has to be suppressed (the value is applied in setup()).
-static bool neopixels_ready = false;
-
-class LedAnimatorTask : public MicroTasks::Task
-{
-  public:
-    void setup() {
-    }
-    unsigned long loop(MicroTasks::WakeReason reason) {
-      ws2812fx.service();
-      return 10;
-    }
-} animator;
+#ifndef LED_FX
+#define LED_FX 0
 #endif
 
-#define FADE_STEP         16
-#define FADE_DELAY        50
+#if defined(ESP32) && !defined(EPOXY_DUINO) && (RGB_LED || defined(WIFI_LED))
+#define LED_OUTPUT_TASK 1
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#else
+#define LED_OUTPUT_TASK 0
+#endif
 
 #define CONNECTING_FLASH_TIME 450
 #define CONNECTED_FLASH_TIME  250
@@ -117,10 +108,10 @@ const uint8_t gamma8[] = {
 uint8_t buttonShareState = 0;
 #endif
 
-#if RGB_LED
-
 #define rgb(r,g,b) (r<<16|g<<8|b)
 
+#if RGB_LED
+
 #if defined(NEO_PIXEL_PIN) && defined(NEO_PIXEL_LENGTH) && defined(ENABLE_WS2812FX)
 
 static uint32_t status_colour_map(u_int8_t lcdcol)
@@ -170,13 +161,242 @@ static uint32_t status_colour_map[] =
 #endif
 #endif
 
+#if RGB_LED && !LED_FX
+static uint8_t frame_red(uint32_t col) { return (col >> 16) & 0xff; }
+static uint8_t frame_green(uint32_t col) { return (col >> 8) & 0xff; }
+static uint8_t frame_blue(uint32_t col) { return col & 0xff; }
+#endif
+
+// -------------------------------------------------------------------
+// LED output
+//
+// Everything that touches the LED hardware runs here. With FreeRTOS that is
+// a task of its own that sleeps until the next frame of the animation is due,
+// or until LedManagerTask hands it a new one, so steady colours cost nothing
+// and flashes cost a wake per frame, none of them on the MicroTasks loop.
+// -------------------------------------------------------------------
+
+#if LED_FX
+// Effect settings for WS2812FX, which renders its own frames
+struct LedFxState {
+  uint32_t colour;
+  uint8_t mode;
+  uint16_t speed;
+  uint8_t brightness;
+
+  bool operator==(const LedFxState &other) const {
+    return colour == other.colour && mode == other.mode &&
+           speed == other.speed && brightness == other.brightness;
+  }
+};
+
+static void led_output_apply(const LedFxState &fx)
+{
+  if(fx.brightness != ws2812fx.getBrightness()) {
+    ws2812fx.setBrightness(fx.brightness);
+  }
+  if(fx.colour != ws2812fx.getColor()) {
+    ws2812fx.setColor(fx.colour);
+  }
+  if(fx.speed != ws2812fx.getSpeed()) {
+    ws2812fx.setSpeed(fx.speed);
+  }
+  if(fx.mode != ws2812fx.getMode()) {
+    ws2812fx.setMode(fx.mode);
+  }
+
+  // Draw the change now, not when the old effect next steps
+  ws2812fx.trigger();
+}
+
+// Service the effect, returns ms until it needs servicing again
+static uint32_t led_output_render(uint32_t now)
+{
+  ws2812fx.service();
+  return FX_MODE_STATIC == ws2812fx.getMode() ? LED_ANIMATION_STATIC : LED_FX_SERVICE_TIME;
+}
+
+typedef LedFxState LedOutputState;
+#else
+static LedAnimationPlayer led_player;
+
+static void led_output_frame(const LedFrame &frame)
+{
+#if defined(NEO_PIXEL_PIN) && defined(NEO_PIXEL_LENGTH)
+  uint32_t col = strip.gamma32(strip.Color(frame.evse[0], frame.evse[1], frame.evse[2]));
+  DBUGVAR(col, HEX);
+  strip.fill(col);
+#ifdef WIFI_PIXEL_NUMBER
+  strip.setPixelColor(WIFI_PIXEL_NUMBER, frame.wifi[0], frame.wifi[1], frame.wifi[2]);
+#endif
+  strip.show();
+#endif
+
+#if defined(RED_LED) && defined(GREEN_LED) && defined(BLUE_LED)
+#if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3,0,0)
+  ledcWrite(RED_LED, gamma8[frame.wifi[0]]);
+  ledcWrite(GREEN_LED, gamma8[frame.wifi[1]]);
+  ledcWrite(BLUE_LED, gamma8[frame.wifi[2]]);
+#else
+  ledcWrite(RED_LEDC_CHANNEL, gamma8[frame.wifi[0]]);
+  ledcWrite(GREEN_LEDC_CHANNEL, gamma8[frame.wifi[1]]);
+  ledcWrite(BLUE_LEDC_CHANNEL, gamma8[frame.wifi[2]]);
+#endif
+
+#ifdef WIFI_BUTTON_SHARE_LED
+  #if RED_LED == WIFI_BUTTON_SHARE_LED
+    buttonShareState = gamma8[frame.wifi[0]];
+  #elif GREEN_LED == WIFI_BUTTON_SHARE_LED
+    buttonShareState = gamma8[frame.wifi[1]];
+  #elif BLUE_LED == WIFI_BUTTON_SHARE_LED
+    buttonShareState = gamma8[frame.wifi[2]];
+  #endif
+#endif
+#endif
+
+#ifdef WIFI_LED
+  uint8_t state = frame.wifiLed ? WIFI_LED_ON_STATE : !WIFI_LED_ON_STATE;
+  digitalWrite(WIFI_LED, state);
+#if defined(WIFI_BUTTON_SHARE_LED) && WIFI_BUTTON_SHARE_LED == WIFI_LED
+  buttonShareState = state ? 0 : 255;
+#endif
+#endif
+}
+
+static void led_output_apply(const LedAnimation &animation)
+{
+  led_player.start(animation, millis());
+  led_output_frame(led_player.frame());
+}
+
+static uint32_t led_output_render(uint32_t now)
+{
+  if(led_player.update(now)) {
+    led_output_frame(led_player.frame());
+  }
+  return led_player.nextChange(now);
+}
+
+typedef LedAnimation LedOutputState;
+#endif
+
+// Last state handed to the output, so a wake that changes nothing visible
+// does not restart the animation
+static LedOutputState led_output_current;
+static bool led_output_valid = false;
+
+static bool led_output_changed(const LedOutputState &state)
+{
+  if(led_output_valid && state == led_output_current) {
+    return false;
+  }
+
+  led_output_current = state;
+  led_output_valid = true;
+  return true;
+}
+
+#if LED_OUTPUT_TASK
+
+static SemaphoreHandle_t led_output_mutex = NULL;
+static TaskHandle_t led_output_task = NULL;
+static LedOutputState led_output_next;
+static bool led_output_pending = false;
+
+static void led_output_lock() {
+  if(led_output_mutex) {
+    xSemaphoreTake(led_output_mutex, portMAX_DELAY);
+  }
+}
+
+static void led_output_unlock() {
+  if(led_output_mutex) {
+    xSemaphoreGive(led_output_mutex);
+  }
+}
+
+static void led_output_loop(void *)
+{
+  TickType_t wait = portMAX_DELAY;
+  for(;;)
+  {
+    ulTaskNotifyTake(pdTRUE, wait);
+
+    led_output_lock();
+    if(led_output_pending) {
+      led_output_pending = false;
+      led_output_apply(led_output_next);
+    }
+    uint32_t next = led_output_render(millis());
+    led_output_unlock();
+
+    wait = LED_ANIMATION_STATIC == next ? portMAX_DELAY : max(pdMS_TO_TICKS(next), (TickType_t)1);
+  }
+}
+
+static void led_output_begin()
+{
+  led_output_mutex = xSemaphoreCreateMutex();
+  if(NULL == led_output_mutex ||
+     pdPASS != xTaskCreatePinnedToCore(led_output_loop, "led_output",
+                                       LED_TASK_STACK, NULL,
+                                       LED_TASK_PRIORITY, &led_output_task,
+                                       xPortGetCoreID()))
+  {
+    DEBUG_PORT.println(F("LED output: failed to start task"));
+    led_output_task = NULL;
+  }
+}
+
+static void led_output_set(const LedOutputState &state)
+{
+  if(NULL == led_output_task || !led_output_changed(state)) {
+    return;
+  }
+
+  led_output_lock();
+  led_output_next = state;
+  led_output_pending = true;
+  led_output_unlock();
+  xTaskNotifyGive(led_output_task);
+}
+
+// Nothing for the MicroTasks loop to do, the output task keeps time
+static uint32_t led_output_service() {
+  return LED_ANIMATION_STATIC;
+}
+
+#else // !LED_OUTPUT_TASK
+
+static void led_output_begin() {
+}
+
+static void led_output_lock() {
+}
+
+static void led_output_unlock() {
+}
+
+static void led_output_set(const LedOutputState &state)
+{
+  if(led_output_changed(state)) {
+    led_output_apply(state);
+    led_output_render(millis());
+  }
+}
+
+static uint32_t led_output_service() {
+  return led_output_render(millis());
+}
+
+#endif // LED_OUTPUT_TASK
+
 LedManagerTask::LedManagerTask() :
   MicroTasks::Task(),
   _evse(nullptr),
   state(LedState_Test_Red),
   wifiClient(false),
   wifiConnected(false),
-  flashState(false),
   brightness(LED_DEFAULT_BRIGHTNESS),
   onStateChange(this)
 {
@@ -195,23 +415,15 @@ void LedManagerTask::setup()
   DBUGF("Initialising NeoPixels");
   strip.begin();
   //strip.setBrightness(brightness);
-  setAllRGB(0, 0, 0);
 #elif defined(NEO_PIXEL_PIN) && defined(NEO_PIXEL_LENGTH) && defined(ENABLE_WS2812FX)
   DEBUG.printf("Initialising NeoPixels WS2812FX MODE...\n");
   ws2812fx.init();
-  neopixels_ready = true;
-  // apply the brightness stored by any pre-init setBrightness() call, with
-  // the same 0 = max mapping it uses
-  ws2812fx.setBrightness(0 == brightness ? 255 : brightness - 1);
   ws2812fx.setSpeed(DEFAULT_FX_SPEED);
   ws2812fx.setColor(BLACK);
   ws2812fx.setMode(FX_MODE_STATIC);
-  //ws2812fx.setBrightness(this->brightness);
-  DBUGF("Brightness: %d ", this->brightness);
   DBUGF("Brightness: %d ", brightness);
 
   ws2812fx.start();
-  MicroTask.startTask(&animator);
 #endif
 
 #if defined(RED_LED) && defined(GREEN_LED) && defined(BLUE_LED)
@@ -242,10 +454,14 @@ void LedManagerTask::setup()
   DBUGF("Configuring pin %d for Button", WIFI_BUTTON);
   pinMode(WIFI_BUTTON, WIFI_BUTTON_PRESSED_PIN_MODE);
 #endif
+
+  // From here on only the output side touches the LEDs
+  led_output_begin();
 }
 
 unsigned long LedManagerTask::loop(MicroTasks::WakeReason reason)
 {
+  Profile_Scope("LedManagerTask");
   DBUG("LED manager woke: ");
   DBUG(WakeReason_Scheduled == reason ? "WakeReason_Scheduled" :
        WakeReason_Event == reason ? "WakeReason_Event" :
@@ -267,34 +483,35 @@ unsigned long LedManagerTask::loop(MicroTasks::WakeReason reason)
     setNewState(false);
   }
 
-#if RGB_LED
-#if defined(NEO_PIXEL_PIN) && defined(NEO_PIXEL_LENGTH) && defined(ENABLE_WS2812FX)
+  // Only the test sequence needs waking again, animations are timed by the
+  // output side
+  unsigned long next = MicroTask.Infinate;
+
+#if LED_FX
   switch(state)
   {
     case LedState_Off:
-      //setAllRGB(0, 0, 0);
-      ws2812fx.setColor(BLACK);
-      return MicroTask.Infinate;
+      setAllRGB(BLACK, FX_MODE_STATIC, DEFAULT_FX_SPEED);
+      break;
 
     case LedState_Test_Red:
-      //setAllRGB(255, 0, 0);
-      ws2812fx.setColor(RED);
+      setAllRGB(RED, FX_MODE_STATIC, DEFAULT_FX_SPEED);
       state = LedState_Test_Green;
-      return TEST_LED_TIME;
+      next = TEST_LED_TIME;
+      break;
 
     case LedState_Test_Green:
-      //setAllRGB(0, 255, 0);
-      ws2812fx.setColor(GREEN);
+      setAllRGB(GREEN, FX_MODE_STATIC, DEFAULT_FX_SPEED);
       state = LedState_Test_Blue;
-      return TEST_LED_TIME;
+      next = TEST_LED_TIME;
+      break;
 
     case LedState_Test_Blue:
-      //setAllRGB(0, 0, 255);
-      ws2812fx.setColor(BLUE);
+      setAllRGB(BLUE, FX_MODE_STATIC, DEFAULT_FX_SPEED);
       state = LedState_Off;
       setNewState(false);
-      return TEST_LED_TIME;
-
+      next = TEST_LED_TIME;
+      break;
 
     case LedState_Evse_State:
     case LedState_WiFi_Access_Point_Waiting:
@@ -314,12 +531,6 @@ unsigned long LedManagerTask::loop(MicroTasks::WakeReason reason)
       DBUGF("Amps: %d ", _evse->getAmps());
       DBUGF("ChargeCurrent: %d ", _evse->getChargeCurrent());
       DBUGF("MaxHWCurrent: %d ", _evse->getMaxHardwareCurrent());
-      if (this->brightness == 0){
-        ws2812fx.setBrightness(255);
-      }
-      else {
-        ws2812fx.setBrightness(this->brightness-1);
-      }
       switch(state)
       {
         case LedState_Evse_State:
@@ -331,248 +542,146 @@ unsigned long LedManagerTask::loop(MicroTasks::WakeReason reason)
             setAllRGB(col, FX_MODE_FADE, DEFAULT_FX_SPEED);
           } else {
             setAllRGB(col, FX_MODE_STATIC, DEFAULT_FX_SPEED);
-          }    
-          //DBUGF("MODE:  LedState_Evse_State\n");
-          return MicroTask.Infinate;
+          }
+          break;
 
         case LedState_WiFi_Access_Point_Waiting:
           setEvseAndWifiRGB(col, FX_MODE_BLINK, CONNECTING_FX_SPEED);
-          //DBUGF("MODE: LedState_WiFi_Access_Point_Waiting\n");
-          return CONNECTING_FLASH_TIME;
+          break;
 
         case LedState_WiFi_Access_Point_Connected:
           setEvseAndWifiRGB(col, FX_MODE_FADE, CONNECTED_FX_SPEED);
-          flashState = !flashState;
-          //DBUGF("MODE: LedState_WiFi_Access_Point_Connected\n");
-          return CONNECTED_FLASH_TIME;
+          break;
 
         case LedState_WiFi_Client_Connecting:
           setEvseAndWifiRGB(col, FX_MODE_FADE, CONNECTING_FX_SPEED);
-          flashState = !flashState;
-          //DBUGF("MODE: LedState_WiFi_Client_Connecting\n");
-          return CONNECTING_FLASH_TIME;
+          break;
 
         case LedState_WiFi_Client_Connected:
           setEvseAndWifiRGB(col, FX_MODE_FADE, CONNECTED_FX_SPEED);
-          //DBUGF("MODOE: LedState_WiFi_Client_Connected\n");
-          return MicroTask.Infinate;
+          break;
 
         default:
           break;
       }
-    }
-
+    } break;
   }
 #else
+  LedAnimation animation;
+  uint32_t evseCol = 0;
+#if RGB_LED
+  uint8_t lcdCol = _evse->getStateColour();
+  DBUGVAR(lcdCol);
+  evseCol = status_colour_map[lcdCol];
+  DBUGVAR(evseCol, HEX);
+#endif
+
+  // WiFi status flashes on the WiFi pixel if there is one, otherwise on
+  // everything
+  auto wifiFlash = [&](uint32_t col, uint16_t time)
+  {
+#ifdef WIFI_PIXEL_NUMBER
+    animation.flash(makeFrame(evseCol, col, true), makeFrame(evseCol, 0, false), time);
+#else
+    animation.flash(makeFrame(col, col, true), makeFrame(0, 0, false), time);
+#endif
+  };
+
   switch(state)
   {
     case LedState_Off:
-      setAllRGB(0, 0, 0);
-      return MicroTask.Infinate;
+      animation.steady(makeFrame(0, 0, false));
+      break;
 
+#if RGB_LED
     case LedState_Test_Red:
-      setAllRGB(255, 0, 0);
+      animation.steady(makeFrame(rgb(255, 0, 0), rgb(255, 0, 0), true));
       state = LedState_Test_Green;
-      return TEST_LED_TIME;
+      next = TEST_LED_TIME;
+      break;
 
     case LedState_Test_Green:
-      setAllRGB(0, 255, 0);
+      animation.steady(makeFrame(rgb(0, 255, 0), rgb(0, 255, 0), true));
       state = LedState_Test_Blue;
-      return TEST_LED_TIME;
+      next = TEST_LED_TIME;
+      break;
 
     case LedState_Test_Blue:
-      setAllRGB(0, 0, 255);
+      animation.steady(makeFrame(rgb(0, 0, 255), rgb(0, 0, 255), true));
       state = LedState_Off;
       setNewState(false);
-      return TEST_LED_TIME;
-
-#ifdef WIFI_PIXEL_NUMBER
-    case LedState_Evse_State:
-    case LedState_WiFi_Access_Point_Waiting:
-    case LedState_WiFi_Access_Point_Connected:
-    case LedState_WiFi_Client_Connecting:
-    case LedState_WiFi_Client_Connected:
-    {
-      uint8_t lcdCol = _evse->getStateColour();
-      DBUGVAR(lcdCol);
-      uint32_t col = status_colour_map[lcdCol];
-      DBUGVAR(col, HEX);
-      uint8_t evseR = (col >> 16) & 0xff;
-      uint8_t evseG = (col >> 8) & 0xff;
-      uint8_t evseB = col & 0xff;
-
-      switch(state)
-      {
-        case LedState_Evse_State:
-          setAllRGB(evseR, evseG, evseB);
-          return MicroTask.Infinate;
-
-        case LedState_WiFi_Access_Point_Waiting:
-          setEvseAndWifiRGB(evseR, evseG, evseB, flashState ? 255 : 0, flashState ? 255 : 0, 0);
-          flashState = !flashState;
-          return CONNECTING_FLASH_TIME;
-
-        case LedState_WiFi_Access_Point_Connected:
-          setEvseAndWifiRGB(evseR, evseG, evseB, flashState ? 255 : 0, 0, flashState ? 255 : 0);
-          flashState = !flashState;
-          return CONNECTED_FLASH_TIME;
-
-        case LedState_WiFi_Client_Connecting:
-          setEvseAndWifiRGB(evseR, evseG, evseB, 0, flashState ? 255 : 0, flashState ? 255 : 0);
-          flashState = !flashState;
-          return CONNECTING_FLASH_TIME;
-
-        case LedState_WiFi_Client_Connected:
-          setEvseAndWifiRGB(evseR, evseG, evseB, 0, 255, 0);
-          return MicroTask.Infinate;
-
-        default:
-          break;
-      }
-    }
+      next = TEST_LED_TIME;
+      break;
 #else
-    case LedState_Evse_State:
-    {
-      uint8_t lcdCol = _evse->getStateColour();
-      DBUGVAR(lcdCol);
-      uint32_t col = status_colour_map[lcdCol];
-      DBUGVAR(col, HEX);
-      uint8_t r = (col >> 16) & 0xff;
-      uint8_t g = (col >> 8) & 0xff;
-      uint8_t b = col & 0xff;
-      setAllRGB(r, g, b);
-    } return MicroTask.Infinate;
-
-    case LedState_WiFi_Access_Point_Waiting:
-      setAllRGB(flashState ? 255 : 0, flashState ? 255 : 0, 0);
-      flashState = !flashState;
-      return CONNECTING_FLASH_TIME;
-
-    case LedState_WiFi_Access_Point_Connected:
-      setAllRGB(flashState ? 255 : 0, 0, flashState ? 255 : 0);
-      flashState = !flashState;
-      return CONNECTED_FLASH_TIME;
-
-    case LedState_WiFi_Client_Connecting:
-      setAllRGB(0, flashState ? 255 : 0, flashState ? 255 : 0);
-      flashState = !flashState;
-      return CONNECTING_FLASH_TIME;
-
-    case LedState_WiFi_Client_Connected:
-      setAllRGB(0, 255, 0);
-      return MicroTask.Infinate;
-#endif
-  }
-#endif
-#endif
-
-#ifdef WIFI_LED
-  switch(state)
-  {
     case LedState_Test_Red:
     case LedState_Test_Green:
     case LedState_Test_Blue:
-      setWiFiLed(WIFI_LED_ON_STATE);
+      animation.steady(makeFrame(0, 0, true));
       state = LedState_Off;
       setNewState(false);
-      return TEST_LED_TIME;
+      next = TEST_LED_TIME;
+      break;
+#endif
 
-    case LedState_Off:
-      setWiFiLed(!WIFI_LED_ON_STATE);
-      return MicroTask.Infinate;
+    case LedState_Evse_State:
+      animation.steady(makeFrame(evseCol, evseCol, wifiConnected));
+      break;
 
     case LedState_WiFi_Access_Point_Waiting:
-      setWiFiLed(flashState ? WIFI_LED_ON_STATE : !WIFI_LED_ON_STATE);
-      flashState = !flashState;
-      return CONNECTING_FLASH_TIME;
+      wifiFlash(rgb(255, 255, 0), CONNECTING_FLASH_TIME);
+      break;
 
     case LedState_WiFi_Access_Point_Connected:
-      setWiFiLed(flashState ? WIFI_LED_ON_STATE : !WIFI_LED_ON_STATE);
-      flashState = !flashState;
-      return CONNECTED_FLASH_TIME;
+      wifiFlash(rgb(255, 0, 255), CONNECTED_FLASH_TIME);
+      break;
 
     case LedState_WiFi_Client_Connecting:
-      setWiFiLed(flashState ? WIFI_LED_ON_STATE : !WIFI_LED_ON_STATE);
-      flashState = !flashState;
-      return CONNECTING_FLASH_TIME;
+      wifiFlash(rgb(0, 255, 255), CONNECTING_FLASH_TIME);
+      break;
 
     case LedState_WiFi_Client_Connected:
-      setWiFiLed(WIFI_LED_ON_STATE);
-      return MicroTask.Infinate;
-
-    default:
+#ifdef WIFI_PIXEL_NUMBER
+      animation.steady(makeFrame(evseCol, rgb(0, 255, 0), true));
+#else
+      animation.steady(makeFrame(rgb(0, 255, 0), rgb(0, 255, 0), true));
+#endif
       break;
   }
-#endif
 
-  return MicroTask.Infinate;
-}
+  led_output_set(animation);
+#endif
 
-/*
-int LedManagerTask::fadeLed(int fadeValue, int FadeDir)
-{
-  fadeValue += FadeDir;
-  if(fadeValue >= MAX_BM_FADE_LED)
-  {
-    fadeValue = MAX_BM_FADE_LED;
-    FadeDir = -FADE_STEP;
-  } else if(fadeValue <= 0) {
-    fadeValue = 0;
-    FadeDir = FADE_STEP;
-  }
-  return fadeValue;
+  return min(next, (unsigned long)led_output_service());
 }
-*/
 
-#if RGB_LED
-#if defined(NEO_PIXEL_PIN) && defined(NEO_PIXEL_LENGTH) && defined(ENABLE_WS2812FX)
+#if LED_FX
 void LedManagerTask::setAllRGB(uint32_t color, u_int8_t mode, uint16_t speed)
 {
   setEvseAndWifiRGB(color, mode, speed);
 }
 
-
 void LedManagerTask::setEvseAndWifiRGB(uint32_t evseColor, u_int8_t mode, u_int16_t speed)
 {
   DBUG("EVSE LED COLOR:");
   DBUG(evseColor);
-  if(evseColor != ws2812fx.getColor()){
-    ws2812fx.setColor(evseColor);
-  }
-
-  if(speed != ws2812fx.getSpeed()){
-    ws2812fx.setSpeed(speed);
-  }
-
-  if (ws2812fx.getMode() != mode){
-    ws2812fx.setMode(mode);
-  }
 
+  // See notes in setBrightness()
+  LedFxState fx = { evseColor, mode, speed, (uint8_t)(0 == brightness ? 255 : brightness - 1) };
+  led_output_set(fx);
 }
 #else
-void LedManagerTask::setAllRGB(uint8_t red, uint8_t green, uint8_t blue)
+LedFrame LedManagerTask::makeFrame(uint32_t evseCol, uint32_t wifiCol, bool wifiLed)
 {
-  setEvseAndWifiRGB(red, green, blue, red, green, blue);
-}
-#endif
-#endif
+  LedFrame frame = {};
+  frame.wifiLed = wifiLed;
 
-#if WIFI_PIXEL_NUMBER && !defined(ENABLE_WS2812FX)
-void LedManagerTask::setEvseAndWifiRGB(uint8_t evseRed, uint8_t evseGreen, uint8_t evseBlue, uint8_t wifiRed, uint8_t wifiGreen, uint8_t wifiBlue)
-{
-  DBUG("EVSE LED R:");
-  DBUG(evseRed);
-  DBUG(" G:");
-  DBUG(evseGreen);
-  DBUG(" B:");
-  DBUGLN(evseBlue);
-
-  DBUG("WiFi LED R:");
-  DBUG(wifiRed);
-  DBUG(" G:");
-  DBUG(wifiGreen);
-  DBUG(" B:");
-  DBUGLN(wifiBlue);
+#if RGB_LED
+  uint8_t evseRed = frame_red(evseCol);
+  uint8_t evseGreen = frame_green(evseCol);
+  uint8_t evseBlue = frame_blue(evseCol);
+  uint8_t wifiRed = frame_red(wifiCol);
+  uint8_t wifiGreen = frame_green(wifiCol);
+  uint8_t wifiBlue = frame_blue(wifiCol);
 
   if(brightness) { // See notes in setBrightness()
     evseRed = (evseRed * brightness) >> 8;
@@ -597,58 +706,15 @@ void LedManagerTask::setEvseAndWifiRGB(uint8_t evseRed, uint8_t evseGreen, uint8
   DBUG(" B:");
   DBUGLN(wifiBlue);
 
-#if defined(NEO_PIXEL_PIN) && defined(NEO_PIXEL_LENGTH) && !defined(ENABLE_WS2812FX)
-  uint32_t col = strip.gamma32(strip.Color(evseRed, evseGreen, evseBlue));
-  DBUGVAR(col, HEX);
-  strip.fill(col);
-  strip.setPixelColor(WIFI_PIXEL_NUMBER, wifiRed, wifiGreen, wifiBlue);
-  strip.show();
-#endif
-
-#if defined(RED_LED) && defined(GREEN_LED) && defined(BLUE_LED)
-
-  DBUGVAR(gamma8[wifiRed]);
-  DBUGVAR(gamma8[wifiGreen]);
-  DBUGVAR(gamma8[wifiBlue]);
-
-#if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3,0,0)
-  ledcWrite(RED_LED, gamma8[wifiRed]);
-  ledcWrite(GREEN_LED, gamma8[wifiGreen]);
-  ledcWrite(BLUE_LED, gamma8[wifiBlue]);
-#else
-  ledcWrite(RED_LEDC_CHANNEL, gamma8[wifiRed]);
-  ledcWrite(GREEN_LEDC_CHANNEL, gamma8[wifiGreen]);
-  ledcWrite(BLUE_LEDC_CHANNEL, gamma8[wifiBlue]);
+  frame.evse[0] = evseRed;
+  frame.evse[1] = evseGreen;
+  frame.evse[2] = evseBlue;
+  frame.wifi[0] = wifiRed;
+  frame.wifi[1] = wifiGreen;
+  frame.wifi[2] = wifiBlue;
 #endif
 
-#ifdef WIFI_BUTTON_SHARE_LED
-  #if RED_LED == WIFI_BUTTON_SHARE_LED
-    buttonShareState = gamma8[wifiRed];
-  #elif GREEN_LED == WIFI_BUTTON_SHARE_LED
-    buttonShareState = gamma8[wifiGreen];
-  #elif BLUE_LED == WIFI_BUTTON_SHARE_LED
-    buttonShareState = gamma8[wifiBlue];
-  #endif
-  DBUGVAR(buttonShareState);
-#endif
-#endif
-}
-#endif
-
-#ifdef WIFI_LED
-void LedManagerTask::setWiFiLed(uint8_t state)
-{
-  DBUGVAR(state);
-  digitalWrite(WIFI_LED, state);  // Stored brightness value is different than what's passed.
-  // This simplifies the actual scaling math later, allowing a fast
-  // 8x8-bit multiply and taking the MSB. 'brightness' is a uint8_t,
-  // adding 1 here may (intentionally) roll over...so 0 = max brightness
-  // (color values are interpreted ltimingiterally; no scaling), 1 = min
-  // brightness (off), 255 = just below max brightness.
-
-#ifdef WIFI_BUTTON_SHARE_LED
-  buttonShareState = state ? 0 : 255;
-#endif
+  return frame;
 }
 #endif
 
@@ -732,6 +798,9 @@ void LedManagerTask::setWifiMode(bool client, bool connected)
 int LedManagerTask::getButtonPressed()
 {
 #if defined(WIFI_BUTTON_SHARE_LED)
+  // Keep the output task off the pin while it is an input
+  led_output_lock();
+
   #ifdef RGB_LEDC_CHANNEL
   #if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3,0,0)
   ledcDetach(WIFI_BUTTON_SHARE_LED);
@@ -760,6 +829,8 @@ int LedManagerTask::getButtonPressed()
   pinMode(WIFI_BUTTON_SHARE_LED, OUTPUT);
   digitalWrite(WIFI_BUTTON_SHARE_LED, buttonShareState ? HIGH : LOW);
   #endif
+
+  led_output_unlock();
 #endif
 
   return button;
@@ -775,19 +846,11 @@ void LedManagerTask::setBrightness(uint8_t brightness)
   // brightness (off), 255 = just below max brightness.
   this->brightness = brightness + 1;
 
-#if defined(NEO_PIXEL_PIN) && defined(NEO_PIXEL_LENGTH) && defined(ENABLE_WS2812FX)
-// This controls changes on the limits of the web interface slidebar.
-// Otherwise it gets out of sync
-  if(neopixels_ready)
-  {
-    if (this->brightness == 0){
-      ws2812fx.setBrightness(255);
-    }
-    else {
-      ws2812fx.setBrightness(this->brightness-1);
-    }
-  }
-#endif
+  // Applied with the next frame. WS2812FX::setBrightness() calls show(), so it
+  // is left to the output task: a show() before ws2812fx.init() breaks the
+  // strip on core 3 (NeoPixel caches an RMT channel that init()'s
+  // pinMode(OUTPUT) then destroys), and config_load_settings() calls this
+  // before setup() runs.
 
   DBUGVAR(this->brightness);
 
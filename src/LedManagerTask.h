@@ -5,6 +5,7 @@
 #include <MicroTasks.h>
 
 #include "evse_man.h"
+#include "led_animation.h"
 
 #if defined(NEO_PIXEL_PIN) && defined(NEO_PIXEL_LENGTH)
 #define RGB_LED 1
@@ -14,6 +15,20 @@
 #define RGB_LED 0
 #endif
 
+// LED output task, owns the LED hardware and plays the animations
+#ifndef LED_TASK_STACK
+#define LED_TASK_STACK          3072
+#endif
+
+#ifndef LED_TASK_PRIORITY
+#define LED_TASK_PRIORITY       1
+#endif
+
+// How often WS2812FX effects are stepped, static colours are not
+#ifndef LED_FX_SERVICE_TIME
+#define LED_FX_SERVICE_TIME     10
+#endif
+
 enum LedState
 {
   LedState_Test_Red,
@@ -37,24 +52,15 @@ class LedManagerTask : public MicroTasks::Task
     bool wifiClient;
     bool wifiConnected;
 
-    bool flashState;
-
     uint8_t brightness;
 
     MicroTasks::EventListener onStateChange;
 
-#if RGB_LED
 #if defined(NEO_PIXEL_PIN) && defined(NEO_PIXEL_LENGTH) && defined(ENABLE_WS2812FX)
     void setAllRGB(uint32_t color, u_int8_t mode, u_int16_t speed);
     void setEvseAndWifiRGB(uint32_t evseColor, u_int8_t mode, u_int16_t speed);
 #else
-    void setAllRGB(uint8_t red, uint8_t green, uint8_t blue);
-    void setEvseAndWifiRGB(uint8_t evseRed, uint8_t evseGreen, uint8_t evseBlue, uint8_t wifiRed, uint8_t wifiGreen, uint8_t wifiBlue);
-#endif
-#endif
-
-#ifdef WIFI_LED
-    void setWiFiLed(uint8_t state);
+    LedFrame makeFrame(uint32_t evseCol, uint32_t wifiCol, bool wifiLed);
 #endif
 
     LedState ledStateFromEvseState(uint8_t);
@@ -25,8 +25,10 @@
 #include "input.h"
 #include "LedManagerTask.h"
 #include "current_shaper.h"
+#include "load_balancer.h"
 
 #include "limit.h"
+#include "publisher.h"
 #endif
 
 #ifndef HTTP_SERVER_PORT
@@ -93,6 +95,7 @@ String emoncms_server;
 String emoncms_node;
 String emoncms_apikey;
 String emoncms_fingerprint;
+uint32_t emoncms_interval;
 
 // MQTT Settings
 String mqtt_server;
@@ -105,6 +108,9 @@ String mqtt_solar;
 String mqtt_grid_ie;
 String mqtt_vrms;
 String mqtt_live_pwr;
+String mqtt_live_pwr_l1;
+String mqtt_live_pwr_l2;
+String mqtt_live_pwr_l3;
 String mqtt_vehicle_soc;
 String mqtt_vehicle_range;
 String mqtt_vehicle_eta;
@@ -112,6 +118,7 @@ String mqtt_vehicle_charge_limit;
 String mqtt_home_battery_soc;
 String mqtt_home_battery_power;
 String mqtt_announce_topic;
+uint32_t mqtt_publish_interval;
 
 // OCPP 1.6 Settings
 String ocpp_server;
@@ -135,6 +142,9 @@ double divert_PV_ratio;
 uint32_t divert_attack_smoothing_time;
 uint32_t divert_decay_smoothing_time;
 uint32_t divert_min_charge_time;
+double divert_pilot_hysteresis;
+uint32_t divert_pilot_interval;
+uint32_t divert_pilot_lookahead;
 
 // Current Shaper settings
 uint32_t current_shaper_max_pwr;
@@ -142,9 +152,19 @@ uint32_t current_shaper_smoothing_time;
 uint32_t current_shaper_min_pause_time;   // in seconds
 uint32_t current_shaper_data_maxinterval; // in seconds
 
+// Phase (1-3) a single-phase EVSE is connected to
+uint8_t evse_phase;
+
 // Temperature Throttle settings
 uint32_t temp_throttle_setpoint;
 
+// Site load balancing settings
+uint32_t load_balancing_budget;
+String load_balancing_topic;
+uint32_t load_balancing_priority;
+String load_balancing_policy;
+uint32_t load_balancing_failsafe_current;
+
 // Over-temperature shutdown threshold (degrees C)
 uint32_t over_temp_shutdown;
 
@@ -252,6 +272,7 @@ ConfigOpt *opts[] =
   new ConfigOptDefinition<String>(emoncms_node, esp_hostname, "emoncms_node", "en"),
   new ConfigOptSecret(emoncms_apikey, "", "emoncms_apikey", "ea"),
   new ConfigOptDefinition<String>(emoncms_fingerprint, "", "emoncms_fingerprint", "ef"),
+  new ConfigOptDefinition<uint32_t>(emoncms_interval, 60, "emoncms_interval", "ei"),
 
 // MQTT Settings
   new ConfigOptDefinition<String>(mqtt_server, "", "mqtt_server", "ms"),
@@ -264,6 +285,9 @@ ConfigOpt *opts[] =
   new ConfigOptDefinition<String>(mqtt_grid_ie, "", "mqtt_grid_ie", "mg"),
   new ConfigOptDefinition<String>(mqtt_vrms, "", "mqtt_vrms", "mv"),
   new ConfigOptDefinition<String>(mqtt_live_pwr, "", "mqtt_live_pwr", "map"),
+  new ConfigOptDefinition<String>(mqtt_live_pwr_l1, "", "mqtt_live_pwr_l1", "ml1"),
+  new ConfigOptDefinition<String>(mqtt_live_pwr_l2, "", "mqtt_live_pwr_l2", "ml2"),
+  new ConfigOptDefinition<String>(mqtt_live_pwr_l3, "", "mqtt_live_pwr_l3", "ml3"),
   new ConfigOptDefinition<String>(mqtt_vehicle_soc, "", "mqtt_vehicle_soc", "mc"),
   new ConfigOptDefinition<String>(mqtt_vehicle_range, "", "mqtt_vehicle_range", "mr"),
   new ConfigOptDefinition<String>(mqtt_vehicle_eta, "", "mqtt_vehicle_eta", "met"),
@@ -271,6 +295,7 @@ ConfigOpt *opts[] =
   new ConfigOptDefinition<String>(mqtt_home_battery_soc, "", "mqtt_home_battery_soc", "mhs"),
   new ConfigOptDefinition<String>(mqtt_home_battery_power, "", "mqtt_home_battery_power", "mhp"),
   new ConfigOptDefinition<String>(mqtt_announce_topic, "openevse/announce/" + ESPAL.getShortId(), "mqtt_announce_topic", "ma"),
+  new ConfigOptDefinition<uint32_t>(mqtt_publish_interval, 0, "mqtt_publish_interval", "mpi"),
 
 // OCPP 1.6 Settings
   new ConfigOptDefinition<String>(ocpp_server, "", "ocpp_server", "ows"),
@@ -287,15 +312,26 @@ ConfigOpt *opts[] =
   new ConfigOptDefinition<uint32_t>(divert_attack_smoothing_time, 20, "divert_attack_smoothing_time", "das"),
   new ConfigOptDefinition<uint32_t>(divert_decay_smoothing_time, 600, "divert_decay_smoothing_time", "dds"),
   new ConfigOptDefinition<uint32_t>(divert_min_charge_time, 600, "divert_min_charge_time", "dt"),
+  new ConfigOptDefinition<double>(divert_pilot_hysteresis, 0.5, "divert_pilot_hysteresis", "dph"),
+  new ConfigOptDefinition<uint32_t>(divert_pilot_interval, 30, "divert_pilot_interval", "dpi"),
+  new ConfigOptDefinition<uint32_t>(divert_pilot_lookahead, 0, "divert_pilot_lookahead", "dpl"),
 
 // Current Shaper settings
   new ConfigOptDefinition<uint32_t>(current_shaper_max_pwr, 0, "current_shaper_max_pwr", "smp"),
   new ConfigOptDefinition<uint32_t>(current_shaper_smoothing_time, 60, "current_shaper_smoothing_time", "sst"),
   new ConfigOptDefinition<uint32_t>(current_shaper_min_pause_time, 300, "current_shaper_min_pause_time", "spt"),
   new ConfigOptDefinition<uint32_t>(current_shaper_data_maxinterval, 120, "current_shaper_data_maxinterval", "sdm"),
+  new ConfigOptDefinition<uint8_t>(evse_phase, 1, "evse_phase", "eph"),
 
 // Temperature Throttle settings
   new ConfigOptDefinition<uint32_t>(temp_throttle_setpoint, TEMP_THROTTLE_SETPOINT_DEFAULT, "temp_throttle_setpoint", "tts"),
+
+// Site load balancing settings
+  new ConfigOptDefinition<uint32_t>(load_balancing_budget, 32, "load_balancing_budget", "lbb"),
+  new ConfigOptDefinition<String>(load_balancing_topic, "openevse/site", "load_balancing_topic", "lbs"),
+  new ConfigOptDefinition<uint32_t>(load_balancing_priority, 0, "load_balancing_priority", "lbp"),
+  new ConfigOptDefinition<String>(load_balancing_policy, "fair", "load_balancing_policy", "lbo"),
+  new ConfigOptDefinition<uint32_t>(load_balancing_failsafe_current, 0, "load_balancing_failsafe_current", "lbf"),
   new ConfigOptDefinition<uint32_t>(over_temp_shutdown, 72, "over_temp_shutdown", "ots"),
   new ConfigOptDefinition<uint32_t>(voltage_cfg, 0, "voltage", "sv"),
   new ConfigOptDefinition<uint32_t>(heartbeat_interval_cfg, 5, "heartbeat_interval", "hbi"),
@@ -350,6 +386,7 @@ ConfigOpt *opts[] =
   new ConfigOptVirtualMaskedBool(flagsOpt, flagsChanged, CONFIG_DEFAULT_STATE, CONFIG_DEFAULT_STATE, "default_state", "dfs"),
   new ConfigOptVirtualMaskedBool(flagsOpt, flagsChanged, CONFIG_TEMP_THROTTLE, CONFIG_TEMP_THROTTLE, "temp_throttle_enabled", "tte"),
   new ConfigOptVirtualMaskedBool(flagsOpt, flagsChanged, CONFIG_LCD_NETWORK_INFO, CONFIG_LCD_NETWORK_INFO, "lcd_network_info", "lni"),
+  new ConfigOptVirtualMaskedBool(flagsOpt, flagsChanged, CONFIG_LOAD_BALANCING, CONFIG_LOAD_BALANCING, "load_balancing_enabled", "lbe"),
   new ConfigOptVirtualMqttProtocol(flagsOpt, flagsChanged, "mqtt_protocol", "mprt"),
   new ConfigOptVirtualChargeMode(flagsOpt, flagsChanged, "charge_mode", "chmd")
 };
@@ -463,6 +500,8 @@ void config_changed(String name)
   // This must run regardless of ENABLE_CONFIG_CHANGE_NOTIFICATION.
   if(name == "www_password" || name == "www_username") {
     web_auth_rotate_secret();
+  } else if(name == "server_secret") {
+    web_auth_secret_changed();
   }
 
 #if ENABLE_CONFIG_CHANGE_NOTIFICATION
@@ -481,6 +520,11 @@ void config_changed(String name)
     timeManager.setSntpEnabled(config_sntp_enabled());
     OcppTask::notifyConfigChanged();
     evse.setSleepForDisable(!config_pause_uses_disabled());
+    // The default state is used when no claim sets the state
+    evse.reevaluateClaims();
+    limit.notifyConfigChanged();
+  } else if(name == "mqtt_publish_interval") {
+    publisher.setMqttInterval(mqtt_publish_interval);
   } else if(name.startsWith("mqtt_")) {
     mqtt.restartConnection();
   } else if(name.startsWith("ocpp_")) {
@@ -499,6 +543,15 @@ void config_changed(String name)
     shaper.notifyConfigChanged(config_current_shaper_enabled()?1:0,current_shaper_max_pwr);
   } else if(name.startsWith("temp_throttle_")) {
     tempThrottle.notifyConfigChanged(config_temp_throttle_enabled(), temp_throttle_setpoint);
+  } else if(name.startsWith("load_balancing_")) {
+    loadBalancer.notifyConfigChanged(config_load_balancing_enabled(), load_balancing_budget,
+                                     load_balancing_priority,
+                                     LoadShareAllocator::policyFromName(load_balancing_policy.c_str()),
+                                     load_balancing_failsafe_current);
+    if(name == "load_balancing_enabled" || name == "load_balancing_topic") {
+      // (un)subscribe from the site topic
+      mqtt.restartConnection();
+    }
   } else if(name == "tesla_vehicle_id") {
     teslaClient.setVehicleId(tesla_vehicle_id);
   } else if(name.startsWith("tesla_")) {
@@ -68,6 +68,8 @@ extern String emoncms_server;
 extern String emoncms_node;
 extern String emoncms_apikey;
 extern String emoncms_fingerprint;
+// Seconds between batched posts, 0 = post every update
+extern uint32_t emoncms_interval;
 
 // MQTT Settings
 extern String mqtt_server;
@@ -80,6 +82,9 @@ extern String mqtt_solar;
 extern String mqtt_grid_ie;
 extern String mqtt_vrms;
 extern String mqtt_live_pwr;
+extern String mqtt_live_pwr_l1;
+extern String mqtt_live_pwr_l2;
+extern String mqtt_live_pwr_l3;
 extern String mqtt_vehicle_soc;
 extern String mqtt_vehicle_range;
 extern String mqtt_vehicle_eta;
@@ -87,6 +92,7 @@ extern String mqtt_vehicle_charge_limit;
 extern String mqtt_home_battery_soc;
 extern String mqtt_home_battery_power;
 extern String mqtt_announce_topic;
+extern uint32_t mqtt_publish_interval;
 
 // OCPP 1.6 Settings
 extern String ocpp_server;
@@ -106,6 +112,9 @@ extern double divert_PV_ratio;
 extern uint32_t divert_attack_smoothing_time;
 extern uint32_t divert_decay_smoothing_time;
 extern uint32_t divert_min_charge_time;
+extern double divert_pilot_hysteresis;
+extern uint32_t divert_pilot_interval;
+extern uint32_t divert_pilot_lookahead;
 
 // Scheduler settings
 extern uint32_t scheduler_start_window;
@@ -116,9 +125,19 @@ extern uint32_t current_shaper_smoothing_time;
 extern uint32_t current_shaper_min_pause_time;
 extern uint32_t current_shaper_data_maxinterval;
 
+// Phase (1-3) a single-phase EVSE is connected to
+extern uint8_t evse_phase;
+
 // Temperature Throttle settings
 extern uint32_t temp_throttle_setpoint;
 
+// Site load balancing settings
+extern uint32_t load_balancing_budget;
+extern String load_balancing_topic;
+extern uint32_t load_balancing_priority;
+extern String load_balancing_policy;
+extern uint32_t load_balancing_failsafe_current;
+
 // Heartbeat Supervision settings (stored in ESP32 config, applied to EVSE on boot)
 extern uint32_t heartbeat_interval_cfg;
 extern uint32_t heartbeat_current_cfg;
@@ -167,6 +186,7 @@ extern uint32_t flags;
 #define CONFIG_DEFAULT_STATE        (1 << 26)
 #define CONFIG_TEMP_THROTTLE        (1 << 27)
 #define CONFIG_LCD_NETWORK_INFO     (1 << 28) // next free bit after CONFIG_LCD_NETWORK_INFO
+#define CONFIG_LOAD_BALANCING       (1 << 29)
 
 #define INITIAL_CONFIG_VERSION  1
 
@@ -270,6 +290,11 @@ inline bool config_lcd_network_info_enabled()
   return CONFIG_LCD_NETWORK_INFO == (flags & CONFIG_LCD_NETWORK_INFO);
 }
 
+inline bool config_load_balancing_enabled()
+{
+  return CONFIG_LOAD_BALANCING == (flags & CONFIG_LOAD_BALANCING);
+}
+
 // Ohm Connect Settings
 extern String ohm;
 
@@ -0,0 +1,98 @@
+#include "certificate_index.h"
+
+#include <string.h>
+
+static void put_le(std::string &out, uint64_t value, size_t bytes)
+{
+  for(size_t i = 0; i < bytes; i++) {
+    out.push_back((char)((value >> (8 * i)) & 0xff));
+  }
+}
+
+static uint64_t get_le(const uint8_t *p, size_t bytes)
+{
+  uint64_t value = 0;
+  for(size_t i = 0; i < bytes; i++) {
+    value |= (uint64_t)p[i] << (8 * i);
+  }
+  return value;
+}
+
+void certificate_index_encode(const std::vector<CertificateIndexEntry> &entries, std::string &out)
+{
+  out.clear();
+  out.reserve(CERTIFICATE_INDEX_HEADER_SIZE + entries.size() * (CERTIFICATE_INDEX_RECORD_SIZE + 16));
+
+  out.append(CERTIFICATE_INDEX_MAGIC, 4);
+  put_le(out, CERTIFICATE_INDEX_VERSION, 1);
+  put_le(out, 0, 1);
+  put_le(out, entries.size(), 2);
+
+  for(const CertificateIndexEntry &entry : entries)
+  {
+    size_t name_len = entry.name.length();
+    if(name_len > CERTIFICATE_INDEX_NAME_MAX) {
+      name_len = CERTIFICATE_INDEX_NAME_MAX;
+    }
+
+    put_le(out, entry.id, 8);
+    put_le(out, entry.type, 1);
+    put_le(out, name_len, 1);
+    put_le(out, entry.cert_offset, 4);
+    put_le(out, entry.cert_len, 4);
+    put_le(out, entry.key_offset, 4);
+    put_le(out, entry.key_len, 4);
+    out.append(entry.name, 0, name_len);
+  }
+}
+
+bool certificate_index_decode(const uint8_t *data, size_t len, std::vector<CertificateIndexEntry> &entries)
+{
+  entries.clear();
+
+  if(len < CERTIFICATE_INDEX_HEADER_SIZE ||
+     0 != memcmp(data, CERTIFICATE_INDEX_MAGIC, 4) ||
+     CERTIFICATE_INDEX_VERSION != data[4])
+  {
+    return false;
+  }
+
+  size_t count = get_le(data + 6, 2);
+  size_t pos = CERTIFICATE_INDEX_HEADER_SIZE;
+  entries.reserve(count);
+
+  for(size_t i = 0; i < count; i++)
+  {
+    if(len - pos < CERTIFICATE_INDEX_RECORD_SIZE) {
+      entries.clear();
+      return false;
+    }
+
+    const uint8_t *p = data + pos;
+    CertificateIndexEntry entry;
+    entry.id = get_le(p, 8);
+    entry.type = p[8];
+    size_t name_len = p[9];
+    entry.cert_offset = (uint32_t)get_le(p + 10, 4);
+    entry.cert_len = (uint32_t)get_le(p + 14, 4);
+    entry.key_offset = (uint32_t)get_le(p + 18, 4);
+    entry.key_len = (uint32_t)get_le(p + 22, 4);
+    pos += CERTIFICATE_INDEX_RECORD_SIZE;
+
+    if(len - pos < name_len) {
+      entries.clear();
+      return false;
+    }
+    entry.name.assign((const char *)data + pos, name_len);
+    pos += name_len;
+
+    entries.push_back(entry);
+  }
+
+  if(pos != len) {
+    entries.clear();
+    return false;
+  }
+
+  return true;
+}
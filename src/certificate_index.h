@@ -0,0 +1,45 @@
+#ifndef CERTIFICATE_INDEX_H
+#define CERTIFICATE_INDEX_H
+
+// Compact index of the certificate store.
+//
+// The index holds only the metadata of each stored certificate. The PEM bodies
+// live in a per-certificate file and are referenced by offset/length, so the
+// store can be listed at boot without reading or parsing any certificate, and
+// a body is only read when something actually needs it.
+//
+//   header  "OECI" | uint8 version | uint8 reserved | uint16 count
+//   record  uint64 id | uint8 type | uint8 name_len |
+//           uint32 cert_offset | uint32 cert_len |
+//           uint32 key_offset | uint32 key_len | name
+//
+// All integers little endian. No Arduino dependency so it can be unit-tested on
+// the build host.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define CERTIFICATE_INDEX_MAGIC         "OECI"
+#define CERTIFICATE_INDEX_VERSION       1
+#define CERTIFICATE_INDEX_HEADER_SIZE   8
+#define CERTIFICATE_INDEX_RECORD_SIZE   26
+#define CERTIFICATE_INDEX_NAME_MAX      255
+
+struct CertificateIndexEntry
+{
+  uint64_t id = 0;
+  uint8_t type = 0;
+  std::string name;           // truncated to CERTIFICATE_INDEX_NAME_MAX
+  uint32_t cert_offset = 0;
+  uint32_t cert_len = 0;
+  uint32_t key_offset = 0;
+  uint32_t key_len = 0;       // 0 for a root certificate
+};
+
+void certificate_index_encode(const std::vector<CertificateIndexEntry> &entries, std::string &out);
+// Returns false, leaving entries empty, if the index is corrupt or truncated
+bool certificate_index_decode(const uint8_t *data, size_t len, std::vector<CertificateIndexEntry> &entries);
+
+#endif // CERTIFICATE_INDEX_H
@@ -71,20 +71,149 @@ bool CertificateStore::Certificate::deserialize(JsonObject &obj)
 
 bool CertificateStore::Certificate::serialize(JsonObject &doc, uint32_t flags)
 {
+  // Only hold the bodies for as long as it takes to copy them into the doc
+  bool wasLoaded = _loaded;
+  if(!load()) {
+    return false;
+  }
+
   doc["id"] = String(_id, HEX);
   doc["type"] = _type.toString();
   doc["name"] = _name;
   doc["certificate"] = _cert;
   if(_type == Type::Client) {
-    doc["key"] = flags & Flags::REDACT_PRIVATE_KEY ? "__REDACTED__" : _key.c_str();
+    if(flags & Flags::REDACT_PRIVATE_KEY) {
+      doc["key"] = "__REDACTED__";
+    } else {
+      doc["key"] = _key;
+    }
+  }
+
+  if(!wasLoaded) {
+    unload();
+  }
+
+  return true;
+}
+
+String CertificateStore::Certificate::getPath() const
+{
+  return String(CERTIFICATE_BASE_DIRECTORY) + "/" + String(_id, HEX) + ".pem";
+}
+
+static bool readSection(File &file, uint32_t offset, uint32_t len, char *dest)
+{
+  return file.seek(offset) && file.read((uint8_t *)dest, len) == len;
+}
+
+bool CertificateStore::Certificate::load()
+{
+  if(_loaded) {
+    return true;
+  }
+
+  File file = LittleFS.open(getPath());
+  if(!file)
+  {
+    DBUGF("Failed to open %s", getPath().c_str());
+    return false;
+  }
+
+  _cert.resize(_certLen);
+  _key.resize(_keyLen);
+  bool ok = readSection(file, _certOffset, _certLen, &_cert[0]) &&
+            readSection(file, _keyOffset, _keyLen, &_key[0]);
+  file.close();
+
+  if(!ok)
+  {
+    DBUGF("Failed to read %s", getPath().c_str());
+    unload();
+    return false;
   }
 
+  _loaded = true;
   return true;
 }
 
+void CertificateStore::Certificate::unload()
+{
+  // Nothing to reload from until it has been saved
+  if(0 == _certLen) {
+    return;
+  }
+
+  std::string().swap(_cert);
+  std::string().swap(_key);
+  _loaded = false;
+}
+
+bool CertificateStore::Certificate::readCert(char *dest)
+{
+  if(_loaded) {
+    memcpy(dest, _cert.c_str(), _cert.length());
+    return true;
+  }
+
+  File file = LittleFS.open(getPath());
+  if(!file) {
+    return false;
+  }
+
+  bool ok = readSection(file, _certOffset, _certLen, dest);
+  file.close();
+  return ok;
+}
+
+bool CertificateStore::Certificate::save()
+{
+  String path = getPath();
+
+  // Don't truncate an existing valid cert if the new contents won't fit.
+  if(!littlefs_has_space(_cert.length() + _key.length()))
+  {
+    DBUGLN("Certificates: insufficient space, not saving");
+    return false;
+  }
+
+  File file = LittleFS.open(path, "w");
+  if(!file)
+  {
+    return false;
+  }
+
+  bool ok = file.write((const uint8_t *)_cert.c_str(), _cert.length()) == _cert.length() &&
+            file.write((const uint8_t *)_key.c_str(), _key.length()) == _key.length();
+  file.close();
+  if(!ok)
+  {
+    // Partial write — remove the corrupt file rather than leave it.
+    LittleFS.remove(path);
+    return false;
+  }
+
+  _certOffset = 0;
+  _certLen = _cert.length();
+  _keyOffset = _certLen;
+  _keyLen = _key.length();
+  return true;
+}
+
+void CertificateStore::Certificate::getIndexEntry(CertificateIndexEntry &entry) const
+{
+  entry.id = _id;
+  entry.type = (uint8_t)(Type::Value)_type;
+  entry.name = _name;
+  entry.cert_offset = _certOffset;
+  entry.cert_len = _certLen;
+  entry.key_offset = _keyOffset;
+  entry.key_len = _keyLen;
+}
+
 CertificateStore::CertificateStore() :
   _certs(),
-  _root_ca(root_ca)
+  _root_ca(root_ca),
+  _root_ca_valid(true)
 {
 }
 
@@ -100,7 +229,7 @@ CertificateStore::~CertificateStore()
   }
 
   if(_root_ca != root_ca) {
-    delete _root_ca;
+    delete [] _root_ca;
   }
 }
 
@@ -115,12 +244,17 @@ bool CertificateStore::begin()
 
 const char *CertificateStore::getRootCa()
 {
+  // Assembled on the first TLS connection after a change rather than on every
+  // add/remove, so a batch of changes costs one rebuild
+  if(!_root_ca_valid) {
+    buildRootCa();
+  }
   return _root_ca;
 }
 
 bool CertificateStore::addCertificate(const char *name, const char *certificate, const char *key, uint64_t *id)
 {
-  Certificate *cert = new Certificate(certificate, key);
+  Certificate *cert = new Certificate(name, certificate, key);
   if(cert)
   {
     if(addCertificate(cert, id)) {
@@ -134,7 +268,7 @@ bool CertificateStore::addCertificate(const char *name, const char *certificate,
 
 bool CertificateStore::addCertificate(const char *name, const char *certificate, uint64_t *id)
 {
-  Certificate *cert = new Certificate(certificate);
+  Certificate *cert = new Certificate(name, certificate);
   if(cert)
   {
     if(addCertificate(cert, id)) {
@@ -175,14 +309,24 @@ bool CertificateStore::addCertificate(Certificate *cert, uint64_t *id, bool save
     *id = cert->getId();
   }
 
+  if(save && !saveCertificate(cert)) {
+    return false;
+  }
+
   _certs.push_back(cert);
 
-  if(cert->getType() == Certificate::Type::Root) {
-    buildRootCa();
+  if(save && !saveIndex())
+  {
+    _certs.pop_back();
+    removeCertificate(cert);
+    return false;
   }
 
-  if(save) {
-    return saveCertificate(cert);
+  if(cert->getType() == Certificate::Type::Root) {
+    _root_ca_valid = false;
+
+    // The bundle holds its own copy
+    cert->unload();
   }
 
   return true;
@@ -200,10 +344,11 @@ bool CertificateStore::removeCertificate(uint64_t id)
 
       _certs.erase(it);
       if(cert->getType() == Certificate::Type::Root) {
-        buildRootCa();
+        _root_ca_valid = false;
       }
 
       removeCertificate(cert);
+      saveIndex();
       delete cert;
 
       return true;
@@ -216,7 +361,7 @@ bool CertificateStore::removeCertificate(uint64_t id)
 const char *CertificateStore::getCertificate(uint64_t id)
 {
   Certificate *cert = nullptr;
-  if(findCertificate(id, cert)) {
+  if(findCertificate(id, cert) && cert->load()) {
     return cert->getCert().c_str();
   }
 
@@ -226,7 +371,7 @@ const char *CertificateStore::getCertificate(uint64_t id)
 const char *CertificateStore::getKey(uint64_t id)
 {
   Certificate *cert = nullptr;
-  if(findCertificate(id, cert)) {
+  if(findCertificate(id, cert) && cert->load()) {
     return cert->getKey().c_str();
   }
 
@@ -236,7 +381,7 @@ const char *CertificateStore::getKey(uint64_t id)
 bool CertificateStore::getCertificate(uint64_t id, std::string &certificate)
 {
   Certificate *cert = nullptr;
-  if(findCertificate(id, cert)) {
+  if(findCertificate(id, cert) && cert->load()) {
     certificate = cert->getCert();
     return true;
   }
@@ -247,7 +392,7 @@ bool CertificateStore::getCertificate(uint64_t id, std::string &certificate)
 bool CertificateStore::getKey(uint64_t id, std::string &key)
 {
   Certificate *cert = nullptr;
-  if(findCertificate(id, cert)) {
+  if(findCertificate(id, cert) && cert->load()) {
     key = cert->getKey();
     return true;
   }
@@ -309,11 +454,13 @@ bool CertificateStore::findCertificate(uint64_t id, int &index)
 
 bool CertificateStore::buildRootCa()
 {
+  _root_ca_valid = true;
+
   size_t len = 1;
   for(auto &c : _certs)
   {
     if(c->getType() == Certificate::Type::Root) {
-      len += c->getCert().length();
+      len += c->getCertLength();
     }
   }
 
@@ -321,7 +468,7 @@ bool CertificateStore::buildRootCa()
   DBUGF("%p != %p", _root_ca, root_ca);
 
   if(_root_ca != root_ca) {
-    delete _root_ca;
+    delete [] _root_ca;
   }
 
   if(len <= 1)
@@ -346,13 +493,19 @@ bool CertificateStore::buildRootCa()
   memcpy(ptr, root_ca, root_ca_len);
   ptr += root_ca_len;
 
+  // Read the PEM bodies straight into the bundle
   for(auto &c : _certs)
   {
-    if(c->getType() == Certificate::Type::Root) {
-      strcpy(ptr, c->getCert().c_str());
-      ptr += c->getCert().length();
+    if(c->getType() == Certificate::Type::Root)
+    {
+      if(c->readCert(ptr)) {
+        ptr += c->getCertLength();
+      } else {
+        DBUGF("Failed to read certificate %llx", c->getId());
+      }
     }
   }
+  *ptr = '\0';
 
   DBUGLN("Using custom root certificates");
   _root_ca = new_root_ca;
@@ -361,95 +514,155 @@ bool CertificateStore::buildRootCa()
 
 bool CertificateStore::loadCertificates()
 {
-  bool loaded = true;
+  if(!LittleFS.exists(CERTIFICATE_BASE_DIRECTORY)) {
+    LittleFS.mkdir(CERTIFICATE_BASE_DIRECTORY);
+    return true;
+  }
+
+  bool loaded = loadIndex();
 
+  // Convert certificates saved as JSON by older firmware, this is the only
+  // time they are parsed and validated at boot
+  std::vector<String> legacy;
   File certificateDir = LittleFS.open(CERTIFICATE_BASE_DIRECTORY);
   if(certificateDir && certificateDir.isDirectory())
   {
     File file = certificateDir.openNextFile();
     while(file)
     {
-      if(!file.isDirectory())
-      {
-        String name = file.name();
-        DBUGVAR(name.c_str());
-        if(false == loadCertificate(name)) {
-          loaded = false;
-        }
+      String name = file.name();
+      if(!file.isDirectory() && name.endsWith(".json")) {
+        legacy.push_back(name);
       }
-
       file = certificateDir.openNextFile();
     }
-  } else {
-    LittleFS.mkdir(CERTIFICATE_BASE_DIRECTORY);
+  }
+
+  for(String &name : legacy)
+  {
+    DBUGVAR(name.c_str());
+    if(false == loadLegacyCertificate(name)) {
+      loaded = false;
+    }
   }
 
   return loaded;
 }
 
-bool CertificateStore::loadCertificate(String &name)
+bool CertificateStore::loadIndex()
 {
-  bool loaded = false;
+  File file = LittleFS.open(CERTIFICATE_INDEX_FILE);
+  if(!file) {
+    return true;
+  }
 
-  String path = String(CERTIFICATE_BASE_DIRECTORY) + "/" + name;
-  DBUGF("Loading certificate %s", path.c_str());
+  size_t size = file.size();
+  std::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+  bool read = data && file.read(data.get(), size) == size;
+  file.close();
 
-  File file = LittleFS.open(path);
-  if(file)
+  std::vector<CertificateIndexEntry> entries;
+  if(!read || !certificate_index_decode(data.get(), size, entries))
   {
-    DynamicJsonDocument doc(CERTIFICATE_JSON_BUFFER_SIZE);
-    DeserializationError err = deserializeJson(doc, file);
-    if(DeserializationError::Code::Ok == err)
-    {
-      //#ifdef ENABLE_DEBUG
-      //DBUG("Certificate loaded: ");
-      //serializeJson(doc, DEBUG_PORT);
-      //DBUGLN("");
-      //#endif
-      loaded = addCertificate(doc, nullptr, false);
+    DEBUG.println(F("Certificate index corrupt, stored certificates ignored"));
+    return false;
+  }
+
+  for(CertificateIndexEntry &entry : entries)
+  {
+    Certificate *cert = new Certificate(entry);
+    if(cert) {
+      _certs.push_back(cert);
     }
 
-    file.close();
+    if(cert && entry.type == Certificate::Type::Root) {
+      _root_ca_valid = false;
+    }
   }
 
-  return loaded;
+  DBUGF("Indexed %u certificates", (unsigned)_certs.size());
+  return true;
 }
 
-bool CertificateStore::saveCertificate(Certificate *cert)
+bool CertificateStore::saveIndex()
 {
-  String name = String(CERTIFICATE_BASE_DIRECTORY) + "/" + String(cert->getId(), HEX) + ".json";
+  std::vector<CertificateIndexEntry> entries(_certs.size());
+  for(size_t i = 0; i < _certs.size(); i++) {
+    _certs[i]->getIndexEntry(entries[i]);
+  }
 
-  DynamicJsonDocument doc(CERTIFICATE_JSON_BUFFER_SIZE);
-  JsonObject object = doc.to<JsonObject>();
-  cert->serialize(object, Certificate::Flags::SHOW_PRIVATE_KEY);
+  std::string data;
+  certificate_index_encode(entries, data);
 
-  // Don't truncate an existing valid cert if the new contents won't fit.
-  if(!littlefs_has_space(measureJson(doc)))
+  if(!littlefs_has_space(data.length()))
   {
-    DBUGLN("Certificates: insufficient space, not saving");
+    DBUGLN("Certificates: insufficient space, not saving index");
     return false;
   }
 
-  File file = LittleFS.open(name, "w");
-  if(!file)
-  {
+  // Write a new copy and swap it in, so a power cut can't lose the whole store
+  String temp = String(CERTIFICATE_INDEX_FILE) + ".new";
+  File file = LittleFS.open(temp, "w");
+  if(!file) {
     return false;
   }
 
-  bool ok = serializeJson(doc, file) > 0;
+  bool ok = file.write((const uint8_t *)data.data(), data.length()) == data.length();
   file.close();
   if(!ok)
   {
-    // Partial write — remove the corrupt file rather than leave it.
-    LittleFS.remove(name);
+    LittleFS.remove(temp);
+    return false;
   }
-  return ok;
+
+  LittleFS.remove(CERTIFICATE_INDEX_FILE);
+  return LittleFS.rename(temp, CERTIFICATE_INDEX_FILE);
+}
+
+bool CertificateStore::loadLegacyCertificate(String &name)
+{
+  bool loaded = false;
+
+  String path = String(CERTIFICATE_BASE_DIRECTORY) + "/" + name;
+  DBUGF("Converting certificate %s", path.c_str());
+
+  File file = LittleFS.open(path);
+  if(file)
+  {
+    DynamicJsonDocument doc(CERTIFICATE_JSON_BUFFER_SIZE);
+    DeserializationError err = deserializeJson(doc, file);
+    file.close();
+
+    Certificate *cert = new Certificate();
+    Certificate *existing = nullptr;
+    if(DeserializationError::Code::Ok == err && cert && cert->deserialize(doc))
+    {
+      // Already converted, the JSON copy was left by an interrupted upgrade
+      if(findCertificate(cert->getId(), existing)) {
+        loaded = true;
+      } else if(addCertificate(cert, nullptr, true)) {
+        cert = nullptr;
+        loaded = true;
+      }
+    }
+    delete cert;
+
+    if(loaded) {
+      LittleFS.remove(path);
+    }
+  }
+
+  return loaded;
+}
+
+bool CertificateStore::saveCertificate(Certificate *cert)
+{
+  return cert->save();
 }
 
 bool CertificateStore::removeCertificate(Certificate *cert)
 {
-  String name = String(CERTIFICATE_BASE_DIRECTORY) + "/" + String(cert->getId(), HEX) + ".json";
-  if(LittleFS.remove(name))
+  if(LittleFS.remove(cert->getPath()))
   {
     return true;
   }
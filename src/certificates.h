@@ -7,6 +7,14 @@
 #include <vector>
 
 #include "json_serialize.h"
+#include "certificate_index.h"
+
+// Certificates are stored as a compact index (certificate_index.h) plus one
+// PEM body file per certificate. Only the index is read at boot, bodies are
+// read when first needed and the root CA bundle is assembled on first use.
+#ifndef CERTIFICATE_INDEX_FILE
+#define CERTIFICATE_INDEX_FILE CERTIFICATE_BASE_DIRECTORY "/index"
+#endif
 
 class CertificateStore
 {
@@ -58,35 +66,86 @@ class CertificateStore
         std::string _cert;
         std::string _key;
 
+        // Location of the bodies in the certificate's file, see certificate_index.h
+        uint32_t _certOffset;
+        uint32_t _certLen;
+        uint32_t _keyOffset;
+        uint32_t _keyLen;
+        bool _loaded;
+
       public:
-        Certificate(const char *cert, const char *key) :
+        Certificate(const char *name, const char *cert, const char *key) :
           JsonSerialize(),
           _type(Type::Client),
-          _name(""),
+          _id(0),
+          _name(name),
           _cert(cert),
-          _key(key)
+          _key(key),
+          _certOffset(0),
+          _certLen(0),
+          _keyOffset(0),
+          _keyLen(0),
+          _loaded(true)
         { }
 
-        Certificate(const char *cert) :
+        Certificate(const char *name, const char *cert) :
           JsonSerialize(),
           _type(Type::Root),
-          _name(""),
+          _id(0),
+          _name(name),
           _cert(cert),
-          _key("")
+          _key(""),
+          _certOffset(0),
+          _certLen(0),
+          _keyOffset(0),
+          _keyLen(0),
+          _loaded(true)
         { }
 
         Certificate() :
           JsonSerialize(),
           _type(Type::Invalid),
+          _id(0),
           _name(""),
           _cert(""),
-          _key("")
+          _key(""),
+          _certOffset(0),
+          _certLen(0),
+          _keyOffset(0),
+          _keyLen(0),
+          _loaded(true)
+        { }
+
+        // An indexed certificate, bodies are read from the file on demand
+        Certificate(const CertificateIndexEntry &entry) :
+          JsonSerialize(),
+          _type((Type::Value)entry.type),
+          _id(entry.id),
+          _name(entry.name),
+          _cert(""),
+          _key(""),
+          _certOffset(entry.cert_offset),
+          _certLen(entry.cert_len),
+          _keyOffset(entry.key_offset),
+          _keyLen(entry.key_len),
+          _loaded(false)
         { }
 
         uint64_t getId() const { return _id; }
         Type getType() const { return _type; }
-        std::string &getCert() { return _cert; };
-        std::string &getKey() { return _key; }
+        std::string &getCert() { load(); return _cert; };
+        std::string &getKey() { load(); return _key; }
+        size_t getCertLength() const { return _loaded ? _cert.length() : _certLen; }
+
+        String getPath() const;
+        bool load();
+        void unload();
+        // Copy the certificate PEM to dest, without keeping it in RAM
+        bool readCert(char *dest);
+
+        // Write the bodies to the certificate's file and record where they are
+        bool save();
+        void getIndexEntry(CertificateIndexEntry &entry) const;
 
         using JsonSerialize::deserialize;
         virtual bool deserialize(JsonObject &obj);
@@ -100,6 +159,7 @@ class CertificateStore
   private:
     std::vector<Certificate *> _certs;
     const char *_root_ca;
+    bool _root_ca_valid;
 
   public:
     CertificateStore();
@@ -126,8 +186,10 @@ class CertificateStore
 
   private:
     bool loadCertificates();
+    bool loadIndex();
+    bool saveIndex();
 
-    bool loadCertificate(String &name);
+    bool loadLegacyCertificate(String &name);
     bool saveCertificate(Certificate *cert);
     bool removeCertificate(Certificate *cert);
 
@@ -0,0 +1,148 @@
+#include <string.h>
+
+#include "claim_order.h"
+
+ClaimOrder::ClaimOrder()
+{
+  clear();
+}
+
+void ClaimOrder::clear()
+{
+  _count = 0;
+  for(uint8_t i = 0; i < EVSE_MANAGER_MAX_CLIENT_CLAIMS; i++) {
+    _priority[i] = 0;
+    _sets[i] = 0;
+  }
+  for(uint8_t p = 0; p < CLAIM_PROPERTY_COUNT; p++) {
+    _winner[p] = CLAIM_SLOT_NONE;
+    _winnerPriority[p] = 0;
+  }
+}
+
+bool ClaimOrder::contains(uint8_t slot) const
+{
+  for(uint8_t i = 0; i < _count; i++)
+  {
+    if(_order[i] == slot) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ClaimOrder::set(uint8_t slot, int priority, uint8_t sets)
+{
+  if(slot >= EVSE_MANAGER_MAX_CLIENT_CLAIMS) {
+    return;
+  }
+
+  bool valid = contains(slot);
+  if(valid && _priority[slot] == priority) {
+    // Same place in the order
+    _sets[slot] = sets;
+    return;
+  }
+
+  if(valid) {
+    erase(slot);
+  }
+  _priority[slot] = priority;
+  _sets[slot] = sets;
+  insert(slot);
+}
+
+void ClaimOrder::remove(uint8_t slot)
+{
+  if(erase(slot)) {
+    _sets[slot] = 0;
+  }
+}
+
+void ClaimOrder::insert(uint8_t slot)
+{
+  int priority = _priority[slot];
+
+  // Equal priorities keep slot order so the same claim wins as when the slots
+  // were scanned in order
+  uint8_t pos = 0;
+  while(pos < _count &&
+        (_priority[_order[pos]] > priority ||
+         (_priority[_order[pos]] == priority && _order[pos] < slot)))
+  {
+    pos++;
+  }
+
+  memmove(&_order[pos + 1], &_order[pos], _count - pos);
+  _order[pos] = slot;
+  _count++;
+}
+
+bool ClaimOrder::erase(uint8_t slot)
+{
+  for(uint8_t i = 0; i < _count; i++)
+  {
+    if(_order[i] == slot)
+    {
+      memmove(&_order[i], &_order[i + 1], _count - i - 1);
+      _count--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ClaimOrder::evaluate()
+{
+  uint8_t unset = 0;
+  for(uint8_t p = 0; p < CLAIM_PROPERTY_COUNT; p++) {
+    _winner[p] = CLAIM_SLOT_NONE;
+    _winnerPriority[p] = 0;
+    unset |= CLAIM_SETS(p);
+  }
+
+  // Highest priority first, so the first claim asking for a property wins it
+  // and we can stop once they all have a winner
+  for(uint8_t i = 0; i < _count && unset; i++)
+  {
+    uint8_t slot = _order[i];
+    if(_priority[slot] <= 0) {
+      break;
+    }
+
+    uint8_t wins = _sets[slot] & unset;
+    for(uint8_t p = 0; p < CLAIM_PROPERTY_COUNT; p++)
+    {
+      if(wins & CLAIM_SETS(p)) {
+        _winner[p] = slot;
+        _winnerPriority[p] = _priority[slot];
+      }
+    }
+    unset &= ~wins;
+  }
+}
+
+bool ClaimOrder::affects(uint8_t slot) const
+{
+  if(!contains(slot)) {
+    return false;
+  }
+
+  for(uint8_t p = 0; p < CLAIM_PROPERTY_COUNT; p++)
+  {
+    if(_winner[p] == slot) {
+      return true;
+    }
+
+    // Equal priority may still win on a lower slot
+    if((_sets[slot] & CLAIM_SETS(p)) && _priority[slot] > 0 &&
+       _priority[slot] >= _winnerPriority[p])
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
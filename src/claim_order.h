@@ -0,0 +1,84 @@
+#ifndef _OPENEVSE_CLAIM_ORDER_H
+#define _OPENEVSE_CLAIM_ORDER_H
+
+// Priority order of the EvseManager claims and the winner of each target
+// property.
+//
+// EvseManager keeps its claims in fixed slots. This indexes the valid ones
+// highest priority first, ties in slot order, so the winner of a property is
+// the first claim asking for it and evaluation can stop once every property
+// has one. It also answers whether changing or releasing a claim could move
+// any winner, so one that can't doesn't need the claims evaluating again.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+
+#include <stdint.h>
+
+// Claim slots, one per client. Override with -D to leave room for more
+// integrations, at most 255.
+#ifndef EVSE_MANAGER_MAX_CLIENT_CLAIMS
+#define EVSE_MANAGER_MAX_CLIENT_CLAIMS 16
+#endif // !EVSE_MANAGER_MAX_CLIENT_CLAIMS
+
+static_assert(EVSE_MANAGER_MAX_CLIENT_CLAIMS <= UINT8_MAX, "claim slots are indexed by uint8_t");
+
+enum ClaimProperty : uint8_t
+{
+  CLAIM_PROPERTY_STATE = 0,
+  CLAIM_PROPERTY_CHARGE_CURRENT,
+  CLAIM_PROPERTY_MAX_CURRENT,
+  CLAIM_PROPERTY_COUNT
+};
+
+// Bit for a property in the mask of those a claim asks for
+#define CLAIM_SETS(property) ((uint8_t)(1 << (property)))
+
+// No claim, or no winner
+#define CLAIM_SLOT_NONE UINT8_MAX
+
+class ClaimOrder
+{
+  public:
+    ClaimOrder();
+
+    // Add the claim in slot, or update it. sets is the CLAIM_SETS() mask of
+    // the properties it asks for.
+    void set(uint8_t slot, int priority, uint8_t sets);
+    void remove(uint8_t slot);
+    void clear();
+
+    bool contains(uint8_t slot) const;
+
+    // The valid claims, index 0 the highest priority
+    uint8_t count() const { return _count; }
+    uint8_t slot(uint8_t index) const { return _order[index]; }
+
+    // Pick the winner of each property, the highest priority claim asking
+    // for it, the lowest slot of equal priorities. A claim needs a priority
+    // above 0 to win.
+    void evaluate();
+
+    // As of the last evaluate(), CLAIM_SLOT_NONE and 0 when nothing won
+    uint8_t winner(ClaimProperty property) const { return _winner[property]; }
+    int winnerPriority(ClaimProperty property) const { return _winnerPriority[property]; }
+
+    // Could the claim in slot, as it was last set, change what the last
+    // evaluate() picked: it won a property, or asks for one at a priority
+    // that could take it. False for an empty slot.
+    bool affects(uint8_t slot) const;
+
+  private:
+    uint8_t _order[EVSE_MANAGER_MAX_CLIENT_CLAIMS];
+    uint8_t _count;
+
+    int _priority[EVSE_MANAGER_MAX_CLIENT_CLAIMS];
+    uint8_t _sets[EVSE_MANAGER_MAX_CLIENT_CLAIMS];
+
+    uint8_t _winner[CLAIM_PROPERTY_COUNT];
+    int _winnerPriority[CLAIM_PROPERTY_COUNT];
+
+    void insert(uint8_t slot);
+    bool erase(uint8_t slot);
+};
+
+#endif // _OPENEVSE_CLAIM_ORDER_H
@@ -4,22 +4,42 @@
 
 static const size_t BLOCK = 64;
 
-void hmac_sha256(const uint8_t *key, size_t key_len,
-                 const uint8_t *msg, size_t msg_len, uint8_t out[32]) {
+void hmac_sha256_key_init(HmacSha256Key &key, const uint8_t *secret, size_t secret_len) {
   uint8_t k[BLOCK]; std::memset(k, 0, BLOCK);
-  if(key_len > BLOCK) { sha256(key, key_len, k); }
-  else { std::memcpy(k, key, key_len); }
+  if(secret_len > BLOCK) { sha256(secret, secret_len, k); }
+  else { std::memcpy(k, secret, secret_len); }
 
   uint8_t ipad[BLOCK], opad[BLOCK];
   for(size_t i = 0; i < BLOCK; i++) { ipad[i] = k[i] ^ 0x36; opad[i] = k[i] ^ 0x5c; }
 
-  // inner = SHA256(ipad || msg)
+  oevse_sha256_init(&key.inner);
+  oevse_sha256_update(&key.inner, ipad, BLOCK);
+  oevse_sha256_init(&key.outer);
+  oevse_sha256_update(&key.outer, opad, BLOCK);
+
+  std::memset(k, 0, BLOCK);
+  std::memset(ipad, 0, BLOCK);
+  std::memset(opad, 0, BLOCK);
+}
+
+void hmac_sha256_with_key(const HmacSha256Key &key,
+                          const uint8_t *msg, size_t msg_len, uint8_t out[32]) {
+  // inner = SHA256(ipad || msg), resumed from the saved midstate
   uint8_t inner[32];
-  { std::string buf; buf.assign((char*)ipad, BLOCK); buf.append((char*)msg, msg_len);
-    sha256((const uint8_t*)buf.data(), buf.size(), inner); }
+  oevse_sha256_ctx ctx = key.inner;
+  oevse_sha256_update(&ctx, msg, msg_len);
+  oevse_sha256_final(&ctx, inner);
   // out = SHA256(opad || inner)
-  { std::string buf; buf.assign((char*)opad, BLOCK); buf.append((char*)inner, 32);
-    sha256((const uint8_t*)buf.data(), buf.size(), out); }
+  ctx = key.outer;
+  oevse_sha256_update(&ctx, inner, 32);
+  oevse_sha256_final(&ctx, out);
+}
+
+void hmac_sha256(const uint8_t *key, size_t key_len,
+                 const uint8_t *msg, size_t msg_len, uint8_t out[32]) {
+  HmacSha256Key schedule;
+  hmac_sha256_key_init(schedule, key, key_len);
+  hmac_sha256_with_key(schedule, msg, msg_len, out);
 }
 
 std::string hmac_sha256_hex(const std::string &key, const std::string &msg) {
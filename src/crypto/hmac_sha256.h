@@ -3,6 +3,20 @@
 #include <string>
 #include <cstdint>
 #include <cstddef>
+#include "crypto/sha256.h"
+
+// Precomputed HMAC key schedule: the SHA-256 midstates after absorbing the
+// ipad/opad blocks. Deriving it once per key saves two block transforms and
+// the pad setup on every MAC.
+struct HmacSha256Key {
+  oevse_sha256_ctx inner;
+  oevse_sha256_ctx outer;
+};
+
+void hmac_sha256_key_init(HmacSha256Key &key, const uint8_t *secret, size_t secret_len);
+void hmac_sha256_with_key(const HmacSha256Key &key,
+                          const uint8_t *msg, size_t msg_len, uint8_t out[32]);
+
 void hmac_sha256(const uint8_t *key, size_t key_len,
                  const uint8_t *msg, size_t msg_len, uint8_t out[32]);
 std::string hmac_sha256_hex(const std::string &key, const std::string &msg);
@@ -40,12 +40,7 @@ static const uint32_t K[64] = {
 #define SIG0(x) (ROTRIGHT(x,7)  ^ ROTRIGHT(x,18) ^ ((x) >> 3))
 #define SIG1(x) (ROTRIGHT(x,17) ^ ROTRIGHT(x,19) ^ ((x) >> 10))
 
-typedef struct {
-    uint8_t  data[64];
-    uint32_t datalen;
-    uint64_t bitlen;
-    uint32_t state[8];
-} SHA256_CTX;
+typedef oevse_sha256_ctx SHA256_CTX;
 
 static void sha256_transform(SHA256_CTX *ctx, const uint8_t data[])
 {
@@ -153,3 +148,19 @@ void sha256(const uint8_t *data, size_t len, uint8_t out[32])
     sha256_update(&ctx, data, len);
     sha256_final(&ctx, out);
 }
+
+/* Public incremental API. */
+void oevse_sha256_init(oevse_sha256_ctx *ctx)
+{
+    sha256_init(ctx);
+}
+
+void oevse_sha256_update(oevse_sha256_ctx *ctx, const uint8_t *data, size_t len)
+{
+    sha256_update(ctx, data, len);
+}
+
+void oevse_sha256_final(oevse_sha256_ctx *ctx, uint8_t out[32])
+{
+    sha256_final(ctx, out);
+}
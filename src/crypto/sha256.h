@@ -12,6 +12,20 @@
 extern "C" {
 #endif
 void sha256(const uint8_t *data, size_t len, uint8_t out[32]);
+
+/* Incremental API. The context may be copied by value to resume hashing from
+   a saved midstate (used by the HMAC key schedule). Prefixed to stay clear of
+   the SDK's own sha256_* symbols. */
+typedef struct {
+    uint8_t  data[64];
+    uint32_t datalen;
+    uint64_t bitlen;
+    uint32_t state[8];
+} oevse_sha256_ctx;
+
+void oevse_sha256_init(oevse_sha256_ctx *ctx);
+void oevse_sha256_update(oevse_sha256_ctx *ctx, const uint8_t *data, size_t len);
+void oevse_sha256_final(oevse_sha256_ctx *ctx, uint8_t out[32]);
 #ifdef __cplusplus
 }
 #endif
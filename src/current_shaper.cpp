@@ -16,6 +16,7 @@ CurrentShaperTask::CurrentShaperTask() : MicroTasks::Task() {
 	_pause_timer = 0;
 	_timer = 0;
 	_updated = false;
+	_limiting_phase = 0;
 }
 
 CurrentShaperTask::~CurrentShaperTask() {
@@ -30,6 +31,7 @@ void CurrentShaperTask::setup() {
 }
 
 unsigned long CurrentShaperTask::loop(MicroTasks::WakeReason reason) {
+	Profile_Scope("CurrentShaperTask");
 
 	if (_enabled) {
 			EvseProperties props;
@@ -61,13 +63,19 @@ unsigned long CurrentShaperTask::loop(MicroTasks::WakeReason reason) {
 					int priority = (_timer_controlled && !config_current_shaper_enabled())
 					               ? EvseManager_Priority_TimerFeature : EvseManager_Priority_Safety;
 					_evse->claim(EvseClient_OpenEVSE_Shaper, priority, props);
-					StaticJsonDocument<128> event;
+					StaticJsonDocument<256> event;
 					event["shaper"] = 1;
 					event["shaper_live_pwr"] = _live_pwr;
 					event["shaper_smoothed_live_pwr"] = _smoothed_live_pwr;
 					event["shaper_max_pwr"] = _max_pwr;
 					event["shaper_cur"] = _max_cur;
 					event["shaper_updated"] = _updated;
+					event["shaper_limiting_phase"] = _limiting_phase;
+					if (_limiting_phase) {
+						event["shaper_live_current_l1"] = _phases.current(0);
+						event["shaper_live_current_l2"] = _phases.current(1);
+						event["shaper_live_current_l3"] = _phases.current(2);
+					}
 					event_send(event);
 				}
 			}
@@ -150,6 +158,22 @@ void CurrentShaperTask::setLivePwr(int live_pwr) {
 	shapeCurrent();
 }
 
+void CurrentShaperTask::setLivePhasePwr(uint8_t phase, int live_pwr) {
+	if (phase < 1 || phase > PHASE_LOAD_PHASES) {
+		return;
+	}
+	_phases.setPower(phase - 1, live_pwr, _evse->getVoltage(), millis());
+	shapeCurrent();
+}
+
+void CurrentShaperTask::setLivePhaseCurrent(uint8_t phase, double live_current) {
+	if (phase < 1 || phase > PHASE_LOAD_PHASES) {
+		return;
+	}
+	_phases.setCurrent(phase - 1, live_current, millis());
+	shapeCurrent();
+}
+
 // temporary change Current Shaper state without changing configuration
 void CurrentShaperTask::setState(bool state) {
 	_enabled = state;
@@ -177,43 +201,61 @@ void CurrentShaperTask::setTimerEnabled(bool active) {
 }
 
 void CurrentShaperTask::shapeCurrent() {
-	_updated = true;
+	uint32_t now = millis();
+	uint32_t max_age = current_shaper_data_maxinterval * 1000;
+	double voltage = _evse->getVoltage();
+	double amps = _evse->getAmps();
+	double phases = config_threephase_enabled() ? 3.0 : 1.0;
+
 	// adding self produced energy to total
 	int max_pwr = _max_pwr;
+	if (config_divert_enabled() == true) {
+		if ( divert_type == DIVERT_TYPE_SOLAR ) {
+			max_pwr += divert.getSolar();
+		}
+	}
+
+	int live_pwr = _live_pwr;
+	_limiting_phase = 0;
+	if (_phases.active(now, max_age)) {
+		if (!_phases.valid(now, max_age)) {
+			// Don't shape on a partial picture, if a phase has stopped
+			// reporting the failsafe in loop() pauses the charge
+			return;
+		}
+
+		// max_pwr is shared evenly between the phases and the most loaded
+		// phase the EVSE is on sets the current. Turn that back into the
+		// total live power that would give the same current so the
+		// smoothing below works as it does for a single reading.
+		uint8_t limiting;
+		double max_cur = _phases.available(max_pwr / 3.0 / voltage, amps,
+		                                   PhaseLoad::phaseMask(config_threephase_enabled(), evse_phase),
+		                                   &limiting);
+		_limiting_phase = limiting + 1;
+		_live_pwr = _phases.total() * voltage;
+		live_pwr = max_pwr - (max_cur - amps) * voltage * phases;
+	}
+
+	_updated = true;
 
 	int livepwr;
 	DBUGVAR(_pause_timer);
 	if (_pause_timer == 0) {
-		_smoothed_live_pwr = _live_pwr;
-		livepwr = _live_pwr;
+		_smoothed_live_pwr = live_pwr;
+		livepwr = live_pwr;
 	}
 	else {
-		if (_live_pwr > _smoothed_live_pwr) {
-			_smoothed_live_pwr = _live_pwr;
+		if (live_pwr > _smoothed_live_pwr) {
+			_smoothed_live_pwr = live_pwr;
 		}
 		else {
-			_smoothed_live_pwr = _inputFilter.filter(_live_pwr, _smoothed_live_pwr, current_shaper_smoothing_time);
+			_smoothed_live_pwr = _inputFilter.filter(live_pwr, _smoothed_live_pwr, current_shaper_smoothing_time);
 		}
 		livepwr = _smoothed_live_pwr;
 	}
 
-	if (config_divert_enabled() == true) {
-		if ( divert_type == DIVERT_TYPE_SOLAR ) {
-			max_pwr += divert.getSolar();
-		}
-	}
-//	if (livepwr > max_pwr) {
-//		livepwr = max_pwr;
-//	}
-	if(!config_threephase_enabled()) {
-		_max_cur = ((max_pwr - livepwr) / _evse->getVoltage()) + _evse->getAmps();
-	 }
-
-	else {
-		_max_cur = ((max_pwr - livepwr) / _evse->getVoltage() / 3.0) + _evse->getAmps();
-	}
-
-
+	_max_cur = ((max_pwr - livepwr) / voltage / phases) + amps;
 
 	_changed = true;
 }
@@ -231,6 +273,21 @@ int CurrentShaperTask::getSmoothedLivePwr() {
 double CurrentShaperTask::getMaxCur() {
 	return _max_cur;
 }
+bool CurrentShaperTask::hasPhaseData() {
+	return _limiting_phase != 0;
+}
+
+double CurrentShaperTask::getLivePhaseCurrent(uint8_t phase) {
+	if (phase < 1 || phase > PHASE_LOAD_PHASES) {
+		return 0;
+	}
+	return _phases.current(phase - 1);
+}
+
+uint8_t CurrentShaperTask::getLimitingPhase() {
+	return _limiting_phase;
+}
+
 bool CurrentShaperTask::getState() {
 	return _enabled;
 }
@@ -23,6 +23,7 @@
 #include "event.h"
 #include "divert.h"
 #include "input_filter.h"
+#include "phase_load.h"
 
 class CurrentShaperTask: public MicroTasks::Task
 {
@@ -40,6 +41,8 @@ class CurrentShaperTask: public MicroTasks::Task
     uint32_t     _pause_timer;
     bool         _updated;
     InputFilter  _inputFilter;
+    PhaseLoad    _phases;    // per-phase site load, when the meter reports it
+    uint8_t      _limiting_phase; // 1-3, the phase setting _max_cur, 0 if shaping on the total
 
   protected:
     void setup();
@@ -52,12 +55,18 @@ class CurrentShaperTask: public MicroTasks::Task
     void shapeCurrent();
     void setMaxPwr(int max_pwr);
     void setLivePwr(int live_pwr);
+    // Site load on one phase, phase 1 to 3
+    void setLivePhasePwr(uint8_t phase, int live_pwr);
+    void setLivePhaseCurrent(uint8_t phase, double live_current);
     void setState(bool state);
     bool getState();
     int getMaxPwr();
     int getLivePwr();
     int getSmoothedLivePwr();
     double getMaxCur();
+    bool hasPhaseData();
+    double getLivePhaseCurrent(uint8_t phase);
+    uint8_t getLimitingPhase();
     bool isActive();
     bool isUpdated();
 
@@ -0,0 +1,157 @@
+#include "display_model.h"
+
+#include <string.h>
+
+// millis() comparisons that survive the 49 day wrap
+static bool time_reached(uint32_t now, uint32_t when)
+{
+  return (int32_t)(now - when) >= 0;
+}
+
+DisplayMessageQueue::DisplayMessageQueue() :
+  _count(0),
+  _nextTime(0),
+  _holdUntil(0),
+  _holdPriority(DISPLAY_PRIORITY_NORMAL),
+  _held(false),
+  _dropped(0)
+{
+}
+
+void DisplayMessageQueue::remove(size_t index)
+{
+  memmove(&_queue[index], &_queue[index + 1], (_count - index - 1) * sizeof(DisplayMessage));
+  _count--;
+}
+
+void DisplayMessageQueue::push(const char *text, int x, int y, uint32_t time, bool clear,
+                               uint8_t priority, bool now, uint32_t millis)
+{
+  if(now)
+  {
+    for(size_t i = _count; i > 0; i--) {
+      if(_queue[i - 1].priority <= priority) {
+        remove(i - 1);
+      }
+    }
+  }
+
+  bool wasEmpty = 0 == _count;
+
+  if(DISPLAY_MESSAGE_QUEUE_SIZE == _count)
+  {
+    // Make room by dropping the newest of the lowest priority, or this one
+    size_t victim = _count - 1;
+    for(size_t i = 0; i < _count; i++) {
+      if(_queue[i].priority < _queue[victim].priority) {
+        victim = i;
+      }
+    }
+    _dropped++;
+    if(_queue[victim].priority > priority) {
+      return;
+    }
+    remove(victim);
+  }
+
+  // After everything of the same or higher priority, keeps the order within a
+  // priority so multi-line messages stay together
+  size_t pos = 0;
+  while(pos < _count && _queue[pos].priority >= priority) {
+    pos++;
+  }
+  memmove(&_queue[pos + 1], &_queue[pos], (_count - pos) * sizeof(DisplayMessage));
+  _count++;
+
+  DisplayMessage &msg = _queue[pos];
+  strncpy(msg.text, text ? text : "", DISPLAY_MESSAGE_LEN);
+  msg.text[DISPLAY_MESSAGE_LEN] = '\0';
+  msg.x = (int8_t)x;
+  msg.y = (int8_t)y;
+  msg.clear = clear;
+  msg.priority = priority;
+  msg.time = time;
+  msg.queued = millis;
+
+  // A message arriving at an idle queue is shown straight away, the same as
+  // now, unless something more important is holding the display
+  if(wasEmpty || now)
+  {
+    _nextTime = (holding(millis) && _holdPriority > priority) ? _holdUntil : millis;
+  }
+}
+
+bool DisplayMessageQueue::pop(uint32_t millis, DisplayMessage &msg)
+{
+  while(_count > 0 && time_reached(millis, _nextTime))
+  {
+    msg = _queue[0];
+    remove(0);
+
+    if(millis - msg.queued > DISPLAY_MESSAGE_EXPIRY) {
+      _dropped++;
+      continue;
+    }
+
+    _holdUntil = millis + msg.time;
+    _holdPriority = msg.priority;
+    _held = true;
+    _nextTime = _holdUntil;
+    return true;
+  }
+
+  return false;
+}
+
+bool DisplayMessageQueue::holding(uint32_t millis) const
+{
+  return _held && !time_reached(millis, _holdUntil);
+}
+
+uint32_t DisplayMessageQueue::nextChange(uint32_t millis) const
+{
+  if(_count > 0) {
+    return time_reached(millis, _nextTime) ? 0 : _nextTime - millis;
+  }
+  if(holding(millis)) {
+    return _holdUntil - millis;
+  }
+  return DISPLAY_MESSAGE_IDLE;
+}
+
+void DisplayMessageQueue::clear()
+{
+  _count = 0;
+  _held = false;
+}
+
+uint32_t DisplayState::diff(const DisplayState &other) const
+{
+  uint32_t changed = 0;
+
+  if(evse_state != other.evse_state ||
+     pilot_state != other.pilot_state ||
+     flags != other.flags ||
+     state_client != other.state_client ||
+     vehicle_connected != other.vehicle_connected ||
+     active != other.active)
+  {
+    changed |= DISPLAY_CHANGED_STATE;
+  }
+
+  if(charge_current != other.charge_current ||
+     amps != other.amps ||
+     voltage != other.voltage ||
+     power != other.power ||
+     session_energy != other.session_energy ||
+     session_elapsed != other.session_elapsed ||
+     temperature_valid != other.temperature_valid ||
+     temperature != other.temperature ||
+     total_day != other.total_day ||
+     total_energy != other.total_energy)
+  {
+    changed |= DISPLAY_CHANGED_VALUES;
+  }
+
+  return changed;
+}
@@ -0,0 +1,121 @@
+#ifndef DISPLAY_MODEL_H
+#define DISPLAY_MODEL_H
+
+// Display model shared by the character LCD, TFT and LVGL LcdTask backends.
+//
+// DisplayMessageQueue holds the transient messages queued through
+// LcdTask::display(), ordered by priority, dropped if they wait too long to
+// be shown. DisplayState is a snapshot of the EVSE values the screens show,
+// captured once per EVSE event so a backend can tell what changed, and only
+// redraw then, instead of polling EvseManager on a timer.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Longest message text kept, backends truncate to their own line length
+#define DISPLAY_MESSAGE_LEN 64
+
+#ifndef DISPLAY_MESSAGE_QUEUE_SIZE
+#define DISPLAY_MESSAGE_QUEUE_SIZE 8
+#endif
+
+// Messages still queued after this long are stale and dropped unshown
+#ifndef DISPLAY_MESSAGE_EXPIRY
+#define DISPLAY_MESSAGE_EXPIRY (60 * 1000)
+#endif
+
+// nextChange() when there is nothing left to do
+#define DISPLAY_MESSAGE_IDLE UINT32_MAX
+
+enum DisplayPriority : uint8_t
+{
+  DISPLAY_PRIORITY_NORMAL = 0,
+  DISPLAY_PRIORITY_HIGH = 1     // OTA progress, factory reset, ...
+};
+
+struct DisplayMessage
+{
+  char text[DISPLAY_MESSAGE_LEN + 1];
+  int8_t x;
+  int8_t y;
+  bool clear;
+  uint8_t priority;
+  uint32_t time;                // ms the message holds the display
+  uint32_t queued;              // millis() when queued
+};
+
+class DisplayMessageQueue
+{
+  public:
+    DisplayMessageQueue();
+
+    // Queue a message. With now set, queued messages of the same or lower
+    // priority are dropped and this one is shown next, unless a higher
+    // priority message is still holding the display
+    void push(const char *text, int x, int y, uint32_t time, bool clear,
+              uint8_t priority, bool now, uint32_t millis);
+
+    // Take the next message if it is due
+    bool pop(uint32_t millis, DisplayMessage &msg);
+
+    // A popped message is still within its display time
+    bool holding(uint32_t millis) const;
+
+    // ms until the next pop() or until the holding message ends,
+    // DISPLAY_MESSAGE_IDLE if neither
+    uint32_t nextChange(uint32_t millis) const;
+
+    bool empty() const { return 0 == _count; }
+    size_t size() const { return _count; }
+    uint32_t dropped() const { return _dropped; }
+    void clear();
+
+  private:
+    void remove(size_t index);
+
+    DisplayMessage _queue[DISPLAY_MESSAGE_QUEUE_SIZE];
+    size_t _count;
+    uint32_t _nextTime;         // earliest time the head may be shown
+    uint32_t _holdUntil;
+    uint8_t _holdPriority;
+    bool _held;
+    uint32_t _dropped;
+};
+
+#define DISPLAY_CHANGED_STATE   (1 << 0)  // EVSE/pilot state, flags, controlling client, vehicle
+#define DISPLAY_CHANGED_VALUES  (1 << 1)  // live readings
+// Not from diff(), for backends to pass on with the above
+#define DISPLAY_CHANGED_MESSAGE (1 << 2)  // message lines
+#define DISPLAY_CHANGED_NETWORK (1 << 3)  // WiFi mode
+
+struct DisplayState
+{
+  uint8_t evse_state = 0;
+  uint8_t pilot_state = 0;
+  uint32_t flags = 0;
+  uint32_t state_client = 0;
+  bool vehicle_connected = false;
+  bool active = false;          // the claims leave the EVSE active
+
+  long charge_current = 0;      // A
+  double amps = 0;
+  double voltage = 0;
+  double power = 0;             // W
+  double session_energy = 0;    // Wh
+  uint32_t session_elapsed = 0; // s
+  bool temperature_valid = false;
+  double temperature = 0;       // Celsius
+  double total_day = 0;         // kWh
+  double total_energy = 0;      // kWh
+
+  // DISPLAY_CHANGED_* bits that differ from other
+  uint32_t diff(const DisplayState &other) const;
+};
+
+// Fill a snapshot from the EVSE, firmware builds only
+class EvseManager;
+void display_state_capture(EvseManager &evse, DisplayState &state);
+
+#endif // DISPLAY_MODEL_H
@@ -0,0 +1,23 @@
+#include "display_model.h"
+#include "evse_man.h"
+
+void display_state_capture(EvseManager &evse, DisplayState &state)
+{
+  state.evse_state = evse.getEvseState();
+  state.pilot_state = evse.getPilotState();
+  state.flags = evse.getFlags();
+  state.state_client = evse.getStateClient();
+  state.vehicle_connected = evse.isVehicleConnected();
+  state.active = evse.isActive();
+
+  state.charge_current = evse.getChargeCurrent();
+  state.amps = evse.getAmps();
+  state.voltage = evse.getVoltage();
+  state.power = evse.getPower();
+  state.session_energy = evse.getSessionEnergy();
+  state.session_elapsed = evse.getSessionElapsed();
+  state.temperature_valid = evse.isTemperatureValid(EVSE_MONITOR_TEMP_MONITOR);
+  state.temperature = state.temperature_valid ? evse.getTemperature(EVSE_MONITOR_TEMP_MONITOR) : 0;
+  state.total_day = evse.getTotalDay();
+  state.total_energy = evse.getTotalEnergy();
+}
@@ -35,6 +35,10 @@
 // Once charging begins it will not pause before a minimum amount of time has passed and this even if solar PV / excess power drops less then minimum charge rate.
 // This avoids wear on the relay and the car.
 
+// While charging, the pilot is not moved for every reading: DivertPilotPlanner applies a hysteresis band, a
+// minimum time between changes and optionally a look-ahead on the smoothed trend (divert_pilot_* settings),
+// see divert_planner.h.
+
 // Default to normal charging unless set. Divert mode always defaults back to 1 if unit is reset (_mode not saved in EEPROM)
 
 // define as 'weak' so the simulator can override
@@ -82,6 +86,7 @@ void DivertTask::setup()
 
 unsigned long DivertTask::loop(MicroTasks::WakeReason reason)
 {
+  Profile_Scope("DivertTask");
   DBUG("Divert woke: ");
   DBUGLN(WakeReason_Scheduled == reason ? "WakeReason_Scheduled" :
          WakeReason_Event == reason ? "WakeReason_Event" :
@@ -136,6 +141,7 @@ void DivertTask::setMode(DivertMode mode)
       case DivertMode::Eco:
       {
         _min_charge_end = 0;
+        _planner.reset();
 
         event["charge_rate"] = _charge_rate = 0;
         event["available_current"] = _available_current = 0;
@@ -161,10 +167,11 @@ void DivertTask::setMode(DivertMode mode)
 // Set charge rate depending on divert mode and solar / grid_ie
 void DivertTask::update_state()
 {
-  Profile_Start(DivertTask::update_state);
+  Profile_Start(DivertTask_update_state);
 
-  StaticJsonDocument<256> event;
+  StaticJsonDocument<384> event;
   event["divert_update"] = 0;
+  _grid_phases.takeReading();
 
   if (divert_type == DIVERT_TYPE_GRID)
   {
@@ -202,7 +209,21 @@ void DivertTask::update_state()
       Igrid_ie -= amps;
       DBUGVAR(Igrid_ie);
 
-      if (Igrid_ie < 0)
+      uint32_t now = millis();
+      if (_grid_phases.active(now, EVSE_DIVERT_PHASE_MAX_AGE))
+      {
+        // Per-phase readings: only divert what is exported on every phase
+        // the EVSE is on, so the least exporting phase sets the current.
+        // Without a reading from each phase there is nothing to divert.
+        _available_current = 0;
+        if (_grid_phases.valid(now, EVSE_DIVERT_PHASE_MAX_AGE))
+        {
+          double reserve = (1000.0 * ((divert_PV_ratio > 1.0) ? (divert_PV_ratio - 1.0) : 0.0)) / voltage;
+          DBUGVAR(reserve);
+          _available_current = _grid_phases.available(0, amps, PhaseLoad::phaseMask(config_threephase_enabled(), evse_phase)) - reserve;
+        }
+      }
+      else if (Igrid_ie < 0)
       {
         // If excess power
         double reserve = (1000.0 * ((divert_PV_ratio > 1.0) ? (divert_PV_ratio - 1.0) : 0.0)) / voltage;
@@ -233,11 +254,14 @@ void DivertTask::update_state()
     _smoothed_available_current = _inputFilter.filter(_available_current, _smoothed_available_current, scale);
     DBUGVAR(_smoothed_available_current);
 
-    _charge_rate = (int)floor(_available_current);
-    // if the remaining current can be used with a sufficient ratio of PV current in it, use it
-    if ((_available_current - _charge_rate) > min(1.0, divert_PV_ratio)) {
-      _charge_rate += 1;
+    // Only plan around the pilot while divert is the one setting it,
+    // otherwise start from the reading when divert next takes over
+    _planner.configure(min(1.0, divert_PV_ratio), divert_pilot_hysteresis,
+                       divert_pilot_interval, divert_pilot_lookahead);
+    if(EvseState::Active != _evse->getState(EvseClient_OpenEVSE_Divert)) {
+      _planner.reset();
     }
+    _charge_rate = _planner.plan(_available_current, _smoothed_available_current, divertmode_get_time());
 
     DBUGVAR(_charge_rate);
 
@@ -281,6 +305,8 @@ void DivertTask::update_state()
     event["available_current"] = _available_current;
     event["smoothed_available_current"] = _smoothed_available_current;
     event["pilot"] = _evse->getChargeCurrent();
+    event["pilot_changes"] = _planner.changes();
+    event["pilot_changes_avoided"] = _planner.avoided();
     event["min_charge_end"] = min_charge_time_remaining;
   } // end ecomode
 
@@ -289,7 +315,7 @@ void DivertTask::update_state()
 
   _last_update = millis();
 
-  Profile_End(DivertTask::update_state, 5);
+  Profile_End(DivertTask_update_state, 5);
 } //end divert_update_state
 
 bool DivertTask::isActive()
@@ -349,6 +375,29 @@ void DivertTask::setTimerDivertActive(bool active)
   MicroTask.wakeTask(this);
 }
 
+void DivertTask::setGridIePhase(uint8_t phase, int value)
+{
+  if (phase < 1 || phase > PHASE_LOAD_PHASES) {
+    return;
+  }
+
+  // Each update moves the smoothing and the planner on, so make one a
+  // reading rather than one a phase. If this phase comes round again before
+  // the others they are not being sent, go with what there is.
+  if (_grid_phases.updated(phase - 1)) {
+    update_state();
+  }
+
+  double voltage = _evse->getVoltage();
+  _grid_phases.setPower(phase - 1, value, voltage, millis());
+  // Keep grid_ie as the total for reporting
+  _grid_ie = _grid_phases.total() * voltage;
+
+  if (_grid_phases.complete()) {
+    update_state();
+  }
+}
+
 // compatiblity trick, to remove after few version upgrade
 void DivertTask::initDivertType() {
 
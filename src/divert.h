@@ -9,11 +9,18 @@
 #define EVSE_DIVERT_HYSTERESIS 0.5 // A
 #endif
 
+// How long a per-phase grid reading is used for before it is ignored
+#ifndef EVSE_DIVERT_PHASE_MAX_AGE
+#define EVSE_DIVERT_PHASE_MAX_AGE 120000 // ms
+#endif
+
 #include <Arduino.h>
 #include <MicroTasks.h>
 
 #include "evse_man.h"
 #include "input_filter.h"
+#include "divert_planner.h"
+#include "phase_load.h"
 
 enum divert_type {
   DIVERT_TYPE_UNSET = -1,
@@ -62,9 +69,11 @@ class DivertTask : public MicroTasks::Task
     time_t _min_charge_end;
     uint8_t _evse_last_state;
     InputFilter _inputFilter;
+    DivertPilotPlanner _planner;
     bool _timer_divert_active;  // true while a scheduler timer window controls divert
     int _solar;
     int _grid_ie;
+    PhaseLoad _grid_phases;
 
   protected:
     void setup();
@@ -102,11 +111,23 @@ class DivertTask : public MicroTasks::Task
       return _smoothed_available_current;
     }
 
+    // Pilot changes made, and avoided by the planner, since boot
+    uint32_t pilotChanges() {
+      return _planner.changes();
+    }
+
+    uint32_t pilotChangesAvoided() {
+      return _planner.avoided();
+    }
+
     // Set charge rate depending on charge mode and solarPV output
     void update_state();
 
     void setSolar(int value) { _solar = value; }
     void setGridIe(int value) { _grid_ie = value; }
+    // Grid import/export on one phase, phase 1 to 3. Updates the state
+    // once for each reading of all the phases.
+    void setGridIePhase(uint8_t phase, int value);
     int getSolar() const { return _solar; }
     int getGridIe() const { return _grid_ie; }
 
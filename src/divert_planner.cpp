@@ -0,0 +1,110 @@
+#include <math.h>
+
+#include "divert_planner.h"
+
+DivertPilotPlanner::DivertPilotPlanner() :
+  _ratio(1.0),
+  _band(0),
+  _interval(0),
+  _lookahead(0),
+  _pilot(-1),
+  _unplannedPilot(-1),
+  _lastChange(0),
+  _hasLast(false),
+  _lastSmoothed(0),
+  _lastTime(0),
+  _trend(0),
+  _changes(0),
+  _unplanned(0)
+{
+}
+
+void DivertPilotPlanner::configure(double ratio, double band, uint32_t interval, uint32_t lookahead)
+{
+  _ratio = ratio;
+  _band = band > 0 ? band : 0;
+  _interval = interval;
+  _lookahead = lookahead;
+}
+
+void DivertPilotPlanner::reset()
+{
+  _pilot = -1;
+  _unplannedPilot = -1;
+}
+
+int DivertPilotPlanner::pilotFor(double available) const
+{
+  if(available <= 0) {
+    return 0;
+  }
+
+  int pilot = (int)floor(available);
+  // if the remaining current can be used with a sufficient ratio of PV
+  // current in it, use it
+  if((available - pilot) > _ratio) {
+    pilot += 1;
+  }
+  return pilot;
+}
+
+int DivertPilotPlanner::plan(double available, double smoothed, uint32_t now)
+{
+  if(_hasLast && now > _lastTime) {
+    _trend = (smoothed - _lastSmoothed) / (double)(now - _lastTime);
+  }
+  _hasLast = true;
+  _lastSmoothed = smoothed;
+  _lastTime = now;
+
+  int unplanned = pilotFor(available);
+  if(_unplannedPilot >= 0 && unplanned != _unplannedPilot) {
+    _unplanned++;
+  }
+  _unplannedPilot = unplanned;
+
+  if(_pilot < 0)
+  {
+    _pilot = unplanned;
+    _lastChange = now;
+    return _pilot;
+  }
+
+  int up = pilotFor(available - _band);
+  int down = unplanned;
+  if(_lookahead > 0)
+  {
+    int projected = pilotFor(smoothed + _trend * _lookahead);
+    if(projected < up) {
+      up = projected;
+    }
+    if(projected < down) {
+      down = projected;
+    }
+  }
+
+  int next = _pilot;
+  if(up > _pilot) {
+    next = up;
+  } else if(down < _pilot) {
+    next = down;
+  }
+
+  if(next == _pilot) {
+    return _pilot;
+  }
+
+  if(_interval > 0 && now - _lastChange < _interval)
+  {
+    // Too soon, unless holding the pilot would import more than the band
+    bool importing = next < _pilot && (double)_pilot - available > _band;
+    if(!importing) {
+      return _pilot;
+    }
+  }
+
+  _pilot = next;
+  _lastChange = now;
+  _changes++;
+  return _pilot;
+}
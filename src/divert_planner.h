@@ -0,0 +1,72 @@
+#ifndef _EMONESP_DIVERT_PLANNER_H
+#define _EMONESP_DIVERT_PLANNER_H
+
+// Pilot setpoint planning for solar divert.
+//
+// Every pilot change is a RAPI command and a renegotiation with the vehicle,
+// so rather than follow each solar/grid reading the planner holds the pilot
+// until there is a reason to move it:
+//
+// - hysteresis: the pilot only goes up once there is band amps of headroom
+//   above the new setpoint, it comes down as soon as the reading drops below
+//   the current one
+// - rate limit: at most one change per interval seconds, except a drop that
+//   would import more than band amps, which is never held back
+// - look-ahead: the trend of the smoothed available current is projected
+//   lookahead seconds forward and the pilot is never planned above it, so a
+//   short spike is ridden out and a steady fall is followed early
+//
+// Changes made and changes avoided, compared to following every reading,
+// are counted so the settings can be tuned with divert_sim.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+
+#include <stdint.h>
+
+class DivertPilotPlanner
+{
+  public:
+    DivertPilotPlanner();
+
+    // ratio: the marginal fraction of a step that must be available before
+    // rounding up, min(1, divert_PV_ratio)
+    void configure(double ratio, double band, uint32_t interval, uint32_t lookahead);
+
+    // Forget the current pilot, the next plan() takes the reading as is.
+    // Call while divert is not controlling the EVSE.
+    void reset();
+
+    // Plan the pilot for a new reading. available is the raw available
+    // current, smoothed the filtered one, now a time in seconds
+    int plan(double available, double smoothed, uint32_t now);
+
+    // The pilot that following every reading would give
+    int pilotFor(double available) const;
+
+    int pilot() const { return _pilot; }
+    double trend() const { return _trend; }          // A/s
+    uint32_t changes() const { return _changes; }
+    uint32_t avoided() const {
+      return _unplanned > _changes ? _unplanned - _changes : 0;
+    }
+
+  private:
+    double _ratio;
+    double _band;
+    uint32_t _interval;
+    uint32_t _lookahead;
+
+    int _pilot;                 // -1 once reset
+    int _unplannedPilot;
+    uint32_t _lastChange;
+
+    bool _hasLast;
+    double _lastSmoothed;
+    uint32_t _lastTime;
+    double _trend;
+
+    uint32_t _changes;          // pilot changes made
+    uint32_t _unplanned;        // changes following every reading would make
+};
+
+#endif // _EMONESP_DIVERT_PLANNER_H
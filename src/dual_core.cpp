@@ -0,0 +1,135 @@
+#include <Arduino.h>
+
+#include "dual_core.h"
+#include "debug.h"
+
+#if DUAL_CORE
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include "spsc_queue.h"
+#include "pooled_json.h"
+
+static SemaphoreHandle_t dual_core_mutex = NULL;
+static TaskHandle_t control_task = NULL;
+static TaskHandle_t network_task = NULL;
+static void (*network_loop_fn)() = NULL;
+
+// Serialized events, written in place on the control side and read in
+// place on the network side, so nothing is allocated for each one
+struct DualCoreEvent {
+  size_t length;
+  char json[DUAL_CORE_EVENT_SIZE];
+};
+
+static SpscQueue<DualCoreEvent, DUAL_CORE_EVENT_QUEUE + 1> event_queue;
+
+static void dual_core_network_task(void *)
+{
+  for(;;)
+  {
+    network_loop_fn();
+    // Let the idle task on this core run
+    vTaskDelay(1);
+  }
+}
+
+void dual_core_begin(void (*network_loop)())
+{
+  network_loop_fn = network_loop;
+  control_task = xTaskGetCurrentTaskHandle();
+  dual_core_mutex = xSemaphoreCreateRecursiveMutex();
+
+  // Take the lock until the network task has been created, so it does not
+  // start while setup() is still running
+  dual_core_lock();
+  if(NULL == dual_core_mutex ||
+     pdPASS != xTaskCreatePinnedToCore(dual_core_network_task, "network",
+                                       DUAL_CORE_NETWORK_STACK, NULL,
+                                       DUAL_CORE_NETWORK_PRIORITY, &network_task,
+                                       1 - xPortGetCoreID()))
+  {
+    DEBUG_PORT.println(F("Dual core: failed to start network task"));
+    network_task = NULL;
+  }
+  dual_core_unlock();
+}
+
+void dual_core_lock()
+{
+  if(dual_core_mutex) {
+    xSemaphoreTakeRecursive(dual_core_mutex, portMAX_DELAY);
+  }
+}
+
+void dual_core_unlock()
+{
+  if(dual_core_mutex) {
+    xSemaphoreGiveRecursive(dual_core_mutex);
+  }
+}
+
+bool dual_core_queue_event(JsonDocument &event)
+{
+  // Only the control task produces, anything else sends directly
+  if(NULL == network_task || xTaskGetCurrentTaskHandle() != control_task) {
+    return false;
+  }
+
+  // Too big for a slot, rare enough to just send it from here
+  if(measureJson(event) >= DUAL_CORE_EVENT_SIZE) {
+    return false;
+  }
+
+  DualCoreEvent *slot = event_queue.back();
+  if(slot) {
+    slot->length = serializeJson(event, slot->json, sizeof(slot->json));
+    event_queue.commit();
+  }
+  return true;
+}
+
+void dual_core_send_events(void (*publish)(JsonDocument &event))
+{
+  DualCoreEvent *slot;
+  while(nullptr != (slot = event_queue.front()))
+  {
+    // Parsed in place, the strings point into the slot until it is released
+    PooledJsonDocument event(JSON_OBJECT_SIZE(64) + slot->length);
+    if(DeserializationError::Ok == deserializeJson(event, slot->json, slot->length)) {
+      publish(event);
+    }
+    event_queue.release();
+  }
+}
+
+uint32_t dual_core_events_dropped()
+{
+  return event_queue.dropped();
+}
+
+#else // !DUAL_CORE
+
+void dual_core_begin(void (*network_loop)()) {
+}
+
+void dual_core_lock() {
+}
+
+void dual_core_unlock() {
+}
+
+bool dual_core_queue_event(JsonDocument &event) {
+  return false;
+}
+
+void dual_core_send_events(void (*publish)(JsonDocument &event)) {
+}
+
+uint32_t dual_core_events_dropped() {
+  return 0;
+}
+
+#endif // DUAL_CORE
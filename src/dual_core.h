@@ -0,0 +1,83 @@
+#ifndef DUAL_CORE_H
+#define DUAL_CORE_H
+
+// -------------------------------------------------------------------
+// Split execution between the two ESP32 cores
+//
+// Built with -D ENABLE_DUAL_CORE the Arduino loop task only runs the EVSE
+// control side: RAPI and the MicroTasks (EvseManager, claims, divert, the
+// shaper, limits, ...), once a millisecond. Mongoose, the web server, OTA
+// and the other network polling move to a task on the other core.
+//
+// Both sides still share the firmware's state, and Mongoose is used from
+// MicroTasks such as OCPP, MQTT and the load balancer, so each side holds
+// the dual core lock while it runs. The network side takes it one step at a
+// time, but a step can be a Mongoose poll that runs a TLS handshake, and
+// control waits for all of it. Events raised on the control side are queued,
+// lock-free, and sent to the WebSocket and MQTT clients by the network side.
+//
+// Until the control side no longer needs the lock, which takes snapshots or
+// queues for those MicroTasks' calls into Mongoose, this does not keep RAPI
+// running through slow network work. No build environment enables it, it is
+// here to build on.
+//
+// Without ENABLE_DUAL_CORE, or on single core/native builds, everything
+// runs from loop() as before and the lock is a no-op.
+// -------------------------------------------------------------------
+
+#include <ArduinoJson.h>
+
+#if defined(ENABLE_DUAL_CORE) && defined(ESP32) && !defined(EPOXY_DUINO) && !CONFIG_FREERTOS_UNICORE
+#define DUAL_CORE 1
+#else
+#define DUAL_CORE 0
+#endif
+
+#ifndef DUAL_CORE_NETWORK_STACK
+#ifdef ENABLE_FLASH_MIGRATE
+#define DUAL_CORE_NETWORK_STACK (16 * 1024)
+#else
+#define DUAL_CORE_NETWORK_STACK (8 * 1024)
+#endif
+#endif
+
+// Same as the Arduino loop task, the control side, so neither starves
+#ifndef DUAL_CORE_NETWORK_PRIORITY
+#define DUAL_CORE_NETWORK_PRIORITY 1
+#endif
+
+// Events waiting for the network side, more are dropped
+#ifndef DUAL_CORE_EVENT_QUEUE
+#define DUAL_CORE_EVENT_QUEUE 16
+#endif
+
+// Largest serialized event the queue holds, each slot is this big. Anything
+// larger is sent by the control side itself.
+#ifndef DUAL_CORE_EVENT_SIZE
+#define DUAL_CORE_EVENT_SIZE 512
+#endif
+
+// Start the network side running network_loop, call from setup()
+void dual_core_begin(void (*network_loop)());
+
+void dual_core_lock();
+void dual_core_unlock();
+
+class DualCoreLock
+{
+  public:
+    DualCoreLock() { dual_core_lock(); }
+    ~DualCoreLock() { dual_core_unlock(); }
+};
+
+// Queue an event raised on the control side for the network side to send,
+// false if the caller should send it itself
+bool dual_core_queue_event(JsonDocument &event);
+
+// Network side, send the queued events with publish
+void dual_core_send_events(void (*publish)(JsonDocument &event));
+
+// Events dropped because the queue was full
+uint32_t dual_core_events_dropped();
+
+#endif // DUAL_CORE_H
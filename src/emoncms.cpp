@@ -4,6 +4,7 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <MicroTasks.h>
 #include <MongooseString.h>
 #include <MongooseHttpClient.h>
 
@@ -13,20 +14,172 @@
 #include "input.h"
 #include "event.h"
 
+#ifdef ENABLE_TSDB
+#include "tsdb_energy_logger.h"
+#include "tsdb_sample.h"
+#include "esp_tsdb.h"
+#endif
+
+// Minimum retry delay after a failed post (ms)
+#define EMONCMS_BACKOFF_MIN (10 * 1000)
+
+// Wall-clock must be past this (2023-11-14) before sample times are trusted
+// for finding gaps in the energy history
+#define EMONCMS_TIME_VALID_FLOOR 1700000000UL
+
 boolean emoncms_connected = false;
 boolean emoncms_updated = false;
 
 unsigned long packets_sent = 0;
 unsigned long packets_success = 0;
+unsigned long packets_dropped = 0;
+unsigned long packets_backfilled = 0;
 
-const char *post_path = "/input/post?";
+const char *bulk_path = "/input/bulk?apikey=";
 
 static MongooseHttpClient client;
 
+struct EmonCmsSample {
+  uint32_t uptime;  // seconds since boot, sent relative to sentat
+  uint32_t time;    // wall clock, 0 if the clock was not yet valid
+  String json;      // numeric inputs as a JSON object
+};
+
 struct EmonCmsClientState {
   bool connected;
+  bool success;
+  bool backfill;
+  uint32_t backfill_last;   // timestamp of the last history row sent
+  size_t backfill_rows;
+  bool backfill_complete;
 };
 
+class EmonCmsTask : public MicroTasks::Task
+{
+  private:
+    EmonCmsSample _samples[EMONCMS_BATCH_MAX_SAMPLES];
+    size_t _head;           // index of the oldest sample
+    size_t _count;
+    size_t _in_flight;      // samples, from _head, included in the active request
+    bool _request_active;
+    bool _flush;
+    unsigned long _next_post;
+    unsigned long _backoff;
+    String _body;           // kept alive until the active request closes
+
+    // Wall clock range of samples dropped from the buffer, waiting to be
+    // backfilled from the energy history. _gap_end == 0 means no gap.
+    uint32_t _gap_start;
+    uint32_t _gap_end;
+
+    unsigned long interval()
+    {
+      return emoncms_interval * 1000;
+    }
+
+    void drop(size_t count)
+    {
+      while(count-- > 0 && _count > 0)
+      {
+        _samples[_head].json = String();
+        _head = (_head + 1) % EMONCMS_BATCH_MAX_SAMPLES;
+        _count--;
+      }
+    }
+
+    void addGap(uint32_t time)
+    {
+      if(0 == time) {
+        return;
+      }
+      if(0 == _gap_end || time < _gap_start) {
+        _gap_start = time;
+      }
+      if(time > _gap_end) {
+        _gap_end = time;
+      }
+    }
+
+    bool post(EmonCmsClientState *state);
+    bool postSamples();
+    bool postBackfill();
+    void complete(EmonCmsClientState *state);
+
+  protected:
+    void setup()
+    {
+    }
+
+    unsigned long loop(MicroTasks::WakeReason reason)
+    {
+      if(_request_active) {
+        // Woken again when the request closes
+        return MicroTask.Infinate;
+      }
+
+      if(!config_emoncms_enabled() || emoncms_apikey == 0) {
+        clear();
+        return MicroTask.Infinate;
+      }
+
+      if(0 == _count && 0 == _gap_end) {
+        return MicroTask.Infinate;
+      }
+
+      unsigned long now = millis();
+      if(!_flush && (long)(_next_post - now) > 0) {
+        return _next_post - now;
+      }
+      _flush = false;
+
+      if(_count > 0 ? postSamples() : postBackfill()) {
+        return MicroTask.Infinate;
+      }
+
+      return 0 == _count && 0 == _gap_end ? MicroTask.Infinate : max(interval(), (unsigned long)EMONCMS_BACKOFF_MIN);
+    }
+
+  public:
+    EmonCmsTask() :
+      MicroTasks::Task(),
+      _head(0),
+      _count(0),
+      _in_flight(0),
+      _request_active(false),
+      _flush(false),
+      _next_post(0),
+      _backoff(0),
+      _gap_start(0),
+      _gap_end(0)
+    {
+    }
+
+    void begin()
+    {
+      MicroTask.startTask(this);
+    }
+
+    void push(JsonDocument &data);
+
+    void flush()
+    {
+      _flush = true;
+      MicroTask.wakeTask(this);
+    }
+
+    void clear()
+    {
+      drop(_count);
+      _in_flight = 0;
+      _gap_start = _gap_end = 0;
+      _backoff = 0;
+    }
+
+    size_t queued() {
+      return _count;
+    }
+} emoncms;
+
 static void emoncms_result(bool success, String message)
 {
   StaticJsonDocument<128> event;
@@ -42,65 +195,299 @@ static void emoncms_result(bool success, String message)
   event_send(event);
 }
 
-void emoncms_publish(JsonDocument &data)
+void EmonCmsTask::push(JsonDocument &data)
 {
-  Profile_Start(emoncms_publish);
+  // Only numeric inputs can be logged, skip strings and the `false` used for
+  // invalid readings
+  String json = "{";
+  for(JsonPair kv : data.as<JsonObject>())
+  {
+    JsonVariant value = kv.value();
+    if(value.is<bool>() || !value.is<double>()) {
+      continue;
+    }
 
-  if (config_emoncms_enabled() && emoncms_apikey != 0)
+    if(json.length() > 1) {
+      json += ',';
+    }
+    json += '"';
+    json += kv.key().c_str();
+    json += "\":";
+    if(value.is<long>()) {
+      json += value.as<long>();
+    } else {
+      json += String(value.as<double>(), 3);
+    }
+  }
+  json += '}';
+
+  if(_count == EMONCMS_BATCH_MAX_SAMPLES)
   {
-    String url = emoncms_server + post_path;
-    String json;
-    serializeJson(data, json);
-    url += "fulljson=";
-    MongooseString encodedJson = mg_url_encode(MongooseString(json));
-    url += (const char *)encodedJson;
-    mg_strfree(encodedJson);
-    url += "&node=";
-    url += emoncms_node;
-    url += "&apikey=";
-    url += emoncms_apikey;
-
-    DBUGVAR(url);
-    packets_sent++;
-
-    auto state = new EmonCmsClientState;
-
-    state->connected = false;
-
-    client.get(url, [state](MongooseHttpClientResponse *response)
+    // Drop the oldest sample, if it is part of the active request the
+    // request will now remove one sample less when it completes
+    addGap(_samples[_head].time);
+    if(_in_flight > 0) {
+      _in_flight--;
+    }
+    drop(1);
+    packets_dropped++;
+  }
+
+  time_t now = time(NULL);
+  EmonCmsSample &sample = _samples[(_head + _count) % EMONCMS_BATCH_MAX_SAMPLES];
+  sample.uptime = uptimeMillis() / 1000;
+  sample.time = (unsigned long)now >= EMONCMS_TIME_VALID_FLOOR ? (uint32_t)now : 0;
+  sample.json = json;
+  _count++;
+
+  // Start the batch interval from the first sample after an idle period
+  if(1 == _count && 0 == _backoff && (long)(_next_post - millis()) <= 0) {
+    _next_post = millis() + interval();
+  }
+
+  // Post straight away in unbatched mode or when the buffer is full, unless
+  // we are backing off after a failure
+  if(0 == _backoff && (0 == emoncms_interval || _count == EMONCMS_BATCH_MAX_SAMPLES)) {
+    _flush = true;
+  }
+
+  MicroTask.wakeTask(this);
+}
+
+bool EmonCmsTask::postSamples()
+{
+  // Bulk format: data=[[time,node,{"key":value,...}],...]&sentat=<time>
+  // Sample times are uptime seconds, sentat lets emoncms convert them to
+  // server time so this works even before NTP has set the clock.
+  String data = "[";
+  for(size_t i = 0; i < _count; i++)
+  {
+    EmonCmsSample &sample = _samples[(_head + i) % EMONCMS_BATCH_MAX_SAMPLES];
+    if(i > 0) {
+      data += ',';
+    }
+    data += '[';
+    data += sample.uptime;
+    data += ",\"";
+    data += emoncms_node;
+    data += "\",";
+    data += sample.json;
+    data += ']';
+  }
+  data += ']';
+
+  MongooseString encoded = mg_url_encode(MongooseString(data));
+  _body = "data=";
+  _body += (const char *)encoded;
+  mg_strfree(encoded);
+  _body += "&sentat=";
+  _body += (uint32_t)(uptimeMillis() / 1000);
+
+  _in_flight = _count;
+
+  auto state = new EmonCmsClientState();
+  state->backfill = false;
+  return post(state);
+}
+
+bool EmonCmsTask::postBackfill()
+{
+#ifdef ENABLE_TSDB
+  if(!tsdbEnergyLogger.isReady()) {
+    _gap_start = _gap_end = 0;
+    return false;
+  }
+
+  static const uint8_t cols[] = {
+    TSDB_COL_AMPS, TSDB_COL_VOLTS, TSDB_COL_POWER, TSDB_COL_TEMP, TSDB_COL_PILOT
+  };
+  const uint8_t num_cols = sizeof(cols) / sizeof(cols[0]);
+
+  tsdb_query_t query;
+  if(ESP_OK != tsdb_query_init(&query, _gap_start, _gap_end, cols, num_cols)) {
+    _gap_start = _gap_end = 0;
+    return false;
+  }
+
+  // History rows use the same input names and scaling as the live samples so
+  // they land in the same feeds. Times are absolute, relative to time=<first>.
+  String data = "[";
+  uint32_t first = 0;
+  uint32_t last = 0;
+  size_t rows = 0;
+  uint32_t ts;
+  int16_t values[num_cols];
+  while(rows < EMONCMS_BACKFILL_ROWS && ESP_OK == tsdb_query_next(&query, &ts, values))
+  {
+    if(0 == rows) {
+      first = ts;
+    } else {
+      data += ',';
+    }
+    data += '[';
+    data += ts - first;
+    data += ",\"";
+    data += emoncms_node;
+    // Formatted as push() formats the live values
+    data += "\",{\"amp\":";
+    data += String(tsdb_unscale(TSDB_COL_AMPS, values[0]) * AMPS_SCALE_FACTOR, 3);
+    data += ",\"voltage\":";
+    data += String(tsdb_unscale(TSDB_COL_VOLTS, values[1]) * VOLTS_SCALE_FACTOR, 3);
+    data += ",\"power\":";
+    data += String(tsdb_unscale(TSDB_COL_POWER, values[2]) * POWER_SCALE_FACTOR, 3);
+    data += ",\"temp\":";
+    data += String(tsdb_unscale(TSDB_COL_TEMP, values[3]) * TEMP_SCALE_FACTOR, 3);
+    data += ",\"pilot\":";
+    data += (long)tsdb_unscale(TSDB_COL_PILOT, values[4]);
+    data += "}]";
+    last = ts;
+    rows++;
+  }
+  tsdb_query_close(&query);
+  data += ']';
+
+  if(0 == rows) {
+    _gap_start = _gap_end = 0;
+    return false;
+  }
+
+  DBUGF("Backfill %u rows from %u to %u", (unsigned)rows, first, last);
+
+  MongooseString encoded = mg_url_encode(MongooseString(data));
+  _body = "data=";
+  _body += (const char *)encoded;
+  mg_strfree(encoded);
+  _body += "&time=";
+  _body += first;
+
+  auto state = new EmonCmsClientState();
+  state->backfill = true;
+  state->backfill_last = last;
+  state->backfill_rows = rows;
+  state->backfill_complete = rows < EMONCMS_BACKFILL_ROWS || last >= _gap_end;
+  return post(state);
+#else
+  // No local history to backfill from
+  _gap_start = _gap_end = 0;
+  return false;
+#endif
+}
+
+bool EmonCmsTask::post(EmonCmsClientState *state)
+{
+  String url = emoncms_server + bulk_path;
+  url += emoncms_apikey;
+
+  MongooseHttpClientRequest *request = client.beginRequest(url.c_str());
+  if(!request) {
+    delete state;
+    _in_flight = 0;
+    return false;
+  }
+
+  DBUGVAR(url);
+  DBUGVAR(_body);
+  packets_sent++;
+
+  state->connected = false;
+  state->success = false;
+  _request_active = true;
+
+  request->setMethod(HTTP_POST);
+  request->addHeader("Content-Type", "application/x-www-form-urlencoded");
+  request->setContent((const uint8_t *)_body.c_str(), _body.length());
+  request->onResponse([state](MongooseHttpClientResponse *response)
+  {
+    MongooseString result = response->body();
+    DBUGF("result = %.*s", result.length(), result.c_str());
+
+    state->connected = true;
+
+    const size_t capacity = JSON_OBJECT_SIZE(2) + result.length();
+    DynamicJsonDocument doc(capacity);
+    if(DeserializationError::Code::Ok == deserializeJson(doc, result.c_str(), result.length()))
     {
-      MongooseString result = response->body();
-      DBUGF("result = %.*s", result.length(), result.c_str());
+      DBUGLN("Got JSON");
+      state->success = doc["success"]; // true
+      emoncms_result(state->success, doc["message"]);
+    } else if (result == "ok") {
+      state->success = true;
+      emoncms_result(true, result);
+    } else {
+      DEBUG.print("Emoncms error: ");
+      DEBUG.printf("%.*s\n", result.length(), (const char *)result);
+      emoncms_result(false, result.toString());
+    }
+  });
+  request->onClose([this, state]()
+  {
+    DBUGF("onClose");
+    if(false == state->connected) {
+      emoncms_result(false, String("Failed to connect"));
+    }
+    complete(state);
+    delete state;
+  });
+  client.send(request);
 
-      state->connected = true;
+  return true;
+}
 
-      const size_t capacity = JSON_OBJECT_SIZE(2) + result.length();
-      DynamicJsonDocument doc(capacity);
-      if(DeserializationError::Code::Ok == deserializeJson(doc, result.c_str(), result.length()))
-      {
-        DBUGLN("Got JSON");
-        bool success = doc["success"]; // true
-        if(success) {
-          packets_success++;
-        }
-        emoncms_result(success, doc["message"]);
-      } else if (result == "ok") {
-        packets_success++;
-        emoncms_result(true, result);
-      } else {
-        DEBUG.print("Emoncms error: ");
-        DEBUG.printf("%.*s\n", result.length(), (const char *)result);
-        emoncms_result(false, result.toString());
-      }
-    }, [state]()
+void EmonCmsTask::complete(EmonCmsClientState *state)
+{
+  _request_active = false;
+  _body = String();
+
+  unsigned long now = millis();
+  if(state->success)
+  {
+    packets_success++;
+    _backoff = 0;
+
+    if(state->backfill)
     {
-      DBUGF("onClose");
-      if(false == state->connected) {
-        emoncms_result(false, String("Failed to connect"));
+      packets_backfilled += state->backfill_rows;
+      if(state->backfill_complete) {
+        _gap_start = _gap_end = 0;
+      } else {
+        _gap_start = state->backfill_last + 1;
       }
-      delete state;
-    });
+    } else {
+      drop(_in_flight);
+    }
+
+    // Catch up on history quickly once the live samples are out
+    _next_post = now + (0 == _count && 0 != _gap_end ? EMONCMS_BACKFILL_DELAY : interval());
+  }
+  else
+  {
+    // Keep the samples and retry with an exponential backoff
+    _backoff = _backoff > 0 ? _backoff * 2 : max(interval(), (unsigned long)EMONCMS_BACKOFF_MIN);
+    if(_backoff > EMONCMS_BACKOFF_MAX) {
+      _backoff = EMONCMS_BACKOFF_MAX;
+    }
+    DBUGF("Post failed, retry in %lums", _backoff);
+    _next_post = now + _backoff;
+  }
+
+  _in_flight = 0;
+  MicroTask.wakeTask(this);
+}
+
+void emoncms_setup()
+{
+  emoncms.begin();
+}
+
+void emoncms_publish(JsonDocument &data)
+{
+  Profile_Start(emoncms_publish);
+
+  if (config_emoncms_enabled() && emoncms_apikey != 0)
+  {
+    emoncms.push(data);
   } else {
+    emoncms.clear();
     if(false != emoncms_connected) {
       emoncms_result(false, String("Disabled"));
     }
@@ -108,3 +495,13 @@ void emoncms_publish(JsonDocument &data)
 
   Profile_End(emoncms_publish, 10);
 }
+
+void emoncms_flush()
+{
+  emoncms.flush();
+}
+
+size_t emoncms_queued()
+{
+  return emoncms.queued();
+}
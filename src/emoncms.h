@@ -4,6 +4,28 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+// Maximum number of samples held in RAM waiting to be posted. When the buffer
+// is full the oldest sample is dropped and, on TSDB builds, the gap is later
+// backfilled from the energy history.
+#ifndef EMONCMS_BATCH_MAX_SAMPLES
+#define EMONCMS_BATCH_MAX_SAMPLES 30
+#endif
+
+// Upper bound for the retry backoff after failed posts (ms)
+#ifndef EMONCMS_BACKOFF_MAX
+#define EMONCMS_BACKOFF_MAX (15 * 60 * 1000)
+#endif
+
+// Maximum number of history rows sent per backfill request
+#ifndef EMONCMS_BACKFILL_ROWS
+#define EMONCMS_BACKFILL_ROWS 60
+#endif
+
+// Delay between consecutive backfill requests (ms)
+#ifndef EMONCMS_BACKFILL_DELAY
+#define EMONCMS_BACKFILL_DELAY 1000
+#endif
+
 // -------------------------------------------------------------------
 // Commutication with EmonCMS
 // -------------------------------------------------------------------
@@ -13,13 +35,29 @@ extern boolean emoncms_updated;
 
 extern unsigned long packets_sent;
 extern unsigned long packets_success;
+extern unsigned long packets_dropped;
+extern unsigned long packets_backfilled;
+
+// -------------------------------------------------------------------
+// Start the EmonCMS upload task
+// -------------------------------------------------------------------
+void emoncms_setup();
 
 // -------------------------------------------------------------------
-// Publish values to EmonCMS
+// Queue values for EmonCMS
 //
-// data: a comma seperated list of name:value pairs to send
+// data: a JSON object of name:value pairs, non-numeric values are ignored.
+// Samples are posted in batches via the input/bulk API every
+// emoncms_interval seconds, or straight away if emoncms_interval is 0.
 // -------------------------------------------------------------------
 void emoncms_publish(JsonDocument &data);
 
-#endif // _EMONESP_EMONCMS_H
+// -------------------------------------------------------------------
+// Post any queued samples now, ignoring the interval and backoff
+// -------------------------------------------------------------------
+void emoncms_flush();
+
+// Number of samples waiting to be posted
+size_t emoncms_queued();
 
+#endif // _EMONESP_EMONCMS_H
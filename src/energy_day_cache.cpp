@@ -0,0 +1,92 @@
+#include "energy_day_cache.h"
+
+void EnergyDay::begin(uint32_t day_start)
+{
+  start    = day_start;
+  count    = 0;
+  energy   = 0;
+  temp_max = 0;
+  temp_min = 0;
+}
+
+void EnergyDay::add(int16_t energy_wh, int16_t temp)
+{
+  if (count == 0 || temp > temp_max) temp_max = temp;
+  if (count == 0 || temp < temp_min) temp_min = temp;
+  energy += energy_wh;
+  count++;
+}
+
+void EnergyDay::merge(const EnergyDay &day)
+{
+  if (day.count == 0) return;
+  if (count == 0 || day.temp_max > temp_max) temp_max = day.temp_max;
+  if (count == 0 || day.temp_min < temp_min) temp_min = day.temp_min;
+  energy += day.energy;
+  count  += day.count;
+}
+
+// Consecutive days land in consecutive slots, so any ENERGY_DAY_CACHE_DAYS
+// run of days is held without one evicting another
+static uint32_t slot_of(uint32_t day_start)
+{
+  return (day_start / ENERGY_DAY_SECS) % ENERGY_DAY_CACHE_DAYS;
+}
+
+void EnergyDayCache::setToday(uint32_t today_start)
+{
+  if (today_start < _today) clear();
+  _today = today_start;
+}
+
+void EnergyDayCache::store(const EnergyDay &day)
+{
+  if (day.start == 0 || day.start + ENERGY_DAY_SECS > _today) return;
+  _days[slot_of(day.start)] = day;
+}
+
+const EnergyDay *EnergyDayCache::find(uint32_t day_start) const
+{
+  const EnergyDay &day = _days[slot_of(day_start)];
+  return (day.start == day_start && day_start != 0) ? &day : nullptr;
+}
+
+void EnergyDayCache::clear()
+{
+  for (uint32_t i = 0; i < ENERGY_DAY_CACHE_DAYS; i++) {
+    _days[i] = EnergyDay();
+  }
+}
+
+EnergyDayScan::EnergyDayScan(EnergyDayCache &cache, uint32_t start, uint32_t days) :
+  _cache(cache),
+  _start(start),
+  _days(days),
+  _index(0)
+{
+  _day.begin(start);
+}
+
+void EnergyDayScan::advance(uint32_t index)
+{
+  while (_index < index && _index < _days) {
+    _cache.store(_day);
+    _index++;
+    _day.begin(_start + _index * ENERGY_DAY_SECS);
+  }
+}
+
+void EnergyDayScan::add(uint32_t ts, int16_t energy_wh, int16_t temp)
+{
+  if (ts < _start) return;
+  uint32_t index = (ts - _start) / ENERGY_DAY_SECS;
+  if (index >= _days || index < _index) return;
+
+  advance(index);
+  _day.add(energy_wh, temp);
+}
+
+void EnergyDayScan::finish()
+{
+  advance(_days);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Per-day energy/temperature aggregates for the /energy/daily and
+// /energy/weekly charts.
+//
+// Past days do not change once the day is over, so each is aggregated from
+// the TSDB once, in a single pass over a run of days (EnergyDayScan), and
+// kept in EnergyDayCache. Weekly buckets are merged from the cached days.
+// Days with no samples are cached too, so gaps are not rescanned.
+//
+// No Arduino or TSDB dependency so it can be unit-tested on the build host.
+// ---------------------------------------------------------------------------
+
+#define ENERGY_DAY_SECS 86400
+
+// Enough for a 365 day chart, or 52 weeks
+#ifndef ENERGY_DAY_CACHE_DAYS
+#define ENERGY_DAY_CACHE_DAYS 371
+#endif
+
+struct EnergyDay {
+  uint32_t start = 0;     // epoch of the start of the day, 0 = empty slot
+  uint32_t count = 0;     // samples, 0 for a day with no data
+  int32_t  energy = 0;    // Wh, sum of the TSDB_COL_ENERGY deltas
+  int16_t  temp_max = 0;  // deci-degC
+  int16_t  temp_min = 0;
+
+  void begin(uint32_t day_start);
+  void add(int16_t energy_wh, int16_t temp);
+  // Combine days into a wider bucket
+  void merge(const EnergyDay &day);
+};
+
+class EnergyDayCache {
+public:
+  // Set the start of today, the cache is cleared if it has gone back (the
+  // clock was set back, so past days may yet get samples)
+  void setToday(uint32_t today_start);
+
+  // Only days before today are stored
+  void store(const EnergyDay &day);
+  const EnergyDay *find(uint32_t day_start) const;
+  void clear();
+
+  uint32_t today() const { return _today; }
+
+private:
+  EnergyDay _days[ENERGY_DAY_CACHE_DAYS];
+  uint32_t  _today = 0;
+};
+
+// Aggregates a time ordered stream of samples into `days` consecutive days
+// from `start`, storing each day in the cache as it is completed. Samples
+// outside the range, or out of order, are ignored.
+class EnergyDayScan {
+public:
+  EnergyDayScan(EnergyDayCache &cache, uint32_t start, uint32_t days);
+
+  void add(uint32_t ts, int16_t energy_wh, int16_t temp);
+  // Store the rest of the days, including any without samples
+  void finish();
+
+private:
+  void advance(uint32_t index);
+
+  EnergyDayCache &_cache;
+  uint32_t  _start;
+  uint32_t  _days;
+  uint32_t  _index;       // day being aggregated
+  EnergyDay _day;
+};
@@ -0,0 +1,51 @@
+#include "energy_export.h"
+
+size_t energy_export_varint(uint8_t *out, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+// Small differences either way to small numbers: 0, -1, 1, -2, ...
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+EnergyExportEncoder::EnergyExportEncoder(uint8_t num_cols) :
+  _num_cols(num_cols > ENERGY_EXPORT_MAX_COLS ? ENERGY_EXPORT_MAX_COLS : num_cols)
+{
+}
+
+size_t EnergyExportEncoder::header(uint8_t *out) {
+  out[0] = 'O';
+  out[1] = 'E';
+  out[2] = 'X';
+  out[3] = ENERGY_EXPORT_VERSION;
+  out[4] = _num_cols;
+  return ENERGY_EXPORT_HEADER_SIZE;
+}
+
+size_t EnergyExportEncoder::record(uint8_t *out, uint32_t ts, const int16_t *values) {
+  // +1 keeps 0 free to mark the footer; the tsdb never goes back in time
+  uint32_t delta = ts >= _last_ts ? ts - _last_ts : 0;
+  size_t n = energy_export_varint(out, delta + 1);
+  for (uint8_t i = 0; i < _num_cols; i++) {
+    n += energy_export_varint(out + n, zigzag((int32_t)values[i] - _last[i]));
+    _last[i] = values[i];
+  }
+  _last_ts = ts;
+  _count++;
+  return n;
+}
+
+size_t EnergyExportEncoder::footer(uint8_t *out, bool more) {
+  size_t n = energy_export_varint(out, 0);
+  n += energy_export_varint(out + n, _count);
+  n += energy_export_varint(out + n, _last_ts);
+  out[n++] = more ? 1 : 0;
+  return n;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Compact binary encoding of the energy tsdb for bulk export (/energy/export)
+//
+// The raw int16 columns are sent as they are stored, no scaling or float
+// formatting. Each value is the zigzag varint of its difference from the
+// same column in the previous record, so slow moving columns mostly take a
+// byte. A typical record is 8-10 bytes, against ~100 as /energy/raw JSON.
+//
+//   header   "OEX" version(1)  num_cols(1)
+//   record   varint(ts delta + 1)  zigzag varint(column delta) * num_cols
+//   ...
+//   footer   varint(0)  varint(count)  varint(next)  more(1)
+//
+// The first record's deltas are from 0. `next` is the timestamp of the
+// last record (0 if there were none), pass it back as since=<next> to
+// resume; `more` is 1 if there are records after it. Varints are LEB128,
+// low 7 bits first.
+// ---------------------------------------------------------------------------
+
+#define ENERGY_EXPORT_VERSION     1
+#define ENERGY_EXPORT_HEADER_SIZE 5
+// Worst case record: 5 byte ts + 3 bytes a column
+#define ENERGY_EXPORT_MAX_RECORD(num_cols) (5 + 3 * (num_cols))
+#define ENERGY_EXPORT_MAX_FOOTER  (1 + 5 + 5 + 1)
+#define ENERGY_EXPORT_MAX_COLS    16
+
+class EnergyExportEncoder {
+public:
+  explicit EnergyExportEncoder(uint8_t num_cols);
+
+  // Each writes to `out`, which must have room for the worst case, and
+  // returns the bytes written
+  size_t header(uint8_t *out);
+  size_t record(uint8_t *out, uint32_t ts, const int16_t *values);
+  size_t footer(uint8_t *out, bool more);
+
+  uint32_t count() const { return _count; }
+  uint32_t last() const { return _last_ts; }
+
+private:
+  uint8_t  _num_cols;
+  uint32_t _count = 0;
+  uint32_t _last_ts = 0;
+  int16_t  _last[ENERGY_EXPORT_MAX_COLS] = {};
+};
+
+size_t energy_export_varint(uint8_t *out, uint32_t value);
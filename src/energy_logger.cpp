@@ -5,8 +5,11 @@
 #include <sys/time.h>
 #include <time.h>
 #include <stdio.h>
+#include <math.h>
+#include <algorithm>
 
 #include "energy_logger.h"
+#include "tsdb_sample.h"
 #include "evse_man.h"
 #include "debug.h"
 
@@ -30,14 +33,21 @@ static size_t dir_used_bytes(const char *path) {
   return total;
 }
 
+static size_t file_used_bytes(const char *path) {
+  File f = LittleFS.open(path, "r");
+  if (!f) return 0;
+  size_t size = f.size();
+  f.close();
+  return size;
+}
+
 // Returns total bytes currently used by all energy logger files.
 static size_t energy_log_used_bytes() {
   size_t total = 0;
-  total += dir_used_bytes(ENERGY_LOGGER_RAW_DIR);
-  total += dir_used_bytes(ENERGY_LOGGER_DAILY_DIR);
+  total += dir_used_bytes(ENERGY_LOGGER_RAW_RING);
+  total += dir_used_bytes(ENERGY_LOGGER_DAILY_RING);
   total += dir_used_bytes(ENERGY_LOGGER_MONTHLY_DIR);
-  File f = LittleFS.open(ENERGY_LOGGER_ANNUAL_FILE, "r");
-  if (f) { total += f.size(); f.close(); }
+  total += file_used_bytes(ENERGY_LOGGER_ANNUAL_FILE);
   return total;
 }
 
@@ -52,13 +62,144 @@ static bool energy_log_has_budget(size_t needed) {
   return energy_log_used_bytes() + needed <= (size_t)ENERGY_LOGGER_MAX_BYTES * el_scale();
 }
 
-EnergyLogger::EnergyLogger() : _buffer_index(0), _buffer_count(0), _monitor(nullptr),
-  _last_sample_time(0), _last_hour_time(0), _last_day_time(0), _last_chunk_time(0),
-  _last_month(0), _last_year(0),
-  _hour_peak_temp(-99.0), _hour_min_temp(99.0), _hour_energy_wh(0), _hour_sample_count(0),
-  _day_peak_temp(-99.0), _day_min_temp(99.0), _day_energy_wh(0)
+// Ring sizes in records. Both rings at full size, with their spare
+// segment, fit the small partition budget, ~16 KB of ENERGY_LOGGER_MAX_BYTES.
+static uint32_t raw_capacity() {
+  return ENERGY_LOGGER_RAW_KEEP_HOURS * 3600u / (ENERGY_LOGGER_SAMPLE_INTERVAL / 1000) * el_scale();
+}
+
+static uint32_t daily_capacity() {
+  return ENERGY_LOGGER_DAILY_KEEP_DAYS * el_scale();
+}
+
+static time_t start_of_day(time_t t) {
+  struct tm tm_day;
+  localtime_r(&t, &tm_day);
+  tm_day.tm_hour  = 0;
+  tm_day.tm_min   = 0;
+  tm_day.tm_sec   = 0;
+  tm_day.tm_isdst = -1;
+  return mktime(&tm_day);
+}
+
+// First second of the given month, month may be 13 for January next year
+static time_t start_of_month(int year, int month) {
+  struct tm tm_month = {};
+  tm_month.tm_year  = year - 1900;
+  tm_month.tm_mon   = month - 1;
+  tm_month.tm_mday  = 1;
+  tm_month.tm_isdst = -1;
+  return mktime(&tm_month);
+}
+
+// ── Ring segment files ───────────────────────────────────────────────────────
+
+EnergyRingFiles::EnergyRingFiles(const char *dir) :
+  _dir(dir), _file_segment(0)
+{
+}
+
+void EnergyRingFiles::path(uint32_t segment, char *buf, size_t len)
+{
+  snprintf(buf, len, "%s/%u", _dir, segment);
+}
+
+// A file is only written through a handle of its own, so one open for
+// reading is closed before the segment is written or removed
+File &EnergyRingFiles::open(uint32_t segment)
+{
+  if (!_file || _file_segment != segment) {
+    close();
+    char filepath[64];
+    path(segment, filepath, sizeof(filepath));
+    _file = LittleFS.open(filepath, "r");
+    _file_segment = segment;
+  }
+  return _file;
+}
+
+void EnergyRingFiles::close()
+{
+  if (_file) _file.close();
+}
+
+bool EnergyRingFiles::range(uint32_t &first, uint32_t &last)
+{
+  close();
+  File dir = LittleFS.open(_dir);
+  if (!dir || !dir.isDirectory()) return false;
+
+  bool found = false;
+  File entry = dir.openNextFile();
+  while (entry) {
+    const char *full = entry.name();
+    const char *name = strrchr(full, '/');
+    name = name ? name + 1 : full;
+    char *end;
+    uint32_t segment = strtoul(name, &end, 10);
+    if (!entry.isDirectory() && end != name && '\0' == *end) {
+      if (!found || segment < first) first = segment;
+      if (!found || segment > last) last = segment;
+      found = true;
+    }
+    entry = dir.openNextFile();
+  }
+  dir.close();
+  return found;
+}
+
+size_t EnergyRingFiles::size(uint32_t segment)
+{
+  File &file = open(segment);
+  return file ? file.size() : 0;
+}
+
+bool EnergyRingFiles::read(uint32_t segment, uint32_t offset, uint8_t *data, size_t len)
+{
+  File &file = open(segment);
+  return file && file.seek(offset) && file.read(data, len) == len;
+}
+
+bool EnergyRingFiles::write(uint32_t segment, uint32_t offset, const uint8_t *data, size_t len)
+{
+  if (_file_segment == segment) close();
+
+  char filepath[64];
+  path(segment, filepath, sizeof(filepath));
+
+  File file;
+  if (0 == offset) {
+    // A new segment grows to a block, see the room for all of it first
+    if (!fs_has_space(ENERGY_RING_SEGMENT_SIZE)) {
+      DBUGF("[EnergyLogger] Insufficient space for %s", filepath);
+      return false;
+    }
+    file = LittleFS.open(filepath, "w");
+  } else {
+    file = LittleFS.open(filepath, "r+");
+  }
+  if (!file) return false;
+
+  bool ok = file.seek(offset) && file.write(data, len) == len;
+  file.close();
+  return ok;
+}
+
+bool EnergyRingFiles::remove(uint32_t segment)
+{
+  if (_file_segment == segment) close();
+
+  char filepath[64];
+  path(segment, filepath, sizeof(filepath));
+  return LittleFS.remove(filepath);
+}
+
+EnergyLogger::EnergyLogger() : _monitor(nullptr),
+  _raw_files(ENERGY_LOGGER_RAW_RING), _daily_files(ENERGY_LOGGER_DAILY_RING),
+  _raw(TSDB_NUM_COLS), _daily(ROLLUP_NUM_COLS),
+  _day(ENERGY_LOGGER_SAMPLE_INTERVAL / 1000), _day_restored(false), _last_session_wh(0),
+  _last_month(0), _last_year(0)
 {
-  memset(_hourly_buffer, 0, sizeof(_hourly_buffer));
 }
 
 EnergyLogger::~EnergyLogger()
@@ -69,75 +210,55 @@ EnergyLogger::~EnergyLogger()
 void EnergyLogger::begin(EvseManager *monitor)
 {
   _monitor = monitor;
+  _last_session_wh = _monitor->getSessionEnergy();
   ensure_directories();
+  open_rings();
   MicroTask.startTask(this);
 }
 
 void EnergyLogger::end()
 {
+  // The day so far is rolled up again from the raw ring on the next boot
   if (_monitor) {
-    aggregate_hourly();
-    aggregate_daily();
-    aggregate_monthly_yearly();
+    close_rings();
     _monitor = nullptr;
   }
 }
 
 void EnergyLogger::setup()
 {
-  _last_sample_time = time(NULL);
-  _last_hour_time   = _last_sample_time;
-  _last_day_time    = _last_sample_time;
-  _last_chunk_time  = _last_sample_time;
-
-  struct tm timeinfo;
-  localtime_r(&_last_sample_time, &timeinfo);
-  _last_month = timeinfo.tm_mon + 1;
-  _last_year = timeinfo.tm_year + 1900;
+  time_t now = time(NULL);
+  if ((unsigned long)now >= ENERGY_LOGGER_TIME_VALID_FLOOR) {
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    _last_month = timeinfo.tm_mon + 1;
+    _last_year = timeinfo.tm_year + 1900;
+  }
 }
 
 unsigned long EnergyLogger::loop(MicroTasks::WakeReason reason)
 {
+  Profile_Scope("EnergyLogger");
   if (!_monitor) {
     return ENERGY_LOGGER_SAMPLE_INTERVAL;
   }
 
-  time_t now = time(NULL);
-
-  // Sampling every 60 seconds
+  // Sampling every 60 seconds, the daily ring is written as each day closes
   sample();
 
-  // Check for hourly aggregation
-  struct tm now_tm, last_tm;
-  localtime_r(&now, &now_tm);
-  localtime_r(&_last_hour_time, &last_tm);
-
-  if (now_tm.tm_hour != last_tm.tm_hour || now_tm.tm_mday != last_tm.tm_mday) {
-    aggregate_hourly();
-    _last_hour_time = now;
-  }
-
-  // Check for 6-hour raw chunk save (boundaries at 00:00, 06:00, 12:00, 18:00)
-  struct tm last_chunk_tm;
-  localtime_r(&_last_chunk_time, &last_chunk_tm);
-  if ((now_tm.tm_hour / ENERGY_LOGGER_RAW_SAVE_HOURS) != (last_chunk_tm.tm_hour / ENERGY_LOGGER_RAW_SAVE_HOURS) ||
-      now_tm.tm_mday != last_chunk_tm.tm_mday ||
-      now_tm.tm_mon  != last_chunk_tm.tm_mon) {
-    save_raw_chunk();
-    _last_chunk_time = now;
-  }
-
-  // Check for daily aggregation (midnight)
-  if (now_tm.tm_mday != last_tm.tm_mday) {
-    aggregate_daily();
-    _last_day_time = now;
-  }
-
-  // Check for monthly/annual aggregation
-  if (now_tm.tm_mon != last_tm.tm_mon || now_tm.tm_year != last_tm.tm_year) {
-    aggregate_monthly_yearly();
-    _last_month = now_tm.tm_mon + 1;
-    _last_year = now_tm.tm_year + 1900;
+  // Check for monthly/annual aggregation. _last_month is seeded the first
+  // time the clock is valid, so NTP setting it after boot is not a new month.
+  time_t now = time(NULL);
+  if ((unsigned long)now >= ENERGY_LOGGER_TIME_VALID_FLOOR) {
+    struct tm now_tm;
+    localtime_r(&now, &now_tm);
+    uint16_t month = now_tm.tm_mon + 1;
+    uint16_t year = now_tm.tm_year + 1900;
+    if (_last_month != 0 && (month != _last_month || year != _last_year)) {
+      aggregate_monthly_yearly();
+    }
+    _last_month = month;
+    _last_year = year;
   }
 
   return ENERGY_LOGGER_SAMPLE_INTERVAL;
@@ -147,180 +268,192 @@ void EnergyLogger::sample()
 {
   if (!_monitor) return;
 
+  // Advance the energy baseline every sample, logged or not, so the deltas
+  // stay honest. A session reset to 0 on unplug gives a small positive
+  // delta (the new session so far), not a negative one.
+  double cur_wh = _monitor->getSessionEnergy();
+  double delta  = (cur_wh >= _last_session_wh) ? (cur_wh - _last_session_wh) : cur_wh;
+  _last_session_wh = cur_wh;
+
+  // A pre-NTP ~1970 timestamp would be refused by the rings from then on
   time_t now = time(NULL);
-  double amps = _monitor->getAmps();
-  // Store 0.0 as the "no valid reading" sentinel; a real 0 °C reading is
-  // indistinguishable but practically impossible for an EVSE environment.
-  double temperature = _monitor->isTemperatureValid(EVSE_MONITOR_TEMP_MONITOR)
-                         ? _monitor->getTemperature(EVSE_MONITOR_TEMP_MONITOR)
-                         : 0.0;
-  double session_energy = _monitor->getSessionEnergy();
+  if ((unsigned long)now < ENERGY_LOGGER_TIME_VALID_FLOOR) return;
 
-  // Add to circular buffer
-  _hourly_buffer[_buffer_index].timestamp = now;
-  _hourly_buffer[_buffer_index].amps = amps;
-  _hourly_buffer[_buffer_index].temperature = temperature;
-  _hourly_buffer[_buffer_index].energy_wh = session_energy;
+  // Same columns as the tsdb logger: temperature always, current, power,
+  // pilot and SoC only while charging. 0 is the no temperature sentinel.
+  EnergySample s;
+  s.energy_wh_delta = delta;
+  s.temp_c = _monitor->isTemperatureValid(EVSE_MONITOR_TEMP_MONITOR)
+               ? _monitor->getTemperature(EVSE_MONITOR_TEMP_MONITOR) : 0;
+  if (_monitor->isCharging()) {
+    s.amps    = _monitor->getAmps();
+    s.volts   = _monitor->getVoltage();
+    s.power_w = s.amps * s.volts;
+    s.soc     = _monitor->isVehicleStateOfChargeValid() ? _monitor->getVehicleStateOfCharge() : -1;
+    s.pilot_a = _monitor->getChargeCurrent();
+  }
+
+  int16_t row[TSDB_NUM_COLS];
+  tsdb_scale_sample(s, row);
+
+  if (!_day_restored) {
+    restore_day(now);
+    _day_restored = true;
+  }
 
-  _buffer_index = (_buffer_index + 1) % ENERGY_LOGGER_BUFFER_SIZE;
-  if (_buffer_count < ENERGY_LOGGER_BUFFER_SIZE) {
-    _buffer_count++;
+  if (!_raw.append((uint32_t)now, row)) {
+    DBUGF("[EnergyLogger] Raw sample not written");
   }
 
-  // Track hourly and daily statistics (daily runs independently of the 3-hour
-  // circular buffer so yesterday's values survive to midnight aggregation)
-  if (temperature > 0) {  // 0 is the invalid/no-sensor sentinel
-    if (temperature > _hour_peak_temp) _hour_peak_temp = temperature;
-    if (temperature < _hour_min_temp)  _hour_min_temp  = temperature;
-    if (temperature > _day_peak_temp)  _day_peak_temp  = temperature;
-    if (temperature < _day_min_temp)   _day_min_temp   = temperature;
+  if (_day.add((uint32_t)start_of_day(now), (uint32_t)now, row)) {
+    write_day(_day.completed());
   }
-  _hour_energy_wh = session_energy;
-  _day_energy_wh  = session_energy;
-  _hour_sample_count++;
 
-  DBUGF("[EnergyLogger] Sample: amps=%.2f, temp=%.2f, energy=%.2f Wh", amps, temperature, session_energy);
+  DBUGF("[EnergyLogger] Sample: amps=%.2f, temp=%.2f, energy=%.2f Wh", s.amps, s.temp_c, delta);
 }
 
-void EnergyLogger::aggregate_hourly()
+void EnergyLogger::open_rings()
 {
-  _hour_peak_temp = -99.0;
-  _hour_min_temp = 99.0;
-  _hour_energy_wh = 0;
-  _hour_sample_count = 0;
+  // Reads the newest segment of each once to find where it left off
+  if (_raw.begin(&_raw_files, raw_capacity())) {
+    if (_raw.created()) remove_legacy_raw();
+  } else {
+    DBUGF("[EnergyLogger] Failed to open %s", ENERGY_LOGGER_RAW_RING);
+  }
+
+  if (_daily.begin(&_daily_files, daily_capacity())) {
+    if (_daily.created()) import_legacy_daily();
+  } else {
+    DBUGF("[EnergyLogger] Failed to open %s", ENERGY_LOGGER_DAILY_RING);
+  }
 
-  DBUG("[EnergyLogger] Hourly aggregation completed");
+  DBUGF("[EnergyLogger] Rings: raw %u/%u in %u segments, daily %u/%u in %u segments",
+        _raw.count(), _raw.capacity(), _raw.segments(),
+        _daily.count(), _daily.capacity(), _daily.segments());
 }
 
-void EnergyLogger::save_raw_chunk()
+void EnergyLogger::close_rings()
 {
-  if (_buffer_count == 0) return;
+  _raw.end();
+  _daily.end();
+  _raw_files.close();
+  _daily_files.close();
+}
 
-  // _last_chunk_time is within the 6-hour block that just completed.
-  // Round its hour down to the block-start (0, 6, 12, or 18).
-  struct tm chunk_tm;
-  localtime_r(&_last_chunk_time, &chunk_tm);
-  chunk_tm.tm_hour = (chunk_tm.tm_hour / ENERGY_LOGGER_RAW_SAVE_HOURS) * ENERGY_LOGGER_RAW_SAVE_HOURS;
-  chunk_tm.tm_min  = 0;
-  chunk_tm.tm_sec  = 0;
-  time_t chunk_start = mktime(&chunk_tm);
-  time_t chunk_end   = chunk_start + ENERGY_LOGGER_RAW_SAVE_HOURS * 3600;
+// The day in progress is only held in RAM, after a reboot roll up what the
+// raw ring has of it
+void EnergyLogger::restore_day(time_t now)
+{
+  uint32_t day_start = (uint32_t)start_of_day(now);
+  EnergyRingQuery q;
+  if (!_raw.query(q, day_start, (uint32_t)now)) return;
 
-  char filepath[64];
-  snprintf(filepath, sizeof(filepath), "%s/%04d-%02d-%02d-%02d.json",
-    ENERGY_LOGGER_RAW_DIR,
-    chunk_tm.tm_year + 1900,
-    chunk_tm.tm_mon + 1,
-    chunk_tm.tm_mday,
-    chunk_tm.tm_hour);
-
-  // Count matching samples to size the JSON document exactly
-  int count = 0;
-  for (int i = 0; i < _buffer_count; i++) {
-    int idx = (_buffer_index - _buffer_count + i + ENERGY_LOGGER_BUFFER_SIZE) % ENERGY_LOGGER_BUFFER_SIZE;
-    if (_hourly_buffer[idx].timestamp >= chunk_start && _hourly_buffer[idx].timestamp < chunk_end)
-      count++;
+  uint32_t ts;
+  int16_t row[TSDB_NUM_COLS];
+  while (_raw.next(q, ts, row)) {
+    _day.add(day_start, ts, row);
   }
+  DBUGF("[EnergyLogger] Restored %u samples of today", _day.current().samples);
+}
 
-  if (count == 0) return;
-
-  const size_t cap = JSON_ARRAY_SIZE(count + 1) + (count + 1) * JSON_OBJECT_SIZE(4) + 64;
-  DynamicJsonDocument doc(cap);
-  JsonArray arr = doc.to<JsonArray>();
+void EnergyLogger::write_day(const RollupPeriod &day)
+{
+  // Already written, the clock has been set back
+  if (_daily.count() > 0 && day.start <= _daily.newest()) return;
 
-  for (int i = 0; i < _buffer_count; i++) {
-    int idx = (_buffer_index - _buffer_count + i + ENERGY_LOGGER_BUFFER_SIZE) % ENERGY_LOGGER_BUFFER_SIZE;
-    RawSample &s = _hourly_buffer[idx];
-    if (s.timestamp >= chunk_start && s.timestamp < chunk_end) {
-      JsonObject obj = arr.createNestedObject();
-      obj["ts"] = (uint32_t)s.timestamp;
-      obj["a"]  = s.amps;
-      obj["t"]  = s.temperature;
-      obj["e"]  = s.energy_wh;
-    }
+  int16_t row[ROLLUP_NUM_COLS];
+  day.toRow(row);
+  if (!_daily.append(day.start, row)) {
+    DBUGF("[EnergyLogger] Failed to write day %u", day.start);
+    return;
   }
 
-  size_t needed = measureJson(doc);
+  DBUGF("[EnergyLogger] Daily aggregation: day=%u, peak=%d, min=%d, energy=%d Wh",
+        day.start, day.temp_max, day.temp_min, day.energy);
+}
 
-  cleanup_old_raw_files();
+// ── Legacy JSON files ─────────────────────────────────────────────────────────
 
-  if (!energy_log_has_budget(needed) || !fs_has_space(needed)) {
-    DBUGF("[EnergyLogger] Insufficient space for raw chunk (%u B needed), skipping", needed);
-    return;
-  }
-  File file = LittleFS.open(filepath, "w");
-  if (!file) {
-    DBUGF("[EnergyLogger] Failed to save raw chunk: %s", filepath);
-    return;
-  }
-  if (serializeJson(doc, file) == 0) {
-    DBUGF("[EnergyLogger] Write failed for raw chunk: %s", filepath);
-    file.close();
-    LittleFS.remove(filepath);
-    return;
-  }
-  file.close();
+// Capacity for one legacy quarterly file: up to 92 days, each with a 10-char date string
+#define QUARTER_JSON_CAP \
+  (JSON_ARRAY_SIZE(93) + 93 * JSON_OBJECT_SIZE(4) + 93 * 16)
 
-  DBUGF("[EnergyLogger] Saved %d raw samples to %s", count, filepath);
-}
+// Up to ENERGY_LOGGER_DAILY_MAX_QTRS * el_scale() files were kept
+#define LEGACY_DAILY_MAX_FILES  (ENERGY_LOGGER_DAILY_MAX_QTRS * 40)
 
-void EnergyLogger::cleanup_old_raw_files()
+// Once, when the daily ring is created: copy the YYYY-QN.json files into it
+// oldest first, then remove them
+void EnergyLogger::import_legacy_daily()
 {
-  time_t cutoff = time(NULL) - (time_t)ENERGY_LOGGER_RAW_KEEP_HOURS * el_scale() * 3600;
-  struct tm cutoff_tm;
-  localtime_r(&cutoff, &cutoff_tm);
-  // Align to the block boundary so we never clip a file that is still in window
-  cutoff_tm.tm_hour = (cutoff_tm.tm_hour / ENERGY_LOGGER_RAW_SAVE_HOURS) * ENERGY_LOGGER_RAW_SAVE_HOURS;
-  cutoff_tm.tm_min  = 0;
-  cutoff_tm.tm_sec  = 0;
-  mktime(&cutoff_tm);
+  File dir = LittleFS.open(ENERGY_LOGGER_DAILY_DIR);
+  if (!dir || !dir.isDirectory()) return;
 
-  // File names are YYYY-MM-DD-HH.json — lexicographic order equals chronological order
-  char cutoff_name[24];
-  snprintf(cutoff_name, sizeof(cutoff_name), "%04d-%02d-%02d-%02d.json",
-    cutoff_tm.tm_year + 1900,
-    cutoff_tm.tm_mon + 1,
-    cutoff_tm.tm_mday,
-    cutoff_tm.tm_hour);
+  uint16_t quarters[LEGACY_DAILY_MAX_FILES];
+  int count = 0;
+  File entry = dir.openNextFile();
+  while (entry) {
+    const char *full = entry.name();
+    const char *slash = strrchr(full, '/');
+    int year = 0, quarter = 0;
+    if (!entry.isDirectory() && count < LEGACY_DAILY_MAX_FILES &&
+        sscanf(slash ? slash + 1 : full, "%d-Q%d.json", &year, &quarter) == 2 &&
+        quarter >= 1 && quarter <= 4)
+    {
+      quarters[count++] = year * 4 + quarter - 1;
+    }
+    entry = dir.openNextFile();
+  }
+  dir.close();
+  std::sort(quarters, quarters + count);
 
-  // Delete files one at a time; re-open the directory after each removal
-  bool deleted;
-  do {
-    deleted = false;
-    File dir = LittleFS.open(ENERGY_LOGGER_RAW_DIR);
-    if (!dir || !dir.isDirectory()) return;
+  for (int i = 0; i < count; i++)
+  {
+    char filepath[64];
+    snprintf(filepath, sizeof(filepath), "%s/%04d-Q%d.json",
+             ENERGY_LOGGER_DAILY_DIR, quarters[i] / 4, quarters[i] % 4 + 1);
 
-    File entry = dir.openNextFile();
-    while (entry) {
-      if (!entry.isDirectory()) {
-        const char *full = entry.name();
-        const char *slash = strrchr(full, '/');
-        const char *name  = slash ? slash + 1 : full;
-        if (strcmp(name, cutoff_name) < 0) {
-          char filepath[64];
-          snprintf(filepath, sizeof(filepath), "%s/%s", ENERGY_LOGGER_RAW_DIR, name);
-          entry.close();
-          LittleFS.remove(filepath);
-          deleted = true;
-          break;
+    File file = LittleFS.open(filepath, "r");
+    if (!file) continue;
+    DynamicJsonDocument doc(QUARTER_JSON_CAP);
+    DeserializationError err = deserializeJson(doc, file);
+    file.close();
+
+    if (!err && doc.is<JsonArray>()) {
+      for (JsonObject item : doc.as<JsonArray>()) {
+        DailyMetrics metrics = DailyMetrics::deserialize(item);
+        struct tm day_tm = {};
+        if (sscanf(metrics.date, "%d-%d-%d", &day_tm.tm_year, &day_tm.tm_mon, &day_tm.tm_mday) != 3) {
+          continue;
         }
+        day_tm.tm_year -= 1900;
+        day_tm.tm_mon  -= 1;
+        day_tm.tm_isdst = -1;
+
+        RollupPeriod day;
+        day.begin((uint32_t)mktime(&day_tm));
+        day.energy   = (int32_t)lround(metrics.energy_wh);
+        day.temp_max = (int16_t)lround(metrics.peak_temp * 10.0);
+        day.temp_min = (int16_t)lround(metrics.min_temp * 10.0);
+        day.samples  = 1;   // not recorded
+        write_day(day);
       }
-      entry = dir.openNextFile();
     }
-  } while (deleted);
+    LittleFS.remove(filepath);
+  }
+  LittleFS.rmdir(ENERGY_LOGGER_DAILY_DIR);
+
+  DBUGF("[EnergyLogger] Imported %d quarterly files, %u days", count, _daily.count());
 }
 
-void EnergyLogger::cleanup_old_daily_files()
+// Once, when the raw ring is created: the 3 hour chunk files are not worth
+// importing, remove them
+void EnergyLogger::remove_legacy_raw()
 {
-  // Files are named YYYY-QN.json — lexicographic order equals chronological order.
-  // Delete the oldest file whenever the count exceeds ENERGY_LOGGER_DAILY_MAX_QTRS.
+  // Delete files one at a time; re-open the directory after each removal
   bool deleted;
   do {
     deleted = false;
-    int count = 0;
-    char oldest_name[24] = {0};
-
-    File dir = LittleFS.open(ENERGY_LOGGER_DAILY_DIR);
+    File dir = LittleFS.open(ENERGY_LOGGER_RAW_DIR);
     if (!dir || !dir.isDirectory()) return;
 
     File entry = dir.openNextFile();
@@ -328,148 +461,42 @@ void EnergyLogger::cleanup_old_daily_files()
       if (!entry.isDirectory()) {
         const char *full = entry.name();
         const char *slash = strrchr(full, '/');
-        const char *name  = slash ? slash + 1 : full;
-        count++;
-        if (oldest_name[0] == '\0' || strcmp(name, oldest_name) < 0)
-          strlcpy(oldest_name, name, sizeof(oldest_name));
+        char filepath[64];
+        snprintf(filepath, sizeof(filepath), "%s/%s", ENERGY_LOGGER_RAW_DIR, slash ? slash + 1 : full);
+        entry.close();
+        LittleFS.remove(filepath);
+        deleted = true;
+        break;
       }
       entry = dir.openNextFile();
     }
-
-    if (count > (int)(ENERGY_LOGGER_DAILY_MAX_QTRS * el_scale()) && oldest_name[0] != '\0') {
-      char filepath[64];
-      snprintf(filepath, sizeof(filepath), "%s/%s", ENERGY_LOGGER_DAILY_DIR, oldest_name);
-      LittleFS.remove(filepath);
-      DBUGF("[EnergyLogger] Removed old quarterly file: %s", filepath);
-      deleted = true;
-    }
   } while (deleted);
+  LittleFS.rmdir(ENERGY_LOGGER_RAW_DIR);
 }
 
-void EnergyLogger::aggregate_daily()
+bool EnergyLogger::load_month(int year, int month,
+                              double &peak_temp, double &min_temp,
+                              double &total_energy_wh)
 {
-  if (!_monitor) return;
-
-  // Compute the date that just ended (yesterday at the moment midnight fires)
-  time_t now = time(NULL);
-  time_t yesterday = now - 86400;
-  struct tm timeinfo;
-  localtime_r(&yesterday, &timeinfo);
-  timeinfo.tm_hour = 0;
-  timeinfo.tm_min  = 0;
-  timeinfo.tm_sec  = 0;
-  time_t start_of_yesterday = mktime(&timeinfo);
-
-  DailyMetrics daily;
-  format_date(start_of_yesterday, daily.date, sizeof(daily.date));
-
-  // Use the running daily accumulators — they track the full 24 h independently
-  // of the 3-hour circular buffer, so no samples are lost to buffer rotation.
-  daily.peak_temp = (_day_peak_temp > -99.0) ? _day_peak_temp : 0;
-  daily.min_temp  = (_day_min_temp  <  99.0) ? _day_min_temp  : 0;
-  daily.energy_wh = _day_energy_wh;
-
-  // Reset accumulators for the new day
-  _day_peak_temp = -99.0;
-  _day_min_temp  =  99.0;
-  _day_energy_wh =   0.0;
-
-  append_daily_to_quarter(daily);
-
-  DBUGF("[EnergyLogger] Daily aggregation: date=%s, peak=%.2f, min=%.2f, energy=%.2f Wh",
-        daily.date, daily.peak_temp, daily.min_temp, daily.energy_wh);
-}
-
-// ── Quarterly daily helpers ───────────────────────────────────────────────────
-
-// Capacity for one quarterly file: up to 92 days, each with a 10-char date string
-#define QUARTER_JSON_CAP \
-  (JSON_ARRAY_SIZE(93) + 93 * JSON_OBJECT_SIZE(4) + 93 * 16)
-
-bool EnergyLogger::append_daily_to_quarter(const DailyMetrics &metrics)
-{
-  // Parse year + month from metrics.date ("YYYY-MM-DD")
-  int year = 0, month = 0, day = 0;
-  sscanf(metrics.date, "%d-%d-%d", &year, &month, &day);
-  int quarter = month_to_quarter(month);
-
-  char filepath[64];
-  snprintf(filepath, sizeof(filepath), "%s/%04d-Q%d.json",
-           ENERGY_LOGGER_DAILY_DIR, year, quarter);
-
-  DynamicJsonDocument doc(QUARTER_JSON_CAP);
-  JsonArray arr = doc.to<JsonArray>();
-
-  File file = LittleFS.open(filepath, "r");
-  if (file) {
-    deserializeJson(doc, file);
-    file.close();
-    if (!doc.is<JsonArray>()) arr = doc.to<JsonArray>();
-  }
-
-  JsonObject obj = arr.createNestedObject();
-  obj["dt"] = (char *)metrics.date;   // char* forces ArduinoJson to copy the string
-  obj["pk"] = metrics.peak_temp;
-  obj["mn"] = metrics.min_temp;
-  obj["en"] = metrics.energy_wh;
-
-  size_t needed = measureJson(doc);
-
-  cleanup_old_daily_files();
-
-  if (!energy_log_has_budget(needed) || !fs_has_space(needed)) {
-    DBUGF("[EnergyLogger] Insufficient space for quarterly file (%u B needed), skipping", needed);
-    return false;
-  }
-  file = LittleFS.open(filepath, "w");
-  if (!file) {
-    DBUGF("[EnergyLogger] Failed to write quarterly file: %s", filepath);
-    return false;
-  }
-  if (serializeJson(doc, file) == 0) {
-    DBUGF("[EnergyLogger] Write failed for quarterly file: %s", filepath);
-    file.close();
-    LittleFS.remove(filepath);
+  EnergyRingQuery q;
+  if (!_daily.query(q, (uint32_t)start_of_month(year, month),
+                       (uint32_t)start_of_month(year, month + 1) - 1))
+  {
     return false;
   }
-  file.close();
-
-  DBUGF("[EnergyLogger] Appended daily entry to %s", filepath);
-  return true;
-}
-
-bool EnergyLogger::load_month_from_quarter(int year, int month,
-                                           double &peak_temp, double &min_temp,
-                                           double &total_energy_wh)
-{
-  int quarter = month_to_quarter(month);
-  char filepath[64];
-  snprintf(filepath, sizeof(filepath), "%s/%04d-Q%d.json",
-           ENERGY_LOGGER_DAILY_DIR, year, quarter);
-
-  File file = LittleFS.open(filepath, "r");
-  if (!file) return false;
-
-  DynamicJsonDocument doc(QUARTER_JSON_CAP);
-  deserializeJson(doc, file);
-  file.close();
-  if (!doc.is<JsonArray>()) return false;
-
-  char month_prefix[8];
-  snprintf(month_prefix, sizeof(month_prefix), "%04d-%02d", year, month);
 
   bool found = false;
-  for (JsonObject item : doc.as<JsonArray>()) {
-    const char *dt = item["dt"] | "";
-    if (strncmp(dt, month_prefix, 7) == 0) {
-      double pk = item["pk"] | 0.0;
-      double mn = item["mn"] | 0.0;
-      double en = item["en"] | 0.0;
-      if (pk > peak_temp) peak_temp = pk;
-      if (mn > 0 && mn < min_temp) min_temp = mn;
-      total_energy_wh += en;
-      found = true;
-    }
+  uint32_t ts;
+  int16_t row[ROLLUP_NUM_COLS];
+  while (_daily.next(q, ts, row)) {
+    RollupPeriod day;
+    day.fromRow(ts, row);
+    double pk = day.temp_max / 10.0;
+    double mn = day.temp_min / 10.0;
+    if (pk > peak_temp) peak_temp = pk;
+    if (mn > 0 && mn < min_temp) min_temp = mn;
+    total_energy_wh += day.energy;
+    found = true;
   }
   return found;
 }
@@ -495,7 +522,7 @@ void EnergyLogger::aggregate_monthly_yearly()
     int prev_month = prev.tm_mon  + 1;
 
     double peak = -99.0, minT = 99.0, energy_wh = 0.0;
-    bool found = load_month_from_quarter(prev_year, prev_month, peak, minT, energy_wh);
+    bool found = load_month(prev_year, prev_month, peak, minT, energy_wh);
 
     if (found && peak > -99.0) {
       MonthlyMetrics monthly;
@@ -607,9 +634,9 @@ bool EnergyLogger::save_annual(const AnnualMetrics &metrics)
 void EnergyLogger::ensure_directories()
 {
   if (!LittleFS.exists(ENERGY_LOGGER_DIR))         LittleFS.mkdir(ENERGY_LOGGER_DIR);
-  if (!LittleFS.exists(ENERGY_LOGGER_DAILY_DIR))   LittleFS.mkdir(ENERGY_LOGGER_DAILY_DIR);
-  if (!LittleFS.exists(ENERGY_LOGGER_RAW_DIR))     LittleFS.mkdir(ENERGY_LOGGER_RAW_DIR);
   if (!LittleFS.exists(ENERGY_LOGGER_MONTHLY_DIR)) LittleFS.mkdir(ENERGY_LOGGER_MONTHLY_DIR);
+  if (!LittleFS.exists(ENERGY_LOGGER_RAW_RING))    LittleFS.mkdir(ENERGY_LOGGER_RAW_RING);
+  if (!LittleFS.exists(ENERGY_LOGGER_DAILY_RING))  LittleFS.mkdir(ENERGY_LOGGER_DAILY_RING);
 }
 
 char *EnergyLogger::format_date(time_t t, char *buf, size_t len)
@@ -694,88 +721,27 @@ AnnualMetrics AnnualMetrics::deserialize(const JsonObject &obj)
   return m;
 }
 
-void EnergyLogger::getRawSamples(JsonDocument &doc, int max_samples, time_t before)
+void EnergyLogger::getRawSamples(Print &out, int max_samples, time_t before)
 {
-  JsonArray arr = doc.createNestedArray("samples");
+  uint32_t end_ts   = (uint32_t)(before > 0 ? before : time(NULL));
+  uint32_t start_ts = end_ts > ENERGY_LOGGER_RAW_WINDOW_S ? end_ts - ENERGY_LOGGER_RAW_WINDOW_S : 0;
 
-  if (before > 0) {
-    // Step back a full save-interval from 'before' to land in the previous
-    // block.  Using 'before - 1' mapped to the SAME block as the current
-    // buffer when the buffer started at a non-boundary time, and the filter
-    // 'ts >= before' then discarded every sample in that file.
-    time_t target = before - (time_t)ENERGY_LOGGER_RAW_SAVE_HOURS * 3600;
-    struct tm file_tm;
-    localtime_r(&target, &file_tm);
-    file_tm.tm_hour = (file_tm.tm_hour / ENERGY_LOGGER_RAW_SAVE_HOURS) * ENERGY_LOGGER_RAW_SAVE_HOURS;
-    file_tm.tm_min  = 0;
-    file_tm.tm_sec  = 0;
-    time_t chunk_start = mktime(&file_tm);
-    time_t chunk_end   = chunk_start + (time_t)ENERGY_LOGGER_RAW_SAVE_HOURS * 3600;
+  out.print("{\"samples\":[");
 
-    char filepath[64];
-    snprintf(filepath, sizeof(filepath), "%s/%04d-%02d-%02d-%02d.json",
-      ENERGY_LOGGER_RAW_DIR,
-      file_tm.tm_year + 1900,
-      file_tm.tm_mon + 1,
-      file_tm.tm_mday,
-      file_tm.tm_hour);
-
-    File file = LittleFS.open(filepath, "r");
-    if (file) {
-      DynamicJsonDocument file_doc(JSON_ARRAY_SIZE(ENERGY_LOGGER_BUFFER_SIZE + 1) + (ENERGY_LOGGER_BUFFER_SIZE + 1) * JSON_OBJECT_SIZE(4) + 128);
-      DeserializationError err = deserializeJson(file_doc, file);
-      file.close();
-
-      if (!err && file_doc.is<JsonArray>()) {
-        int count = 0;
-        for (JsonObject item : file_doc.as<JsonArray>()) {
-          // Return all samples in the chunk — no 'before' filter needed
-          // because we are already pointing at the preceding block.
-          if (max_samples > 0 && count >= max_samples) break;
-          JsonObject obj = arr.createNestedObject();
-          obj["ts"] = item["ts"];
-          obj["a"]  = item["a"];
-          obj["t"]  = item["t"];
-          obj["e"]  = item["e"];
-          count++;
-        }
-      }
-    } else {
-      // File not yet written — search the in-memory buffer for the window
-      for (int i = 0; i < _buffer_count; i++) {
-        int idx = (_buffer_index - _buffer_count + i + ENERGY_LOGGER_BUFFER_SIZE) % ENERGY_LOGGER_BUFFER_SIZE;
-        RawSample &s = _hourly_buffer[idx];
-        if (s.timestamp < chunk_start || s.timestamp >= chunk_end) continue;
-        if (max_samples > 0 && (int)arr.size() >= max_samples) break;
-        JsonObject obj = arr.createNestedObject();
-        obj["ts"] = (uint32_t)s.timestamp;
-        obj["a"]  = s.amps;
-        obj["t"]  = s.temperature;
-        obj["e"]  = s.energy_wh;
-      }
+  EnergyRingQuery q;
+  if (_raw.query(q, start_ts, end_ts)) {
+    uint32_t ts;
+    int16_t  v[TSDB_NUM_COLS];
+    int count = 0;
+    while ((max_samples <= 0 || count < max_samples) && _raw.next(q, ts, v)) {
+      char buf[192];
+      tsdb_sample_json(buf, sizeof(buf), ts, v, 0 == count);
+      out.print(buf);
+      count++;
     }
-    return;
-  }
-
-  // Default: return most-recent in-memory samples
-  int offset = 0;
-  int count  = _buffer_count;
-
-  if (max_samples > 0 && count > max_samples) {
-    offset = count - max_samples;
-    count  = max_samples;
   }
 
-  for (int i = offset; i < offset + count; i++) {
-    int idx = (_buffer_index - _buffer_count + i + ENERGY_LOGGER_BUFFER_SIZE) % ENERGY_LOGGER_BUFFER_SIZE;
-    RawSample &sample = _hourly_buffer[idx];
-
-    JsonObject obj = arr.createNestedObject();
-    obj["ts"] = (uint32_t)sample.timestamp;
-    obj["a"]  = sample.amps;
-    obj["t"]  = sample.temperature;
-    obj["e"]  = sample.energy_wh;
-  }
+  out.print("]}");
 }
 
 void EnergyLogger::getDailyMetrics(JsonDocument &doc, int year, int quarter)
@@ -791,25 +757,28 @@ void EnergyLogger::getDailyMetrics(JsonDocument &doc, int year, int quarter)
 
   JsonArray arr = doc.createNestedArray("daily");
 
-  char filepath[64];
-  snprintf(filepath, sizeof(filepath), "%s/%04d-Q%d.json",
-           ENERGY_LOGGER_DAILY_DIR, year, quarter);
+  int first_month = (quarter - 1) * 3 + 1;
+  EnergyRingQuery q;
+  if (!_daily.query(q, (uint32_t)start_of_month(year, first_month),
+                       (uint32_t)start_of_month(year, first_month + 3) - 1))
+  {
+    return;
+  }
 
-  File file = LittleFS.open(filepath, "r");
-  if (!file) return;
+  uint32_t ts;
+  int16_t row[ROLLUP_NUM_COLS];
+  while (_daily.next(q, ts, row)) {
+    RollupPeriod day;
+    day.fromRow(ts, row);
 
-  DynamicJsonDocument file_doc(QUARTER_JSON_CAP);
-  DeserializationError err = deserializeJson(file_doc, file);
-  file.close();
-  if (err || !file_doc.is<JsonArray>()) return;
+    DailyMetrics metrics;
+    format_date((time_t)ts, metrics.date, sizeof(metrics.date));
+    metrics.peak_temp = day.temp_max / 10.0;
+    metrics.min_temp  = day.temp_min / 10.0;
+    metrics.energy_wh = day.energy;
 
-  for (JsonObject item : file_doc.as<JsonArray>()) {
     JsonObject obj = arr.createNestedObject();
-    const char *dt = item["dt"] | "";
-    obj["dt"] = (char *)dt;   // force copy into doc's pool
-    obj["pk"] = item["pk"] | 0.0;
-    obj["mn"] = item["mn"] | 0.0;
-    obj["en"] = item["en"] | 0.0;
+    metrics.serialize(obj);
   }
 }
 
@@ -6,32 +6,60 @@
 #include <MicroTasks.h>
 #include <LittleFS.h>
 #include "emonesp.h"
+#include "energy_ring.h"
+#include "tsdb_rollup.h"
 
 #define ENERGY_LOGGER_SAMPLE_INTERVAL  60000   // 60 seconds
-#define ENERGY_LOGGER_HOURLY_SAMPLES   60      // 60 samples per hour
-#define ENERGY_LOGGER_BUFFER_SIZE      180     // 3 hours of 1-per-minute samples
 #define ENERGY_LOGGER_DIR              "/logs"
-#define ENERGY_LOGGER_DAILY_DIR        "/logs/daily"
-#define ENERGY_LOGGER_RAW_DIR          "/logs/raw"
-#define ENERGY_LOGGER_RAW_SAVE_HOURS   3       // write a raw chunk file every 3 h
-#define ENERGY_LOGGER_RAW_KEEP_HOURS   6       // keep 6 h = 2 files (~18 KB)
-#define ENERGY_LOGGER_DAILY_MAX_QTRS   2       // keep 2 quarterly files = 6 months (~6 KB)
+#define ENERGY_LOGGER_RAW_RING         "/logs/raw_ring"
+#define ENERGY_LOGGER_DAILY_RING       "/logs/daily_ring"
+#define ENERGY_LOGGER_RAW_WINDOW_S     (3 * 3600)  // /energy/raw returns 3 h at a time
+#define ENERGY_LOGGER_RAW_KEEP_HOURS   6       // 360 samples, up to ~9.7 KB
+#define ENERGY_LOGGER_DAILY_KEEP_DAYS  184     // ~6 months, up to ~6.6 KB
 #define ENERGY_LOGGER_MAX_BYTES        20480   // hard cap for all /logs files (~20 KB)
 #define ENERGY_LOGGER_MONTHLY_DIR      "/logs/monthly"
 #define ENERGY_LOGGER_ANNUAL_FILE      "/logs/annual.json"
+// Wall-clock must be past this (2023-11-14) before samples are logged, the
+// rings refuse anything older than their newest record
+#define ENERGY_LOGGER_TIME_VALID_FLOOR 1700000000UL
 
-// Daily files:   /logs/daily/YYYY-QN.json   (quarterly, appended daily)
+// Raw ring:      TSDB_COL_* rows (tsdb_sample.h), one a minute
+// Daily ring:    ROLLUP_COL_* rows (tsdb_rollup.h), one a day
 // Monthly files: /logs/monthly/YYYY.json    (yearly,    appended monthly, ≤12 entries)
+//
+// Each ring is a directory of energy_ring.h segment files named by number.
+// A sample is appended to the newest segment and the oldest is deleted
+// whole, so nothing is rewritten. The keep limits scale up on larger
+// partitions.
+
+// Legacy JSON files, imported into or replaced by the rings on first boot
+#define ENERGY_LOGGER_DAILY_DIR        "/logs/daily"   // YYYY-QN.json
+#define ENERGY_LOGGER_RAW_DIR          "/logs/raw"
+#define ENERGY_LOGGER_DAILY_MAX_QTRS   2
 
 // Forward declaration
 class EvseManager;
 
-struct RawSample
+// The segment files of a ring, <dir>/<number>
+class EnergyRingFiles : public EnergyRingStorage
 {
-  time_t timestamp;
-  double amps;
-  double temperature;
-  double energy_wh;
+private:
+  const char *_dir;
+  File _file;               // the segment last read, a query mostly stays in one
+  uint32_t _file_segment;
+
+  void path(uint32_t segment, char *buf, size_t len);
+  File &open(uint32_t segment);
+
+public:
+  explicit EnergyRingFiles(const char *dir);
+
+  bool range(uint32_t &first, uint32_t &last) override;
+  size_t size(uint32_t segment) override;
+  bool read(uint32_t segment, uint32_t offset, uint8_t *data, size_t len) override;
+  bool write(uint32_t segment, uint32_t offset, const uint8_t *data, size_t len) override;
+  bool remove(uint32_t segment) override;
+  void close();
 };
 
 struct DailyMetrics
@@ -70,46 +98,39 @@ struct AnnualMetrics
 class EnergyLogger : public MicroTasks::Task
 {
 private:
-  RawSample _hourly_buffer[ENERGY_LOGGER_BUFFER_SIZE];
-  int _buffer_index;
-  int _buffer_count;
-
   EvseManager *_monitor;
 
-  time_t _last_sample_time;
-  time_t _last_hour_time;
-  time_t _last_day_time;
-  time_t _last_chunk_time;   // tracks the raw-file boundary
-  uint16_t _last_month;
-  uint16_t _last_year;
+  EnergyRingFiles _raw_files;
+  EnergyRingFiles _daily_files;
+  EnergyRing _raw;
+  EnergyRing _daily;
 
-  double _hour_peak_temp;
-  double _hour_min_temp;
-  double _hour_energy_wh;
-  uint32_t _hour_sample_count;
+  // The day being accumulated, written to the daily ring when it closes
+  RollupSeries _day;
+  bool _day_restored;
+  double _last_session_wh;   // for the per-sample energy delta
 
-  double _day_peak_temp;
-  double _day_min_temp;
-  double _day_energy_wh;
+  uint16_t _last_month;      // 0 until the clock is valid
+  uint16_t _last_year;
 
   void sample();
-  void aggregate_hourly();
-  void aggregate_daily();
+  void open_rings();
+  void close_rings();
+  void restore_day(time_t now);
+  void write_day(const RollupPeriod &day);
   void aggregate_monthly_yearly();
 
-  // Quarterly daily file helpers
+  // Calendar quarters, as /energy/daily pages by them
   static int month_to_quarter(int month) { return (month - 1) / 3 + 1; }
-  bool append_daily_to_quarter(const DailyMetrics &metrics);
-  bool load_month_from_quarter(int year, int month,
-                               double &peak_temp, double &min_temp,
-                               double &total_energy_wh);
+  bool load_month(int year, int month,
+                  double &peak_temp, double &min_temp,
+                  double &total_energy_wh);
 
   bool save_monthly(const MonthlyMetrics &metrics);
   bool save_annual(const AnnualMetrics &metrics);
 
-  void save_raw_chunk();
-  void cleanup_old_raw_files();
-  void cleanup_old_daily_files();
+  void import_legacy_daily();
+  void remove_legacy_raw();
   void ensure_directories();
 
   char *format_date(time_t t, char *buf, size_t len);
@@ -127,7 +148,9 @@ public:
   void begin(EvseManager *monitor);
   void end();
 
-  void getRawSamples(JsonDocument &doc, int max_samples = 0, time_t before = 0);
+  // Streams {"samples":[...]} as the tsdb /energy/raw does: the
+  // ENERGY_LOGGER_RAW_WINDOW_S before `before` (default now), oldest first
+  void getRawSamples(Print &out, int max_samples = 0, time_t before = 0);
   // year=0 → current year, quarter=0 → current quarter (1-4)
   void getDailyMetrics(JsonDocument &doc, int year = 0, int quarter = 0);
   void getMonthlyMetrics(JsonDocument &doc, int year = 0);
@@ -282,7 +282,7 @@ bool EnergyMeter::update()
 
 bool EnergyMeter::publish()
 {
-  DynamicJsonDocument doc(capacity);
+  StaticJsonDocument<capacity> doc;
   createEnergyMeterJsonDoc(doc);
   event_send(doc);
   return true;
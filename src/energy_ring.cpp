@@ -0,0 +1,263 @@
+#include "energy_ring.h"
+
+#include <string.h>
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+         ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+EnergyRing::EnergyRing(uint8_t num_cols) :
+  _storage(nullptr),
+  _num_cols(num_cols > ENERGY_RING_MAX_COLS ? ENERGY_RING_MAX_COLS : num_cols),
+  _open(false),
+  _created(false),
+  _capacity(0),
+  _per_segment(0),
+  _max_segments(0),
+  _first(0),
+  _segments(0),
+  _last_records(0),
+  _newest(0)
+{
+}
+
+bool EnergyRing::begin(EnergyRingStorage *storage, uint32_t capacity)
+{
+  _storage = storage;
+  _open = false;
+  _created = false;
+  if(nullptr == storage || 0 == capacity) {
+    return false;
+  }
+
+  // Spread the capacity evenly over as few segments as fit it, plus one
+  // more so deleting the oldest still leaves `capacity` records
+  uint32_t fit = (ENERGY_RING_SEGMENT_SIZE - ENERGY_RING_HEADER_SIZE) / recordSize();
+  uint32_t needed = (capacity + fit - 1) / fit;
+  _capacity = capacity;
+  _per_segment = (uint16_t)((capacity + needed - 1) / needed);
+  _max_segments = needed + 1;
+
+  _first = 0;
+  _segments = 0;
+  _last_records = 0;
+  _newest = 0;
+
+  uint32_t first, last;
+  if(_storage->range(first, last))
+  {
+    // A new segment whose header did not get written holds nothing
+    while(last > first && _storage->size(last) < ENERGY_RING_HEADER_SIZE) {
+      _storage->remove(last--);
+    }
+
+    size_t size = _storage->size(last);
+    if(size >= ENERGY_RING_HEADER_SIZE && checkHeader(first) && checkHeader(last))
+    {
+      _first = first;
+      _segments = last - first + 1;
+      _last_records = (size - ENERGY_RING_HEADER_SIZE) / recordSize();
+      if(_last_records > _per_segment) {
+        _last_records = _per_segment;
+      }
+
+      // Smaller than it was
+      while(_segments > _max_segments) {
+        _storage->remove(_first++);
+        _segments--;
+      }
+
+      if(0 == count() || readTs(count() - 1, _newest)) {
+        _open = true;
+        return true;
+      }
+    }
+
+    // Foreign, reshaped or unreadable, start again after it
+    removeAll(first, last);
+    _first = last + 1;
+    _segments = 0;
+    _last_records = 0;
+    _newest = 0;
+  }
+
+  _created = true;
+  _open = true;
+  return true;
+}
+
+void EnergyRing::end()
+{
+  _open = false;
+  _storage = nullptr;
+}
+
+uint32_t EnergyRing::count() const
+{
+  return _segments > 0 ? (_segments - 1) * _per_segment + _last_records : 0;
+}
+
+bool EnergyRing::append(uint32_t ts, const int16_t *values)
+{
+  if(!_open || (count() > 0 && ts < _newest)) {
+    return false;
+  }
+
+  if((0 == _segments || _last_records >= _per_segment) && !startSegment()) {
+    return false;
+  }
+
+  uint8_t record[ENERGY_RING_RECORD_SIZE(ENERGY_RING_MAX_COLS)];
+  put_u32(record, ts);
+  for(uint8_t i = 0; i < _num_cols; i++) {
+    uint16_t v = (uint16_t)values[i];
+    record[4 + 2 * i] = (uint8_t)v;
+    record[5 + 2 * i] = (uint8_t)(v >> 8);
+  }
+
+  // Always at the end of the newest segment. If this fails part way the
+  // next record goes in the same place.
+  uint32_t offset = ENERGY_RING_HEADER_SIZE + _last_records * recordSize();
+  if(!_storage->write(_first + _segments - 1, offset, record, recordSize())) {
+    return false;
+  }
+
+  _last_records++;
+  _newest = ts;
+  return true;
+}
+
+bool EnergyRing::clear()
+{
+  if(!_open) {
+    return false;
+  }
+  if(_segments > 0) {
+    removeAll(_first, _first + _segments - 1);
+  }
+  _first += _segments;
+  _segments = 0;
+  _last_records = 0;
+  _newest = 0;
+  return true;
+}
+
+bool EnergyRing::query(EnergyRingQuery &q, uint32_t start, uint32_t end)
+{
+  q = EnergyRingQuery();
+  uint32_t total = count();
+  if(!_open || 0 == total || start > end) {
+    return false;
+  }
+
+  // First record at or after start
+  uint32_t lo = 0;
+  uint32_t hi = total;
+  while(lo < hi)
+  {
+    uint32_t mid = lo + (hi - lo) / 2;
+    uint32_t ts;
+    if(!readTs(mid, ts)) {
+      return false;
+    }
+    if(ts < start) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  q.index = lo;
+  q.end_index = total;
+  q.end_ts = end;
+  return lo < total;
+}
+
+bool EnergyRing::next(EnergyRingQuery &q, uint32_t &ts, int16_t *values)
+{
+  if(!_open || q.index >= q.end_index || q.index >= count()) {
+    return false;
+  }
+  if(!readRecord(q.index, ts, values) || ts > q.end_ts) {
+    q.index = q.end_index;
+    return false;
+  }
+  q.index++;
+  return true;
+}
+
+bool EnergyRing::checkHeader(uint32_t segment)
+{
+  uint8_t header[ENERGY_RING_HEADER_SIZE];
+  return _storage->read(segment, 0, header, sizeof(header)) &&
+         0 == memcmp(header, ENERGY_RING_MAGIC, 3) &&
+         ENERGY_RING_VERSION == header[3] &&
+         _num_cols == header[4] &&
+         _per_segment == (uint16_t)(header[6] | (header[7] << 8));
+}
+
+bool EnergyRing::startSegment()
+{
+  // Drop the oldest first, so once the ring is at size the new segment
+  // takes the space of the one removed
+  if(_segments >= _max_segments) {
+    _storage->remove(_first++);
+    _segments--;
+  }
+
+  uint8_t header[ENERGY_RING_HEADER_SIZE] = {0};
+  memcpy(header, ENERGY_RING_MAGIC, 3);
+  header[3] = ENERGY_RING_VERSION;
+  header[4] = _num_cols;
+  header[6] = (uint8_t)_per_segment;
+  header[7] = (uint8_t)(_per_segment >> 8);
+  if(!_storage->write(_first + _segments, 0, header, sizeof(header))) {
+    return false;
+  }
+
+  _segments++;
+  _last_records = 0;
+  return true;
+}
+
+void EnergyRing::removeAll(uint32_t first, uint32_t last)
+{
+  for(uint32_t segment = first; segment <= last; segment++) {
+    _storage->remove(segment);
+  }
+}
+
+bool EnergyRing::readRecord(uint32_t index, uint32_t &ts, int16_t *values)
+{
+  uint8_t record[ENERGY_RING_RECORD_SIZE(ENERGY_RING_MAX_COLS)];
+  uint32_t offset = ENERGY_RING_HEADER_SIZE + (index % _per_segment) * recordSize();
+  if(!_storage->read(_first + index / _per_segment, offset, record, recordSize())) {
+    return false;
+  }
+  ts = get_u32(record);
+  for(uint8_t i = 0; i < _num_cols; i++) {
+    values[i] = (int16_t)(uint16_t)(record[4 + 2 * i] | (record[5 + 2 * i] << 8));
+  }
+  return true;
+}
+
+bool EnergyRing::readTs(uint32_t index, uint32_t &ts)
+{
+  uint8_t buf[4];
+  uint32_t offset = ENERGY_RING_HEADER_SIZE + (index % _per_segment) * recordSize();
+  if(!_storage->read(_first + index / _per_segment, offset, buf, sizeof(buf))) {
+    return false;
+  }
+  ts = get_u32(buf);
+  return true;
+}
@@ -0,0 +1,118 @@
+#ifndef ENERGY_RING_H
+#define ENERGY_RING_H
+
+// -------------------------------------------------------------------
+// Ring of timestamped int16 records kept as a run of small segment files
+//
+// The energy history store for boards without room for the tsdb. Records
+// hold the same scaled columns as the tsdb (tsdb_sample.h, tsdb_rollup.h).
+// Each segment is at most ENERGY_RING_SEGMENT_SIZE bytes, a flash block, and
+// is only ever written at its end. When the newest segment is full a new one
+// is started and, once the ring is at size, the oldest segment is deleted.
+// Nothing already written is rewritten, so a sample costs one record
+// appended to one small file however much history is kept.
+//
+// Segment file, numbered in order, the oldest lowest:
+//
+//   0   "OES"                  magic
+//   3   uint8  version         ENERGY_RING_VERSION
+//   4   uint8  num_cols
+//   5   uint8                  reserved, 0
+//   6   uint16 per_segment     records a full segment holds
+//   8   records                uint32 ts, int16 column * num_cols
+//
+// All little endian. Every segment but the newest is full, so the position
+// of a record follows from its index and the head and count are found from
+// the newest segment's size at begin(). Bytes past the last whole record,
+// from an interrupted write, are written over by the next record. Records
+// are in time order, a sample older than the newest one is refused.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+// -------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ENERGY_RING_MAGIC          "OES"
+#define ENERGY_RING_VERSION        2
+#define ENERGY_RING_HEADER_SIZE    8
+#define ENERGY_RING_MAX_COLS       8
+#define ENERGY_RING_SEGMENT_SIZE   4096
+
+#define ENERGY_RING_RECORD_SIZE(num_cols) (4 + 2 * (num_cols))
+
+// The segment files, implemented over LittleFS by the energy logger
+class EnergyRingStorage
+{
+  public:
+    virtual ~EnergyRingStorage() {}
+
+    // Lowest and highest segment numbers present, false if there are none
+    virtual bool range(uint32_t &first, uint32_t &last) = 0;
+    // Size of a segment in bytes, 0 if it does not exist
+    virtual size_t size(uint32_t segment) = 0;
+    virtual bool read(uint32_t segment, uint32_t offset, uint8_t *data, size_t len) = 0;
+    // Write at `offset`, never past the end of the segment. Offset 0
+    // creates the segment.
+    virtual bool write(uint32_t segment, uint32_t offset, const uint8_t *data, size_t len) = 0;
+    virtual bool remove(uint32_t segment) = 0;
+};
+
+struct EnergyRingQuery {
+  uint32_t index = 0;       // next record, 0 is the oldest
+  uint32_t end_index = 0;
+  uint32_t end_ts = 0;
+};
+
+class EnergyRing
+{
+  public:
+    explicit EnergyRing(uint8_t num_cols);
+
+    // Find the segments. Missing or unreadable segments, or ones with a
+    // different number of columns or segment size, are removed and the ring
+    // started again empty. Keeps at least `capacity` records, and up to a
+    // segment more.
+    bool begin(EnergyRingStorage *storage, uint32_t capacity);
+    void end();
+
+    bool append(uint32_t ts, const int16_t *values);
+    bool clear();
+
+    // Records with start <= ts <= end, oldest first
+    bool query(EnergyRingQuery &q, uint32_t start, uint32_t end);
+    bool next(EnergyRingQuery &q, uint32_t &ts, int16_t *values);
+
+    bool isOpen() const { return _open; }
+    // true if begin() started a new, empty ring
+    bool created() const { return _created; }
+    uint8_t numCols() const { return _num_cols; }
+    uint32_t capacity() const { return _capacity; }
+    uint32_t count() const;
+    uint32_t newest() const { return _newest; }
+    size_t recordSize() const { return ENERGY_RING_RECORD_SIZE(_num_cols); }
+    uint16_t perSegment() const { return _per_segment; }
+    uint32_t maxSegments() const { return _max_segments; }
+    uint32_t segments() const { return _segments; }
+
+  private:
+    bool checkHeader(uint32_t segment);
+    bool startSegment();
+    void removeAll(uint32_t first, uint32_t last);
+    bool readRecord(uint32_t index, uint32_t &ts, int16_t *values);
+    bool readTs(uint32_t index, uint32_t &ts);
+
+    EnergyRingStorage *_storage;
+    uint8_t _num_cols;
+    bool _open;
+    bool _created;
+    uint32_t _capacity;
+    uint16_t _per_segment;
+    uint32_t _max_segments;
+    uint32_t _first;          // number of the oldest segment
+    uint32_t _segments;       // segments held, 0 if empty
+    uint32_t _last_records;   // records in the newest segment
+    uint32_t _newest;
+};
+
+#endif // ENERGY_RING_H
@@ -6,6 +6,7 @@
 
 #include "evse_man.h"
 #include "debug.h"
+#include "profile.h"
 
 #include "event_log.h"
 #include "divert.h"
@@ -113,6 +114,21 @@ void EvseManager::Claim::release()
   _client = EvseClient_NULL;
 }
 
+uint8_t EvseManager::Claim::getSets()
+{
+  uint8_t sets = 0;
+  if(getState() != EvseState::None) {
+    sets |= CLAIM_SETS(CLAIM_PROPERTY_STATE);
+  }
+  if(getChargeCurrent() != UINT32_MAX) {
+    sets |= CLAIM_SETS(CLAIM_PROPERTY_CHARGE_CURRENT);
+  }
+  if(getMaxCurrent() != UINT32_MAX) {
+    sets |= CLAIM_SETS(CLAIM_PROPERTY_MAX_CURRENT);
+  }
+  return sets;
+}
+
 EvseManager::EvseManager(Stream &port, EventLog &eventLog) :
   MicroTasks::Task(),
   _sender(&port),
@@ -120,12 +136,16 @@ EvseManager::EvseManager(Stream &port, EventLog &eventLog) :
   _monitor(_openevse),
   _eventLog(eventLog),
   _clients(),
+  _order(),
   _evseStateListener(this),
   _evseBootListener(this),
   _sessionCompleteListener(this),
   _settingsChangedListener(this),
   _targetProperties(EvseState::Active),
   _hasClaims(false),
+  _state_client(EvseClient_NULL),
+  _charge_current_client(EvseClient_NULL),
+  _max_current_client(EvseClient_NULL),
   _sleepForDisable(true),
   _evaluateClaims(true),
   _evaluateTargetState(false),
@@ -151,12 +171,13 @@ void EvseManager::initialiseEvse()
 
 bool EvseManager::findClaim(EvseClient client, Claim **claim)
 {
-  for(size_t i = 0; i < EVSE_MANAGER_MAX_CLIENT_CLAIMS; i++)
+  for(uint8_t i = 0; i < _order.count(); i++)
   {
-    if(_clients[i].isValid() && _clients[i] == client)
+    Claim &slot = _clients[_order.slot(i)];
+    if(slot == client)
     {
       if(claim) {
-        *claim = &(_clients[i]);
+        *claim = &slot;
       }
       return true;
     }
@@ -171,65 +192,34 @@ bool EvseManager::evaluateClaims(EvseProperties &properties)
   properties.clear();
   properties.setState(config_default_state());
 
-  bool foundClaim = false;
-
-  int statePriority = 0;
-  int chargeCurrentPriority = 0;
-  int maxCurrentPriority = 0;
+  _order.evaluate();
 
+  uint8_t slot = _order.winner(CLAIM_PROPERTY_STATE);
   _state_client = EvseClient_NULL;
-  _charge_current_client = EvseClient_NULL;
-  _max_current_client = EvseClient_NULL;
-
-  for(size_t i = 0; i < EVSE_MANAGER_MAX_CLIENT_CLAIMS; i++)
-  {
-    if(_clients[i].isValid())
-    {
-      foundClaim = true;
-
-      DBUGF("Found client, slot %d", i);
-      EvseManager::Claim &claim = _clients[i];
-
-      DBUGVAR(claim.getPriority());
-      DBUGVAR(claim.getState().toString());
-      DBUGVAR(claim.getChargeCurrent());
-      DBUGVAR(claim.getMaxCurrent());
-
-      if(claim.getPriority() > statePriority &&
-         claim.getState() != EvseState::None)
-      {
-        properties.setState(claim.getState());
-        statePriority = claim.getPriority();
-        _state_client = claim.getClient();
-      }
-
-      if(claim.getPriority() > chargeCurrentPriority &&
-         claim.getChargeCurrent() != UINT32_MAX)
-      {
-        properties.setChargeCurrent(claim.getChargeCurrent());
-        chargeCurrentPriority = claim.getPriority();
-        _charge_current_client = claim.getClient();
-      }
+  if(CLAIM_SLOT_NONE != slot) {
+    properties.setState(_clients[slot].getState());
+    _state_client = _clients[slot].getClient();
+  }
 
-      if(claim.getPriority() > maxCurrentPriority &&
-         claim.getMaxCurrent() != UINT32_MAX)
-      {
-        properties.setMaxCurrent(claim.getMaxCurrent());
-        maxCurrentPriority = claim.getPriority();
-        _max_current_client = claim.getClient();
-      }
+  slot = _order.winner(CLAIM_PROPERTY_CHARGE_CURRENT);
+  _charge_current_client = EvseClient_NULL;
+  if(CLAIM_SLOT_NONE != slot) {
+    properties.setChargeCurrent(_clients[slot].getChargeCurrent());
+    _charge_current_client = _clients[slot].getClient();
+  }
 
-      if(claim.getClient() == EvseClient_OpenEVSE_Manual) {
-        const size_t capacity = JSON_OBJECT_SIZE(40) + 1024;
-        // update manual_override event to socket & mqtt
-        DynamicJsonDocument event(capacity);
-        event["manual_override"] = 1;
-        event_send(event);
-      }
-    }
+  slot = _order.winner(CLAIM_PROPERTY_MAX_CURRENT);
+  _max_current_client = EvseClient_NULL;
+  if(CLAIM_SLOT_NONE != slot) {
+    properties.setMaxCurrent(_clients[slot].getMaxCurrent());
+    _max_current_client = _clients[slot].getClient();
   }
 
- return foundClaim;
+  DBUGVAR(_state_client);
+  DBUGVAR(_charge_current_client);
+  DBUGVAR(_max_current_client);
+
+  return _order.count() > 0;
 }
 
 void EvseManager::setup()
@@ -321,6 +311,7 @@ void EvseManager::unlock() {
 
 unsigned long EvseManager::loop(MicroTasks::WakeReason reason)
 {
+  Profile_Scope("EvseManager");
   DBUG("EVSE manager woke: ");
   DBUG(WakeReason_Scheduled == reason ? "WakeReason_Scheduled" :
        WakeReason_Event == reason ? "WakeReason_Event" :
@@ -377,8 +368,9 @@ unsigned long EvseManager::loop(MicroTasks::WakeReason reason)
   DBUGVAR(_settingsChangedListener.IsTriggered());
   if(_settingsChangedListener.IsTriggered())
   {
-    // Settings have changed, re-evaluate claims
+    // Settings have changed, re-evaluate claims and re-apply the pilot limits
     _evaluateClaims = true;
+    _evaluateTargetState = true;
 
     DBUGVAR(_monitor.getPilot());
     DBUGVAR(_monitor.getMinCurrent());
@@ -392,13 +384,18 @@ unsigned long EvseManager::loop(MicroTasks::WakeReason reason)
     _evaluateClaims = false;
 
     // Work out the state we should try and get in too
-    _hasClaims = evaluateClaims(_targetProperties);
+    EvseProperties target;
+    _hasClaims = evaluateClaims(target);
     DBUGVAR(_hasClaims);
-    DBUGVAR(_targetProperties.getState().toString());
-    DBUGVAR(_targetProperties.getChargeCurrent());
-    DBUGVAR(_targetProperties.getMaxCurrent());
+    DBUGVAR(target.getState().toString());
+    DBUGVAR(target.getChargeCurrent());
+    DBUGVAR(target.getMaxCurrent());
 
-    _evaluateTargetState = true;
+    // Nothing to do if the winning claims still want the same
+    if(target != _targetProperties) {
+      _targetProperties = target;
+      _evaluateTargetState = true;
+    }
   }
 
   DBUGVAR(_evaluateTargetState);
@@ -424,28 +421,39 @@ bool EvseManager::claim(EvseClient client, int priority, EvseProperties &target)
 
   DBUGF("Claim from 0x%08x, priority %d, %s", client, priority, target.getState().toString());
 
-  for (size_t i = 0; i < EVSE_MANAGER_MAX_CLIENT_CLAIMS; i++)
+  if(!findClaim(client, &slot))
   {
-    DBUGF("Slot %d %s %p", i, _clients[i].isValid() ? "valid" : "free", slot);
-    if(_clients[i] == client) {
-      slot = &(_clients[i]);
-      break;
-    } else if (NULL == slot && !_clients[i].isValid()) {
-      slot = &(_clients[i]);
+    for (size_t i = 0; i < EVSE_MANAGER_MAX_CLIENT_CLAIMS; i++)
+    {
+      if(!_clients[i].isValid()) {
+        slot = &(_clients[i]);
+        break;
+      }
     }
   }
 
   if(slot)
   {
-    DBUGF("Found slot");
+    uint8_t index = slot - _clients;
+    DBUGF("Found slot %d", index);
+    bool affected = _order.affects(index);
+
     if(slot->claim(client, priority, target))
     {
-      DBUGF("Claim added/updated, waking task");
-      _evaluateClaims = true;
-      MicroTask.wakeTask(this);
+      _order.set(index, priority, slot->getSets());
+
+      // A claim that can't win any property leaves the target as it is
+      if(affected || _order.affects(index))
+      {
+        DBUGF("Claim added/updated, waking task");
+        _evaluateClaims = true;
+        MicroTask.wakeTask(this);
+      }
+
       StaticJsonDocument<128> event;
       event["claims_version"] = ++_version;
       if (client == EvseClient_OpenEVSE_Manual) {
+          event["manual_override"] = 1;
           event["override_version"] = manual.setVersion(manual.getVersion() + 1);
       }
       event_send(event);
@@ -464,14 +472,16 @@ bool EvseManager::release(EvseClient client)
   {
     // if claim is manual override, publish data to socket & mqtt
     if (claim->getClient() == EvseClient_OpenEVSE_Manual) {
-      const size_t capacity = JSON_OBJECT_SIZE(40) + 1024;
-      DynamicJsonDocument event(capacity);
+      StaticJsonDocument<128> event;
       event["manual_override"] = 0;
       event_send(event);
     }
+    if(_order.affects(claim - _clients)) {
+      _evaluateClaims = true;
+      MicroTask.wakeTask(this);
+    }
+    _order.remove(claim - _clients);
     claim->release();
-    _evaluateClaims = true;
-    MicroTask.wakeTask(this);
     StaticJsonDocument<128> event;
     event["claims_version"] = ++_version;
     if (client == EvseClient_OpenEVSE_Manual) {
@@ -492,12 +502,19 @@ void EvseManager::releaseAutoReleaseClaims()
     if(_clients[i].isValid() && _clients[i].isAutoRelease())
     {
       DBUGF("Release claim from 0x%08x, priority %d, %s", _clients[i].getClient(), _clients[i].getPriority(), _clients[i].getState().toString());
+      _order.remove(i);
       _clients[i].release();
       _evaluateClaims = true;
     }
   }
 }
 
+void EvseManager::reevaluateClaims()
+{
+  _evaluateClaims = true;
+  MicroTask.wakeTask(this);
+}
+
 bool EvseManager::clientHasClaim(EvseClient client) {
   return findClaim(client);
 }
@@ -590,6 +607,7 @@ void EvseManager::setVehicleStateOfCharge(int vehicleStateOfCharge)
   _vehicleValid |= EVSE_VEHICLE_SOC;
   _vehicleUpdated |= EVSE_VEHICLE_SOC;
   _vehicleLastUpdated = millis();
+  _vehicleUpdate.Trigger();
   MicroTask.wakeTask(this);
 }
 
@@ -599,6 +617,7 @@ void EvseManager::setVehicleRange(int vehicleRange)
   _vehicleValid |= EVSE_VEHICLE_RANGE;
   _vehicleUpdated |= EVSE_VEHICLE_RANGE;
   _vehicleLastUpdated = millis();
+  _vehicleUpdate.Trigger();
   MicroTask.wakeTask(this);
 }
 
@@ -608,6 +627,7 @@ void EvseManager::setVehicleEta(int vehicleEta)
   _vehicleValid |= EVSE_VEHICLE_ETA;
   _vehicleUpdated |= EVSE_VEHICLE_ETA;
   _vehicleLastUpdated = millis();
+  _vehicleUpdate.Trigger();
   MicroTask.wakeTask(this);
 }
 
@@ -617,6 +637,7 @@ void EvseManager::setVehicleChargeLimit(int vehicleChargeLimit)
   _vehicleValid |= EVSE_VEHICLE_CHARGE_LIMIT;
   _vehicleUpdated |= EVSE_VEHICLE_CHARGE_LIMIT;
   _vehicleLastUpdated = millis();
+  _vehicleUpdate.Trigger();
   MicroTask.wakeTask(this);
 }
 
@@ -642,26 +663,23 @@ bool EvseManager::isRapiCommandBlocked(String rapi)
   #endif
 }
 
-bool EvseManager::serializeClaims(DynamicJsonDocument &doc)
+bool EvseManager::serializeClaims(JsonDocument &doc)
 {
   doc.to<JsonArray>();
 
-  for(size_t i = 0; i < EVSE_MANAGER_MAX_CLIENT_CLAIMS; i++)
+  for(uint8_t i = 0; i < _order.count(); i++)
   {
-    Claim &claim = _clients[i];
-    if(claim.isValid())
-    {
-      JsonObject obj = doc.createNestedObject();
-      obj["client"] = claim.getClient();
-      obj["priority"] = claim.getPriority();
-      claim.getProperties().serialize(obj);
-    }
+    Claim &claim = _clients[_order.slot(i)];
+    JsonObject obj = doc.createNestedObject();
+    obj["client"] = claim.getClient();
+    obj["priority"] = claim.getPriority();
+    claim.getProperties().serialize(obj);
   }
 
   return true;
 }
 
-bool EvseManager::serializeClaim(DynamicJsonDocument &doc, EvseClient client)
+bool EvseManager::serializeClaim(JsonDocument &doc, EvseClient client)
 {
   Claim *claim;
 
@@ -675,7 +693,7 @@ bool EvseManager::serializeClaim(DynamicJsonDocument &doc, EvseClient client)
   return false;
 }
 
-bool EvseManager::serializeTarget(DynamicJsonDocument &doc)
+bool EvseManager::serializeTarget(JsonDocument &doc)
 {
   JsonObject properties = doc.createNestedObject("properties");
   _targetProperties.serialize(properties);
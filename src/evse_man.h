@@ -8,6 +8,7 @@
 
 #include "evse_state.h"
 #include "evse_monitor.h"
+#include "claim_order.h"
 #include "event_log.h"
 #include "json_serialize.h"
 #include "app_config.h"
@@ -37,6 +38,7 @@ typedef uint32_t EvseClient;
 #define EvseClient_OpenEVSE_MQTT              EVC(EvseClient_Vendor_OpenEVSE, 0x000B)
 #define EvseClient_OpenEVSE_Shaper            EVC(EvseClient_Vendor_OpenEVSE, 0x000C)
 #define EvseClient_OpenEVSE_TempThrottle      EVC(EvseClient_Vendor_OpenEVSE, 0x000D)
+#define EvseClient_OpenEVSE_LoadBalancer      EVC(EvseClient_Vendor_OpenEVSE, 0x000E)
 
 #define EvseClient_OpenEnergyMonitor_DemandShaper EVC(EvseClient_Vendor_OpenEnergyMonitor, 0x0001)
 
@@ -65,10 +67,6 @@ typedef uint32_t EvseClient;
 #define EVSE_VEHICLE_ETA    (1 << 2)
 #define EVSE_VEHICLE_CHARGE_LIMIT (1 << 3)
 
-#ifndef EVSE_MANAGER_MAX_CLIENT_CLAIMS
-#define EVSE_MANAGER_MAX_CLIENT_CLAIMS 10
-#endif // !EVSE_MANAGER_MAX_CLIENT_CLAIMS
-
 class EvseProperties : virtual public JsonSerialize<512>
 {
   private:
@@ -216,6 +214,9 @@ class EvseManager : public MicroTasks::Task
         EvseProperties &getProperties() {
           return _properties;
         }
+
+        // CLAIM_SETS() mask of the target properties this claim asks for
+        uint8_t getSets();
     };
 
     RapiSender _sender;
@@ -224,6 +225,8 @@ class EvseManager : public MicroTasks::Task
     EventLog &_eventLog;
 
     Claim _clients[EVSE_MANAGER_MAX_CLIENT_CLAIMS];
+    // Slots of the valid claims, highest priority first, then by slot
+    ClaimOrder _order;
 
     MicroTasks::EventListener _evseStateListener;
     MicroTasks::EventListener _evseBootListener;
@@ -251,6 +254,11 @@ class EvseManager : public MicroTasks::Task
     int _vehicleEta;
     int _vehicleChargeLimit;
 
+    class VehicleUpdateEvent : public MicroTasks::Event
+    {
+      friend class EvseManager;
+    } _vehicleUpdate;
+
     void initialiseEvse();
     bool findClaim(EvseClient client, Claim **claim = NULL);
     bool evaluateClaims(EvseProperties &properties);
@@ -275,6 +283,9 @@ class EvseManager : public MicroTasks::Task
     bool claim(EvseClient client, int priority, EvseProperties &target);
     bool release(EvseClient client);
     bool clientHasClaim(EvseClient client);
+    // Work the target out again, for when something other than a claim
+    // changes it, e.g. the default state
+    void reevaluateClaims();
     uint8_t getClaimsVersion();
 
     EvseProperties &getClaimProperties(EvseClient client);
@@ -291,9 +302,9 @@ class EvseManager : public MicroTasks::Task
       return _charge_current_client;
     }
 
-    bool serializeClaims(DynamicJsonDocument &doc);
-    bool serializeClaim(DynamicJsonDocument &doc, EvseClient client);
-    bool serializeTarget(DynamicJsonDocument &doc);
+    bool serializeClaims(JsonDocument &doc);
+    bool serializeClaim(JsonDocument &doc, EvseClient client);
+    bool serializeTarget(JsonDocument &doc);
 
     // Evse Status
     bool isConnected() {
@@ -615,6 +626,13 @@ class EvseManager : public MicroTasks::Task
     void onSessionComplete(MicroTasks::EventListener *listner) {
       _monitor.onSessionComplete(listner);
     }
+    void onTemperatureChanged(MicroTasks::EventListener *listner) {
+      _monitor.onTemperatureChanged(listner);
+    }
+    // Any of the vehicle SoC, range, ETA or charge limit set
+    void onVehicleUpdate(MicroTasks::EventListener *listner) {
+      _vehicleUpdate.Register(listner);
+    }
 
     bool isRapiCommandBlocked(String rapi);
 };
@@ -171,6 +171,7 @@ EvseMonitor::EvseMonitor(OpenEVSEClass &openevse) :
   _mcp9808(),
 #endif
   _settings_changed(),
+  _temperature_changed(),
   _panic_temperature(72),
   _heartbeat_interval(EVSE_HEATBEAT_INTERVAL),
   _heartbeat_current(EVSE_HEARTBEAT_CURRENT),
@@ -343,6 +344,7 @@ void EvseMonitor::updateCurrentSettings(long min_current, long max_hardware_curr
 
 unsigned long EvseMonitor::loop(MicroTasks::WakeReason reason)
 {
+  Profile_Scope("EvseMonitor");
   DBUG("EVSE monitor woke: ");
   DBUG(WakeReason_Scheduled == reason ? "WakeReason_Scheduled" :
        WakeReason_Event == reason ? "WakeReason_Event" :
@@ -970,6 +972,9 @@ void EvseMonitor::getTemperatureFromEvse()
       }
       #endif
 
+      bool was_valid = _temps[EVSE_MONITOR_TEMP_MONITOR].isValid();
+      double was = _temps[EVSE_MONITOR_TEMP_MONITOR].get();
+
       _temps[EVSE_MONITOR_TEMP_MONITOR].invalidate();
       for(int i = EVSE_MONITOR_TEMP_EVSE_DS3232; i < EVSE_MONITOR_TEMP_COUNT; i++)
       {
@@ -983,6 +988,12 @@ void EvseMonitor::getTemperatureFromEvse()
           break;
         }
       }
+
+      if(was_valid != _temps[EVSE_MONITOR_TEMP_MONITOR].isValid() ||
+         was != _temps[EVSE_MONITOR_TEMP_MONITOR].get())
+      {
+        _temperature_changed.Trigger();
+      }
       _data_ready.ready(EVSE_MONITOR_TEMP_DATA_READY);
     }
   });
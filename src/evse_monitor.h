@@ -107,6 +107,11 @@ class EvseMonitor : public MicroTasks::Task
       friend class EvseMonitor;
     };
 
+    class TemperatureChangedEvent : public MicroTasks::Event
+    {
+      friend class EvseMonitor;
+    };
+
     class Temperature
     {
       private:
@@ -188,6 +193,7 @@ class EvseMonitor : public MicroTasks::Task
 #endif
 
     SettingsChangedEvent _settings_changed; // Settings changed
+    TemperatureChangedEvent _temperature_changed; // EVSE_MONITOR_TEMP_MONITOR value or validity changed
 
     void updateFaultCounters(int ret, long gfci_count, long nognd_count, long stuck_count);
 
@@ -450,6 +456,9 @@ class EvseMonitor : public MicroTasks::Task
     void onSessionComplete(MicroTasks::EventListener *listner) {
       _session_complete.Register(listner);
     }
+    void onTemperatureChanged(MicroTasks::EventListener *listner) {
+      _temperature_changed.Register(listner);
+    }
   };
 
 #endif // _OPENEVSE_EVSE_MONITOR_H
@@ -0,0 +1,175 @@
+#include <Arduino.h>
+
+#include "heap_monitor.h"
+#include "emonesp.h"
+
+#if defined(ESP32) && !defined(EPOXY_DUINO)
+#include <esp_heap_caps.h>
+#define HEAP_CAPS MALLOC_CAP_8BIT
+#else
+#include <malloc.h>
+#endif
+
+HeapMonitor heapMonitor;
+
+#ifdef ENABLE_HEAP_TRACKING
+
+// Linked with -Wl,--wrap=malloc etc, calls to malloc() land in
+// __wrap_malloc() and the real one is __real_malloc(). Sizes are those of
+// the block handed out, so allocs and frees of the same block match.
+
+#if defined(ESP32) && !defined(EPOXY_DUINO)
+#define heap_block_size(ptr) heap_caps_get_allocated_size(ptr)
+#else
+#define heap_block_size(ptr) malloc_usable_size(ptr)
+#endif
+
+// Nothing is counted until begin(), the running section is thread local
+// and that is not set up for the allocations made while booting
+static volatile bool heap_tracking_active = false;
+
+extern "C" {
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size)
+{
+  void *ptr = __real_malloc(size);
+  if(ptr && heap_tracking_active) {
+    TaskProfiler::recordAlloc(heap_block_size(ptr));
+  }
+  return ptr;
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+  void *ptr = __real_calloc(count, size);
+  if(ptr && heap_tracking_active) {
+    TaskProfiler::recordAlloc(heap_block_size(ptr));
+  }
+  return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  if(false == heap_tracking_active) {
+    return __real_realloc(ptr, size);
+  }
+
+  size_t old_size = ptr ? heap_block_size(ptr) : 0;
+  void *new_ptr = __real_realloc(ptr, size);
+  if(new_ptr)
+  {
+    if(ptr) {
+      TaskProfiler::recordFree(old_size);
+    }
+    TaskProfiler::recordAlloc(heap_block_size(new_ptr));
+  }
+  else if(ptr && 0 == size)
+  {
+    // Freed
+    TaskProfiler::recordFree(old_size);
+  }
+  return new_ptr;
+}
+
+void __wrap_free(void *ptr)
+{
+  if(ptr && heap_tracking_active) {
+    TaskProfiler::recordFree(heap_block_size(ptr));
+  }
+  __real_free(ptr);
+}
+
+} // extern "C"
+
+#endif // ENABLE_HEAP_TRACKING
+
+HeapMonitor::HeapMonitor() :
+  MicroTasks::Task(),
+  _trend()
+{
+}
+
+void HeapMonitor::begin()
+{
+#ifdef ENABLE_HEAP_TRACKING
+  heap_tracking_active = true;
+#endif
+  MicroTask.startTask(this);
+}
+
+void HeapMonitor::setup()
+{
+}
+
+unsigned long HeapMonitor::loop(MicroTasks::WakeReason reason)
+{
+  _trend.add(millis(), getFree(), getLargestFreeBlock());
+  return HEAP_MONITOR_INTERVAL;
+}
+
+void HeapMonitor::reset()
+{
+  _trend.clear();
+  _trend.add(millis(), getFree(), getLargestFreeBlock());
+  profiler.resetHeap(millis());
+}
+
+#if defined(ESP32) && !defined(EPOXY_DUINO)
+
+uint32_t HeapMonitor::getFree()
+{
+  return heap_caps_get_free_size(HEAP_CAPS);
+}
+
+uint32_t HeapMonitor::getLargestFreeBlock()
+{
+  return heap_caps_get_largest_free_block(HEAP_CAPS);
+}
+
+uint32_t HeapMonitor::getMinFree() const
+{
+  return heap_caps_get_minimum_free_size(HEAP_CAPS);
+}
+
+#else
+
+// glibc does not report the largest free block, the top of the heap is
+// used, a lower bound. Free space below it is in holes, so the trend still
+// shows fragmentation growing.
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define heap_mallinfo mallinfo2
+#else
+#define heap_mallinfo mallinfo
+#endif
+
+uint32_t HeapMonitor::getFree()
+{
+  return heap_mallinfo().fordblks;
+}
+
+uint32_t HeapMonitor::getLargestFreeBlock()
+{
+  return heap_mallinfo().keepcost;
+}
+
+uint32_t HeapMonitor::getMinFree() const
+{
+  return _trend.minFree();
+}
+
+#endif
+
+bool HeapMonitor::isTracking()
+{
+#ifdef ENABLE_HEAP_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
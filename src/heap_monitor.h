@@ -0,0 +1,56 @@
+#ifndef _OPENEVSE_HEAP_MONITOR_H
+#define _OPENEVSE_HEAP_MONITOR_H
+
+// -------------------------------------------------------------------
+// Heap telemetry, served at /debug/heap
+//
+// Samples the free heap and largest free block every
+// HEAP_MONITOR_INTERVAL ms into a HeapTrend.
+//
+// Built with ENABLE_HEAP_TRACKING (see heap_tracking_flags in
+// platformio.ini) malloc, calloc, realloc and free are wrapped at link time
+// and each call is counted against the profiled section running at the
+// time (task_profiler.h), so the MicroTask or HTTP handler churning the
+// heap can be found. Only calls from our own code are seen on the native
+// build, the host C++ runtime's operator new is not wrapped.
+// -------------------------------------------------------------------
+
+#include <MicroTasks.h>
+
+#include "heap_trend.h"
+
+#ifndef HEAP_MONITOR_INTERVAL
+#define HEAP_MONITOR_INTERVAL (60 * 1000)
+#endif
+
+class HeapMonitor : public MicroTasks::Task
+{
+  private:
+    HeapTrend _trend;
+
+  protected:
+    void setup();
+    unsigned long loop(MicroTasks::WakeReason reason);
+
+  public:
+    HeapMonitor();
+
+    void begin();
+
+    // Clear the series and the per-section counts
+    void reset();
+
+    const HeapTrend &trend() const { return _trend; }
+
+    static uint32_t getFree();
+    static uint32_t getLargestFreeBlock();
+    // Lowest free heap since boot, where the platform keeps it, otherwise
+    // the lowest sampled
+    uint32_t getMinFree() const;
+
+    static bool isTracking();
+};
+
+extern HeapMonitor heapMonitor;
+
+#endif // _OPENEVSE_HEAP_MONITOR_H
@@ -0,0 +1,50 @@
+#include "heap_trend.h"
+
+uint8_t HeapSample::fragmentation() const
+{
+  if(0 == free || largest >= free) {
+    return 0;
+  }
+  return (uint8_t)(100 - ((uint64_t)largest * 100) / free);
+}
+
+HeapTrend::HeapTrend()
+{
+  clear();
+}
+
+void HeapTrend::add(uint32_t time, uint32_t free, uint32_t largest)
+{
+  size_t index;
+  if(_count < HEAP_TREND_SAMPLES) {
+    index = (_first + _count++) % HEAP_TREND_SAMPLES;
+  } else {
+    index = _first;
+    _first = (_first + 1) % HEAP_TREND_SAMPLES;
+  }
+
+  HeapSample &sample = _samples[index];
+  sample.time = time;
+  sample.free = free;
+  sample.largest = largest;
+
+  if(free < _min_free) {
+    _min_free = free;
+  }
+  if(largest < _min_largest) {
+    _min_largest = largest;
+  }
+}
+
+void HeapTrend::clear()
+{
+  _first = 0;
+  _count = 0;
+  _min_free = UINT32_MAX;
+  _min_largest = UINT32_MAX;
+}
+
+const HeapSample &HeapTrend::get(size_t index) const
+{
+  return _samples[(_first + index) % HEAP_TREND_SAMPLES];
+}
@@ -0,0 +1,56 @@
+#ifndef _OPENEVSE_HEAP_TREND_H
+#define _OPENEVSE_HEAP_TREND_H
+
+// Recent heap samples, for spotting a slow leak or growing fragmentation.
+//
+// Free heap alone hides fragmentation: a unit can report 60 KB free and
+// still fail to allocate a 4 KB JSON document if no single free block is
+// that large. Each sample keeps both the free total and the largest free
+// block, the oldest samples are dropped once HEAP_TREND_SAMPLES are held.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef HEAP_TREND_SAMPLES
+#define HEAP_TREND_SAMPLES 60
+#endif
+
+struct HeapSample
+{
+  uint32_t time;      // ms
+  uint32_t free;
+  uint32_t largest;   // largest free block
+
+  // Percentage of the free heap that is not in the largest block
+  uint8_t fragmentation() const;
+};
+
+class HeapTrend
+{
+  public:
+    HeapTrend();
+
+    void add(uint32_t time, uint32_t free, uint32_t largest);
+    void clear();
+
+    // Oldest first
+    size_t count() const { return _count; }
+    const HeapSample &get(size_t index) const;
+    const HeapSample &latest() const { return get(_count - 1); }
+
+    // Lowest free heap and largest block seen since the last clear(), the
+    // samples in the series only hold the most recent
+    uint32_t minFree() const { return _min_free; }
+    uint32_t minLargest() const { return _min_largest; }
+
+  private:
+    HeapSample _samples[HEAP_TREND_SAMPLES];
+    size_t _first;
+    size_t _count;
+    uint32_t _min_free;
+    uint32_t _min_largest;
+};
+
+#endif // _OPENEVSE_HEAP_TREND_H
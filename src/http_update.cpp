@@ -8,14 +8,24 @@
 #include "emonesp.h"
 #include "web_server.h"
 #include "ota_signing.h"
+#include "ota_stream.h"
+#include "ota_decoder.h"
 #include "ota_url_allow.h"
 #include <MongooseHttpClient.h>
 #include <Update.h>
 
+#if defined(ESP32) && !defined(EPOXY_DUINO)
+#include <esp_ota_ops.h>
+#endif
+
 MongooseHttpClient client;
 static int lastPercent = -1;
+static unsigned long lastProgress = 0;
 static size_t update_total_size = 0;
 static size_t update_position = 0;
+static bool update_started = false;
+static String update_source;
+static OtaImageDecoder decoder;
 
 struct HttpUpdateRequestState
 {
@@ -75,7 +85,7 @@ bool http_update_from_url(String url,
       {
         size_t total = response->contentLength();
         DBUGVAR(total);
-        if(Update.isRunning() || http_update_start(url, total))
+        if(http_update_running() || http_update_start(url, total))
         {
           state->startedUpdate = true;
           uint8_t *data = (uint8_t *)response->body().c_str();
@@ -137,7 +147,7 @@ bool http_update_from_url(String url,
           return;
         }
 
-        if(!state->startedUpdate || !Update.isRunning())
+        if(!state->startedUpdate || !http_update_running())
         {
           if(!state->errorReported)
           {
@@ -150,7 +160,7 @@ bool http_update_from_url(String url,
         if(update_total_size > 0)
         {
           DEBUG_PORT.printf("Update incomplete: %zu/%zu bytes\n", update_position, update_total_size);
-          Update.abort();
+          http_update_abort();
           state->errorReported = true;
           error(HTTP_UPDATE_ERROR_INCOMPLETE_DOWNLOAD);
           return;
@@ -175,10 +185,7 @@ bool http_update_from_url(String url,
       DBUGLN("Update onClose");
       if(state->startedUpdate && !state->updateComplete && !state->responseComplete)
       {
-        if(Update.isRunning())
-        {
-          Update.abort();
-        }
+        http_update_abort();
         if(!state->errorReported)
         {
           error(HTTP_UPDATE_ERROR_INCOMPLETE_DOWNLOAD);
@@ -199,108 +206,213 @@ bool http_update_from_url(String url,
   return false;
 }
 
-bool http_update_start(String source, size_t total)
+// Reads the running firmware, the base image for delta updates
+static bool http_update_read_base(uint32_t offset, uint8_t *data, size_t len)
 {
-  update_position = 0;
-  update_total_size = total;
-  lastPercent = -1;
+#if defined(ESP32) && !defined(EPOXY_DUINO)
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  if(NULL == running || offset + len > running->size) {
+    return false;
+  }
+  feedLoopWDT();
+  return ESP_OK == esp_partition_read(running, offset, data, len);
+#else
+  return false;
+#endif
+}
+
+// Called by the decoder once it knows the size of the image being received
+static bool http_update_begin_image(const OtaImageInfo &info)
+{
+  size_t size = info.packed ? info.image_size : update_total_size;
 
   // Signed-OTA builds must know the exact image size up front: the verifier
   // hashes (total - 512) bytes and treats the trailing 512 as the signature,
   // so an unknown Content-Length would hash the signature into the firmware and
   // always fail. Reject rather than silently mis-verify.
-  if(ota_signing_required() && total == 0)
+  if(ota_signing_required() && size == 0)
   {
     DEBUG_PORT.println(F("Signed OTA requires a known Content-Length; refusing update"));
     return false;
   }
 
-  // Install the image-signature verifier before begin() (no-op unless this is a
-  // signed-OTA build). If it is required but cannot be installed, fail closed.
-  if(!ota_install_signature())
+  // Pass the expected size so the library can (a) reject an oversized binary
+  // before erasing the target partition, and (b) validate completeness at end().
+  // Fall back to UPDATE_SIZE_UNKNOWN only when Content-Length is absent.
+  if(!Update.begin(size > 0 ? size : UPDATE_SIZE_UNKNOWN))
   {
-    DEBUG_PORT.println(F("Failed to install OTA signature verifier; refusing update"));
+    DEBUG_PORT.printf("Update begin failed: %d (%s)\n", Update.getError(), Update.errorString());
     return false;
   }
 
-  // Pass the expected size so the library can (a) reject an oversized binary
-  // before erasing the target partition, and (b) validate completeness at end().
-  // Fall back to UPDATE_SIZE_UNKNOWN only when Content-Length is absent.
-  if(Update.begin(total > 0 ? total : UPDATE_SIZE_UNKNOWN))
+  DEBUG_PORT.printf("Update Start: %s %zu%s\n", update_source.c_str(), size,
+                    info.packed ? " (packed)" : "");
+
+  // Flash is programmed by the stream's writer task from here on
+  if(!ota_stream_begin())
   {
-    DEBUG_PORT.printf("Update Start: %s %zu\n", source.c_str(), total);
+    DEBUG_PORT.println(F("Failed to start OTA writer; refusing update"));
+    Update.abort();
+    return false;
+  }
 
-    lcd.display(F("Updating WiFi"), 0, 0, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW);
-    lcd.display(F(""), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW);
-    StaticJsonDocument<128> event;
-    event["ota"] = "started";
-    web_server_event(event);
-    return true;
+  return true;
+}
+
+bool http_update_start(String source, size_t total)
+{
+  update_position = 0;
+  update_total_size = total;
+  update_source = source;
+  lastPercent = -1;
+  lastProgress = 0;
+
+  // Install the image-signature verifier before begin() (no-op unless this is a
+  // signed-OTA build). If it is required but cannot be installed, fail closed.
+  if(!ota_install_signature())
+  {
+    DEBUG_PORT.println(F("Failed to install OTA signature verifier; refusing update"));
+    return false;
   }
 
-  return false;
+  // The file may be a packed image (see ota_decoder.h) whose real size is in
+  // its header, so Update.begin() waits for the decoder to read that.
+  decoder.begin(http_update_begin_image,
+    [](const uint8_t *data, size_t len) {
+      return ota_stream_write(data, len);
+    },
+    http_update_read_base);
+  update_started = true;
+
+  lcd.display(F("Updating WiFi"), 0, 0, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
+  lcd.display(F(""), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
+  StaticJsonDocument<128> event;
+  event["ota"] = "started";
+  web_server_event(event);
+  return true;
 }
 
 bool http_update_write(uint8_t *data, size_t len)
 {
   // Issue #187 "HTTP update fails on ESP32 ethernet gateway" was caused by the
-  // loop watchdog timing out, presumably because updating wasn't bottlenecked
-  // by network and execution stayed in the Mongoose poll() method.
+  // loop watchdog timing out. The flash writes now happen on the stream's own
+  // task, but this can still block while every buffer is waiting on flash.
   feedLoopWDT();
 
   DBUGF("Update Writing %u, %u", update_position, len);
-  size_t written = Update.write(data, len);
-  DBUGVAR(written);
-  if(written == len)
+  if(!update_started) {
+    return false;
+  }
+  if(!decoder.write(data, len)) {
+    DEBUG_PORT.printf("Update write failed: %s\n", OtaImageDecoder::errorString(decoder.error()));
+    return false;
+  }
+
+  update_position += len;
+  if(update_total_size > 0)
   {
-    update_position += len;
-    if(update_total_size > 0)
+    int percent = (int)((update_position * 100) / update_total_size);
+    percent = min(percent, 100);
+    DBUGVAR(percent);
+    DBUGVAR(lastPercent);
+
+    // Reporting every percent costs an LCD redraw and a WebSocket send per
+    // step, which slows the download on fast links. Rate limit it but always
+    // show 100%.
+    if(percent != lastPercent &&
+       (100 == percent || millis() - lastProgress >= HTTP_UPDATE_PROGRESS_INTERVAL))
     {
-      int percent = (int)((update_position * 100) / update_total_size);
-      percent = min(percent, 100);
-      DBUGVAR(percent);
-      DBUGVAR(lastPercent);
-      if(percent != lastPercent)
-      {
-        String text = String(percent) + F("%");
-        lcd.display(text, 0, 1, 10 * 1000, LCD_DISPLAY_NOW);
+      OtaStreamStats stats;
+      ota_stream_get_stats(stats);
 
-        DEBUG_PORT.printf("Update: %d%%\n", percent);
+      String text = String(percent) + F("% ") + String(stats.bytes_per_sec / 1024) + F("kB/s");
+      lcd.display(text, 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
 
-        StaticJsonDocument<128> event;
-        event["ota_progress"] = percent;
-        web_server_event(event);
-        yield();
-        lastPercent = percent;
-      }
-    }
+      DEBUG_PORT.printf("Update: %d%% %u B/s\n", percent, stats.bytes_per_sec);
 
-    return true;
+      StaticJsonDocument<128> event;
+      event["ota_progress"] = percent;
+      event["ota_rate"] = stats.bytes_per_sec;
+      web_server_event(event);
+      yield();
+      lastPercent = percent;
+      lastProgress = millis();
+    }
   }
 
-  return false;
+  return true;
 }
 
 bool http_update_end(bool evenIfRemaining)
 {
   DBUGLN("Upload finished");
-  if(Update.end(evenIfRemaining))
+
+  bool decoded = update_started && decoder.end();
+  if(update_started && !decoded) {
+    DEBUG_PORT.printf("Update failed: %s\n", OtaImageDecoder::errorString(decoder.error()));
+  }
+  update_started = false;
+
+  // Drain the last buffers to flash before committing the image
+  bool written = ota_stream_end();
+  OtaStreamStats stats;
+  ota_stream_get_stats(stats);
+
+  uint8_t digest[32];
+  ota_stream_sha256(digest);
+  bool hashOk = ota_check_sha256(digest);
+  if(!hashOk) {
+    DEBUG_PORT.println(F("Update failed: SHA-256 mismatch"));
+  }
+
+  if(decoded && written && hashOk && Update.end(evenIfRemaining))
   {
     DBUGF("Update Success: %u", update_position);
-    lcd.display(F("Complete"), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW);
+    lcd.display(F("Complete"), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
     StaticJsonDocument<128> event;
     event["ota"] = "completed";
+    event["ota_rate"] = stats.bytes_per_sec;
+    event["ota_stall"] = stats.stall_ms;
     web_server_event(event);
     yield();
     return true;
   } else {
     DEBUG_PORT.printf("Update failed: %d (%s)\n", Update.getError(), Update.errorString());
+    if(Update.isRunning()) {
+      Update.abort();
+    }
     StaticJsonDocument<128> event;
     event["ota"] = "failed";
     web_server_event(event);
     yield();
-    lcd.display(F("Error"), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW);
+    lcd.display(F("Error"), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
   }
 
   return false;
 }
+
+bool http_update_running()
+{
+  return update_started;
+}
+
+void http_update_loop()
+{
+  // Hashing all of the running image when the header arrived would hold up
+  // the web server, so a delta's base is checked a step per loop instead.
+  // A mismatch fails the next write.
+  if(update_started && decoder.verifying() && !decoder.verify()) {
+    DEBUG_PORT.printf("Update failed: %s\n", OtaImageDecoder::errorString(decoder.error()));
+  }
+}
+
+void http_update_abort()
+{
+  update_started = false;
+  decoder.reset();
+  ota_stream_abort();
+  ota_expect_sha256(NULL);
+  if(Update.isRunning()) {
+    Update.abort();
+  }
+}
@@ -16,6 +16,11 @@
 
 #define HTTP_UPDATE_OK                                 0
 
+// Minimum time between progress events/LCD updates (ms)
+#ifndef HTTP_UPDATE_PROGRESS_INTERVAL
+#define HTTP_UPDATE_PROGRESS_INTERVAL                500
+#endif
+
 // True if `url` is an HTTPS URL on a host permitted for firmware fetch
 // (OpenEVSE's GitHub release hosts). Enforced on both the initial fetch and any
 // redirect target, so a device can only pull firmware from a trusted origin.
@@ -26,8 +31,16 @@ bool http_update_from_url(String url,
   std::function<void(int)> success,
   std::function<void(int)> error);
 
+// Accepts a plain application image or one packed by scripts/pack_firmware.py
+// (compressed and/or a delta against the running firmware), see ota_decoder.h
 bool http_update_start(String source, size_t total);
 bool http_update_write(uint8_t *data, size_t len);
 bool http_update_end(bool evenIfRemaining = true);
+// True between http_update_start() and http_update_end()/http_update_abort()
+bool http_update_running();
+// Discard a partially written update, safe to call when none is running
+void http_update_abort();
+// Checks a delta's running image a step at a time, call from the main loop
+void http_update_loop();
 
 #endif // _HTTP_UPDATE_H
@@ -14,11 +14,11 @@
 #include "net_manager.h"
 #include "openevse.h"
 #include "espal.h"
-#include "emoncms.h"
-#include "tesla_client.h"
 #include "manual.h"
 #include "mqtt.h"
 #include "rfid.h"
+#include "pooled_json.h"
+#include "publisher.h"
 
 #include "LedManagerTask.h"
 
@@ -50,17 +50,11 @@ class InputTask : public MicroTasks::Task
       {
         if(!Update.isRunning())
         {
-          DynamicJsonDocument data(4096);
+          PooledJsonDocument data(4096);
 
           create_rapi_json(data); // create JSON Strings for EmonCMS and MQTT
-          event_send(data);
-          // Already evented to MQTT etc
-          teslaClient.getChargeInfoJson(data);
-          emoncms_publish(data);
-          // Publish EnergyMeter data if not charging
-          if(!evse.isCharging()) {
-            evse.publishEnergyMeter();
-          }
+          // Sent on to the WebSocket, MQTT, emoncms etc from the network loop
+          publisher.snapshot(data);
         }
       }
 
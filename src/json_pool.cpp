@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_pool.h"
+
+JsonPool jsonPool;
+
+static const size_t class_size[JSON_POOL_CLASSES] = {
+  JSON_POOL_SMALL_SIZE,
+  JSON_POOL_MEDIUM_SIZE,
+  JSON_POOL_LARGE_SIZE
+};
+
+static const uint8_t class_blocks[JSON_POOL_CLASSES] = {
+  JSON_POOL_SMALL_BLOCKS,
+  JSON_POOL_MEDIUM_BLOCKS,
+  JSON_POOL_LARGE_BLOCKS
+};
+
+static_assert(JSON_POOL_SMALL_SIZE < JSON_POOL_MEDIUM_SIZE && JSON_POOL_MEDIUM_SIZE < JSON_POOL_LARGE_SIZE,
+              "JSON pool classes must be in size order");
+static_assert(JSON_POOL_SMALL_BLOCKS <= 32 && JSON_POOL_MEDIUM_BLOCKS <= 32 && JSON_POOL_LARGE_BLOCKS <= 32,
+              "JSON pool classes are limited to 32 blocks");
+
+JsonPool::JsonPool() :
+  _misses(0),
+  _largest_miss(0)
+{
+  size_t offset = 0;
+  for(uint8_t cls = 0; cls < JSON_POOL_CLASSES; cls++)
+  {
+    _offset[cls] = offset;
+    offset += class_size[cls] * class_blocks[cls];
+
+    _free[cls] = class_blocks[cls] < 32 ? (1UL << class_blocks[cls]) - 1 : UINT32_MAX;
+    _stats[cls].size = class_size[cls];
+    _stats[cls].blocks = class_blocks[cls];
+    _stats[cls].in_use = 0;
+    _stats[cls].high_water = 0;
+    _stats[cls].leases = 0;
+  }
+}
+
+uint8_t *JsonPool::block(uint8_t cls, uint8_t index)
+{
+  return _storage + _offset[cls] + class_size[cls] * index;
+}
+
+void *JsonPool::allocate(size_t size)
+{
+  for(uint8_t cls = 0; cls < JSON_POOL_CLASSES; cls++)
+  {
+    if(size > class_size[cls] || 0 == _free[cls]) {
+      continue;
+    }
+
+    uint8_t index = __builtin_ctz(_free[cls]);
+    _free[cls] &= ~(1UL << index);
+
+    JsonPoolStats &stats = _stats[cls];
+    stats.leases++;
+    if(++stats.in_use > stats.high_water) {
+      stats.high_water = stats.in_use;
+    }
+    return block(cls, index);
+  }
+
+  _misses++;
+  if(size > _largest_miss) {
+    _largest_miss = size;
+  }
+  return malloc(size);
+}
+
+void JsonPool::deallocate(void *ptr)
+{
+  if(nullptr == ptr) {
+    return;
+  }
+
+  if(!owns(ptr)) {
+    free(ptr);
+    return;
+  }
+
+  size_t offset = (uint8_t *)ptr - _storage;
+  uint8_t cls = JSON_POOL_CLASSES - 1;
+  while(offset < _offset[cls]) {
+    cls--;
+  }
+  uint8_t index = (offset - _offset[cls]) / class_size[cls];
+
+  _free[cls] |= 1UL << index;
+  _stats[cls].in_use--;
+}
+
+void *JsonPool::reallocate(void *ptr, size_t size)
+{
+  if(!owns(ptr)) {
+    return realloc(ptr, size);
+  }
+
+  // Blocks do not move, shrinking in place leaves the block as it is
+  size_t offset = (uint8_t *)ptr - _storage;
+  uint8_t cls = JSON_POOL_CLASSES - 1;
+  while(offset < _offset[cls]) {
+    cls--;
+  }
+  if(size <= class_size[cls]) {
+    return ptr;
+  }
+
+  void *bigger = allocate(size);
+  if(bigger) {
+    memcpy(bigger, ptr, class_size[cls]);
+    deallocate(ptr);
+  }
+  return bigger;
+}
+
+bool JsonPool::owns(const void *ptr) const
+{
+  return (const uint8_t *)ptr >= _storage && (const uint8_t *)ptr < _storage + sizeof(_storage);
+}
+
+void JsonPool::resetStats()
+{
+  for(uint8_t cls = 0; cls < JSON_POOL_CLASSES; cls++) {
+    _stats[cls].high_water = _stats[cls].in_use;
+    _stats[cls].leases = 0;
+  }
+  _misses = 0;
+  _largest_miss = 0;
+}
+
+JsonPoolLease::JsonPoolLease(size_t size) :
+  _ptr(jsonPool.allocate(size)),
+  _size(size)
+{
+}
+
+JsonPoolLease::~JsonPoolLease()
+{
+  jsonPool.deallocate(_ptr);
+}
@@ -0,0 +1,117 @@
+#ifndef _OPENEVSE_JSON_POOL_H
+#define _OPENEVSE_JSON_POOL_H
+
+// -------------------------------------------------------------------
+// Fixed pool of reusable buffers for JSON documents
+//
+// Status, event and MQTT documents are built and thrown away many times a
+// minute. Allocating each from the heap slowly fragments it on a long
+// running unit, until the large contiguous blocks TLS needs are gone. The
+// pool holds a few blocks in each of JSON_POOL_CLASSES size classes,
+// reserved once, and hands out the smallest free block that fits.
+// Requests it can not meet fall back to the heap and are counted as
+// misses, so the classes can be tuned from /debug/heap.
+//
+// Use PooledJsonDocument (pooled_json.h) in place of DynamicJsonDocument,
+// or JsonPoolLease for a plain buffer. Not thread safe, the main loop
+// sections that use it all run under the dual core lock.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+// -------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A JSON document needs roughly twice the memory on a 64 bit host
+#define JSON_POOL_SCALE (sizeof(void *) / 4)
+
+#ifndef JSON_POOL_SMALL_SIZE
+#define JSON_POOL_SMALL_SIZE (512 * JSON_POOL_SCALE)
+#endif
+#ifndef JSON_POOL_SMALL_BLOCKS
+#define JSON_POOL_SMALL_BLOCKS 4
+#endif
+
+#ifndef JSON_POOL_MEDIUM_SIZE
+#define JSON_POOL_MEDIUM_SIZE (1536 * JSON_POOL_SCALE)
+#endif
+#ifndef JSON_POOL_MEDIUM_BLOCKS
+#define JSON_POOL_MEDIUM_BLOCKS 3
+#endif
+
+#ifndef JSON_POOL_LARGE_SIZE
+#define JSON_POOL_LARGE_SIZE (4096 * JSON_POOL_SCALE)
+#endif
+#ifndef JSON_POOL_LARGE_BLOCKS
+#define JSON_POOL_LARGE_BLOCKS 2
+#endif
+
+#define JSON_POOL_CLASSES 3
+
+#define JSON_POOL_STORAGE \
+  (JSON_POOL_SMALL_SIZE * JSON_POOL_SMALL_BLOCKS + \
+   JSON_POOL_MEDIUM_SIZE * JSON_POOL_MEDIUM_BLOCKS + \
+   JSON_POOL_LARGE_SIZE * JSON_POOL_LARGE_BLOCKS)
+
+struct JsonPoolStats
+{
+  size_t size;
+  uint8_t blocks;
+  uint8_t in_use;
+  uint8_t high_water;   // most in use at once
+  uint32_t leases;
+};
+
+class JsonPool
+{
+  public:
+    JsonPool();
+
+    // A block of at least size bytes, from the heap if no block in the
+    // pool is big enough and free. nullptr only if the heap is out too.
+    void *allocate(size_t size);
+    void deallocate(void *ptr);
+    // For ArduinoJson's shrinkToFit(), only ever asked to shrink
+    void *reallocate(void *ptr, size_t size);
+
+    bool owns(const void *ptr) const;
+
+    const JsonPoolStats &stats(uint8_t cls) const { return _stats[cls]; }
+    // Requests that went to the heap, and the largest
+    uint32_t misses() const { return _misses; }
+    size_t largestMiss() const { return _largest_miss; }
+    // Clear the counts, keeping what is in use
+    void resetStats();
+
+  private:
+    uint8_t *block(uint8_t cls, uint8_t index);
+
+    alignas(8) uint8_t _storage[JSON_POOL_STORAGE];
+    size_t _offset[JSON_POOL_CLASSES];
+    uint32_t _free[JSON_POOL_CLASSES];   // bit per free block
+    JsonPoolStats _stats[JSON_POOL_CLASSES];
+    uint32_t _misses;
+    size_t _largest_miss;
+};
+
+// A buffer from jsonPool for the life of the scope
+class JsonPoolLease
+{
+  private:
+    void *_ptr;
+    size_t _size;
+
+  public:
+    JsonPoolLease(size_t size);
+    ~JsonPoolLease();
+
+    JsonPoolLease(const JsonPoolLease &) = delete;
+    JsonPoolLease &operator=(const JsonPoolLease &) = delete;
+
+    char *data() const { return (char *)_ptr; }
+    size_t size() const { return _ptr ? _size : 0; }
+};
+
+extern JsonPool jsonPool;
+
+#endif // _OPENEVSE_JSON_POOL_H
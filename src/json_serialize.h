@@ -4,6 +4,8 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include "pooled_json.h"
+
 template <size_t CAPACITY> class JsonSerialize
 {
   private:
@@ -11,7 +13,7 @@ template <size_t CAPACITY> class JsonSerialize
   public:
     virtual bool deserialize(const char *json)
     {
-      DynamicJsonDocument doc(_capacity);
+      PooledJsonDocument doc(_capacity);
       DeserializationError err = deserializeJson(doc, json);
       if(DeserializationError::Code::Ok == err) {
         return deserialize(doc);
@@ -25,7 +27,7 @@ template <size_t CAPACITY> class JsonSerialize
 
     virtual bool deserialize(Stream &stream)
     {
-      DynamicJsonDocument doc(_capacity);
+      PooledJsonDocument doc(_capacity);
       DeserializationError err = deserializeJson(doc, stream);
       if(DeserializationError::Code::Ok == err) {
         return deserialize(doc);
@@ -33,7 +35,7 @@ template <size_t CAPACITY> class JsonSerialize
       return false;
     }
 
-    virtual bool deserialize(DynamicJsonDocument &doc)
+    virtual bool deserialize(JsonDocument &doc)
     {
       if (doc.is<JsonObject>())
       {
@@ -48,7 +50,7 @@ template <size_t CAPACITY> class JsonSerialize
 
     virtual bool serialize(String &json)
     {
-      DynamicJsonDocument doc(_capacity);
+      PooledJsonDocument doc(_capacity);
       if(serialize(doc))
       {
         serializeJson(doc, json);
@@ -69,7 +71,7 @@ template <size_t CAPACITY> class JsonSerialize
 
     virtual bool serialize(Stream &stream)
     {
-      DynamicJsonDocument doc(_capacity);
+      PooledJsonDocument doc(_capacity);
       if(serialize(doc))
       {
         serializeJson(doc, stream);
@@ -90,7 +92,7 @@ template <size_t CAPACITY> class JsonSerialize
 
     virtual bool serialize(Print &print)
     {
-      DynamicJsonDocument doc(_capacity);
+      PooledJsonDocument doc(_capacity);
       if(serialize(doc))
       {
         serializeJson(doc, print);
@@ -100,7 +102,7 @@ template <size_t CAPACITY> class JsonSerialize
       return true;
     }
 
-    virtual bool serialize(DynamicJsonDocument &doc)
+    virtual bool serialize(JsonDocument &doc)
     {
       JsonObject object = doc.to<JsonObject>();
       return serialize(object);
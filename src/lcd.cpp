@@ -17,88 +17,53 @@
 static void IGNORE(int ret) {
 }
 
-LcdTask::Message::Message(const __FlashStringHelper *msg, int x, int y, int time, uint32_t flags) :
-  _next(NULL),
-  _msg(""),
-  _x(x),
-  _y(y),
-  _time(time),
-  _clear(flags & LCD_CLEAR_LINE ? 1 : 0)
-{
-  strncpy_P(_msg, reinterpret_cast<PGM_P>(msg), LCD_MAX_LEN);
-  _msg[LCD_MAX_LEN] = '\0';
-}
-
-LcdTask::Message::Message(String &msg, int x, int y, int time, uint32_t flags) :
-  Message(msg.c_str(), x, y, time, flags)
-{
-}
-
-LcdTask::Message::Message(const char *msg, int x, int y, int time, uint32_t flags) :
-  _next(NULL),
-  _msg(""),
-  _x(x),
-  _y(y),
-  _time(time),
-  _clear(flags & LCD_CLEAR_LINE ? 1 : 0)
-{
-  strncpy(_msg, msg, LCD_MAX_LEN);
-  _msg[LCD_MAX_LEN] = '\0';
-}
-
 LcdTask::LcdTask() :
   MicroTasks::Task(),
-  _head(NULL),
-  _tail(NULL),
+  _messages(),
+  _state(),
   _infoLine(LcdInfoLine::Off),
   _evseState(OPENEVSE_STATE_STARTING),
   _evse(NULL),
   _scheduler(NULL),
   _lastStateClient(EvseClient_NULL),
-  _nextMessageTime(0),
   _evseStateEvent(this),
-  _evseSettingsEvent(this)
+  _evseSettingsEvent(this),
+  _evseDataEvent(this),
+  _evseBootEvent(this),
+  _shadow(),
+  _flushPending(0)
 {
 }
 
-void LcdTask::display(Message *msg, uint32_t flags)
-{
-  if(flags & LCD_DISPLAY_NOW)
-  {
-    for(Message *next, *node = _head; node; node = next) {
-      next = node->getNext();
-      delete node;
-    }
-    _head = NULL;
-    _tail = NULL;
-  }
-
-  if(_tail) {
-    _tail->setNext(msg);
-  } else {
-    _head = msg;
-    _nextMessageTime = millis();
-  }
-  _tail = msg;
-
-  if(flags & LCD_DISPLAY_NOW) {
-    displayNextMessage();
-  }
-}
-
 void LcdTask::display(const __FlashStringHelper *msg, int x, int y, int time, uint32_t flags)
 {
-  display(new Message(msg, x, y, time, flags), flags);
+  char text[LCD_MAX_LEN + 1];
+  strncpy_P(text, reinterpret_cast<PGM_P>(msg), LCD_MAX_LEN);
+  text[LCD_MAX_LEN] = '\0';
+  display(text, x, y, time, flags);
 }
 
 void LcdTask::display(String &msg, int x, int y, int time, uint32_t flags)
 {
-  display(new Message(msg, x, y, time, flags), flags);
+  display(msg.c_str(), x, y, time, flags);
 }
 
 void LcdTask::display(const char *msg, int x, int y, int time, uint32_t flags)
 {
-  display(new Message(msg, x, y, time, flags), flags);
+  _messages.push(msg, x, y, time, flags & LCD_CLEAR_LINE,
+                 flags & LCD_PRIORITY_HIGH ? DISPLAY_PRIORITY_HIGH : DISPLAY_PRIORITY_NORMAL,
+                 flags & LCD_DISPLAY_NOW, millis());
+
+  // Not started yet, the first loop() shows what is queued
+  if(NULL == _evse) {
+    return;
+  }
+
+  if(flags & LCD_DISPLAY_NOW) {
+    displayNextMessage();
+    flushDisplay();
+  }
+  MicroTask.wakeTask(this);
 }
 
 void LcdTask::setEvseState(uint8_t lcdColour)
@@ -134,10 +99,13 @@ void LcdTask::setup()
 {
   _evse->onStateChange(&_evseStateEvent);
   _evse->onSettingsChanged(&_evseSettingsEvent);
+  _evse->onDataReady(&_evseDataEvent);
+  _evse->onBootReady(&_evseBootEvent);
 }
 
 unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
 {
+  Profile_Scope("LcdTask");
   DBUG("LCD UI woke: ");
   DBUG(WakeReason_Scheduled == reason ? "WakeReason_Scheduled" :
        WakeReason_Event == reason ? "WakeReason_Event" :
@@ -168,13 +136,28 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
          LcdInfoLine::ManualOverride == _infoLine ? "LcdInfoLine::ManualOverride" :
          "UNKNOWN");
 
+  // One snapshot of the EVSE per wake, used for everything drawn below
+  DisplayState state;
+  display_state_capture(*_evse, state);
+  uint32_t changed = state.diff(_state);
+  _state = state;
+
+  // The EVSE has rebooted and taken the LCD and button back, take them
+  // again as if we had just started
+  if(_evseBootEvent.IsTriggered()) {
+    _evseState = OPENEVSE_STATE_STARTING;
+  }
+
   bool evseStateChanged = false;
-  uint8_t newEvseState = _evse->getEvseState();
+  uint8_t newEvseState = state.evse_state;
   if(newEvseState != _evseState)
   {
     if(OPENEVSE_STATE_STARTING == _evseState)
     {
-      // We have just started, disable the LCD and button, we are going to handle them
+      // We have just started, disable the LCD and button, we are going to handle them.
+      // The EVSE has drawn its own screen, whatever the shadow thinks is shown
+      _shadow.invalidate();
+      _updateInfoLine = true;
       if(!_evse->isButtonDisabled()) {
         _evse->getOpenEVSE().feature(OPENEVSE_FEATURE_BUTTON, false, IGNORE);
       }
@@ -189,7 +172,7 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
   }
 
   //bool pilotStateChanged = false;
-  uint8_t newPilotState = _evse->getPilotState();
+  uint8_t newPilotState = state.pilot_state;
   if(newPilotState != _pilotState)
   {
     _pilotState = newPilotState;
@@ -199,7 +182,7 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
   }
 
   bool flagsChanged = false;
-  uint32_t newFlags = _evse->getFlags();
+  uint32_t newFlags = state.flags;
   if(newFlags != _flags)
   {
     _flags = newFlags;
@@ -235,7 +218,7 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
   // shown while sleeping (divert/timer/manual/...) can change without a
   // hardware state change, e.g. manual override released while a timer still
   // holds the EVSE off
-  EvseClient newStateClient = _evse->getStateClient();
+  EvseClient newStateClient = state.state_client;
   if(newStateClient != _lastStateClient)
   {
     _lastStateClient = newStateClient;
@@ -255,8 +238,9 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
   }
 
   // If we have messages to display, do it
-  if(_head) {
-    return displayNextMessage();
+  if(!_messages.empty() || _messages.holding(millis())) {
+    unsigned long nextUpdate = displayNextMessage();
+    return min(nextUpdate, flushDisplay());
   }
 
   if(_evseSettingsEvent.IsTriggered()) {
@@ -264,6 +248,13 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
     _updateInfoLine = true;
   }
 
+  // Live readings changed (data ready event), redraw the values. The shadow
+  // buffer only sends the characters that actually differ
+  if(changed & DISPLAY_CHANGED_VALUES) {
+    _updateStateDisplay = true;
+    _updateInfoLine = true;
+  }
+
   // Else display the status screen
   unsigned long nextUpdate = MicroTask.Infinate;
 
@@ -284,35 +275,29 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
     nextUpdate = nextInfoDelay;
   }
 
+  nextUpdate = min(nextUpdate, flushDisplay());
+
   DBUGVAR(nextUpdate);
   return nextUpdate;
 }
 
 unsigned long LcdTask::displayNextMessage()
 {
-  while(_head && millis() >= _nextMessageTime)
+  DisplayMessage msg;
+  while(_messages.pop(millis(), msg))
   {
-    // Pop a message from the queue
-    Message *msg = _head;
-    DBUGF("msg = %p", msg);
-    _head = _head->getNext();
-    if(NULL == _head) {
-      _tail = NULL;
-    }
-
     // Display the message
-    showText(msg->getX(), msg->getY(), msg->getMsg(), msg->getClear());
-
-    _nextMessageTime = millis() + msg->getTime();
-
-    // delete the message
-    delete msg;
+    showText(msg.x, msg.y, msg.text, msg.clear);
 
     _updateStateDisplay = true;
     _updateInfoLine = true;
   }
 
-  unsigned long nextUpdate = _nextMessageTime - millis();
+  // Once the last message has had its time go straight back to the status screen
+  uint32_t nextUpdate = _messages.nextChange(millis());
+  if(DISPLAY_MESSAGE_IDLE == nextUpdate) {
+    nextUpdate = 0;
+  }
   DBUGVAR(nextUpdate);
   return nextUpdate;
 }
@@ -487,7 +472,7 @@ void LcdTask::displayStateLine(uint8_t evseState, unsigned long &nextUpdate)
       displayNumberValue(0,
         (DivertMode::Eco == divert.getMode() && divert.isActive()) ? "Eco" : "Charging",
         _evse->getAmps(), 2, "A");
-      nextUpdate = 1000;
+      // Redrawn on the next data ready event
       break;
 
     case OPENEVSE_STATE_VENT_REQUIRED:
@@ -859,19 +844,37 @@ void LcdTask::displayNameValue(int line, const char *name, const char *value)
 void LcdTask::showText(int x, int y, const char *msg, bool clear)
 {
   DBUGF("LCD: %d %d %s, clear=%s", x, y, msg, clear ? "true" : "false");
-  _evse->getOpenEVSE().lcdDisplayText(x, y, msg, IGNORE);
-  if(clear)
+  _shadow.write(x, y, msg, clear);
+}
+
+unsigned long LcdTask::flushDisplay()
+{
+  // Send what changed, never more than LCD_FLUSH_MAX_PENDING commands at a time
+  // so the display cannot flood the serial link, e.g. while updating the
+  // EVSE firmware. The completion wakes us to send the next span
+  char text[LCD_MAX_LEN + 1];
+  int x, y;
+  while(_flushPending < LCD_FLUSH_MAX_PENDING && _shadow.nextSpan(x, y, text, sizeof(text)))
   {
-    for(int i = x + strlen(msg); i < LCD_MAX_LEN; i += 6)
+    _flushPending++;
+    _evse->getOpenEVSE().lcdDisplayText(x, y, text, [this](int ret)
     {
-      // Older versions of the firmware crash if sending more than 6 spaces so clear the rest
-      // of the line using blocks of 6 spaces
-      _evse->getOpenEVSE().lcdDisplayText(i, y, "      ", IGNORE);
-    }
+      _flushPending--;
+      if(RAPI_RESPONSE_OK != ret) {
+        _shadow.failed();
+      }
+
+      if(_shadow.dirty()) {
+        MicroTask.wakeTask(this);
+      } else if(0 == _flushPending) {
+        const LcdShadowStats &stats = _shadow.stats();
+        DBUGF("LCD: %u writes, %u unchanged, %u commands, %u chars, %u failed",
+              stats.writes, stats.skipped, stats.commands, stats.chars, stats.failures);
+      }
+    });
   }
 
-  // HACK: wait for the display to finish, fixes issues with updating the display while updating the firmware
-  _evse->getSender().flush();
+  return _shadow.dirty() ? LCD_FLUSH_RETRY_TIME : MicroTask.Infinate;
 }
 
 void LcdTask::onButton(int long_press)
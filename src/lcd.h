@@ -3,8 +3,11 @@
 
 #include <Arduino.h>
 
+#include "display_model.h"
+
 #define LCD_CLEAR_LINE    (1 << 0)
 #define LCD_DISPLAY_NOW   (1 << 1)
+#define LCD_PRIORITY_HIGH (1 << 2)  // Not preempted by, and flushes, normal messages
 
 #ifndef LCD_DISPLAY_CHANGE_TIME
 #define LCD_DISPLAY_CHANGE_TIME (4 * 1000)
@@ -29,56 +32,22 @@
 #include "evse_man.h"
 #include "scheduler.h"
 #include "manual.h"
+#include "lcd_shadow.h"
+
+// RAPI LCD commands in flight at once, the rest wait in the shadow buffer
+#ifndef LCD_FLUSH_MAX_PENDING
+#define LCD_FLUSH_MAX_PENDING 1
+#endif
+
+// Retry time if a flush is held up waiting for the EVSE
+#ifndef LCD_FLUSH_RETRY_TIME
+#define LCD_FLUSH_RETRY_TIME 100
+#endif
 
 class LcdTask : public MicroTasks::Task
 {
   private:
 
-    class Message;
-
-    class Message
-    {
-      private:
-        Message *_next;
-        char _msg[LCD_MAX_LEN + 1];
-        int _x;
-        int _y;
-        int _time;
-        uint32_t _clear:1;
-
-      public:
-        Message(const __FlashStringHelper *msg, int x, int y, int time, uint32_t flags);
-        Message(String &msg, int x, int y, int time, uint32_t flags);
-        Message(const char *msg, int x, int y, int time, uint32_t flags);
-
-        Message *getNext() {
-          return _next;
-        }
-        void setNext(Message *msg) {
-          _next = msg;
-        }
-
-        const char *getMsg() {
-          return _msg;
-        }
-
-        int getX() {
-          return _x;
-        }
-
-        int getY() {
-          return _y;
-        }
-
-        int getTime() {
-          return _time;
-        }
-
-        bool getClear() {
-          return _clear;
-        }
-    };
-
     enum class LcdInfoLine
     {
       Off,
@@ -104,8 +73,8 @@ class LcdTask : public MicroTasks::Task
       ManualOverride
     };
 
-    Message *_head;
-    Message *_tail;
+    DisplayMessageQueue _messages;
+    DisplayState _state;
 
     LcdInfoLine _infoLine;
 
@@ -119,7 +88,6 @@ class LcdTask : public MicroTasks::Task
 
     EvseClient _lastStateClient;
 
-    uint32_t _nextMessageTime;
     uint32_t _infoLineChageTime;
 
     bool _updateStateDisplay;
@@ -127,12 +95,18 @@ class LcdTask : public MicroTasks::Task
 
     MicroTasks::EventListener _evseStateEvent;
     MicroTasks::EventListener _evseSettingsEvent;
+    MicroTasks::EventListener _evseDataEvent;
+    MicroTasks::EventListener _evseBootEvent;
+
+    LcdShadow _shadow;
+    uint8_t _flushPending;
 
     LcdInfoLine ledStateFromEvseState(uint8_t);
     void setNewState(bool wake = true);
     int getPriority(LcdInfoLine state);
 
     void showText(int x, int y, const char *msg, bool clear);
+    unsigned long flushDisplay();
 
     void setEvseState(uint8_t lcdColour);
     void setInfoLine(LcdInfoLine info);
@@ -142,7 +116,6 @@ class LcdTask : public MicroTasks::Task
 
     LcdInfoLine getNextInfoLine(LcdInfoLine info);
 
-    void display(Message *msg, uint32_t flags);
     unsigned long displayNextMessage();
 
     void displayStateLine(uint8_t EvseState, unsigned long &nextUpdate);
@@ -167,6 +140,10 @@ class LcdTask : public MicroTasks::Task
     void display(const char *msg, int x, int y, int time, uint32_t flags);
     
     void setWifiMode(bool client, bool connected);
+
+    const LcdShadowStats &getDisplayStats() {
+      return _shadow.stats();
+    }
 };
 
 #endif // ENABLE_SCREEN_LCD_TFT
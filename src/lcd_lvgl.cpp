@@ -54,33 +54,14 @@ static void lvgl_pump()
 }
 #endif
 
-// --- Message inner class (mechanics identical to the TFT_eSPI LcdTask) ---
-
-LcdTask::Message::Message(const __FlashStringHelper *msg, int x, int y, int time, uint32_t flags) :
-  _next(NULL), _msg(""), _x(x), _y(y), _time(time), _clear(flags & LCD_CLEAR_LINE ? 1 : 0)
-{
-  strncpy_P(_msg, reinterpret_cast<PGM_P>(msg), LCD_MAX_LEN);
-  _msg[LCD_MAX_LEN] = '\0';
-}
-
-LcdTask::Message::Message(String &msg, int x, int y, int time, uint32_t flags) :
-  Message(msg.c_str(), x, y, time, flags)
-{
-}
-
-LcdTask::Message::Message(const char *msg, int x, int y, int time, uint32_t flags) :
-  _next(NULL), _msg(""), _x(x), _y(y), _time(time), _clear(flags & LCD_CLEAR_LINE ? 1 : 0)
-{
-  strncpy(_msg, msg, LCD_MAX_LEN);
-  _msg[LCD_MAX_LEN] = '\0';
-}
-
 LcdTask::LcdTask() :
   MicroTasks::Task(),
-  _head(NULL),
-  _tail(NULL),
-  _nextMessageTime(0),
-  _evse(NULL)
+  _messages(),
+  _state(),
+  _evse(NULL),
+  _evseStateEvent(this),
+  _evseSettingsEvent(this),
+  _evseDataEvent(this)
 {
   clearMessageLines();
 }
@@ -91,79 +72,69 @@ void LcdTask::clearMessageLines()
     _msg[i][0] = '\0';
   }
   _msg_cleared = true;
-}
-
-void LcdTask::display(Message *msg, uint32_t flags)
-{
-  if(flags & LCD_DISPLAY_NOW) {
-    for(Message *next, *node = _head; node; node = next) {
-      next = node->getNext();
-      delete node;
-    }
-    _head = NULL;
-    _tail = NULL;
-  }
-
-  if(_tail) {
-    _tail->setNext(msg);
-  } else {
-    _head = msg;
-    _nextMessageTime = millis();
-  }
-  _tail = msg;
-
-  if(flags & LCD_DISPLAY_NOW) {
-    displayNextMessage();
-  }
+  _changed |= DISPLAY_CHANGED_MESSAGE;
 }
 
 void LcdTask::display(const __FlashStringHelper *msg, int x, int y, int time, uint32_t flags)
 {
-  display(new Message(msg, x, y, time, flags), flags);
+  char text[LCD_MAX_LEN + 1];
+  strncpy_P(text, reinterpret_cast<PGM_P>(msg), LCD_MAX_LEN);
+  text[LCD_MAX_LEN] = '\0';
+  display(text, x, y, time, flags);
 }
 
 void LcdTask::display(String &msg, int x, int y, int time, uint32_t flags)
 {
-  display(new Message(msg, x, y, time, flags), flags);
+  display(msg.c_str(), x, y, time, flags);
 }
 
 void LcdTask::display(const char *msg, int x, int y, int time, uint32_t flags)
 {
-  display(new Message(msg, x, y, time, flags), flags);
+  // Shared queue (display_model.h), same mechanics as the other LcdTasks
+  _messages.push(msg, x, y, time, flags & LCD_CLEAR_LINE,
+                 flags & LCD_PRIORITY_HIGH ? DISPLAY_PRIORITY_HIGH : DISPLAY_PRIORITY_NORMAL,
+                 flags & LCD_DISPLAY_NOW, millis());
+
+  // Not started yet, the first loop() shows what is queued
+  if(NULL == _evse) {
+    return;
+  }
+
+  MicroTask.wakeTask(this);
 }
 
 unsigned long LcdTask::displayNextMessage()
 {
-  while(_head && millis() >= _nextMessageTime)
+  DisplayMessage msg;
+  while(_messages.pop(millis(), msg))
   {
-    Message *msg = _head;
-    _head = _head->getNext();
-    if(NULL == _head) {
-      _tail = NULL;
-    }
-
     wakeBacklight();
 
-    int line = msg->getY();
+    int line = msg.y;
     if(line >= 0 && line < LCD_MAX_LINES) {
-      strncpy(_msg[line], msg->getMsg(), LCD_MAX_LEN);
+      strncpy(_msg[line], msg.text, LCD_MAX_LEN);
       _msg[line][LCD_MAX_LEN] = '\0';
       _msg_cleared = false;
+      _changed |= DISPLAY_CHANGED_MESSAGE;
     }
-
-    _nextMessageTime = millis() + msg->getTime();
-    delete msg;
   }
 
-  return _nextMessageTime - millis();
+  uint32_t nextChange = _messages.nextChange(millis());
+  return DISPLAY_MESSAGE_IDLE == nextChange ? MicroTask.Infinate : nextChange;
 }
 
 void LcdTask::setWifiMode(bool client, bool connected)
 {
+  if(client != _wifi_client || connected != _wifi_connected || !_wifiModeKnown) {
+    _changed |= DISPLAY_CHANGED_NETWORK;
+  }
   _wifi_client = client;
   _wifi_connected = connected;
   _wifiModeKnown = true;
   wakeBacklight();
+  if(NULL != _evse) {
+    MicroTask.wakeTask(this);
+  }
 }
 
 // Resolve the tft_theme config into the active palette. Returns true if the theme
@@ -204,10 +175,14 @@ void LcdTask::begin(EvseManager &evse, Scheduler &scheduler, ManualOverride &man
 
 void LcdTask::setup()
 {
+  _evse->onStateChange(&_evseStateEvent);
+  _evse->onSettingsChanged(&_evseSettingsEvent);
+  _evse->onDataReady(&_evseDataEvent);
 }
 
 unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
 {
+  Profile_Scope("LcdTask");
   if(_initialise)
   {
     // Bring up LVGL + the panel AFTER networking (it breaks the display if done
@@ -235,10 +210,8 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
   }
 
   // Drain queued messages into the message lines, clear them when their time is up.
-  if(_head) {
-    displayNextMessage();
-  }
-  if(!_msg_cleared && millis() >= _nextMessageTime) {
+  displayNextMessage();
+  if(!_msg_cleared && !_messages.holding(millis())) {
     clearMessageLines();
   }
 
@@ -266,6 +239,7 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
       } else {
         charge_screen_build();
         _activeScreen = SCR_CHARGE;
+        _redraw = true;
       }
       boot_screen_destroy();
       _booting = false;
@@ -290,6 +264,7 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
     charge_screen_build();
     setup_screen_destroy();
     _activeScreen = SCR_CHARGE;
+    _redraw = true;
   }
 
   // Live theme switch: swap palette + rebuild whichever screen is showing.
@@ -301,6 +276,7 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
     } else if(_activeScreen == SCR_STANDBY) {
       standby_screen_build();
     }
+    _redraw = true;
     lvgl_pump();
   }
 
@@ -310,9 +286,17 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
     return 1000;
   }
 
+  // One snapshot of the EVSE per wake. The EVSE events wake us when it
+  // changes, between them only the clock is redrawn.
+  DisplayState snapshot;
+  display_state_capture(*_evse, snapshot);
+  uint32_t changed = snapshot.diff(_state) | _changed;
+  _state = snapshot;
+  _changed = 0;
+
   // --- Backlight / standby decision (chooses which screen we render) ---
-  uint8_t state = _evse->getEvseState();
-  bool vehicle = _evse->isVehicleConnected();
+  uint8_t state = _state.evse_state;
+  bool vehicle = _state.vehicle_connected;
   applyDisplayConfig();   // pick up live /config changes; also applies brightness now
                           // so slider changes take effect without waiting for a wake
 
@@ -322,7 +306,7 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
     _prev_vehicle = vehicle;
   }
 
-  bool keepAwake = stateKeepsAwake(state, vehicle, _evse->getAmps());
+  bool keepAwake = stateKeepsAwake(state, vehicle, _state.amps);
   if(keepAwake) {
     _lastWake = millis(); // keep re-arming so we never time out while charging/fault
     if(_standby) {
@@ -336,63 +320,74 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
     }
   }
 
+  // Entering or leaving standby above may have rebuilt the screen
+  bool redraw = _redraw || 0 != changed;
+  _redraw = false;
+
+  char dt[24];
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  struct tm ti;
+  localtime_r(&tv.tv_sec, &ti);
+  strftime(dt, sizeof(dt), "%Y-%m-%d  %H:%M:%S", &ti);
+
   // Render the standby screen when dimmed-with-screen; otherwise fall through to charge.
   if(_activeScreen == SCR_STANDBY) {
-    StandbyScreenData sd = {};
-    sd.evse_state        = state;
-    sd.temp_valid        = _evse->isTemperatureValid(EVSE_MONITOR_TEMP_MONITOR);
-    sd.temp_c            = sd.temp_valid ? _evse->getTemperature(EVSE_MONITOR_TEMP_MONITOR) : 0.0f;
-    sd.temp_fahrenheit   = temp_unit.equals("f");
-    sd.wifi_client       = _wifi_client;
-    sd.wifi_connected    = _wifi_connected;
-    sd.rssi              = WiFi.RSSI();
-    sd.sta_count         = WiFi.softAPgetStationNum();
-    sd.today_kwh         = _evse->getTotalDay();
-    sd.total_kwh         = _evse->getTotalEnergy();
-
-    char ck[24];
-    timeval tv; gettimeofday(&tv, NULL);
-    struct tm ti; localtime_r(&tv.tv_sec, &ti);
-    strftime(ck, sizeof(ck), "%Y-%m-%d  %H:%M:%S", &ti);  // match the charge screen header
-    sd.clock = ck;
-
-    char ipbuf[20];
-    IPAddress ip = _wifi_client ? WiFi.localIP() : WiFi.softAPIP();
-    snprintf(ipbuf, sizeof(ipbuf), "%s", ip.toString().c_str());
-    sd.hostname = esp_hostname.c_str();
-    sd.ip = ipbuf;
-
-    standby_screen_update(sd);
+    if(redraw) {
+      StandbyScreenData sd = {};
+      sd.evse_state        = state;
+      sd.temp_valid        = _state.temperature_valid;
+      sd.temp_c            = _state.temperature;
+      sd.temp_fahrenheit   = temp_unit.equals("f");
+      sd.wifi_client       = _wifi_client;
+      sd.wifi_connected    = _wifi_connected;
+      sd.rssi              = WiFi.RSSI();
+      sd.sta_count         = WiFi.softAPgetStationNum();
+      sd.today_kwh         = _state.total_day;
+      sd.total_kwh         = _state.total_energy;
+      sd.clock             = dt;  // match the charge screen header
+
+      char ipbuf[20];
+      IPAddress ip = _wifi_client ? WiFi.localIP() : WiFi.softAPIP();
+      snprintf(ipbuf, sizeof(ipbuf), "%s", ip.toString().c_str());
+      sd.hostname = esp_hostname.c_str();
+      sd.ip = ipbuf;
+
+      standby_screen_update(sd);
+    } else {
+      standby_screen_set_clock(dt);
+    }
     lvgl_pump();
     gettimeofday(&tv, NULL);
     return 1000 - tv.tv_usec / 1000;
   }
 
-  // Assemble a full snapshot from EvseManager + WiFi + clock.
+  // Only the clock moves between display state changes
+  if(!redraw) {
+    charge_screen_set_clock(dt);
+    lvgl_pump();
+    gettimeofday(&tv, NULL);
+    return 1000 - tv.tv_usec / 1000;
+  }
+
+  // Assemble a full snapshot from the display state + WiFi + clock.
   ChargeScreenData d = {};
   d.evse_state        = state;
   d.charging          = (state == OPENEVSE_STATE_CHARGING);
   d.vehicle_connected = vehicle;
-  d.power_kw          = _evse->getPower() / 1000.0f;
-  d.pilot_a           = (int)_evse->getChargeCurrent();
-  d.volts             = _evse->getVoltage();
-  d.amps              = _evse->getAmps();
-  d.elapsed_s         = _evse->getSessionElapsed();
-  d.session_wh        = _evse->getSessionEnergy();
-  d.temp_valid        = _evse->isTemperatureValid(EVSE_MONITOR_TEMP_MONITOR);
-  d.temp_c            = d.temp_valid ? _evse->getTemperature(EVSE_MONITOR_TEMP_MONITOR) : 0.0f;
+  d.power_kw          = _state.power / 1000.0f;
+  d.pilot_a           = (int)_state.charge_current;
+  d.volts             = _state.voltage;
+  d.amps              = _state.amps;
+  d.elapsed_s         = _state.session_elapsed;
+  d.session_wh        = _state.session_energy;
+  d.temp_valid        = _state.temperature_valid;
+  d.temp_c            = _state.temperature;
   d.temp_fahrenheit   = temp_unit.equals("f");
   d.wifi_client       = _wifi_client;
   d.wifi_connected    = _wifi_connected;
   d.rssi              = WiFi.RSSI();
   d.sta_count         = WiFi.softAPgetStationNum();
-
-  char dt[24];
-  timeval tv;
-  gettimeofday(&tv, NULL);
-  struct tm ti;
-  localtime_r(&tv.tv_sec, &ti);
-  strftime(dt, sizeof(dt), "%Y-%m-%d  %H:%M:%S", &ti);
   d.datetime = dt;
 
   // Bottom row: hostname (left) + IP (right). A transient message overrides both.
@@ -433,6 +428,7 @@ void LcdTask::wakeBacklight()
       charge_screen_build();
       standby_screen_destroy();
       _activeScreen = SCR_CHARGE;
+      _redraw = true;
     }
   }
 }
@@ -446,6 +442,7 @@ void LcdTask::enterStandby()
       charge_screen_destroy();
     }
     _activeScreen = SCR_STANDBY;
+    _redraw = true;
   }
   lvgl_panel_set_backlight((uint8_t)(_standbyBrightness < 0 ? 0 : _standbyBrightness));
 }
@@ -12,6 +12,7 @@
 #define LCD_CHAR_CLOCK      5
 
 #include "evse_man.h"
+#include "display_model.h"
 #include "scheduler.h"
 #include "manual.h"
 
@@ -21,38 +22,17 @@
 class LcdTask : public MicroTasks::Task
 {
   private:
-    class Message;
-
-    class Message
-    {
-      private:
-        Message *_next;
-        char _msg[LCD_MAX_LEN + 1];
-        int _x;
-        int _y;
-        int _time;
-        uint32_t _clear:1;
-
-      public:
-        Message(const __FlashStringHelper *msg, int x, int y, int time, uint32_t flags);
-        Message(String &msg, int x, int y, int time, uint32_t flags);
-        Message(const char *msg, int x, int y, int time, uint32_t flags);
-
-        Message *getNext() { return _next; }
-        void setNext(Message *msg) { _next = msg; }
-        const char *getMsg() { return _msg; }
-        int getX() { return _x; }
-        int getY() { return _y; }
-        int getTime() { return _time; }
-        bool getClear() { return _clear; }
-    };
-
-    Message *_head;
-    Message *_tail;
-    uint32_t _nextMessageTime;
+    DisplayMessageQueue _messages;
+    DisplayState _state;         // What the screens draw from
+    uint32_t _changed = 0;       // DISPLAY_CHANGED_* not from the EVSE, since the last draw
+    bool _redraw = false;        // a screen was (re)built and needs a full snapshot
 
     EvseManager *_evse;
 
+    MicroTasks::EventListener _evseStateEvent;
+    MicroTasks::EventListener _evseSettingsEvent;
+    MicroTasks::EventListener _evseDataEvent;
+
     bool _initialise = true;
     bool _displayOk = false;
     bool _booting = false;       // showing the boot splash before the main screen
@@ -88,7 +68,6 @@ class LcdTask : public MicroTasks::Task
     bool stateKeepsAwake(uint8_t state, bool vehicle, double amps);  // charging/fault force-bright
     void applyDisplayConfig();          // refresh cached brightness/timeout + apply live
 
-    void display(Message *msg, uint32_t flags);
     unsigned long displayNextMessage();
     void clearMessageLines();
     void buildSetupScreen();     // gather AP creds + build the QR setup screen
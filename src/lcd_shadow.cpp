@@ -0,0 +1,122 @@
+#include "lcd_shadow.h"
+
+#include <string.h>
+
+// Never matches a printable character, forces the cell to be sent
+#define LCD_SHADOW_UNKNOWN '\0'
+
+LcdShadow::LcdShadow()
+{
+  for(int y = 0; y < LCD_SHADOW_ROWS; y++) {
+    memset(_want[y], ' ', LCD_SHADOW_COLS);
+    _want[y][LCD_SHADOW_COLS] = '\0';
+  }
+  invalidate();
+}
+
+void LcdShadow::write(int x, int y, const char *msg, bool clear)
+{
+  if(y < 0 || y >= LCD_SHADOW_ROWS || x < 0 || x >= LCD_SHADOW_COLS) {
+    return;
+  }
+
+  _stats.writes++;
+  bool changed = false;
+
+  for(; x < LCD_SHADOW_COLS && *msg; x++, msg++)
+  {
+    if(_want[y][x] != *msg) {
+      _want[y][x] = *msg;
+      changed = true;
+    }
+  }
+
+  if(clear)
+  {
+    for(; x < LCD_SHADOW_COLS; x++)
+    {
+      if(_want[y][x] != ' ') {
+        _want[y][x] = ' ';
+        changed = true;
+      }
+    }
+  }
+
+  if(!changed) {
+    _stats.skipped++;
+  }
+}
+
+void LcdShadow::invalidate()
+{
+  memset(_shown, LCD_SHADOW_UNKNOWN, sizeof(_shown));
+}
+
+bool LcdShadow::dirty() const
+{
+  for(int y = 0; y < LCD_SHADOW_ROWS; y++) {
+    if(0 != memcmp(_want[y], _shown[y], LCD_SHADOW_COLS)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool LcdShadow::nextSpan(int &x, int &y, char *text, size_t size)
+{
+  if(size < 2) {
+    return false;
+  }
+
+  for(int row = 0; row < LCD_SHADOW_ROWS; row++)
+  {
+    const char *want = _want[row];
+    char *shown = _shown[row];
+
+    int start = 0;
+    while(start < LCD_SHADOW_COLS && want[start] == shown[start]) {
+      start++;
+    }
+    if(start == LCD_SHADOW_COLS) {
+      continue;
+    }
+
+    // Extend over the following changes while the unchanged gaps are short,
+    // the span stays within the text buffer and the space limit
+    int end = start;      // one past the last changed character
+    int spaces = 0;
+    int gap = 0;
+    for(int col = start; col < LCD_SHADOW_COLS && (size_t)(col - start) < size - 1; col++)
+    {
+      if(want[col] == ' ' && ++spaces > LCD_SHADOW_MAX_SPACES) {
+        break;
+      }
+
+      if(want[col] != shown[col]) {
+        end = col + 1;
+        gap = 0;
+      } else if(++gap > LCD_SHADOW_MERGE_GAP) {
+        break;
+      }
+    }
+
+    int len = end - start;
+    memcpy(text, want + start, len);
+    text[len] = '\0';
+    memcpy(shown + start, want + start, len);
+
+    x = start;
+    y = row;
+    _stats.commands++;
+    _stats.chars += len;
+    return true;
+  }
+
+  return false;
+}
+
+void LcdShadow::failed()
+{
+  _stats.failures++;
+  invalidate();
+}
@@ -0,0 +1,69 @@
+#ifndef LCD_SHADOW_H
+#define LCD_SHADOW_H
+
+// Shadow of the 16x2 character LCD driven over RAPI.
+//
+// Display calls only update the wanted contents in memory. The flusher then
+// asks for the spans that differ from what the LCD already shows and sends
+// one RAPI $FP command per span, so redrawing an unchanged line costs no
+// serial traffic and a changing value only resends the characters around it.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LCD_SHADOW_COLS 16
+#define LCD_SHADOW_ROWS 2
+
+// Unchanged characters between two changes that are resent rather than
+// starting a new command, a $FP command costs ~12 bytes of framing
+#ifndef LCD_SHADOW_MERGE_GAP
+#define LCD_SHADOW_MERGE_GAP 4
+#endif
+
+// Older versions of the OpenEVSE firmware crash when a $FP command carries
+// more than 6 spaces
+#ifndef LCD_SHADOW_MAX_SPACES
+#define LCD_SHADOW_MAX_SPACES 6
+#endif
+
+struct LcdShadowStats
+{
+  uint32_t writes = 0;        // display calls
+  uint32_t commands = 0;      // RAPI commands sent
+  uint32_t chars = 0;         // characters sent
+  uint32_t skipped = 0;       // display calls that changed nothing
+  uint32_t failures = 0;      // commands the EVSE did not accept
+};
+
+class LcdShadow
+{
+  public:
+    LcdShadow();
+
+    // Update the wanted contents. clear pads the rest of the line with spaces
+    void write(int x, int y, const char *msg, bool clear);
+
+    // Contents of the LCD unknown, e.g. after a failed command: send it all
+    void invalidate();
+
+    bool dirty() const;
+
+    // Next span to send, marked as shown. Returns false when the LCD is up to
+    // date. text is NUL terminated, size should be at least LCD_SHADOW_COLS + 1
+    bool nextSpan(int &x, int &y, char *text, size_t size);
+
+    // Report a command that was not accepted
+    void failed();
+
+    const char *line(int y) const { return _want[y]; }
+    const LcdShadowStats &stats() const { return _stats; }
+
+  private:
+    char _want[LCD_SHADOW_ROWS][LCD_SHADOW_COLS + 1];
+    char _shown[LCD_SHADOW_ROWS][LCD_SHADOW_COLS];
+    LcdShadowStats _stats;
+};
+
+#endif // LCD_SHADOW_H
@@ -21,39 +21,17 @@
 
 PNG png; // Global PNG decoder instance
 
-LcdTask::Message::Message(const __FlashStringHelper *msg, int x, int y, int time, uint32_t flags) :
-  _next(NULL),
-  _msg(""),
-  _x(x),
-  _y(y),
-  _time(time),
-  _clear(flags & LCD_CLEAR_LINE ? 1 : 0)
-{
-  strncpy_P(_msg, reinterpret_cast<PGM_P>(msg), LCD_MAX_LEN);
-  _msg[LCD_MAX_LEN] = '\0';
-}
-
-LcdTask::Message::Message(String &msg, int x, int y, int time, uint32_t flags) :
-  Message(msg.c_str(), x, y, time, flags)
-{
-}
-
-LcdTask::Message::Message(const char *msg, int x, int y, int time, uint32_t flags) :
-  _next(NULL),
-  _msg(""),
-  _x(x),
-  _y(y),
-  _time(time),
-  _clear(flags & LCD_CLEAR_LINE ? 1 : 0)
-{
-  strncpy(_msg, msg, LCD_MAX_LEN);
-  _msg[LCD_MAX_LEN] = '\0';
-}
-
 LcdTask::LcdTask() :
   MicroTasks::Task(),
-  _head(NULL),
-  _tail(NULL),
+  _messages(),
+  _state(),
+  _changed(0),
+  _evse(NULL),
+  _scheduler(NULL),
+  _manual(NULL),
+  _evseStateEvent(this),
+  _evseSettingsEvent(this),
+  _evseDataEvent(this),
   _tft(),
 #ifdef ENABLE_DOUBLE_BUFFER
   _back_buffer(&_tft),
@@ -73,76 +51,64 @@ LcdTask::~LcdTask()
     delete _screenManager;
     _screenManager = nullptr;
   }
-
-  // Clean up any remaining messages
-  for(Message *next, *node = _head; node; node = next) {
-    next = node->getNext();
-    delete node;
-  }
-}
-
-void LcdTask::display(Message *msg, uint32_t flags)
-{
-  if(flags & LCD_DISPLAY_NOW)
-  {
-    for(Message *next, *node = _head; node; node = next) {
-      next = node->getNext();
-      delete node;
-    }
-    _head = NULL;
-    _tail = NULL;
-  }
-
-  if(_tail) {
-    _tail->setNext(msg);
-  } else {
-    _head = msg;
-    _nextMessageTime = millis();
-  }
-  _tail = msg;
-
-  if(flags & LCD_DISPLAY_NOW) {
-    displayNextMessage();
-  }
 }
 
 void LcdTask::display(const __FlashStringHelper *msg, int x, int y, int time, uint32_t flags)
 {
   DBUGVAR(msg);
-  display(new Message(msg, x, y, time, flags), flags);
+  char text[LCD_MAX_LEN + 1];
+  strncpy_P(text, reinterpret_cast<PGM_P>(msg), LCD_MAX_LEN);
+  text[LCD_MAX_LEN] = '\0';
+  display(text, x, y, time, flags);
 }
 
 void LcdTask::display(String &msg, int x, int y, int time, uint32_t flags)
 {
-  DBUGVAR(msg);
-  display(new Message(msg, x, y, time, flags), flags);
+  display(msg.c_str(), x, y, time, flags);
 }
 
 void LcdTask::display(const char *msg, int x, int y, int time, uint32_t flags)
 {
   DBUGVAR(msg);
-  display(new Message(msg, x, y, time, flags), flags);
+  _messages.push(msg, x, y, time, flags & LCD_CLEAR_LINE,
+                 flags & LCD_PRIORITY_HIGH ? DISPLAY_PRIORITY_HIGH : DISPLAY_PRIORITY_NORMAL,
+                 flags & LCD_DISPLAY_NOW, millis());
+
+  // Not started yet, the first loop() shows what is queued
+  if(NULL == _evse) {
+    return;
+  }
+
+  MicroTask.wakeTask(this);
 }
 
 void LcdTask::setWifiMode(bool client, bool connected)
 {
-  if (_screenManager)
+  if (_screenManager && _screenManager->setWifiMode(client, connected))
   {
-    _screenManager->setWifiMode(client, connected);
+    _changed |= DISPLAY_CHANGED_NETWORK;
+    MicroTask.wakeTask(this);
   }
 }
 
 void LcdTask::begin(EvseManager &evse, Scheduler &scheduler, ManualOverride &manual)
 {
+  _evse = &evse;
+  _scheduler = &scheduler;
+  _manual = &manual;
   MicroTask.startTask(this);
 }
 
 void LcdTask::setup()
 {
+  _evse->onStateChange(&_evseStateEvent);
+  _evse->onSettingsChanged(&_evseSettingsEvent);
+  _evse->onDataReady(&_evseDataEvent);
 }
 
 unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
 {
+  Profile_Scope("LcdTask");
   DBUG("LCD UI woke: ");
   DBUGLN(WakeReason_Scheduled == reason ? "WakeReason_Scheduled" :
        WakeReason_Event == reason ? "WakeReason_Event" :
@@ -167,7 +133,7 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
 #endif
 
     // Create the screen manager with pointers to display and data sources
-    _screenManager = new ScreenManager(_screen, evse, scheduler, manual);
+    _screenManager = new ScreenManager(_screen, _state, *_scheduler, *_manual);
 
     pinMode(LCD_BACKLIGHT_PIN, OUTPUT);
 #ifdef TFT_BACKLIGHT_TIMEOUT_MS
@@ -179,26 +145,32 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
   }
 
   // If we have messages to display, do it
-  if(_head) {
-    nextUpdate = displayNextMessage();
-  }
-  DBUGVAR(_nextMessageTime);
-  if(!_msg_cleared && millis() >= _nextMessageTime)
+  nextUpdate = displayNextMessage();
+  if(!_msg_cleared && !_messages.holding(millis()))
   {
     DBUGLN("Clearing message lines");
     for(int i = 0; i < LCD_MAX_LINES; i++) {
       clear_message_line(i);
     }
     _msg_cleared = true;
+    _changed |= DISPLAY_CHANGED_MESSAGE;
   }
 
+  // One snapshot of the EVSE per wake, the screens only redraw what changed
+  // and otherwise just tick the clock
+  DisplayState state;
+  display_state_capture(*_evse, state);
+  uint32_t changed = state.diff(_state) | _changed;
+  _state = state;
+  _changed = 0;
+
 #ifdef ENABLE_DOUBLE_BUFFER
   _tft.startWrite();
 #endif
 
   // Update the screen manager
   if (_screenManager) {
-    unsigned long screenUpdate = _screenManager->update();
+    unsigned long screenUpdate = _screenManager->update(changed);
     if (screenUpdate < nextUpdate) {
       nextUpdate = screenUpdate;
     }
@@ -215,31 +187,21 @@ unsigned long LcdTask::loop(MicroTasks::WakeReason reason)
 
 unsigned long LcdTask::displayNextMessage()
 {
-  while(_head && millis() >= _nextMessageTime)
+  DisplayMessage msg;
+  while(_messages.pop(millis(), msg))
   {
-    // Pop a message from the queue
-    Message *msg = _head;
-    DBUGF("msg = %p", msg);
-    _head = _head->getNext();
-    if(NULL == _head) {
-      _tail = NULL;
-    }
-
     // Display the message
 #ifdef TFT_BACKLIGHT_TIMEOUT_MS
     if (_screenManager) {
       _screenManager->wakeBacklight();
     }
 #endif //TFT_BACKLIGHT_TIMEOUT_MS
-    set_message_line(msg->getX(), msg->getY(), msg->getMsg(), msg->getClear());
-
-    _nextMessageTime = millis() + msg->getTime();
-
-    // delete the message
-    delete msg;
+    set_message_line(msg.x, msg.y, msg.text, msg.clear);
+    _changed |= DISPLAY_CHANGED_MESSAGE;
   }
 
-  unsigned long nextUpdate = _nextMessageTime - millis();
+  uint32_t nextChange = _messages.nextChange(millis());
+  unsigned long nextUpdate = DISPLAY_MESSAGE_IDLE == nextChange ? MicroTask.Infinate : nextChange;
   DBUGVAR(nextUpdate);
   return nextUpdate;
 }
@@ -0,0 +1,94 @@
+#include <string.h>
+
+#include "led_animation.h"
+
+bool LedFrame::operator==(const LedFrame &other) const
+{
+  return 0 == memcmp(evse, other.evse, sizeof(evse)) &&
+         0 == memcmp(wifi, other.wifi, sizeof(wifi)) &&
+         wifiLed == other.wifiLed;
+}
+
+LedAnimation::LedAnimation() :
+  _count(1),
+  _frameTime(0)
+{
+  memset(_frames, 0, sizeof(_frames));
+}
+
+void LedAnimation::steady(const LedFrame &frame)
+{
+  memset(_frames, 0, sizeof(_frames));
+  _frames[0] = frame;
+  _count = 1;
+  _frameTime = 0;
+}
+
+void LedAnimation::flash(const LedFrame &on, const LedFrame &off, uint16_t time)
+{
+  memset(_frames, 0, sizeof(_frames));
+  _frames[0] = on;
+  _frames[1] = off;
+  _count = 2;
+  _frameTime = time;
+}
+
+bool LedAnimation::operator==(const LedAnimation &other) const
+{
+  if(_count != other._count || _frameTime != other._frameTime) {
+    return false;
+  }
+
+  for(uint8_t i = 0; i < _count; i++) {
+    if(_frames[i] != other._frames[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+LedAnimationPlayer::LedAnimationPlayer() :
+  _start(0),
+  _index(0)
+{
+}
+
+bool LedAnimationPlayer::start(const LedAnimation &animation, uint32_t now)
+{
+  if(animation == _animation) {
+    return false;
+  }
+
+  _animation = animation;
+  _start = now;
+  _index = 0;
+  return true;
+}
+
+bool LedAnimationPlayer::update(uint32_t now)
+{
+  if(!_animation.animated()) {
+    return false;
+  }
+
+  // Worked out from the start time rather than stepped, so a late wake
+  // never makes the animation drift
+  uint8_t index = ((now - _start) / _animation.frameTime()) % _animation.count();
+  if(index == _index) {
+    return false;
+  }
+
+  _index = index;
+  return true;
+}
+
+uint32_t LedAnimationPlayer::nextChange(uint32_t now) const
+{
+  if(!_animation.animated()) {
+    return LED_ANIMATION_STATIC;
+  }
+
+  uint32_t frameTime = _animation.frameTime();
+  return frameTime - ((now - _start) % frameTime);
+}
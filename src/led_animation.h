@@ -0,0 +1,84 @@
+#ifndef LED_ANIMATION_H
+#define LED_ANIMATION_H
+
+// Status LED animations as precomputed frame tables.
+//
+// LedManagerTask builds an LedAnimation when the LED state changes, a
+// steady colour or a flash between two frames, and hands it to the LED
+// output task. LedAnimationPlayer works out which frame is due from the time
+// since the animation started, so the output side only has to sleep until
+// the next frame change and write it out, without calling back into the
+// MicroTasks loop.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LED_ANIMATION_MAX_FRAMES
+#define LED_ANIMATION_MAX_FRAMES 4
+#endif
+
+// nextChange() for an animation that never changes
+#define LED_ANIMATION_STATIC UINT32_MAX
+
+struct LedFrame
+{
+  uint8_t evse[3];              // R, G, B, brightness applied
+  uint8_t wifi[3];              // R, G, B of the WiFi pixel / RGB LED
+  bool wifiLed;                 // Single colour WiFi LED lit
+
+  bool operator==(const LedFrame &other) const;
+  bool operator!=(const LedFrame &other) const { return !(*this == other); }
+};
+
+class LedAnimation
+{
+  public:
+    LedAnimation();
+
+    // Show one frame until told otherwise
+    void steady(const LedFrame &frame);
+    // Alternate between two frames, each shown for time ms
+    void flash(const LedFrame &on, const LedFrame &off, uint16_t time);
+
+    uint8_t count() const { return _count; }
+    uint16_t frameTime() const { return _frameTime; }
+    const LedFrame &frame(uint8_t index) const { return _frames[index]; }
+
+    bool animated() const { return _count > 1 && _frameTime > 0; }
+
+    bool operator==(const LedAnimation &other) const;
+    bool operator!=(const LedAnimation &other) const { return !(*this == other); }
+
+  private:
+    LedFrame _frames[LED_ANIMATION_MAX_FRAMES];
+    uint8_t _count;
+    uint16_t _frameTime;
+};
+
+class LedAnimationPlayer
+{
+  public:
+    LedAnimationPlayer();
+
+    // Start playing from the first frame. Returns false, and keeps the
+    // current timing, if the animation is the one already playing
+    bool start(const LedAnimation &animation, uint32_t now);
+
+    // Move on to the frame due at now, returns true if it is a different
+    // frame to the one last returned by frame()
+    bool update(uint32_t now);
+
+    const LedFrame &frame() const { return _animation.frame(_index); }
+
+    // ms from now until the next frame is due
+    uint32_t nextChange(uint32_t now) const;
+
+  private:
+    LedAnimation _animation;
+    uint32_t _start;
+    uint8_t _index;
+};
+
+#endif // LED_ANIMATION_H
@@ -4,6 +4,7 @@
 
 #include "limit.h"
 #include "debug.h"
+#include "profile.h"
 #include "event.h"
 // ---------------------------------------------
 //
@@ -141,7 +142,9 @@ Limit limit;
 Limit::Limit() :
   MicroTasks::Task(),
   _version(0),
-  _sessionCompleteListener(this)
+  _sessionCompleteListener(this),
+  _stateChangeListener(this),
+  _vehicleUpdateListener(this)
 {
   _limit_properties.init();
 }
@@ -159,13 +162,16 @@ void Limit::begin(EvseManager &evse) {
   // todo get saved default limit
   DBUGLN("Starting Limit task");
   this->_evse = &evse;
-  setDefaultLimit(limit_default_type.c_str(), limit_default_value);
   MicroTask.startTask(this);
   _evse->onSessionComplete(&_sessionCompleteListener);
+  _evse->onStateChange(&_stateChangeListener);
+  _evse->onVehicleUpdate(&_vehicleUpdateListener);
+  setDefaultLimit(limit_default_type.c_str(), limit_default_value);
 };
 
 unsigned long Limit::loop(MicroTasks::WakeReason reason)
 {
+  Profile_Scope("Limit");
   DBUG("Limit woke: ");
   DBUGLN(WakeReason_Scheduled == reason ? "WakeReason_Scheduled" :
          WakeReason_Event == reason ? "WakeReason_Event" :
@@ -173,6 +179,12 @@ unsigned long Limit::loop(MicroTasks::WakeReason reason)
          WakeReason_Manual == reason ? "WakeReason_Manual" :
          "UNKNOWN");
 
+  // These only wake the task, everything is looked at again below
+  _stateChangeListener.IsTriggered();
+  _vehicleUpdateListener.IsTriggered();
+
+  unsigned long next = MicroTask.Infinate;
+
   if(_sessionCompleteListener.IsTriggered())
   {
     DBUGLN("Session complete, clearing limit");
@@ -197,10 +209,10 @@ unsigned long Limit::loop(MicroTasks::WakeReason reason)
       bool limit_reached = false;
       switch (type) {
         case LimitType::Time:
-          limit_reached = limitTime(value);
+          limit_reached = limitTime(value, next);
           break;
         case LimitType::Energy:
-          limit_reached = limitEnergy(value);
+          limit_reached = limitEnergy(value, next);
           break;
         case LimitType::Soc:
           limit_reached = limitSoc(value);
@@ -216,6 +228,8 @@ unsigned long Limit::loop(MicroTasks::WakeReason reason)
         props.setState(EvseState::Disabled);
         props.setAutoRelease(true);
         _evse->claim(EvseClient_OpenEVSE_Limit, EvseManager_Priority_Limit, props);
+        // Until charging stops, a state change
+        next = EVSE_LIMIT_LOOP_TIME;
       }
     }
     else if(_limit_properties.getAutoRelease() &&
@@ -237,22 +251,33 @@ unsigned long Limit::loop(MicroTasks::WakeReason reason)
       _evse->release(EvseClient_OpenEVSE_Limit);
     }
   }
-  return EVSE_LIMIT_LOOP_TIME;
+  return next;
 };
 
-bool Limit::limitTime(uint32_t val) {
-  uint32_t elapsed = (uint32_t)_evse->getSessionElapsed()/60;
-  if ( val > 0 && elapsed >= val ) {
+bool Limit::limitTime(uint32_t val, unsigned long &next) {
+  uint32_t elapsed = (uint32_t)_evse->getSessionElapsed();
+  uint32_t limit = val * 60;
+  if ( val > 0 && elapsed >= limit ) {
     // Time limit done
     DBUGLN("Time limit reached");
     DBUGVAR(val);
     DBUGVAR(elapsed);
     return true;
   }
-  else return false;
+  else if ( val > 0 ) {
+    // Sleep until it is due. The session time only counts while charging,
+    // and a pause is a state change, so this is the deadline. Capped so the
+    // milliseconds do not overflow.
+    uint32_t remaining = limit - elapsed;
+    if (remaining > 86400) {
+      remaining = 86400;
+    }
+    next = remaining * 1000UL;
+  }
+  return false;
 };
 
-bool Limit::limitEnergy(uint32_t val) {
+bool Limit::limitEnergy(uint32_t val, unsigned long &next) {
   uint32_t elapsed = _evse->getSessionEnergy();
   if ( val > 0 && elapsed >= val ) {
     // Energy limit done
@@ -261,7 +286,19 @@ bool Limit::limitEnergy(uint32_t val) {
     DBUGVAR(elapsed);
     return true;
   }
-  else return false;
+  else if ( val > 0 ) {
+    // Sleep until it is expected to be reached at the present power
+    next = EVSE_LIMIT_PREDICT_TIME;
+    double power = _evse->getPower();
+    if (power > 0) {
+      double ms = (val - _evse->getSessionEnergy()) * 3600000.0 / power;
+      if (ms < EVSE_LIMIT_PREDICT_TIME) {
+        next = ms > EVSE_LIMIT_LOOP_TIME ? (unsigned long)ms : EVSE_LIMIT_LOOP_TIME;
+      }
+    }
+    DBUGVAR(next);
+  }
+  return false;
 };
 
 bool Limit::limitSoc(uint32_t val) {
@@ -308,6 +345,7 @@ bool Limit::set(LimitProperties props) {
   doc["limit"] = hasLimit();
   doc["limit_version"] = ++_version;
   event_send(doc);
+  MicroTask.wakeTask(this);
   return true;
 };
 
@@ -321,6 +359,7 @@ bool Limit::clear() {
   doc["limit"] = false;
   doc["limit_version"] = ++_version;
   event_send(doc);
+  MicroTask.wakeTask(this);
   return true;
 };
 
@@ -328,6 +367,10 @@ uint8_t Limit::getVersion() {
   return _version;
 }
 
+void Limit::notifyConfigChanged() {
+  MicroTask.wakeTask(this);
+}
+
 bool Limit::setDefaultLimit(const char* typeStr, uint32_t value) {
   LimitProperties limitprops;
   LimitType limitType;
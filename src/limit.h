@@ -2,9 +2,17 @@
 #define _OPENEVSE_LIMIT_H
 
 
+// The limit task sleeps until a limit is due, or until the EVSE state or the
+// vehicle data changes. This is the shortest it sleeps, the session energy
+// and time are updated once a second.
 #ifndef EVSE_LIMIT_LOOP_TIME
 #define EVSE_LIMIT_LOOP_TIME 1000
 #endif
+// Longest the energy limit trusts its prediction of when it is reached, the
+// charge power can change
+#ifndef EVSE_LIMIT_PREDICT_TIME
+#define EVSE_LIMIT_PREDICT_TIME 60000
+#endif
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <MicroTasks.h>
@@ -64,8 +72,12 @@ class Limit: public MicroTasks::Task
 		LimitProperties _limit_properties;
 		uint8_t   _version;
     MicroTasks::EventListener _sessionCompleteListener;
-		bool limitTime(uint32_t val);
-		bool limitEnergy(uint32_t val);
+    MicroTasks::EventListener _stateChangeListener;
+    MicroTasks::EventListener _vehicleUpdateListener;
+		// Set next to when to look again if the limit has not been reached
+		bool limitTime(uint32_t val, unsigned long &next);
+		bool limitEnergy(uint32_t val, unsigned long &next);
+		// Looked at again when the vehicle data is updated
 		bool limitSoc(uint32_t val);
 		bool limitRange(uint32_t val);
 
@@ -84,6 +96,8 @@ class Limit: public MicroTasks::Task
 		bool clear();
 		bool setDefaultLimit(const char* typeStr, uint32_t value);
 		uint8_t getVersion();
+		// The default state has changed
+		void notifyConfigChanged();
 };
 
 extern Limit limit;
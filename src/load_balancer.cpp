@@ -0,0 +1,274 @@
+#include <ArduinoJson.h>
+
+#include "load_balancer.h"
+#include "event.h"
+
+//global instance
+LoadBalancerTask loadBalancer;
+
+LoadBalancerTask::LoadBalancerTask() :
+  MicroTasks::Task(),
+  _evse(nullptr),
+  _evseState(this),
+  _publisher(nullptr),
+  _enabled(false),
+  _budget(0),
+  _priority(0),
+  _policy(LoadSharePolicy::Fair),
+  _failsafe_current(0),
+  _changed(false),
+  _announced(false),
+  _withdraw(false),
+  _last_announce(0),
+  _last_echo(0),
+  _failsafe(false),
+  _claim_state(EvseState::None),
+  _claim_current(0),
+  _allocation(0)
+{
+  _id[0] = '\0';
+}
+
+LoadBalancerTask::~LoadBalancerTask()
+{
+  if(_evse) {
+    _evse->release(EvseClient_OpenEVSE_LoadBalancer);
+  }
+}
+
+void LoadBalancerTask::setup()
+{
+}
+
+void LoadBalancerTask::begin(EvseManager &evse, const char *id)
+{
+  _evse = &evse;
+  strncpy(_id, id, sizeof(_id) - 1);
+  _id[sizeof(_id) - 1] = '\0';
+  _last_echo = millis();
+  _evse->onStateChange(&_evseState);
+  MicroTask.startTask(this);
+}
+
+void LoadBalancerTask::setPublisher(LoadBalancerPublisher publisher)
+{
+  _publisher = publisher;
+}
+
+void LoadBalancerTask::notifyConfigChanged(bool enabled, uint32_t budget, int32_t priority,
+                                           LoadSharePolicy policy, uint32_t failsafe_current)
+{
+  DBUGF("LoadBalancer: got config changed");
+  if(_enabled && !enabled)
+  {
+    // Withdraw our announcement so the others can use our share, the
+    // loop tries again until it is sent
+    _withdraw = true;
+    _table.clear();
+  }
+  if(!_enabled && enabled)
+  {
+    _withdraw = false;
+    // Give the link a chance before the failsafe applies
+    _last_echo = millis();
+    _announced = false;
+  }
+
+  _enabled = enabled;
+  _budget = budget;
+  _priority = priority;
+  _policy = policy;
+  _failsafe_current = failsafe_current;
+  _changed = true;
+  MicroTask.wakeTask(this);
+}
+
+void LoadBalancerTask::receive(const char *id, const char *payload, size_t length)
+{
+  if(!_enabled) {
+    return;
+  }
+
+  if(0 == strncmp(id, _id, LOAD_SHARE_ID_SIZE - 1))
+  {
+    // Our own announcement back from the site, the link is working
+    _last_echo = millis();
+    if(_failsafe) {
+      MicroTask.wakeTask(this);
+    }
+    return;
+  }
+
+  if(0 == length)
+  {
+    if(_table.remove(id)) {
+      MicroTask.wakeTask(this);
+    }
+    return;
+  }
+
+  StaticJsonDocument<256> doc;
+  DeserializationError error = deserializeJson(doc, payload, length);
+  if(error || !doc.containsKey("budget")) {
+    DBUGF("LoadBalancer: ignoring announcement from %s", id);
+    return;
+  }
+
+  LoadSharePeer peer;
+  memset(&peer, 0, sizeof(peer));
+  strncpy(peer.id, id, sizeof(peer.id) - 1);
+  peer.demand = doc["demand"] | false;
+  peer.charging = doc["charging"] | false;
+  peer.min_current = doc["min"] | 6;
+  peer.max_current = doc["max"] | peer.min_current;
+  peer.priority = doc["priority"] | 0;
+  peer.budget = doc["budget"];
+  peer.policy = LoadShareAllocator::policyFromName(doc["policy"].as<const char *>());
+
+  if(_table.update(peer, millis())) {
+    MicroTask.wakeTask(this);
+  }
+}
+
+void LoadBalancerTask::makeSelf(LoadSharePeer &self)
+{
+  memset(&self, 0, sizeof(self));
+  strncpy(self.id, _id, sizeof(self.id) - 1);
+  // A vehicle that is connected and not held off by someone other than us
+  self.demand = _evse->isVehicleConnected() &&
+                (EvseState::Disabled != _evse->getState() ||
+                 EvseClient_OpenEVSE_LoadBalancer == _evse->getStateClient());
+  self.charging = _evse->isCharging();
+  self.min_current = _evse->getMinCurrent();
+  self.max_current = _evse->getMaxConfiguredCurrent();
+  self.priority = _priority;
+  self.budget = _budget;
+  self.policy = _policy;
+}
+
+bool LoadBalancerTask::announce(const LoadSharePeer &self)
+{
+  if(!_publisher) {
+    return false;
+  }
+
+  StaticJsonDocument<192> doc;
+  doc["demand"] = self.demand;
+  doc["charging"] = self.charging;
+  doc["min"] = self.min_current;
+  doc["max"] = self.max_current;
+  doc["priority"] = self.priority;
+  doc["budget"] = self.budget;
+  doc["policy"] = LoadShareAllocator::policyName(self.policy);
+
+  String payload;
+  serializeJson(doc, payload);
+  return _publisher(payload);
+}
+
+void LoadBalancerTask::apply(const LoadSharePeer &self)
+{
+  EvseState state = EvseState::None;
+  uint32_t current;
+
+  if(!self.demand) {
+    // Nothing to share, wait at the minimum so a new session does not
+    // start above it before the others have made room
+    current = self.min_current;
+  } else {
+    current = _failsafe ? _failsafe_current : _table.allocation(_id);
+    if(current < self.min_current) {
+      // pause, not enough of the budget left for us
+      state = EvseState::Disabled;
+      current = self.min_current;
+    }
+  }
+  _allocation = (self.demand && EvseState::Disabled != state) ? current : 0;
+
+  if(state == _claim_state && current == _claim_current &&
+     _evse->clientHasClaim(EvseClient_OpenEVSE_LoadBalancer))
+  {
+    return;
+  }
+
+  DBUGF("LoadBalancer: %s at %uA%s", EvseState::Disabled == state ? "paused" : "limited",
+        current, _failsafe ? " (failsafe)" : "");
+
+  EvseProperties props(state);
+  props.setMaxCurrent(current);
+  _evse->claim(EvseClient_OpenEVSE_LoadBalancer, EvseManager_Priority_Safety, props);
+  _claim_state = state;
+  _claim_current = current;
+
+  sendEvent();
+}
+
+void LoadBalancerTask::sendEvent()
+{
+  StaticJsonDocument<192> event;
+  event["load_balancing"] = _enabled ? 1 : 0;
+  event["load_balancing_allocation"] = _allocation;
+  event["load_balancing_budget"] = _table.budget();
+  event["load_balancing_peers"] = _table.count();
+  event["load_balancing_failsafe"] = isFailsafe();
+  event_send(event);
+}
+
+unsigned long LoadBalancerTask::loop(MicroTasks::WakeReason reason)
+{
+  Profile_Scope("LoadBalancerTask");
+  if(!_evse) {
+    return MicroTask.Infinate;
+  }
+
+  if(!_enabled)
+  {
+    if(_evse->clientHasClaim(EvseClient_OpenEVSE_LoadBalancer)) {
+      _evse->release(EvseClient_OpenEVSE_LoadBalancer);
+      _allocation = 0;
+      sendEvent();
+    }
+    if(_withdraw) {
+      // Retained, so until it is cleared the others keep counting us
+      _withdraw = !(_publisher && _publisher(""));
+      if(_withdraw) {
+        return LOAD_BALANCER_ANNOUNCE_TIME;
+      }
+    }
+    return MicroTask.Infinate;
+  }
+
+  uint32_t now = millis();
+
+  // Plug in, unplug and anything else about us that changes the allocation
+  // is announced straight away rather than on the next heartbeat
+  LoadSharePeer self;
+  makeSelf(self);
+  if(_table.update(self, now)) {
+    _changed = true;
+  }
+  if(_evseState.IsTriggered()) {
+    _changed = true;
+  }
+
+  if(_changed || !_announced || now - _last_announce >= LOAD_BALANCER_ANNOUNCE_TIME)
+  {
+    _announced = announce(self);
+    _last_announce = now;
+    _changed = false;
+  }
+
+  _table.expire(now, LOAD_BALANCER_PEER_TIMEOUT, _id);
+
+  bool failsafe = now - _last_echo > LOAD_BALANCER_FAILSAFE_TIME;
+  if(failsafe != _failsafe) {
+    DBUGF("LoadBalancer: link to the site %s", failsafe ? "lost" : "restored");
+    _failsafe = failsafe;
+    sendEvent();
+  }
+
+  _table.allocate(_budget, _policy);
+  apply(self);
+
+  return LOAD_BALANCER_LOOP_TIME;
+}
@@ -0,0 +1,96 @@
+#ifndef _OPENEVSE_LOAD_BALANCER_H
+#define _OPENEVSE_LOAD_BALANCER_H
+
+// Time between loop polls
+#ifndef LOAD_BALANCER_LOOP_TIME
+#define LOAD_BALANCER_LOOP_TIME 1000
+#endif
+
+// Heartbeat, an announcement is also sent straight away on any change
+#ifndef LOAD_BALANCER_ANNOUNCE_TIME
+#define LOAD_BALANCER_ANNOUNCE_TIME (10 * 1000)
+#endif
+
+// Without our own announcement coming back for this long the link to the
+// site is taken as lost and the failsafe applies
+#ifndef LOAD_BALANCER_FAILSAFE_TIME
+#define LOAD_BALANCER_FAILSAFE_TIME (30 * 1000)
+#endif
+
+// Peers not heard from for this long are dropped and their share handed
+// out again. Must be longer than LOAD_BALANCER_FAILSAFE_TIME so a peer that
+// has lost the link is already in its failsafe by then.
+#ifndef LOAD_BALANCER_PEER_TIMEOUT
+#define LOAD_BALANCER_PEER_TIMEOUT (60 * 1000)
+#endif
+
+#include <functional>
+
+#include "emonesp.h"
+#include <MicroTasks.h>
+#include "evse_man.h"
+#include "load_share.h"
+
+// Publish our announcement, retained, to <site topic>/<id>. An empty
+// payload withdraws it. Returns false if it could not be sent.
+typedef std::function<bool(const String &payload)> LoadBalancerPublisher;
+
+class LoadBalancerTask : public MicroTasks::Task
+{
+  private:
+    EvseManager *_evse;
+    MicroTasks::EventListener _evseState;
+    LoadBalancerPublisher _publisher;
+    LoadShareAllocator _table;
+
+    bool     _enabled;
+    uint32_t _budget;            // A
+    int32_t  _priority;
+    LoadSharePolicy _policy;
+    uint32_t _failsafe_current;  // A, 0 to pause
+
+    char     _id[LOAD_SHARE_ID_SIZE];
+    bool     _changed;
+    bool     _announced;
+    bool     _withdraw;          // announcement still to be withdrawn
+    uint32_t _last_announce;
+    uint32_t _last_echo;
+    bool     _failsafe;
+
+    EvseState _claim_state;
+    uint32_t  _claim_current;
+    uint32_t  _allocation;
+
+    void makeSelf(LoadSharePeer &self);
+    bool announce(const LoadSharePeer &self);
+    void apply(const LoadSharePeer &self);
+    void sendEvent();
+
+  protected:
+    void setup();
+    unsigned long loop(MicroTasks::WakeReason reason);
+
+  public:
+    LoadBalancerTask();
+    ~LoadBalancerTask();
+
+    void begin(EvseManager &evse, const char *id);
+    void setPublisher(LoadBalancerPublisher publisher);
+
+    // An announcement from the peer id, from <site topic>/<id>
+    void receive(const char *id, const char *payload, size_t length);
+
+    void notifyConfigChanged(bool enabled, uint32_t budget, int32_t priority,
+                             LoadSharePolicy policy, uint32_t failsafe_current);
+
+    bool isEnabled() { return _enabled; }
+    bool isFailsafe() { return _enabled && _failsafe; }
+    uint32_t getAllocation() { return _allocation; }
+    uint32_t getBudget() { return _table.budget(); }
+    size_t getPeerCount() { return _table.count(); }
+    const LoadShareAllocator &getTable() { return _table; }
+};
+
+extern LoadBalancerTask loadBalancer;
+
+#endif // _OPENEVSE_LOAD_BALANCER_H
@@ -0,0 +1,225 @@
+#include <string.h>
+
+#include "load_share.h"
+
+LoadShareAllocator::LoadShareAllocator() :
+  _count(0),
+  _budget(0),
+  _policy(LoadSharePolicy::Fair),
+  _allocated(0)
+{
+  memset(_peers, 0, sizeof(_peers));
+}
+
+bool LoadShareAllocator::update(const LoadSharePeer &peer, uint32_t now)
+{
+  for(size_t i = 0; i < _count; i++)
+  {
+    LoadSharePeer &entry = _peers[i];
+    if(0 == strcmp(entry.id, peer.id))
+    {
+      bool changed = entry.demand != peer.demand ||
+                     entry.charging != peer.charging ||
+                     entry.min_current != peer.min_current ||
+                     entry.max_current != peer.max_current ||
+                     entry.priority != peer.priority ||
+                     entry.budget != peer.budget ||
+                     entry.policy != peer.policy;
+      uint32_t allocation = entry.allocation;
+      entry = peer;
+      entry.seen = now;
+      entry.allocation = allocation;
+      return changed;
+    }
+  }
+
+  if(_count >= LOAD_SHARE_MAX_PEERS) {
+    return false;
+  }
+
+  LoadSharePeer &entry = _peers[_count++];
+  entry = peer;
+  entry.id[LOAD_SHARE_ID_SIZE - 1] = '\0';
+  entry.seen = now;
+  entry.allocation = 0;
+  return true;
+}
+
+bool LoadShareAllocator::remove(const char *id)
+{
+  for(size_t i = 0; i < _count; i++)
+  {
+    if(0 == strcmp(_peers[i].id, id))
+    {
+      _peers[i] = _peers[--_count];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool LoadShareAllocator::expire(uint32_t now, uint32_t timeout, const char *keep)
+{
+  bool expired = false;
+  for(size_t i = 0; i < _count; )
+  {
+    if(now - _peers[i].seen > timeout &&
+       (nullptr == keep || 0 != strcmp(_peers[i].id, keep)))
+    {
+      _peers[i] = _peers[--_count];
+      expired = true;
+    } else {
+      i++;
+    }
+  }
+
+  return expired;
+}
+
+void LoadShareAllocator::clear()
+{
+  _count = 0;
+  _allocated = 0;
+}
+
+bool LoadShareAllocator::before(const LoadSharePeer &a, const LoadSharePeer &b) const
+{
+  if(LoadSharePolicy::Priority == _policy && a.priority != b.priority) {
+    return a.priority > b.priority;
+  }
+  // Keep sessions that are running going rather than swap one for another
+  if(a.charging != b.charging) {
+    return a.charging;
+  }
+  return strcmp(a.id, b.id) < 0;
+}
+
+// Even split of remaining across the funded peers in order, up to their
+// maximum. Any amps that do not divide go one each in order. Returns what
+// is left over once everyone is at their maximum.
+uint32_t LoadShareAllocator::share(const uint8_t *order, size_t count, uint32_t remaining)
+{
+  while(remaining > 0)
+  {
+    size_t open = 0;
+    for(size_t i = 0; i < count; i++) {
+      const LoadSharePeer &peer = _peers[order[i]];
+      if(peer.allocation > 0 && peer.allocation < peer.max_current) {
+        open++;
+      }
+    }
+    if(0 == open) {
+      break;
+    }
+
+    uint32_t each = remaining / open;
+    for(size_t i = 0; i < count && remaining > 0; i++)
+    {
+      LoadSharePeer &peer = _peers[order[i]];
+      if(0 == peer.allocation || peer.allocation >= peer.max_current) {
+        continue;
+      }
+
+      uint32_t add = each > 0 ? each : 1;
+      if(add > peer.max_current - peer.allocation) {
+        add = peer.max_current - peer.allocation;
+      }
+      peer.allocation += add;
+      remaining -= add;
+    }
+  }
+
+  return remaining;
+}
+
+void LoadShareAllocator::allocate(uint32_t budget, LoadSharePolicy policy)
+{
+  // Be as conservative as the most conservative unit
+  for(size_t i = 0; i < _count; i++)
+  {
+    if(_peers[i].budget < budget) {
+      budget = _peers[i].budget;
+    }
+    if(LoadSharePolicy::Priority != _peers[i].policy) {
+      policy = LoadSharePolicy::Fair;
+    }
+  }
+  _budget = budget;
+  _policy = policy;
+
+  uint8_t order[LOAD_SHARE_MAX_PEERS];
+  size_t count = 0;
+  for(size_t i = 0; i < _count; i++)
+  {
+    LoadSharePeer &peer = _peers[i];
+    peer.allocation = 0;
+    if(!peer.demand) {
+      continue;
+    }
+
+    // Insertion sort, the table is small
+    size_t pos = count++;
+    while(pos > 0 && before(peer, _peers[order[pos - 1]])) {
+      order[pos] = order[pos - 1];
+      pos--;
+    }
+    order[pos] = i;
+  }
+
+  uint32_t remaining = budget;
+  for(size_t i = 0; i < count; i++)
+  {
+    LoadSharePeer &peer = _peers[order[i]];
+    uint32_t min = peer.min_current > 0 ? peer.min_current : 1;
+    if(min <= remaining) {
+      peer.allocation = min;
+      remaining -= min;
+    }
+  }
+
+  if(LoadSharePolicy::Priority == policy)
+  {
+    for(size_t start = 0; start < count && remaining > 0; )
+    {
+      size_t end = start + 1;
+      while(end < count && _peers[order[end]].priority == _peers[order[start]].priority) {
+        end++;
+      }
+      remaining = share(order + start, end - start, remaining);
+      start = end;
+    }
+  } else {
+    remaining = share(order, count, remaining);
+  }
+
+  _allocated = budget - remaining;
+}
+
+const LoadSharePeer *LoadShareAllocator::find(const char *id) const
+{
+  for(size_t i = 0; i < _count; i++)
+  {
+    if(0 == strcmp(_peers[i].id, id)) {
+      return &_peers[i];
+    }
+  }
+
+  return nullptr;
+}
+
+uint32_t LoadShareAllocator::allocation(const char *id) const
+{
+  const LoadSharePeer *peer = find(id);
+  return peer ? peer->allocation : 0;
+}
+
+const char *LoadShareAllocator::policyName(LoadSharePolicy policy)
+{
+  return LoadSharePolicy::Priority == policy ? "priority" : "fair";
+}
+
+LoadSharePolicy LoadShareAllocator::policyFromName(const char *name)
+{
+  return (name && 0 == strcmp(name, "priority")) ? LoadSharePolicy::Priority : LoadSharePolicy::Fair;
+}
@@ -0,0 +1,97 @@
+#ifndef _OPENEVSE_LOAD_SHARE_H
+#define _OPENEVSE_LOAD_SHARE_H
+
+// Site budget allocation for load balancing across several chargers.
+//
+// Every unit keeps the same table of peers, built from the announcements
+// they publish, and runs the same allocation over it, so all of them agree
+// on who gets what without electing a coordinator:
+//
+// - peers with a vehicle connected are ordered by priority (priority policy
+//   only), then peers already charging, then id
+// - in that order each peer is given its minimum current while the budget
+//   lasts, a peer that does not fit gets nothing and is paused
+// - the rest of the budget is shared out evenly up to each peer's maximum,
+//   for the priority policy one priority level at a time, highest first
+//
+// The budget used is the smallest one announced and the priority policy is
+// only used when every peer asks for it, so a unit that is configured
+// differently can make the allocation more conservative but never larger.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef LOAD_SHARE_MAX_PEERS
+#define LOAD_SHARE_MAX_PEERS 16
+#endif
+
+#define LOAD_SHARE_ID_SIZE 33
+
+enum class LoadSharePolicy : uint8_t {
+  Fair,
+  Priority
+};
+
+struct LoadSharePeer
+{
+  char id[LOAD_SHARE_ID_SIZE];
+  bool demand;              // vehicle connected and wanting to charge
+  bool charging;
+  uint32_t min_current;     // A
+  uint32_t max_current;     // A
+  int32_t priority;
+  uint32_t budget;          // site budget configured on that unit, A
+  LoadSharePolicy policy;   // site policy configured on that unit
+
+  uint32_t seen;            // millis() of the last announcement
+  uint32_t allocation;      // A, set by allocate()
+};
+
+class LoadShareAllocator
+{
+  public:
+    LoadShareAllocator();
+
+    // Add or refresh a peer. Returns true if the peer is new or anything
+    // that changes the allocation has changed, false if nothing did or the
+    // table is full
+    bool update(const LoadSharePeer &peer, uint32_t now);
+    bool remove(const char *id);
+
+    // Drop the peers not heard from for timeout ms, except keep, returns
+    // true if any were dropped
+    bool expire(uint32_t now, uint32_t timeout, const char *keep = nullptr);
+    void clear();
+
+    // Share budget A across the peers with demand, see above
+    void allocate(uint32_t budget, LoadSharePolicy policy);
+
+    const LoadSharePeer *find(const char *id) const;
+    uint32_t allocation(const char *id) const;
+
+    size_t count() const { return _count; }
+    const LoadSharePeer &peer(size_t index) const { return _peers[index]; }
+
+    // The budget and policy used by the last allocate()
+    uint32_t budget() const { return _budget; }
+    LoadSharePolicy policy() const { return _policy; }
+    uint32_t allocated() const { return _allocated; }
+
+    static const char *policyName(LoadSharePolicy policy);
+    static LoadSharePolicy policyFromName(const char *name);
+
+  private:
+    LoadSharePeer _peers[LOAD_SHARE_MAX_PEERS];
+    size_t _count;
+
+    uint32_t _budget;
+    LoadSharePolicy _policy;
+    uint32_t _allocated;
+
+    bool before(const LoadSharePeer &a, const LoadSharePeer &b) const;
+    uint32_t share(const uint8_t *order, size_t count, uint32_t remaining);
+};
+
+#endif // _OPENEVSE_LOAD_SHARE_H
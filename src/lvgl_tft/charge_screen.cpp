@@ -260,6 +260,11 @@ void charge_screen_update(const ChargeScreenData &d)
   }
 }
 
+void charge_screen_set_clock(const char *datetime)
+{
+  lv_label_set_text(datetime_lbl, datetime ? datetime : "");
+}
+
 void charge_screen_destroy()
 {
   if (charge_scr) {
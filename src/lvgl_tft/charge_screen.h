@@ -1,6 +1,6 @@
 // src/lvgl_tft/charge_screen.h — the single LVGL status screen for the stock TFT.
-// One widget tree built once; charge_screen_update() pushes a full snapshot each
-// refresh (~1 Hz). Read-only (no touch). Same data as the original charge screen.
+// One widget tree built once; charge_screen_update() pushes a full snapshot when
+// the display state changes, charge_screen_set_clock() ticks the clock at 1 Hz. Read-only (no touch). Same data as the original charge screen.
 #ifndef __CHARGE_SCREEN_H
 #define __CHARGE_SCREEN_H
 
@@ -42,5 +42,8 @@ void charge_screen_destroy();
 // Push a full snapshot. Cheap; only changed pixels re-flush (LVGL dirty-rect).
 void charge_screen_update(const ChargeScreenData &d);
 
+// Just the date/time, for the clock ticks between snapshots.
+void charge_screen_set_clock(const char *datetime);
+
 #endif // ENABLE_SCREEN_LVGL_TFT
 #endif // __CHARGE_SCREEN_H
@@ -158,6 +158,11 @@ void standby_screen_update(const StandbyScreenData &d)
   lv_label_set_text(ip_lbl, d.ip ? d.ip : "");
 }
 
+void standby_screen_set_clock(const char *clock)
+{
+  lv_label_set_text(clock_lbl, clock ? clock : "");
+}
+
 void standby_screen_destroy()
 {
   if (standby_scr) {
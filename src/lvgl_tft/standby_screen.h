@@ -28,6 +28,8 @@ void standby_screen_build();
 void standby_screen_destroy();
 // Requires a preceding standby_screen_build() (writes into its widgets).
 void standby_screen_update(const StandbyScreenData &d);
+// Just the clock, for the ticks between snapshots.
+void standby_screen_set_clock(const char *clock);
 
 #endif // ENABLE_SCREEN_LVGL_TFT
 #endif // __STANDBY_SCREEN_H
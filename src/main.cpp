@@ -42,6 +42,7 @@
 #include "mqtt.h"
 #include "divert.h"
 #include "ota.h"
+#include "http_update.h"
 #include "lcd.h"
 #include "openevse.h"
 #include "root_ca.h"
@@ -52,6 +53,7 @@
 #include "ocpp.h"
 #include "rfid.h"
 #include "current_shaper.h"
+#include "load_balancer.h"
 #include "temp_throttle.h"
 #include "limit.h"
 
@@ -70,6 +72,10 @@
 #endif
 
 #include "certificates.h"
+#include "dual_core.h"
+#include "heap_monitor.h"
+#include "pooled_json.h"
+#include "publisher.h"
 
 EventLog eventLog;
 CertificateStore certs;
@@ -103,6 +109,9 @@ OcppTask ocpp = OcppTask();
 
 
 static void hardware_setup();
+static void control_loop();
+static void network_loop();
+static void event_publish(JsonDocument &event);
 static void handle_serial();
 
 #if defined(EPOXY_DUINO)
@@ -233,6 +242,7 @@ void setup()
 #endif
 
   input_setup();
+  emoncms_setup();
 
   mqtt.begin();
 
@@ -245,10 +255,24 @@ void setup()
   tempThrottle.begin(evse);
   DBUGF("After tempThrottle.begin: %d", ESPAL.getFreeHeap());
 
+  loadBalancer.setPublisher([](const String &payload) { return mqtt.publishLoadBalancer(payload); });
+  loadBalancer.begin(evse, esp_hostname.c_str());
+  loadBalancer.notifyConfigChanged(config_load_balancing_enabled(), load_balancing_budget,
+                                   load_balancing_priority,
+                                   LoadShareAllocator::policyFromName(load_balancing_policy.c_str()),
+                                   load_balancing_failsafe_current);
+  DBUGF("After loadBalancer.begin: %d", ESPAL.getFreeHeap());
+
+  publisher.begin();
+  heapMonitor.begin();
+
   lcd.display(F("OpenEVSE WiFI"), 0, 0, 0, LCD_CLEAR_LINE);
   lcd.display(currentfirmware, 0, 1, 5 * 1000, LCD_CLEAR_LINE);
 
   start_mem = last_mem = ESPAL.getFreeHeap();
+
+  // With ENABLE_DUAL_CORE networking moves to the other core from here on
+  dual_core_begin(network_loop);
 } // end setup
 
 // -------------------------------------------------------------------
@@ -256,16 +280,25 @@ void setup()
 // -------------------------------------------------------------------
 void loop()
 {
+#if DUAL_CORE
+  control_loop();
+  delay(1);
+#else
   Profile_Start(loop);
+  network_loop();
+  control_loop();
+  Profile_End(loop, 10);
+#endif
+} // end loop
 
-  Profile_Start(Mongoose);
-  Mongoose.poll(0);
-  Profile_End(Mongoose, 10);
+// RAPI and the MicroTasks, the EVSE control side
+static void control_loop()
+{
+  DualCoreLock lock;
 
-  web_server_loop();
-  flash_migrate_loop();
-  ota_loop();
+  Profile_Start(RapiSender);
   rapiSender.loop();
+  Profile_End(RapiSender, 10);
 
   Profile_Start(MicroTask);
   MicroTask.update();
@@ -277,9 +310,41 @@ void loop()
   // import_timers() would auto-import (and clear) the controller's delay timer
   // into Charge Manager rules — a deliberate decision for a separate change,
   // along with routing time_man/ohm/input off the dead global.
+}
+
+// Everything else. With ENABLE_DUAL_CORE the lock is taken a step at a time
+// so the control side is never kept waiting for more than one of them.
+static void network_loop()
+{
+  {
+    DualCoreLock lock;
+    Profile_Start(Mongoose);
+    Mongoose.poll(0);
+    Profile_End(Mongoose, 10);
+  }
+
+  {
+    DualCoreLock lock;
+    dual_core_send_events(event_publish);
+  }
+
+  {
+    DualCoreLock lock;
+    publisher.loop();
+  }
+
+  {
+    DualCoreLock lock;
+    web_server_loop();
+    flash_migrate_loop();
+    ota_loop();
+    http_update_loop();
+  }
 
   if(net.isConnected())
   {
+    DualCoreLock lock;
+
     if (vehicle_data_src == VEHICLE_DATA_SRC_TESLA) {
       teslaClient.loop();
     }
@@ -303,14 +368,16 @@ void loop()
     {
       // Send the current state to check the config
       const size_t capacity = JSON_OBJECT_SIZE(33) + 1024;
-      DynamicJsonDocument data(capacity);
+      PooledJsonDocument data(capacity);
       create_rapi_json(data);
       emoncms_publish(data);
+      emoncms_flush();
       emoncms_updated = false;
     }
   } // end WiFi connected
 
   if(DEBUG_PORT.available()) {
+    DualCoreLock lock;
     handle_serial();
   }
 
@@ -325,9 +392,7 @@ void loop()
     Timer3 = millis();
   }
 #endif
-
-  Profile_End(loop, 10);
-} // end loop
+}
 
 
 void event_send(String &json)
@@ -338,6 +403,15 @@ void event_send(String &json)
 }
 
 void event_send(JsonDocument &event)
+{
+  // Raised on the control core, the network core sends it
+  if(dual_core_queue_event(event)) {
+    return;
+  }
+  event_publish(event);
+}
+
+static void event_publish(JsonDocument &event)
 {
   #ifdef ENABLE_DEBUG
   serializeJson(event, DEBUG_PORT);
@@ -19,6 +19,8 @@
 #include "scheduler.h"
 #include "current_shaper.h"
 #include "home_battery.h"
+#include "load_balancer.h"
+#include "pooled_json.h"
 
 Mqtt mqtt(evse); // global instance
 
@@ -191,7 +193,7 @@ void Mqtt::attemptConnection() {
   String mqtt_host = mqtt_server + ":" + String(mqtt_port);
   DBUGF("MQTT Connecting to... %s://%s", MQTT_MQTT == config_mqtt_protocol() ? "mqtt" : "mqtts", mqtt_host.c_str());
 
-  DynamicJsonDocument willDoc(JSON_OBJECT_SIZE(3) + 60);
+  PooledJsonDocument willDoc(JSON_OBJECT_SIZE(3) + 60);
   willDoc["state"] = "disconnected";
   willDoc["id"] = ESPAL.getLongId();
   willDoc["name"] = esp_hostname;
@@ -244,7 +246,7 @@ void Mqtt::onMqttConnect() {
   _needsDnsLookup = true;
   MicroTask.wakeTask(this);
 
-  DynamicJsonDocument doc(JSON_OBJECT_SIZE(5) + 200);
+  PooledJsonDocument doc(JSON_OBJECT_SIZE(5) + 200);
   doc["state"] = "connected";
   doc["id"] = ESPAL.getLongId();
   doc["name"] = esp_hostname;
@@ -289,7 +291,7 @@ void Mqtt::onMqttDisconnect(int err, const char *reason) {
   }
   setError(category, reason);
 
-  DynamicJsonDocument doc(JSON_OBJECT_SIZE(6) + 160);
+  PooledJsonDocument doc(JSON_OBJECT_SIZE(6) + 160);
   doc["mqtt_connected"]    = 0;
   doc["mqtt_status"]       = "disconnected";
   doc["mqtt_close_code"]   = err;
@@ -322,6 +324,11 @@ void Mqtt::subscribeTopics() {
     _mqttclient.subscribe(mqtt_live_pwr); yield();
   }
 
+  // Per-phase site power, feeds the shaper and grid divert
+  if (mqtt_live_pwr_l1 != "") { _mqttclient.subscribe(mqtt_live_pwr_l1); yield(); }
+  if (mqtt_live_pwr_l2 != "") { _mqttclient.subscribe(mqtt_live_pwr_l2); yield(); }
+  if (mqtt_live_pwr_l3 != "") { _mqttclient.subscribe(mqtt_live_pwr_l3); yield(); }
+
   // Vehicle data
   if (mqtt_vehicle_soc != "") { _mqttclient.subscribe(mqtt_vehicle_soc); yield(); }
   if (mqtt_vehicle_range != "") { _mqttclient.subscribe(mqtt_vehicle_range); yield(); }
@@ -342,6 +349,11 @@ void Mqtt::subscribeTopics() {
   _mqttclient.subscribe(mqtt_topic + "/config/set"); yield();
   _mqttclient.subscribe(mqtt_topic + "/restart"); yield();
 
+  // Site load balancing, one retained announcement per unit
+  if (config_load_balancing_enabled() && load_balancing_topic != "") {
+    _mqttclient.subscribe(load_balancing_topic + "/+"); yield();
+  }
+
   // Broker metadata — most brokers publish this as a retained message
   _mqttclient.subscribe("$SYS/broker/version"); yield();
 
@@ -419,6 +431,15 @@ void Mqtt::handleMqttMessage(MongooseString topic, MongooseString payload) {
     return;
   }
 
+  // Announcements from the other units on the site
+  if (config_load_balancing_enabled() && load_balancing_topic != "" &&
+      topic_string.startsWith(load_balancing_topic + "/"))
+  {
+    String id = topic_string.substring(load_balancing_topic.length() + 1);
+    loadBalancer.receive(id.c_str(), payload_str.c_str(), payload_str.length());
+    return;
+  }
+
   // Logic from old mqttmsg_callback
   if (topic_string == mqtt_solar){
     divert.setSolar(payload_str.toInt());
@@ -440,6 +461,19 @@ void Mqtt::handleMqttMessage(MongooseString topic, MongooseString payload) {
       shaper.setLivePwr(payload_str.toInt());
       DBUGF("shaper: Live Pwr:%dW", shaper.getLivePwr());
   }
+  else if (topic_string == mqtt_live_pwr_l1 ||
+           topic_string == mqtt_live_pwr_l2 ||
+           topic_string == mqtt_live_pwr_l3)
+  {
+    uint8_t phase = topic_string == mqtt_live_pwr_l1 ? 1 :
+                    topic_string == mqtt_live_pwr_l2 ? 2 : 3;
+    int live_pwr = payload_str.toInt();
+    DBUGF("L%d: Live Pwr:%dW", phase, live_pwr);
+    if (divert_type == DIVERT_TYPE_GRID) {
+      divert.setGridIePhase(phase, live_pwr);
+    }
+    shaper.setLivePhasePwr(phase, live_pwr);
+  }
   else if (topic_string == mqtt_vrms) {
     double volts = payload_str.toFloat();
     DBUGF("voltage:%.1f", volts);
@@ -537,7 +571,7 @@ void Mqtt::handleMqttMessage(MongooseString topic, MongooseString payload) {
   else if (topic_string == mqtt_topic + "/restart") {
     // This logic can reuse the existing mqtt_restart_device logic by making it a static helper or part of this class
     const size_t capacity = JSON_OBJECT_SIZE(1) + 16;
-    DynamicJsonDocument doc(capacity);
+    PooledJsonDocument doc(capacity);
     DeserializationError error = deserializeJson(doc, payload_str);
     if(!error && doc.containsKey("device")){
         if (strcmp(doc["device"], "gateway") == 0 ) restart_system();
@@ -568,6 +602,26 @@ bool Mqtt::isConnected() {
   return _mqttclient.connected();
 }
 
+bool Mqtt::publishLoadBalancer(const String &payload) {
+  if (payload.length() == 0) {
+    return withdrawLoadBalancer();
+  }
+  if (!config_load_balancing_enabled() || load_balancing_topic == "" || !_mqttclient.connected()) {
+    return false;
+  }
+
+  return _mqttclient.publish(load_balancing_topic + "/" + esp_hostname, payload, true);
+}
+
+bool Mqtt::withdrawLoadBalancer() {
+  // Sent as load balancing is turned off, so not held back by the flag
+  if (load_balancing_topic == "" || !_mqttclient.connected()) {
+    return false;
+  }
+
+  return _mqttclient.publish(load_balancing_topic + "/" + esp_hostname, "", true);
+}
+
 const char *Mqtt::getMqttStatus() {
   if (!config_mqtt_enabled()) return "disabled";
   if (_mqttclient.connected())  return "connected";
@@ -656,7 +710,7 @@ void Mqtt::setClaim(bool override, EvseProperties &props) {
 void Mqtt::publishClaim() {
   if (!isConnected()) return;
   const size_t capacity = JSON_OBJECT_SIZE(7) + 1024;
-  DynamicJsonDocument claimdata(capacity);
+  PooledJsonDocument claimdata(capacity);
   if (_evse->clientHasClaim(EvseClient_OpenEVSE_MQTT)) {
     _evse->serializeClaim(claimdata, EvseClient_OpenEVSE_MQTT);
   } else {
@@ -671,7 +725,7 @@ void Mqtt::publishClaim() {
 void Mqtt::publishOverride() {
   if (!isConnected()) return;
   const size_t capacity = JSON_OBJECT_SIZE(7) + 1024;
-  DynamicJsonDocument override_data(capacity);
+  PooledJsonDocument override_data(capacity);
   if (_evse->clientHasClaim(EvseClient_OpenEVSE_Manual) || manual.isActive()) {
     EvseProperties props = _evse->getClaimProperties(EvseClient_OpenEVSE_Manual);
     props.serialize(override_data);
@@ -697,7 +751,7 @@ void Mqtt::clearSchedule(uint32_t eventId) {
 void Mqtt::publishSchedule() {
   if (!isConnected()) return;
   const size_t capacity = JSON_OBJECT_SIZE(40) + 2048;
-  DynamicJsonDocument schedule_data(capacity);
+  PooledJsonDocument schedule_data(capacity);
   if (scheduler.serialize(schedule_data)) {
     String fulltopic = mqtt_topic + "/schedule";
     String payload;
@@ -715,7 +769,7 @@ void Mqtt::publishLimit() {
   if (!isConnected()) return;
   LimitProperties currentLimitProps = limit.get();
   const size_t capacity = JSON_OBJECT_SIZE(3) + 512;
-  DynamicJsonDocument limit_data(capacity);
+  PooledJsonDocument limit_data(capacity);
   if (currentLimitProps.serialize(limit_data)) {
     String fulltopic = mqtt_topic + "/limit";
     String payload;
@@ -115,6 +115,8 @@ class Mqtt : public MicroTasks::Task {
     void clearSchedule(uint32_t event);
     void publishLimit();
     void setLimit(LimitProperties &limitProps);
+    bool publishLoadBalancer(const String &payload); // Retained, to <load_balancing_topic>/<hostname>
+    bool withdrawLoadBalancer();                     // Empty retained message, even with load balancing off
 
     // Method to be called by other services when their state changes
     void notifyEvseClaimChanged();
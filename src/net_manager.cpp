@@ -700,8 +700,8 @@ unsigned long NetManagerTask::serviceButton()
   {
     DBUGLN("*** Factory Reset ***");
 
-    _lcd.display(F("Factory Reset"), 0, 0, 0, LCD_CLEAR_LINE | LCD_DISPLAY_NOW);
-    _lcd.display(F(""), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW);
+    _lcd.display(F("Factory Reset"), 0, 0, 0, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
+    _lcd.display(F(""), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
 
     delay(1000);
 
@@ -788,7 +788,7 @@ unsigned long NetManagerTask::loop(MicroTasks::WakeReason reason)
 {
   unsigned long nextLoopDelay = MicroTask.Infinate;
 
-  Profile_Start(NetManagerTask::loop);
+  Profile_Start(NetManagerTask_loop);
 
 //  DBUG("NetManagerTask woke: ");
 //  DBUG(NetState::Starting == _state ? "Starting" :
@@ -817,7 +817,7 @@ unsigned long NetManagerTask::loop(MicroTasks::WakeReason reason)
     _dnsServer.processNextRequest(); // Captive portal DNS re-dierct
   }
 
-  Profile_End(NetManagerTask::loop, 5);
+  Profile_End(NetManagerTask_loop, 5);
 
   return nextLoopDelay;
 }
@@ -8,6 +8,7 @@
 #include <MicroOcpp.h>
 #include <MicroOcpp/Model/Diagnostics/DiagnosticsService.h>
 #include <MicroOcpp/Model/FirmwareManagement/FirmwareService.h>
+#include <MicroOcpp/Model/Transactions/Transaction.h>
 #include <MongooseCore.h>
 
 #include "app_config.h"
@@ -20,6 +21,30 @@
 #define OCPP_LOOP_TIME 200
 #endif
 
+// Time between loop polls while there is no vehicle and no transaction. EVSE
+// events and config changes still wake the task straight away
+#ifndef OCPP_IDLE_LOOP_TIME
+#define OCPP_IDLE_LOOP_TIME 1000
+#endif
+
+// Meter samples taken while offline
+#ifndef OCPP_METER_BUFFER_FILE
+#define OCPP_METER_BUFFER_FILE "/ocpp_meter.bin"
+#endif
+
+// Most buffered samples sent in one MeterValues request
+#ifndef OCPP_METER_BATCH_SIZE
+#define OCPP_METER_BATCH_SIZE 10
+#endif
+
+// Resend a buffered batch if it has not been confirmed by then
+#ifndef OCPP_METER_FLUSH_TIMEOUT
+#define OCPP_METER_FLUSH_TIMEOUT (60 * 1000)
+#endif
+
+// Samples are only taken once the clock has been set (2020-01-01)
+#define OCPP_METER_MIN_TIME 1577836800
+
 #define LCD_DISPLAY(X) if (lcd) lcd->display((X), 0, 1, 5 * 1000, LCD_CLEAR_LINE);
 
 /*
@@ -100,7 +125,10 @@ void dbug_wrapper(const char *msg) {
     DBUG(msg);
 }
 
-OcppTask::OcppTask() : MicroTasks::Task() {
+OcppTask::OcppTask() :
+    MicroTasks::Task(),
+    evseStateEvent(this),
+    evseSettingsEvent(this) {
 
 }
 
@@ -120,6 +148,9 @@ void OcppTask::begin(EvseManager &evse, LcdTask &lcd, EventLog &eventLog, RfidTa
 
     instance = this; //cannot be in constructer because object is invalid before .begin()
 
+    evse.onStateChange(&evseStateEvent);
+    evse.onSettingsChanged(&evseSettingsEvent);
+
     MicroTask.startTask(this);
 
     reconfigure();
@@ -156,6 +187,7 @@ void OcppTask::reconfigure() {
         }
     }
 
+    invalidateEvseClaim();
     MicroTask.wakeTask(this);
 }
 
@@ -233,7 +265,7 @@ void OcppTask::initializeMicroOcpp() {
     /*
      * Set OCPP-only factory defaults
      */
-    MicroOcpp::declareConfiguration<const char*>(
+    meterSampledData = MicroOcpp::declareConfiguration<const char*>(
         "MeterValuesSampledData", "Power.Active.Import,Energy.Active.Import.Register,Current.Import,Current.Offered,Voltage,Temperature"); //read all sensors by default
     MicroOcpp::declareConfiguration<bool>(
         MO_CONFIG_EXT_PREFIX "PreBootTransactions", true); //allow transactions before the OCPP connection has been established (can lead to data loss)
@@ -255,12 +287,16 @@ void OcppTask::initializeMicroOcpp() {
         true); //enable auto recovery
 
     loadEvseBehavior();
+    initializeMeterBuffer();
     initializeDiagnosticsService();
     initializeFwService();
 }
 
 void OcppTask::deinitializeMicroOcpp() {
     rfid->setOnCardScanned(nullptr);
+    meterSampleInterval.reset();
+    meterSampledData.reset();
+    meterFlushPending = false;
     mocpp_deinitialize();
     delete connection;
     connection = nullptr;
@@ -313,18 +349,23 @@ void OcppTask::loadEvseBehavior() {
         "Celsius");
 
     setSmartChargingOutput([this] (float power, float current, int nphases) {
+        float limit;
         if (power >= 0.f && current >= 0.f) {
             //both defined, take smaller value
-            charging_limit = std::min(power / VOLTAGE_DEFAULT, current);
+            limit = std::min(power / VOLTAGE_DEFAULT, current);
         } else if (current >= 0.f) {
             //current defined
-            charging_limit = current;
+            limit = current;
         } else if (power >= 0.f) {
             //power defined
-            charging_limit = power / (float) VOLTAGE_DEFAULT;
+            limit = power / (float) VOLTAGE_DEFAULT;
         } else {
             //Smart charging disabled / limit undefined
-            charging_limit = -1.f;
+            limit = -1.f;
+        }
+        if (limit != charging_limit) {
+            charging_limit = limit;
+            invalidateEvseClaim();
         }
     });
 
@@ -433,6 +474,8 @@ void OcppTask::loadEvseBehavior() {
      * Give the user feedback about the status of the OCPP transaction
      */
     setTxNotificationOutput([this] (MicroOcpp::Transaction*, MicroOcpp::TxNotification notification) {
+        invalidateEvseClaim(); //authorization or transaction state may have changed
+
         switch (notification) {
             case MicroOcpp::TxNotification::AuthorizationRejected:
                 LCD_DISPLAY("Card unknown");
@@ -470,12 +513,40 @@ void OcppTask::loadEvseBehavior() {
 }
 
 unsigned long OcppTask::loop(MicroTasks::WakeReason reason) {
+    Profile_Scope("OcppTask");
+
+    if (evseStateEvent.IsTriggered() || evseSettingsEvent.IsTriggered()) {
+        //vehicle, EVSE state or min current may have changed
+        invalidateEvseClaim();
+    }
 
     if (getOcppContext()) {
         //MicroOcpp is initialized
 
         mocpp_loop();
 
+        sampleMeterValues();
+        flushMeterValues();
+
+        /*
+         * Catch changes of the charge permission which are not reported through a callback,
+         * e.g. ChangeAvailability or a transaction timing out
+         */
+        bool permitsCharge = ocppPermitsCharge();
+        bool readerFailure = rfid->communicationFails();
+        if (permitsCharge != trackPermitsCharge || readerFailure != trackReaderFailure) {
+            invalidateEvseClaim();
+        }
+        trackPermitsCharge = permitsCharge;
+        trackReaderFailure = readerFailure;
+
+        /*
+         * Put the claim back if it has been released from outside, e.g. over HTTP or MQTT
+         */
+        if (claimHeld && !evse->clientHasClaim(EvseClient_OpenEVSE_OCPP)) {
+            invalidateEvseClaim();
+        }
+
         /*
          * Generate messages for LCD
          */
@@ -498,15 +569,34 @@ unsigned long OcppTask::loop(MicroTasks::WakeReason reason) {
         }
         trackVehicleConnected = evse->isVehicleConnected();
 
-        if (isConnected() && !trackOcppConnected) {
-            LCD_DISPLAY("OCPP connected");
+        if (isConnected() != trackOcppConnected) {
+            if (!trackOcppConnected) {
+                LCD_DISPLAY("OCPP connected");
+            }
+            invalidateEvseClaim();
         }
         trackOcppConnected = isConnected();
     }
 
-    updateEvseClaim();
+    if (claimDirty) {
+        claimDirty = false;
+        updateEvseClaim();
+    }
+
+    if (!config_ocpp_enabled()) {
+        return MicroTask.Infinate;
+    }
+
+    /*
+     * MicroOcpp has no API for its next deadline. Keep the fast poll while a vehicle or transaction
+     * may need it and back off otherwise
+     */
+    bool active = getOcppContext() && (trackVehicleConnected || isTransactionActive());
+    return active ? OCPP_LOOP_TIME : OCPP_IDLE_LOOP_TIME;
+}
 
-    return config_ocpp_enabled() ? OCPP_LOOP_TIME : MicroTask.Infinate;
+void OcppTask::invalidateEvseClaim() {
+    claimDirty = true;
 }
 
 void OcppTask::updateEvseClaim() {
@@ -518,6 +608,7 @@ void OcppTask::updateEvseClaim() {
         if (evse->clientHasClaim(EvseClient_OpenEVSE_OCPP)) {
             evse->release(EvseClient_OpenEVSE_OCPP);
         }
+        claimHeld = false;
         return;
     }
 
@@ -566,6 +657,7 @@ void OcppTask::updateEvseClaim() {
         if (evse->clientHasClaim(EvseClient_OpenEVSE_OCPP)) {
             evse->release(EvseClient_OpenEVSE_OCPP);
         }
+        claimHeld = false;
     } else {
         //the claiming rules specify that the EVSE is either active or inactive
 
@@ -576,10 +668,185 @@ void OcppTask::updateEvseClaim() {
 
             evse->claim(EvseClient_OpenEVSE_OCPP, EvseManager_Priority_OCPP, evseProperties);
         }
+        claimHeld = true;
     }
 
 }
 
+static bool meter_file_read(uint32_t offset, uint8_t *data, size_t len) {
+    File file = LittleFS.open(OCPP_METER_BUFFER_FILE, "r");
+    if (!file || !file.seek(offset)) {
+        return false;
+    }
+    return file.read(data, len) == len;
+}
+
+static bool meter_file_write(uint32_t offset, const uint8_t *data, size_t len) {
+    File file = LittleFS.open(OCPP_METER_BUFFER_FILE, LittleFS.exists(OCPP_METER_BUFFER_FILE) ? "r+" : "w");
+    if (!file || !file.seek(offset)) {
+        return false;
+    }
+    return file.write(data, len) == len;
+}
+
+static void add_sampled_value(JsonArray sampledValue, const char *measurand, const char *unit, double value) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%.1f", value);
+
+    JsonObject sv = sampledValue.createNestedObject();
+    sv["value"] = buf;
+    sv["context"] = "Sample.Periodic";
+    sv["measurand"] = measurand;
+    sv["unit"] = unit;
+}
+
+static std::unique_ptr<DynamicJsonDocument> build_meter_values(const std::vector<OcppMeterSample> &batch,
+        const std::string &measurands) {
+    auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(
+        JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(batch.size()) +
+        batch.size() * (JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(6) + 6 * JSON_OBJECT_SIZE(4) + 6 * 16 + 32)));
+
+    JsonObject payload = doc->to<JsonObject>();
+    payload["connectorId"] = 1;
+    if (batch.front().transaction_id >= 0) {
+        payload["transactionId"] = batch.front().transaction_id;
+    }
+
+    auto sampled = [&measurands] (const char *measurand) {
+        return measurands.find(measurand) != std::string::npos;
+    };
+
+    JsonArray meterValue = payload.createNestedArray("meterValue");
+    for (const OcppMeterSample &sample : batch) {
+        char timestamp[24];
+        OcppMeterBuffer::formatTimestamp(sample.timestamp, timestamp, sizeof(timestamp));
+
+        JsonObject entry = meterValue.createNestedObject();
+        entry["timestamp"] = timestamp;
+        JsonArray sampledValue = entry.createNestedArray("sampledValue");
+
+        //energy is the OCPP default measurand, always send it so no entry is empty
+        add_sampled_value(sampledValue, "Energy.Active.Import.Register", "Wh", sample.energy);
+        if (sampled("Power.Active.Import")) {
+            add_sampled_value(sampledValue, "Power.Active.Import", "W", sample.power);
+        }
+        if (sampled("Current.Import")) {
+            add_sampled_value(sampledValue, "Current.Import", "A", sample.current);
+        }
+        if (sampled("Current.Offered")) {
+            add_sampled_value(sampledValue, "Current.Offered", "A", sample.offered);
+        }
+        if (sampled("Voltage")) {
+            add_sampled_value(sampledValue, "Voltage", "V", sample.voltage);
+        }
+        if (sampled("Temperature")) {
+            add_sampled_value(sampledValue, "Temperature", "Celsius", sample.temperature);
+        }
+    }
+
+    return doc;
+}
+
+void OcppTask::initializeMeterBuffer() {
+    meterSampleInterval = MicroOcpp::declareConfiguration<int>("MeterValueSampleInterval", 60);
+    meterBuffer.begin(meter_file_read, meter_file_write);
+    meterSampleLast = millis();
+    meterFlushPending = false;
+    DBUGF("[ocpp] %u buffered meter samples", (unsigned int) meterBuffer.size());
+}
+
+void OcppTask::sampleMeterValues() {
+
+    if (isConnected() || !isTransactionActive()) {
+        //MicroOcpp sends the transaction samples itself while connected
+        meterSampleLast = millis();
+        return;
+    }
+
+    int interval = meterSampleInterval ? meterSampleInterval->getInt() : 0;
+    if (interval <= 0 || millis() - meterSampleLast < (unsigned long) interval * 1000UL) {
+        return;
+    }
+    meterSampleLast = millis();
+
+    time_t now = time(NULL);
+    if (now < OCPP_METER_MIN_TIME) {
+        //without a valid clock the sample cannot be placed
+        return;
+    }
+
+    OcppMeterSample sample;
+    sample.timestamp = (uint32_t) now;
+    auto& transaction = getTransaction();
+    sample.transaction_id = transaction ? transaction->getTransactionId() : -1;
+    sample.energy = evse->getTotalEnergy() * 1000.; //convert kWh into Wh
+    sample.power = evse->getAmps() * evse->getVoltage();
+    sample.current = evse->getAmps();
+    sample.offered = (float) evse->getChargeCurrent();
+    sample.voltage = evse->getVoltage();
+    sample.temperature = evse->getTemperature(EVSE_MONITOR_TEMP_MONITOR);
+
+    if (!meterBuffer.push(sample)) {
+        DBUGLN(F("[ocpp] failed to store meter sample"));
+    }
+}
+
+void OcppTask::flushMeterValues() {
+
+    if (meterFlushPending) {
+        if (millis() - meterFlushStart < OCPP_METER_FLUSH_TIMEOUT) {
+            return;
+        }
+        //not confirmed, send the batch again
+        meterFlushPending = false;
+    }
+
+    if (!isConnected() || meterBuffer.empty()) {
+        return;
+    }
+
+    //one request per transaction, transactionId is per request
+    std::vector<OcppMeterSample> batch;
+    OcppMeterSample sample;
+    while (batch.size() < OCPP_METER_BATCH_SIZE && meterBuffer.peek(batch.size(), sample)) {
+        if (!batch.empty() && sample.transaction_id != batch.front().transaction_id) {
+            break;
+        }
+        batch.push_back(sample);
+    }
+
+    if (batch.empty()) {
+        //storage unreadable, nothing can be recovered
+        DBUGLN(F("[ocpp] meter buffer unreadable, discarding"));
+        meterBuffer.clear();
+        return;
+    }
+
+    size_t count = batch.size();
+    //confirmed by sequence, older samples may be overwritten while it is in flight
+    uint32_t lastSequence = meterBuffer.firstSequence() + count - 1;
+    uint32_t flushId = ++meterFlushId;
+    std::string measurands = meterSampledData ? meterSampledData->getString() : "";
+
+    meterFlushPending = true;
+    meterFlushStart = millis();
+    DBUGF("[ocpp] sending %u of %u buffered meter samples", (unsigned int) count, (unsigned int) meterBuffer.size());
+
+    sendRequest("MeterValues",
+        [batch, measurands] () {
+            return build_meter_values(batch, measurands);
+        },
+        [this, lastSequence, flushId] (JsonObject) {
+            if (flushId != meterFlushId) {
+                //timed out and already resent
+                return;
+            }
+            meterBuffer.popThrough(lastSequence);
+            meterFlushPending = false;
+            MicroTask.wakeTask(this);
+        });
+}
+
 void OcppTask::initializeDiagnosticsService() {
     MicroOcpp::DiagnosticsService *diagService = getDiagnosticsService();
     if (diagService) {
@@ -11,6 +11,7 @@
 #include "evse_man.h"
 #include "lcd.h"
 #include "rfid.h"
+#include "ocpp_meter_buffer.h"
 
 #include <MicroOcppMongooseClient.h>
 #include <MongooseHttpClient.h>
@@ -29,6 +30,14 @@ private:
     bool trackOcppConnected = false;
     bool trackVehicleConnected = false;
 
+    // The claim is only re-evaluated when one of its inputs may have changed
+    bool claimDirty = true;
+    bool claimHeld = false; //set by updateEvseClaim(), to notice it being released elsewhere
+    bool trackPermitsCharge = false;
+    bool trackReaderFailure = false;
+    MicroTasks::EventListener evseStateEvent;
+    MicroTasks::EventListener evseSettingsEvent;
+
     std::function<bool(const String& idTag)> onIdTagInput;
 
     MongooseHttpClient diagClient = MongooseHttpClient();
@@ -38,6 +47,21 @@ private:
     bool updateSuccess = false, updateFailure = false;
     void initializeFwService();
 
+    /*
+     * Meter samples taken while the central system is unreachable, sent several per
+     * MeterValues request once it is back
+     */
+    OcppMeterBuffer meterBuffer;
+    std::shared_ptr<MicroOcpp::Configuration> meterSampleInterval;
+    std::shared_ptr<MicroOcpp::Configuration> meterSampledData;
+    unsigned long meterSampleLast = 0;
+    bool meterFlushPending = false;
+    unsigned long meterFlushStart = 0;
+    uint32_t meterFlushId = 0;
+    void initializeMeterBuffer();
+    void sampleMeterValues();
+    void flushMeterValues();
+
     void initializeMicroOcpp();
     void deinitializeMicroOcpp();
     void loadEvseBehavior();
@@ -60,6 +84,7 @@ public:
     void begin(EvseManager &evse, LcdTask &lcd, EventLog &eventLog, RfidTask &rfid);
     
     void updateEvseClaim();
+    void invalidateEvseClaim();
 
     static void notifyConfigChanged();
     void reconfigure();
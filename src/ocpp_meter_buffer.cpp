@@ -0,0 +1,217 @@
+#include "ocpp_meter_buffer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static void put_le(uint8_t *p, uint64_t value, size_t bytes)
+{
+  for(size_t i = 0; i < bytes; i++) {
+    p[i] = (uint8_t)((value >> (8 * i)) & 0xff);
+  }
+}
+
+static uint64_t get_le(const uint8_t *p, size_t bytes)
+{
+  uint64_t value = 0;
+  for(size_t i = 0; i < bytes; i++) {
+    value |= (uint64_t)p[i] << (8 * i);
+  }
+  return value;
+}
+
+static void put_float(uint8_t *p, float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  put_le(p, bits, 4);
+}
+
+static float get_float(const uint8_t *p)
+{
+  uint32_t bits = (uint32_t)get_le(p, 4);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static void encode_sample(const OcppMeterSample &sample, uint8_t *p)
+{
+  uint64_t energy;
+  memcpy(&energy, &sample.energy, sizeof(energy));
+
+  put_le(p, sample.timestamp, 4);
+  put_le(p + 4, (uint32_t)sample.transaction_id, 4);
+  put_le(p + 8, energy, 8);
+  put_float(p + 16, sample.power);
+  put_float(p + 20, sample.current);
+  put_float(p + 24, sample.offered);
+  put_float(p + 28, sample.voltage);
+  put_float(p + 32, sample.temperature);
+}
+
+static void decode_sample(const uint8_t *p, OcppMeterSample &sample)
+{
+  uint64_t energy = get_le(p + 8, 8);
+
+  sample.timestamp = (uint32_t)get_le(p, 4);
+  sample.transaction_id = (int32_t)(uint32_t)get_le(p + 4, 4);
+  memcpy(&sample.energy, &energy, sizeof(sample.energy));
+  sample.power = get_float(p + 16);
+  sample.current = get_float(p + 20);
+  sample.offered = get_float(p + 24);
+  sample.voltage = get_float(p + 28);
+  sample.temperature = get_float(p + 32);
+}
+
+OcppMeterBuffer::OcppMeterBuffer(uint16_t capacity) :
+  _reader(nullptr),
+  _writer(nullptr),
+  _capacity(capacity > 0 ? capacity : 1),
+  _head(0),
+  _count(0),
+  _first_seq(0),
+  _dropped(0)
+{
+}
+
+void OcppMeterBuffer::begin(Reader reader, Writer writer)
+{
+  _reader = reader;
+  _writer = writer;
+  _head = 0;
+  _count = 0;
+  _first_seq = 0;
+  _dropped = 0;
+
+  uint8_t header[OCPP_METER_BUFFER_HEADER_SIZE];
+  if(_reader && _reader(0, header, sizeof(header)) &&
+     0 == memcmp(header, OCPP_METER_BUFFER_MAGIC, 4) &&
+     OCPP_METER_BUFFER_VERSION == header[4] &&
+     _capacity == get_le(header + 6, 2))
+  {
+    uint32_t head = (uint32_t)get_le(header + 8, 4);
+    uint32_t count = (uint32_t)get_le(header + 12, 4);
+    if(head < _capacity && count <= _capacity) {
+      _head = head;
+      _count = count;
+      _first_seq = (uint32_t)get_le(header + 16, 4);
+      return;
+    }
+  }
+
+  // Missing, from a build with a different capacity or corrupt
+  writeHeader();
+}
+
+bool OcppMeterBuffer::writeHeader()
+{
+  if(!_writer) {
+    return false;
+  }
+
+  uint8_t header[OCPP_METER_BUFFER_HEADER_SIZE];
+  memcpy(header, OCPP_METER_BUFFER_MAGIC, 4);
+  header[4] = OCPP_METER_BUFFER_VERSION;
+  header[5] = 0;
+  put_le(header + 6, _capacity, 2);
+  put_le(header + 8, _head, 4);
+  put_le(header + 12, _count, 4);
+  put_le(header + 16, _first_seq, 4);
+  return _writer(0, header, sizeof(header));
+}
+
+bool OcppMeterBuffer::push(const OcppMeterSample &sample)
+{
+  if(!_writer) {
+    return false;
+  }
+
+  uint8_t slot[OCPP_METER_SAMPLE_SIZE];
+  encode_sample(sample, slot);
+  if(!_writer(slotOffset((_head + _count) % _capacity), slot, sizeof(slot))) {
+    return false;
+  }
+
+  if(_count < _capacity) {
+    _count++;
+  } else {
+    _head = (_head + 1) % _capacity;
+    _first_seq++;
+    _dropped++;
+  }
+
+  return writeHeader();
+}
+
+bool OcppMeterBuffer::peek(size_t index, OcppMeterSample &sample)
+{
+  if(index >= _count || !_reader) {
+    return false;
+  }
+
+  uint8_t slot[OCPP_METER_SAMPLE_SIZE];
+  if(!_reader(slotOffset((_head + index) % _capacity), slot, sizeof(slot))) {
+    return false;
+  }
+
+  decode_sample(slot, sample);
+  return true;
+}
+
+bool OcppMeterBuffer::pop(size_t count)
+{
+  if(count > _count) {
+    count = _count;
+  }
+  if(0 == count) {
+    return true;
+  }
+
+  _head = (_head + count) % _capacity;
+  _count -= count;
+  _first_seq += count;
+  if(0 == _count) {
+    _head = 0;
+  }
+  return writeHeader();
+}
+
+bool OcppMeterBuffer::popThrough(uint32_t sequence)
+{
+  // Wraps with the sequence numbers
+  int32_t count = (int32_t)(sequence + 1 - _first_seq);
+  if(count <= 0) {
+    return true;
+  }
+  return pop((size_t)count);
+}
+
+bool OcppMeterBuffer::clear()
+{
+  _first_seq += _count;
+  _head = 0;
+  _count = 0;
+  return writeHeader();
+}
+
+size_t OcppMeterBuffer::formatTimestamp(uint32_t time, char *buf, size_t size)
+{
+  // Civil date from days since the epoch, avoids depending on gmtime_r
+  uint32_t days = time / 86400;
+  uint32_t secs = time % 86400;
+
+  uint32_t z = days + 719468;
+  uint32_t era = z / 146097;
+  uint32_t doe = z - era * 146097;
+  uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  uint32_t mp = (5 * doy + 2) / 153;
+  uint32_t day = doy - (153 * mp + 2) / 5 + 1;
+  uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+  uint32_t year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+  int len = snprintf(buf, size, "%04u-%02u-%02uT%02u:%02u:%02uZ",
+                     (unsigned)year, (unsigned)month, (unsigned)day,
+                     (unsigned)(secs / 3600), (unsigned)(secs / 60 % 60), (unsigned)(secs % 60));
+  return (len > 0 && (size_t)len < size) ? (size_t)len : 0;
+}
@@ -0,0 +1,103 @@
+#ifndef OCPP_METER_BUFFER_H
+#define OCPP_METER_BUFFER_H
+
+// Persistent ring of OCPP meter samples.
+//
+// Holds the periodic samples taken while the central system is unreachable so
+// they can be sent, several per MeterValues request, once it is back. The ring
+// lives in storage rather than RAM, accessed through a reader/writer pair, so
+// it survives a reboot and costs no heap while idle:
+//
+//   header  "OEMV" | uint8 version | uint8 reserved | uint16 capacity |
+//           uint32 head | uint32 count | uint32 sequence of the oldest
+//   slot    uint32 timestamp | int32 transaction_id | float64 energy |
+//           float32 power | float32 current | float32 offered |
+//           float32 voltage | float32 temperature
+//
+// All values little endian. When full the oldest sample is overwritten. Each
+// sample has a sequence number, one more than the sample before, so a batch
+// in flight can be confirmed by its last sample even if older ones have been
+// overwritten meanwhile. No Arduino dependency so it can be unit-tested on
+// the build host.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+#define OCPP_METER_BUFFER_MAGIC         "OEMV"
+#define OCPP_METER_BUFFER_VERSION       2
+#define OCPP_METER_BUFFER_HEADER_SIZE   20
+#define OCPP_METER_SAMPLE_SIZE          36
+
+// Number of samples kept, 4 hours at the default 60s sample interval
+#ifndef OCPP_METER_BUFFER_SAMPLES
+#define OCPP_METER_BUFFER_SAMPLES       240
+#endif
+
+struct OcppMeterSample
+{
+  uint32_t timestamp = 0;         // Unix time, UTC
+  int32_t transaction_id = -1;    // -1 if not known when sampled
+  double energy = 0;              // Wh
+  float power = 0;                // W
+  float current = 0;              // A
+  float offered = 0;              // A
+  float voltage = 0;              // V
+  float temperature = 0;          // Celsius
+};
+
+class OcppMeterBuffer
+{
+  public:
+    typedef std::function<bool(uint32_t offset, uint8_t *data, size_t len)> Reader;
+    typedef std::function<bool(uint32_t offset, const uint8_t *data, size_t len)> Writer;
+
+    OcppMeterBuffer(uint16_t capacity = OCPP_METER_BUFFER_SAMPLES);
+
+    // Load the ring from storage, starts empty if there is none or it does not
+    // match this buffer's layout
+    void begin(Reader reader, Writer writer);
+
+    // Append a sample, overwriting the oldest if full
+    bool push(const OcppMeterSample &sample);
+    // Read a sample, 0 is the oldest
+    bool peek(size_t index, OcppMeterSample &sample);
+    // Remove the oldest count samples
+    bool pop(size_t count);
+    // Remove the samples up to and including the one numbered `sequence`,
+    // those already overwritten are not counted
+    bool popThrough(uint32_t sequence);
+    bool clear();
+
+    // Sequence number of the oldest sample, index i is firstSequence() + i
+    uint32_t firstSequence() const { return _first_seq; }
+
+    size_t size() const { return _count; }
+    size_t capacity() const { return _capacity; }
+    bool empty() const { return 0 == _count; }
+    // Samples overwritten since begin()
+    uint32_t dropped() const { return _dropped; }
+
+    static size_t storageSize(uint16_t capacity) {
+      return OCPP_METER_BUFFER_HEADER_SIZE + (size_t)capacity * OCPP_METER_SAMPLE_SIZE;
+    }
+
+    // ISO 8601, "2024-01-31T12:00:00Z". Returns the length, 0 if size is too small
+    static size_t formatTimestamp(uint32_t time, char *buf, size_t size);
+
+  private:
+    bool writeHeader();
+    uint32_t slotOffset(uint32_t slot) const {
+      return OCPP_METER_BUFFER_HEADER_SIZE + slot * OCPP_METER_SAMPLE_SIZE;
+    }
+
+    Reader _reader;
+    Writer _writer;
+    uint16_t _capacity;
+    uint32_t _head;
+    uint32_t _count;
+    uint32_t _first_seq;
+    uint32_t _dropped;
+};
+
+#endif // OCPP_METER_BUFFER_H
@@ -20,8 +20,8 @@ void ota_setup()
     // Clean SPIFFS
     //SPIFFS.end();
     DBUGF("Starting ArduinoOTA update");
-    lcd.display(F("Updating WiFi"), 0, 0, 10, LCD_CLEAR_LINE | LCD_DISPLAY_NOW);
-    lcd.display(F(""), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW);
+    lcd.display(F("Updating WiFi"), 0, 0, 10, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
+    lcd.display(F(""), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
   });
 
   ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
@@ -30,7 +30,7 @@ void ota_setup()
     {
       DBUGF("ArduinoOTA progress %d%%", percent);
       String text = String(percent) + F("%");
-      lcd.display(text, 0, 1, 10 * 1000, LCD_DISPLAY_NOW);
+      lcd.display(text, 0, 1, 10 * 1000, LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
       last_percent = percent;
       feedLoopWDT();
     }
@@ -38,7 +38,7 @@ void ota_setup()
 
   ArduinoOTA.onEnd([]() {
     DBUGF("ArduinoOTA finished");
-    lcd.display(F("Complete"), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW);
+    lcd.display(F("Complete"), 0, 1, 10 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
   });
 
   ArduinoOTA.onError([](ota_error_t error) {
@@ -46,7 +46,7 @@ void ota_setup()
     String text = F("Error[");
     text += error;
     text += F("]");
-    lcd.display(text, 0, 1, 5 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW);
+    lcd.display(text, 0, 1, 5 * 1000, LCD_CLEAR_LINE | LCD_DISPLAY_NOW | LCD_PRIORITY_HIGH);
   });
 }
 
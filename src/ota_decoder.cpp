@@ -0,0 +1,536 @@
+#include "ota_decoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t read_le32(const uint8_t *p)
+{
+  return (uint32_t)p[0] |
+         ((uint32_t)p[1] << 8) |
+         ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+OtaImageDecoder::OtaImageDecoder() :
+  _state(STATE_IDLE),
+  _error(OTA_DECODER_ERROR_NONE),
+  _headerLen(0),
+  _baseSize(0),
+  _baseHashed(0),
+  _produced(0),
+  _windowSz2(0),
+  _lookaheadSz2(0),
+  _window(NULL),
+  _head(0),
+  _inflateState(INFLATE_TAG),
+  _backrefOffset(0),
+  _bitBuffer(0),
+  _bitCount(0),
+  _in(NULL),
+  _inLen(0),
+  _outLen(0),
+  _deltaState(DELTA_OP),
+  _op(0),
+  _varint(0),
+  _varintShift(0),
+  _opLen(0)
+{
+}
+
+OtaImageDecoder::~OtaImageDecoder()
+{
+  reset();
+}
+
+void OtaImageDecoder::reset()
+{
+  if(_window) {
+    free(_window);
+    _window = NULL;
+  }
+
+  _state = STATE_IDLE;
+  _error = OTA_DECODER_ERROR_NONE;
+  _info = OtaImageInfo();
+  _headerLen = 0;
+  _baseSize = 0;
+  _baseHashed = 0;
+  _produced = 0;
+  _head = 0;
+  _inflateState = INFLATE_TAG;
+  _backrefOffset = 0;
+  _bitBuffer = 0;
+  _bitCount = 0;
+  _in = NULL;
+  _inLen = 0;
+  _outLen = 0;
+  _deltaState = DELTA_OP;
+  _op = 0;
+  _varint = 0;
+  _varintShift = 0;
+  _opLen = 0;
+}
+
+void OtaImageDecoder::begin(HeaderHandler onHeader, Sink sink, BaseReader base)
+{
+  reset();
+  _onHeader = onHeader;
+  _sink = sink;
+  _base = base;
+  _state = STATE_HEADER;
+}
+
+bool OtaImageDecoder::fail(int error)
+{
+  _state = STATE_ERROR;
+  _error = error;
+  if(_window) {
+    free(_window);
+    _window = NULL;
+  }
+  return false;
+}
+
+bool OtaImageDecoder::write(const uint8_t *data, size_t len)
+{
+  while(len > 0)
+  {
+    switch(_state)
+    {
+      case STATE_HEADER:
+      {
+        // Decide between a plain and a packed image on the magic, then
+        // collect the rest of the header
+        const size_t magic_len = sizeof(OTA_PACK_MAGIC) - 1;
+        size_t want = (_headerLen < magic_len ? magic_len : OTA_PACK_HEADER_SIZE) - _headerLen;
+        size_t chunk = len < want ? len : want;
+        memcpy(_header + _headerLen, data, chunk);
+        _headerLen += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if(_headerLen <= magic_len &&
+           0 != memcmp(_header, OTA_PACK_MAGIC, _headerLen))
+        {
+          _state = STATE_RAW;
+          if(_onHeader && !_onHeader(_info)) {
+            return fail(OTA_DECODER_ERROR_REJECTED);
+          }
+          if(!output(_header, _headerLen)) {
+            return false;
+          }
+        }
+        else if(OTA_PACK_HEADER_SIZE == _headerLen && !header()) {
+          return false;
+        }
+        break;
+      }
+
+      case STATE_RAW:
+        if(!output(data, len)) {
+          return false;
+        }
+        len = 0;
+        break;
+
+      case STATE_BODY:
+        if(!body(data, len)) {
+          return false;
+        }
+        len = 0;
+        break;
+
+      default:
+        return false;
+    }
+  }
+
+  return STATE_ERROR != _state;
+}
+
+bool OtaImageDecoder::end()
+{
+  bool ok = false;
+  switch(_state)
+  {
+    case STATE_RAW:
+      ok = true;
+      break;
+
+    case STATE_BODY:
+      // Trailing heatshrink bits are padding, but a delta must not stop part
+      // way through an operation
+      if(_info.flags & OTA_PACK_FLAG_HEATSHRINK) {
+        ok = inflateFlush();
+      } else {
+        ok = true;
+      }
+      if(ok && (_info.flags & OTA_PACK_FLAG_DELTA) && DELTA_OP != _deltaState) {
+        ok = fail(OTA_DECODER_ERROR_CORRUPT);
+      }
+      // Whatever verify() has not got to yet
+      if(ok) {
+        ok = verify(_baseSize);
+      }
+      if(ok && _produced != _info.image_size) {
+        ok = fail(OTA_DECODER_ERROR_SIZE);
+      }
+      break;
+
+    case STATE_HEADER:
+      ok = fail(OTA_DECODER_ERROR_HEADER);
+      break;
+
+    default:
+      break;
+  }
+
+  if(_window) {
+    free(_window);
+    _window = NULL;
+  }
+
+  return ok;
+}
+
+bool OtaImageDecoder::header()
+{
+  _info.packed = true;
+  _info.flags = _header[5];
+  _info.image_size = read_le32(_header + 8);
+  _windowSz2 = _header[6];
+  _lookaheadSz2 = _header[7];
+  _baseSize = read_le32(_header + 12);
+
+  if(OTA_PACK_VERSION != _header[4] ||
+     0 != (_info.flags & ~(OTA_PACK_FLAG_HEATSHRINK | OTA_PACK_FLAG_DELTA)) ||
+     0 == _info.image_size)
+  {
+    return fail(OTA_DECODER_ERROR_HEADER);
+  }
+
+  if(_info.flags & OTA_PACK_FLAG_HEATSHRINK)
+  {
+    if(_windowSz2 < 4 || _windowSz2 > OTA_PACK_MAX_WINDOW_SZ2 ||
+       _lookaheadSz2 < 3 || _lookaheadSz2 >= _windowSz2)
+    {
+      return fail(OTA_DECODER_ERROR_HEADER);
+    }
+
+    _window = (uint8_t *)calloc(1, (size_t)1 << _windowSz2);
+    if(NULL == _window) {
+      return fail(OTA_DECODER_ERROR_NO_MEMORY);
+    }
+  }
+
+  if((_info.flags & OTA_PACK_FLAG_DELTA) && !beginBase()) {
+    return false;
+  }
+
+  if(_onHeader && !_onHeader(_info)) {
+    return fail(OTA_DECODER_ERROR_REJECTED);
+  }
+
+  _state = STATE_BODY;
+  return true;
+}
+
+bool OtaImageDecoder::beginBase()
+{
+  if(!_base || 0 == _baseSize) {
+    return fail(OTA_DECODER_ERROR_BASE_MISMATCH);
+  }
+
+  oevse_sha256_init(&_baseHash);
+  _baseHashed = 0;
+  return true;
+}
+
+bool OtaImageDecoder::verifying() const
+{
+  return STATE_BODY == _state && (_info.flags & OTA_PACK_FLAG_DELTA) && _baseHashed < _baseSize;
+}
+
+bool OtaImageDecoder::verify(size_t max)
+{
+  if(!verifying()) {
+    return STATE_ERROR != _state;
+  }
+
+  uint8_t buffer[256];
+  while(max > 0 && _baseHashed < _baseSize)
+  {
+    size_t chunk = _baseSize - _baseHashed;
+    if(chunk > sizeof(buffer)) {
+      chunk = sizeof(buffer);
+    }
+    if(chunk > max) {
+      chunk = max;
+    }
+    if(!_base(_baseHashed, buffer, chunk)) {
+      return fail(OTA_DECODER_ERROR_BASE_MISMATCH);
+    }
+    oevse_sha256_update(&_baseHash, buffer, chunk);
+    _baseHashed += chunk;
+    max -= chunk;
+  }
+
+  if(_baseHashed < _baseSize) {
+    return true;
+  }
+
+  uint8_t digest[32];
+  oevse_sha256_final(&_baseHash, digest);
+  if(0 != memcmp(digest, _header + 16, sizeof(digest))) {
+    return fail(OTA_DECODER_ERROR_BASE_MISMATCH);
+  }
+
+  return true;
+}
+
+bool OtaImageDecoder::body(const uint8_t *data, size_t len)
+{
+  if(_info.flags & OTA_PACK_FLAG_HEATSHRINK) {
+    return inflate(data, len);
+  }
+  if(_info.flags & OTA_PACK_FLAG_DELTA) {
+    return delta(data, len);
+  }
+  return output(data, len);
+}
+
+// -------------------------------------------------------------------
+// heatshrink decoder
+//
+// Bits are read MSB first. A 1 tag bit is followed by an 8 bit literal, a 0
+// by a window_sz2 bit (offset - 1) and a lookahead_sz2 bit (count - 1)
+// back-reference into the last 2^window_sz2 bytes of output.
+// -------------------------------------------------------------------
+
+bool OtaImageDecoder::getBits(uint8_t count, uint16_t &value)
+{
+  while(_bitCount < count)
+  {
+    if(0 == _inLen) {
+      return false;
+    }
+    _bitBuffer = (_bitBuffer << 8) | *_in++;
+    _inLen--;
+    _bitCount += 8;
+  }
+
+  _bitCount -= count;
+  value = (uint16_t)((_bitBuffer >> _bitCount) & ((1u << count) - 1));
+  return true;
+}
+
+bool OtaImageDecoder::inflate(const uint8_t *data, size_t len)
+{
+  _in = data;
+  _inLen = len;
+
+  uint16_t mask = (uint16_t)((1u << _windowSz2) - 1);
+  uint16_t value;
+  for(;;)
+  {
+    switch(_inflateState)
+    {
+      case INFLATE_TAG:
+        if(!getBits(1, value)) {
+          return inflateFlush();
+        }
+        _inflateState = value ? INFLATE_LITERAL : INFLATE_INDEX;
+        break;
+
+      case INFLATE_LITERAL:
+        if(!getBits(8, value)) {
+          return inflateFlush();
+        }
+        if(!inflateOut((uint8_t)value)) {
+          return false;
+        }
+        _inflateState = INFLATE_TAG;
+        break;
+
+      case INFLATE_INDEX:
+        if(!getBits(_windowSz2, value)) {
+          return inflateFlush();
+        }
+        _backrefOffset = value + 1;
+        _inflateState = INFLATE_COUNT;
+        break;
+
+      case INFLATE_COUNT:
+        if(!getBits(_lookaheadSz2, value)) {
+          return inflateFlush();
+        }
+        for(uint16_t i = 0; i <= value; i++)
+        {
+          if(!inflateOut(_window[(uint16_t)(_head - _backrefOffset) & mask])) {
+            return false;
+          }
+        }
+        _inflateState = INFLATE_TAG;
+        break;
+    }
+  }
+}
+
+bool OtaImageDecoder::inflateOut(uint8_t c)
+{
+  _window[_head & ((1u << _windowSz2) - 1)] = c;
+  _head++;
+
+  _out[_outLen++] = c;
+  if(sizeof(_out) == _outLen) {
+    return inflateFlush();
+  }
+  return true;
+}
+
+bool OtaImageDecoder::inflateFlush()
+{
+  if(0 == _outLen) {
+    return STATE_ERROR != _state;
+  }
+
+  size_t len = _outLen;
+  _outLen = 0;
+  if(_info.flags & OTA_PACK_FLAG_DELTA) {
+    return delta(_out, len);
+  }
+  return output(_out, len);
+}
+
+// -------------------------------------------------------------------
+// Delta operations
+// -------------------------------------------------------------------
+
+bool OtaImageDecoder::delta(const uint8_t *data, size_t len)
+{
+  while(len > 0)
+  {
+    switch(_deltaState)
+    {
+      case DELTA_OP:
+        _op = *data++;
+        len--;
+        if(OTA_PACK_OP_COPY != _op && OTA_PACK_OP_DATA != _op) {
+          return fail(OTA_DECODER_ERROR_CORRUPT);
+        }
+        _varint = 0;
+        _varintShift = 0;
+        _deltaState = DELTA_LEN;
+        break;
+
+      case DELTA_LEN:
+      case DELTA_OFFSET:
+      {
+        uint8_t b = *data++;
+        len--;
+        if(_varintShift > 28) {
+          return fail(OTA_DECODER_ERROR_CORRUPT);
+        }
+        _varint |= (uint32_t)(b & 0x7f) << _varintShift;
+        _varintShift += 7;
+        if(b & 0x80) {
+          break;
+        }
+
+        if(DELTA_LEN == _deltaState)
+        {
+          _opLen = _varint;
+          _varint = 0;
+          _varintShift = 0;
+          if(OTA_PACK_OP_COPY == _op) {
+            _deltaState = DELTA_OFFSET;
+          } else {
+            _deltaState = _opLen > 0 ? DELTA_DATA : DELTA_OP;
+          }
+        }
+        else
+        {
+          if(!copyBase(_varint, _opLen)) {
+            return false;
+          }
+          _deltaState = DELTA_OP;
+        }
+        break;
+      }
+
+      case DELTA_DATA:
+      {
+        size_t chunk = len < _opLen ? len : _opLen;
+        if(!output(data, chunk)) {
+          return false;
+        }
+        data += chunk;
+        len -= chunk;
+        _opLen -= chunk;
+        if(0 == _opLen) {
+          _deltaState = DELTA_OP;
+        }
+        break;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool OtaImageDecoder::copyBase(uint32_t offset, uint32_t len)
+{
+  if(offset > _baseSize || len > _baseSize - offset) {
+    return fail(OTA_DECODER_ERROR_CORRUPT);
+  }
+
+  uint8_t buffer[256];
+  while(len > 0)
+  {
+    size_t chunk = len < sizeof(buffer) ? len : sizeof(buffer);
+    if(!_base(offset, buffer, chunk)) {
+      return fail(OTA_DECODER_ERROR_BASE_MISMATCH);
+    }
+    if(!output(buffer, chunk)) {
+      return false;
+    }
+    offset += chunk;
+    len -= chunk;
+  }
+
+  return true;
+}
+
+bool OtaImageDecoder::output(const uint8_t *data, size_t len)
+{
+  if(0 == len) {
+    return true;
+  }
+
+  if(_info.packed && len > _info.image_size - _produced) {
+    return fail(OTA_DECODER_ERROR_SIZE);
+  }
+
+  if(_sink && !_sink(data, len)) {
+    return fail(OTA_DECODER_ERROR_OUTPUT);
+  }
+
+  _produced += len;
+  return true;
+}
+
+const char *OtaImageDecoder::errorString(int error)
+{
+  switch(error)
+  {
+    case OTA_DECODER_ERROR_NONE:          return "No error";
+    case OTA_DECODER_ERROR_HEADER:        return "Invalid packed image header";
+    case OTA_DECODER_ERROR_NO_MEMORY:     return "Out of memory";
+    case OTA_DECODER_ERROR_BASE_MISMATCH: return "Delta does not match the running firmware";
+    case OTA_DECODER_ERROR_CORRUPT:       return "Corrupt packed image";
+    case OTA_DECODER_ERROR_SIZE:          return "Decoded image size mismatch";
+    case OTA_DECODER_ERROR_OUTPUT:        return "Write failed";
+    case OTA_DECODER_ERROR_REJECTED:      return "Image rejected";
+  }
+  return "Unknown error";
+}
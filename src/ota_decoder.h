@@ -0,0 +1,182 @@
+#ifndef OTA_DECODER_H
+#define OTA_DECODER_H
+
+// -------------------------------------------------------------------
+// Packed firmware image decoder
+//
+// Turns the bytes received by an OTA update back into the application image,
+// one chunk at a time, so the image never has to be held in RAM. Plain .bin
+// files pass straight through. Packed images, produced by
+// scripts/pack_firmware.py, start with a 48 byte header:
+//
+//   0   "OEVZ"                 magic
+//   4   uint8  version         OTA_PACK_VERSION
+//   5   uint8  flags           OTA_PACK_FLAG_*
+//   6   uint8  window_sz2      heatshrink window, log2 bytes
+//   7   uint8  lookahead_sz2   heatshrink lookahead, log2 bytes
+//   8   uint32 image_size      size of the decoded image (little endian)
+//   12  uint32 base_size       delta only: bytes of the running image used
+//   16  uint8[32] base_sha256  delta only: SHA-256 of those bytes
+//
+// The payload is optionally heatshrink compressed and optionally a delta
+// against the running firmware, a sequence of operations:
+//
+//   0x01 <len> <offset>  copy len bytes from offset in the running image
+//   0x02 <len> <data>    len literal bytes
+//
+// with len and offset as unsigned LEB128. A delta is only accepted if the
+// running image hashes to base_sha256. Hashing the whole image at once would
+// hold up the caller, so it is done a step at a time by verify() while the
+// delta is received, and finished by end(). The image written before then may
+// be wrong, but end() fails and so it is never committed.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+// -------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+#include "crypto/sha256.h"
+
+#define OTA_PACK_MAGIC              "OEVZ"
+#define OTA_PACK_VERSION            1
+#define OTA_PACK_HEADER_SIZE        48
+
+#define OTA_PACK_FLAG_HEATSHRINK    (1 << 0)
+#define OTA_PACK_FLAG_DELTA         (1 << 1)
+
+#define OTA_PACK_OP_COPY            0x01
+#define OTA_PACK_OP_DATA            0x02
+
+// Largest heatshrink window accepted, bounds the RAM used while decoding
+#ifndef OTA_PACK_MAX_WINDOW_SZ2
+#define OTA_PACK_MAX_WINDOW_SZ2     12
+#endif
+
+// Bytes of the running image verify() hashes by default
+#ifndef OTA_PACK_VERIFY_STEP
+#define OTA_PACK_VERIFY_STEP        (16 * 1024)
+#endif
+
+#define OTA_DECODER_ERROR_NONE            0
+#define OTA_DECODER_ERROR_HEADER         -1
+#define OTA_DECODER_ERROR_NO_MEMORY      -2
+#define OTA_DECODER_ERROR_BASE_MISMATCH  -3
+#define OTA_DECODER_ERROR_CORRUPT        -4
+#define OTA_DECODER_ERROR_SIZE           -5
+#define OTA_DECODER_ERROR_OUTPUT         -6
+#define OTA_DECODER_ERROR_REJECTED       -7
+
+struct OtaImageInfo {
+  bool packed = false;        // false for a plain .bin
+  uint8_t flags = 0;
+  uint32_t image_size = 0;    // 0 if not known (plain .bin)
+};
+
+class OtaImageDecoder
+{
+  public:
+    // Called once the image type is known, before any output. Return false to
+    // refuse the image.
+    typedef std::function<bool(const OtaImageInfo &info)> HeaderHandler;
+    // Receives the decoded image. Return false to stop decoding.
+    typedef std::function<bool(const uint8_t *data, size_t len)> Sink;
+    // Reads the running image for deltas.
+    typedef std::function<bool(uint32_t offset, uint8_t *data, size_t len)> BaseReader;
+
+    OtaImageDecoder();
+    ~OtaImageDecoder();
+
+    void begin(HeaderHandler onHeader, Sink sink, BaseReader base = nullptr);
+    // Decode the next chunk of the received file
+    bool write(const uint8_t *data, size_t len);
+    // For a delta, hash up to max more bytes of the running image. False once
+    // it is known not to match, after that write() fails too.
+    bool verify(size_t max = OTA_PACK_VERIFY_STEP);
+    // A delta's running image is still being hashed
+    bool verifying() const;
+    // Check the whole image has been decoded, releases the working buffers
+    bool end();
+    void reset();
+
+    const OtaImageInfo &info() const { return _info; }
+    size_t produced() const { return _produced; }
+    int error() const { return _error; }
+    static const char *errorString(int error);
+
+  private:
+    enum State : uint8_t {
+      STATE_IDLE,
+      STATE_HEADER,
+      STATE_RAW,
+      STATE_BODY,
+      STATE_ERROR
+    };
+
+    enum InflateState : uint8_t {
+      INFLATE_TAG,
+      INFLATE_LITERAL,
+      INFLATE_INDEX,
+      INFLATE_COUNT
+    };
+
+    enum DeltaState : uint8_t {
+      DELTA_OP,
+      DELTA_LEN,
+      DELTA_OFFSET,
+      DELTA_DATA
+    };
+
+    bool fail(int error);
+    bool header();
+    bool beginBase();
+    bool body(const uint8_t *data, size_t len);
+
+    bool inflate(const uint8_t *data, size_t len);
+    bool getBits(uint8_t count, uint16_t &value);
+    bool inflateOut(uint8_t c);
+    bool inflateFlush();
+
+    bool delta(const uint8_t *data, size_t len);
+    bool copyBase(uint32_t offset, uint32_t len);
+
+    bool output(const uint8_t *data, size_t len);
+
+    HeaderHandler _onHeader;
+    Sink _sink;
+    BaseReader _base;
+
+    State _state;
+    int _error;
+    OtaImageInfo _info;
+    uint8_t _header[OTA_PACK_HEADER_SIZE];
+    size_t _headerLen;
+    uint32_t _baseSize;
+    uint32_t _baseHashed;
+    oevse_sha256_ctx _baseHash;
+    size_t _produced;
+
+    // heatshrink
+    uint8_t _windowSz2;
+    uint8_t _lookaheadSz2;
+    uint8_t *_window;
+    uint16_t _head;
+    InflateState _inflateState;
+    uint16_t _backrefOffset;
+    uint32_t _bitBuffer;
+    uint8_t _bitCount;
+    const uint8_t *_in;
+    size_t _inLen;
+    uint8_t _out[64];
+    size_t _outLen;
+
+    // delta
+    DeltaState _deltaState;
+    uint8_t _op;
+    uint32_t _varint;
+    uint8_t _varintShift;
+    uint32_t _opLen;
+};
+
+#endif // OTA_DECODER_H
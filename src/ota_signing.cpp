@@ -1,5 +1,57 @@
 #include "ota_signing.h"
 
+#include <string.h>
+
+static uint8_t expected_sha256[32];
+static bool expected_sha256_set = false;
+
+static int hex_nibble(char c)
+{
+  if(c >= '0' && c <= '9') return c - '0';
+  if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool ota_expect_sha256(const char *hex)
+{
+  expected_sha256_set = false;
+  if(NULL == hex || '\0' == hex[0]) {
+    return true;
+  }
+
+  if(strlen(hex) != 2 * sizeof(expected_sha256)) {
+    return false;
+  }
+
+  for(size_t i = 0; i < sizeof(expected_sha256); i++)
+  {
+    int hi = hex_nibble(hex[2 * i]);
+    int lo = hex_nibble(hex[2 * i + 1]);
+    if(hi < 0 || lo < 0) {
+      return false;
+    }
+    expected_sha256[i] = (uint8_t)((hi << 4) | lo);
+  }
+
+  expected_sha256_set = true;
+  return true;
+}
+
+bool ota_sha256_expected()
+{
+  return expected_sha256_set;
+}
+
+bool ota_check_sha256(const uint8_t digest[32])
+{
+  if(!expected_sha256_set) {
+    return true;
+  }
+  expected_sha256_set = false;
+  return 0 == memcmp(digest, expected_sha256, sizeof(expected_sha256));
+}
+
 #if defined(REQUIRE_SIGNED_OTA)
 
 #if !defined(UPDATE_SIGN)
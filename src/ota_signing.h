@@ -1,6 +1,8 @@
 #ifndef OTA_SIGNING_H
 #define OTA_SIGNING_H
 
+#include <stdint.h>
+
 // Install the compiled-in RSA public key as the signature verifier on the
 // global `Update` object, immediately before `Update.begin()`.
 //
@@ -20,4 +22,19 @@ bool ota_install_signature();
 // True when this build enforces signed OTA (compile-time).
 bool ota_signing_required();
 
+// Optional whole-image SHA-256 check, independent of the RSA signature.
+//
+// The hash is computed incrementally as the image is streamed to flash (see
+// ota_stream.h) and compared before the update is committed, so a truncated or
+// corrupted download is caught without reading the partition back.
+//
+// `hex` is the 64 character digest, e.g. from the `sha256` field of an /update
+// fetch. NULL or "" clears the expectation. Returns false (and clears it) if
+// the string is not a valid digest.
+bool ota_expect_sha256(const char *hex);
+bool ota_sha256_expected();
+// True if no digest is expected or `digest` matches it. The expectation is
+// consumed either way.
+bool ota_check_sha256(const uint8_t digest[32]);
+
 #endif // OTA_SIGNING_H
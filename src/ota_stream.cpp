@@ -0,0 +1,344 @@
+#if defined(ENABLE_DEBUG) && !defined(ENABLE_DEBUG_HTTP_UPATE)
+#undef ENABLE_DEBUG
+#endif
+
+#include <Arduino.h>
+#include <Update.h>
+#include <string.h>
+
+#include "ota_stream.h"
+#include "debug.h"
+#include "crypto/sha256.h"
+
+#if defined(ESP32) && !defined(EPOXY_DUINO)
+#define OTA_STREAM_TASK 1
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#else
+#define OTA_STREAM_TASK 0
+#endif
+
+// Marks the end of the stream in the full queue
+#define OTA_STREAM_END_MARKER 0xff
+
+struct OtaStreamBlock {
+  uint8_t index;
+  uint16_t len;
+};
+
+static bool stream_running = false;
+static volatile bool stream_failed = false;
+static OtaStreamStats stream_stats;
+static uint32_t stream_start = 0;
+static oevse_sha256_ctx stream_hash;
+static uint8_t stream_digest[32];
+
+// Flash write + hash, run on the writer task (or inline without one)
+static void ota_stream_program(const uint8_t *data, size_t len)
+{
+  uint32_t start = millis();
+  size_t written = Update.write(const_cast<uint8_t *>(data), len);
+  uint32_t took = millis() - start;
+  if(took > stream_stats.max_write_ms) {
+    stream_stats.max_write_ms = took;
+  }
+
+  if(written != len) {
+    DEBUG_PORT.printf("OTA flash write failed: %u/%u\n", (unsigned)written, (unsigned)len);
+    stream_failed = true;
+    return;
+  }
+
+  oevse_sha256_update(&stream_hash, data, len);
+  stream_stats.written += len;
+}
+
+#if OTA_STREAM_TASK
+
+static uint8_t *stream_buffers = NULL;
+static QueueHandle_t free_queue = NULL;   // uint8_t buffer index
+static QueueHandle_t full_queue = NULL;   // OtaStreamBlock
+static SemaphoreHandle_t done = NULL;
+static TaskHandle_t writer_task = NULL;
+
+static int fill_index = -1;               // buffer being filled, -1 = none
+static size_t fill_len = 0;
+
+static uint8_t *buffer(uint8_t index) {
+  return stream_buffers + (size_t)index * OTA_STREAM_BUFFER_SIZE;
+}
+
+static void ota_stream_writer(void *)
+{
+  OtaStreamBlock block;
+  for(;;)
+  {
+    if(pdTRUE != xQueueReceive(full_queue, &block, portMAX_DELAY)) {
+      continue;
+    }
+    if(OTA_STREAM_END_MARKER == block.index) {
+      break;
+    }
+
+    // Keep draining after a failure so the receiver never deadlocks, the
+    // data is simply dropped
+    if(!stream_failed) {
+      ota_stream_program(buffer(block.index), block.len);
+    }
+    xQueueSend(free_queue, &block.index, portMAX_DELAY);
+  }
+
+  xSemaphoreGive(done);
+  vTaskDelete(NULL);
+}
+
+// Wait for a queue operation in slices so the loop WDT stays fed
+template<typename F>
+static bool ota_stream_wait(F op)
+{
+  uint32_t start = millis();
+  while(!op(pdMS_TO_TICKS(500)))
+  {
+    feedLoopWDT();
+    if(millis() - start > OTA_STREAM_STALL_TIMEOUT) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void ota_stream_free()
+{
+  if(free_queue) { vQueueDelete(free_queue); free_queue = NULL; }
+  if(full_queue) { vQueueDelete(full_queue); full_queue = NULL; }
+  if(done) { vSemaphoreDelete(done); done = NULL; }
+  if(stream_buffers) { heap_caps_free(stream_buffers); stream_buffers = NULL; }
+  writer_task = NULL;
+  fill_index = -1;
+  fill_len = 0;
+}
+
+// Hand the buffer being filled to the writer
+static bool ota_stream_submit()
+{
+  if(fill_index < 0 || 0 == fill_len) {
+    return true;
+  }
+
+  OtaStreamBlock block = { (uint8_t)fill_index, (uint16_t)fill_len };
+  xQueueSend(full_queue, &block, portMAX_DELAY);  // sized to hold every buffer
+  fill_index = -1;
+  fill_len = 0;
+  return true;
+}
+
+static bool ota_stream_start_task()
+{
+  stream_buffers = (uint8_t *)heap_caps_malloc(OTA_STREAM_BUFFERS * OTA_STREAM_BUFFER_SIZE,
+                                               MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  free_queue = xQueueCreate(OTA_STREAM_BUFFERS, sizeof(uint8_t));
+  full_queue = xQueueCreate(OTA_STREAM_BUFFERS + 1, sizeof(OtaStreamBlock));
+  done = xSemaphoreCreateBinary();
+  if(!stream_buffers || !free_queue || !full_queue || !done) {
+    DEBUG_PORT.println(F("OTA stream: out of memory"));
+    ota_stream_free();
+    return false;
+  }
+
+  for(uint8_t i = 0; i < OTA_STREAM_BUFFERS; i++) {
+    xQueueSend(free_queue, &i, 0);
+  }
+
+  // Run next to the loop task (priority 1) and above it, so flash keeps up
+  // while the loop is receiving, but well below the TCP/IP task
+  if(pdPASS != xTaskCreatePinnedToCore(ota_stream_writer, "ota_writer",
+                                       OTA_STREAM_TASK_STACK, NULL,
+                                       OTA_STREAM_TASK_PRIORITY, &writer_task,
+                                       xPortGetCoreID()))
+  {
+    DEBUG_PORT.println(F("OTA stream: failed to start writer"));
+    ota_stream_free();
+    return false;
+  }
+
+  return true;
+}
+
+static bool ota_stream_queue(const uint8_t *data, size_t len)
+{
+  while(len > 0)
+  {
+    if(fill_index < 0)
+    {
+      uint8_t index;
+      uint32_t wait_start = millis();
+      if(pdTRUE != xQueueReceive(free_queue, &index, 0))
+      {
+        // Every buffer is waiting on flash, apply backpressure to the network
+        stream_stats.stalls++;
+        if(!ota_stream_wait([&index](TickType_t ticks) {
+          return pdTRUE == xQueueReceive(free_queue, &index, ticks);
+        })) {
+          DEBUG_PORT.println(F("OTA stream: writer stalled"));
+          stream_failed = true;
+          return false;
+        }
+        stream_stats.stall_ms += millis() - wait_start;
+      }
+      fill_index = index;
+      fill_len = 0;
+    }
+
+    size_t chunk = min(len, (size_t)(OTA_STREAM_BUFFER_SIZE - fill_len));
+    memcpy(buffer(fill_index) + fill_len, data, chunk);
+    fill_len += chunk;
+    data += chunk;
+    len -= chunk;
+
+    if(OTA_STREAM_BUFFER_SIZE == fill_len) {
+      ota_stream_submit();
+    }
+  }
+
+  return true;
+}
+
+static bool ota_stream_finish(bool discard)
+{
+  // A failed stream tells the writer to drop what is queued
+  if(discard) {
+    stream_failed = true;
+  }
+  ota_stream_submit();
+
+  OtaStreamBlock end = { OTA_STREAM_END_MARKER, 0 };
+  xQueueSend(full_queue, &end, portMAX_DELAY);
+
+  // Until the writer has exited it may be inside Update.write() and is
+  // using the buffers and queues, so wait for it however long its last
+  // flash write takes. Only then can Update.abort() be called or a new
+  // stream begin.
+  bool finished = ota_stream_wait([](TickType_t ticks) {
+    return pdTRUE == xSemaphoreTake(done, ticks);
+  });
+  if(!finished)
+  {
+    DEBUG_PORT.println(F("OTA stream: waiting for the writer to finish"));
+    stream_failed = true;
+    while(pdTRUE != xSemaphoreTake(done, pdMS_TO_TICKS(500))) {
+      feedLoopWDT();
+    }
+  }
+
+  ota_stream_free();
+  return true;
+}
+
+#else // !OTA_STREAM_TASK
+
+static bool ota_stream_start_task()
+{
+  return true;
+}
+
+static bool ota_stream_queue(const uint8_t *data, size_t len)
+{
+  ota_stream_program(data, len);
+  return !stream_failed;
+}
+
+static bool ota_stream_finish(bool discard)
+{
+  if(discard) {
+    stream_failed = true;
+  }
+  return true;
+}
+
+#endif // OTA_STREAM_TASK
+
+bool ota_stream_begin()
+{
+  if(stream_running) {
+    ota_stream_abort();
+  }
+
+  stream_stats = OtaStreamStats();
+  stream_failed = false;
+  stream_start = millis();
+  oevse_sha256_init(&stream_hash);
+  memset(stream_digest, 0, sizeof(stream_digest));
+
+  if(!ota_stream_start_task()) {
+    return false;
+  }
+
+  stream_running = true;
+  return true;
+}
+
+bool ota_stream_write(const uint8_t *data, size_t len)
+{
+  if(!stream_running || stream_failed) {
+    return false;
+  }
+
+  if(!ota_stream_queue(data, len)) {
+    return false;
+  }
+  stream_stats.received += len;
+  return !stream_failed;
+}
+
+bool ota_stream_end()
+{
+  if(!stream_running) {
+    return false;
+  }
+
+  bool ok = ota_stream_finish(false) && !stream_failed;
+  stream_running = false;
+  stream_stats.elapsed_ms = millis() - stream_start;
+  oevse_sha256_final(&stream_hash, stream_digest);
+
+  OtaStreamStats stats;
+  ota_stream_get_stats(stats);
+  DEBUG_PORT.printf("OTA stream: %u bytes in %ums, %u B/s, stalled %ums (%u), max write %ums\n",
+                    (unsigned)stats.written, stats.elapsed_ms, stats.bytes_per_sec,
+                    stats.stall_ms, stats.stalls, stats.max_write_ms);
+  return ok;
+}
+
+void ota_stream_abort()
+{
+  if(!stream_running) {
+    return;
+  }
+
+  ota_stream_finish(true);
+  stream_running = false;
+  stream_stats.elapsed_ms = millis() - stream_start;
+}
+
+bool ota_stream_running()
+{
+  return stream_running;
+}
+
+void ota_stream_get_stats(OtaStreamStats &stats)
+{
+  stats = stream_stats;
+  if(stream_running) {
+    stats.elapsed_ms = millis() - stream_start;
+  }
+  stats.bytes_per_sec = stats.elapsed_ms > 0 ?
+    (uint32_t)(((uint64_t)stats.received * 1000) / stats.elapsed_ms) : 0;
+}
+
+void ota_stream_sha256(uint8_t out[32])
+{
+  memcpy(out, stream_digest, sizeof(stream_digest));
+}
@@ -0,0 +1,68 @@
+#ifndef OTA_STREAM_H
+#define OTA_STREAM_H
+
+// -------------------------------------------------------------------
+// Double-buffered OTA flash writer
+//
+// Decouples receiving the image from programming it: the network side copies
+// each chunk into a ring of sector-sized buffers and returns straight away,
+// while a dedicated task drains full buffers into Update.write() and hashes
+// the image as it goes. Mongoose only blocks when every buffer is waiting on
+// flash, which is reported as stall time.
+//
+// On hosts without FreeRTOS (native builds) the writes are made inline.
+// -------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef OTA_STREAM_BUFFERS
+#define OTA_STREAM_BUFFERS          4
+#endif
+
+// One flash sector, so Update programs whole sectors per write
+#ifndef OTA_STREAM_BUFFER_SIZE
+#define OTA_STREAM_BUFFER_SIZE      4096
+#endif
+
+#ifndef OTA_STREAM_TASK_STACK
+#define OTA_STREAM_TASK_STACK       4096
+#endif
+
+#ifndef OTA_STREAM_TASK_PRIORITY
+#define OTA_STREAM_TASK_PRIORITY    2
+#endif
+
+// Give up if the writer has not freed a buffer for this long (ms)
+#ifndef OTA_STREAM_STALL_TIMEOUT
+#define OTA_STREAM_STALL_TIMEOUT    10000
+#endif
+
+struct OtaStreamStats {
+  size_t   received = 0;       // bytes accepted from the network
+  size_t   written = 0;        // bytes programmed to flash
+  uint32_t elapsed_ms = 0;     // since ota_stream_begin()
+  uint32_t bytes_per_sec = 0;  // received / elapsed
+  uint32_t stall_ms = 0;       // time the receiver waited for a free buffer
+  uint32_t stalls = 0;         // number of times it had to wait
+  uint32_t max_write_ms = 0;   // slowest single flash write
+};
+
+// Start the writer, call after Update.begin()
+bool ota_stream_begin();
+// Queue data for writing. Copies the data, only blocks while all buffers are
+// in use. Returns false once a flash write has failed.
+bool ota_stream_write(const uint8_t *data, size_t len);
+// Flush the last partial buffer and wait for the writer to finish. Returns
+// false if any write failed.
+bool ota_stream_end();
+// Stop the writer and discard any queued data, call before Update.abort().
+// Returns once the writer task has exited.
+void ota_stream_abort();
+
+bool ota_stream_running();
+void ota_stream_get_stats(OtaStreamStats &stats);
+// SHA-256 of every byte written, valid after ota_stream_end()
+void ota_stream_sha256(uint8_t out[32]);
+
+#endif // OTA_STREAM_H
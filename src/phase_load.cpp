@@ -0,0 +1,111 @@
+#include <float.h>
+
+#include "phase_load.h"
+
+PhaseLoad::PhaseLoad()
+{
+  clear();
+}
+
+void PhaseLoad::clear()
+{
+  for(uint8_t i = 0; i < PHASE_LOAD_PHASES; i++) {
+    _current[i] = 0;
+    _updated[i] = 0;
+  }
+  _seen = 0;
+  _fresh = 0;
+}
+
+void PhaseLoad::setCurrent(uint8_t phase, double amps, uint32_t now)
+{
+  if(phase >= PHASE_LOAD_PHASES) {
+    return;
+  }
+
+  _current[phase] = amps;
+  _updated[phase] = now;
+  _seen |= 1 << phase;
+  _fresh |= 1 << phase;
+}
+
+void PhaseLoad::setPower(uint8_t phase, double watts, double voltage, uint32_t now)
+{
+  if(voltage <= 0) {
+    return;
+  }
+
+  setCurrent(phase, watts / voltage, now);
+}
+
+bool PhaseLoad::valid(uint32_t now, uint32_t maxAge) const
+{
+  for(uint8_t i = 0; i < PHASE_LOAD_PHASES; i++)
+  {
+    if(0 == (_seen & (1 << i)) || now - _updated[i] > maxAge) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool PhaseLoad::active(uint32_t now, uint32_t maxAge) const
+{
+  for(uint8_t i = 0; i < PHASE_LOAD_PHASES; i++)
+  {
+    if((_seen & (1 << i)) && now - _updated[i] <= maxAge) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+double PhaseLoad::total() const
+{
+  double total = 0;
+  for(uint8_t i = 0; i < PHASE_LOAD_PHASES; i++) {
+    total += _current[i];
+  }
+  return total;
+}
+
+double PhaseLoad::available(double limit, double evseAmps, uint8_t phaseMask, uint8_t *limiting) const
+{
+  double available = DBL_MAX;
+  uint8_t worst = 0;
+
+  for(uint8_t i = 0; i < PHASE_LOAD_PHASES; i++)
+  {
+    if(0 == (phaseMask & (1 << i))) {
+      continue;
+    }
+
+    // The load on the phase, less what the EVSE is drawing already
+    double headroom = limit - (_current[i] - evseAmps);
+    if(headroom < available) {
+      available = headroom;
+      worst = i;
+    }
+  }
+
+  if(DBL_MAX == available) {
+    available = 0;
+  }
+  if(limiting) {
+    *limiting = worst;
+  }
+  return available;
+}
+
+uint8_t PhaseLoad::phaseMask(bool threephase, uint8_t phase)
+{
+  if(threephase) {
+    return (1 << PHASE_LOAD_PHASES) - 1;
+  }
+  if(phase < 1 || phase > PHASE_LOAD_PHASES) {
+    phase = 1;
+  }
+  return 1 << (phase - 1);
+}
@@ -0,0 +1,62 @@
+#ifndef _OPENEVSE_PHASE_LOAD_H
+#define _OPENEVSE_PHASE_LOAD_H
+
+// Per-phase load at the mains, for shaping and divert on three-phase
+// supplies.
+//
+// An aggregate reading hides an imbalance: 9 kW spread evenly over three
+// 25 A phases leaves plenty of room, 9 kW on one phase does not. Given the
+// current on each phase (import positive, including the EVSE), this works
+// out the current the EVSE could draw without any phase it is connected to
+// going over a per-phase limit, so the most loaded phase sets the headroom.
+// With a limit of 0 the same sum gives the export available to divert
+// without importing on any phase.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+
+#include <stdint.h>
+
+#define PHASE_LOAD_PHASES 3
+
+class PhaseLoad
+{
+  public:
+    PhaseLoad();
+
+    // phase is 0 to PHASE_LOAD_PHASES - 1, now in ms
+    void setCurrent(uint8_t phase, double amps, uint32_t now);
+    void setPower(uint8_t phase, double watts, double voltage, uint32_t now);
+    void clear();
+
+    // Every phase has been updated in the last maxAge ms
+    bool valid(uint32_t now, uint32_t maxAge) const;
+    // Any phase has been updated in the last maxAge ms
+    bool active(uint32_t now, uint32_t maxAge) const;
+
+    // The phases come in one at a time. A reading is complete once every
+    // phase has been updated since the last takeReading(), and the phase
+    // has been updated already if it comes round again before the others.
+    bool updated(uint8_t phase) const { return phase < PHASE_LOAD_PHASES && (_fresh & (1 << phase)); }
+    bool complete() const { return ((1 << PHASE_LOAD_PHASES) - 1) == _fresh; }
+    void takeReading() { _fresh = 0; }
+
+    double current(uint8_t phase) const { return _current[phase]; }
+    double total() const;
+
+    // The most the EVSE could draw on the phases in phaseMask, now drawing
+    // evseAmps on each of them, without any going over limit. The phase
+    // (0 based) that sets it is returned in limiting.
+    double available(double limit, double evseAmps, uint8_t phaseMask, uint8_t *limiting = nullptr) const;
+
+    // The phases an EVSE uses: all of them when three-phase, otherwise the
+    // one it is connected to, phase 1 to PHASE_LOAD_PHASES
+    static uint8_t phaseMask(bool threephase, uint8_t phase);
+
+  private:
+    double _current[PHASE_LOAD_PHASES];
+    uint32_t _updated[PHASE_LOAD_PHASES];
+    uint8_t _seen;
+    uint8_t _fresh;           // updated since the last takeReading()
+};
+
+#endif // _OPENEVSE_PHASE_LOAD_H
@@ -12,6 +12,7 @@
 #include <Wire.h>
 #include "app_config.h"
 #include "debug.h"
+#include "profile.h"
 #include "lcd.h"
 
 #ifndef I2C_SDA
@@ -70,6 +71,7 @@ bool PN532::probeReader() {
 }
 
 unsigned long PN532::loop(MicroTasks::WakeReason reason){
+    Profile_Scope("PN532");
 
     read();
 
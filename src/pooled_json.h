@@ -0,0 +1,28 @@
+#ifndef _OPENEVSE_POOLED_JSON_H
+#define _OPENEVSE_POOLED_JSON_H
+
+#include <ArduinoJson.h>
+
+#include "json_pool.h"
+
+// ArduinoJson allocator taking its memory from jsonPool
+struct JsonPoolAllocator
+{
+  void *allocate(size_t size) {
+    return jsonPool.allocate(size);
+  }
+
+  void deallocate(void *ptr) {
+    jsonPool.deallocate(ptr);
+  }
+
+  void *reallocate(void *ptr, size_t new_size) {
+    return jsonPool.reallocate(ptr, new_size);
+  }
+};
+
+// Drop in for DynamicJsonDocument for documents built and thrown away in
+// the course of normal running
+typedef BasicJsonDocument<JsonPoolAllocator> PooledJsonDocument;
+
+#endif // _OPENEVSE_POOLED_JSON_H
@@ -1,34 +1,83 @@
 #ifndef __PROFILE_H
 #define __PROFILE_H
 
+// Profile_Start/Profile_End time a section of code and Profile_Scope the
+// rest of the enclosing scope, in the run time statistics served at
+// /debug/profile (task_profiler.h). With ENABLE_PROFILE sections taking
+// longer than max ms are also reported on the debug port, and with
+// ENABLE_NOISY_PROFILE every section is. Sections nest, heap use is counted
+// against the innermost.
+
+#include <Arduino.h>
+
+#include "task_profiler.h"
+
+class ProfileScope
+{
+  private:
+    ProfileEntry *_entry;
+    ProfileEntry *_previous;
+    uint32_t _start;
+
+  public:
+    ProfileScope(ProfileEntry *entry) :
+      _entry(entry),
+      _previous(TaskProfiler::enter(entry)),
+      _start(micros())
+    {
+    }
+
+    ~ProfileScope() {
+      TaskProfiler::record(_entry, micros() - _start);
+      TaskProfiler::leave(_previous);
+    }
+};
+
+#define Profile_Scope(name) \
+  static ProfileEntry *profile_scope_entry = profiler.entry(name); \
+  ProfileScope profile_scope(profile_scope_entry)
+
+#define Profile_Enter(x) \
+  static ProfileEntry *profile_entry_ ## x = profiler.entry(#x); \
+  ProfileEntry *profile_previous_ ## x = TaskProfiler::enter(profile_entry_ ## x); \
+  uint32_t profile_ ## x = micros()
+
+#define Profile_Record(x) \
+  uint32_t profile_ ## x ## _diff = micros() - profile_ ## x; \
+  TaskProfiler::record(profile_entry_ ## x, profile_ ## x ## _diff); \
+  TaskProfiler::leave(profile_previous_ ## x)
+
 #if defined(ENABLE_PROFILE)
 
 #if defined(ENABLE_NOISY_PROFILE)
 #define Profile_Start(x) \
-  unsigned long profile ## x = millis(); \
+  Profile_Enter(x); \
   DBUGLN(">> Start " #x)
 
 #define Profile_End(x, max) \
-  unsigned long profile ## x ## Diff = millis() - profile ## x; \
-  DBUGF(">> End " #x " %ldms", profile ## x ## Diff);\
+  Profile_Record(x); \
+  DBUGF(">> End " #x " %lums", (unsigned long)(profile_ ## x ## _diff / 1000));\
 
 #else
 
 #define Profile_Start(x) \
-  unsigned long profile ## x = millis()
+  Profile_Enter(x)
 
 #define Profile_End(x, max) \
-  unsigned long profile ## x ## Diff = millis() - profile ## x; \
-  if(profile ## x ## Diff > max) { \
-    DBUGF(">> Slow " #x " %ldms", profile ## x ## Diff);\
+  Profile_Record(x); \
+  if(profile_ ## x ## _diff > (max) * 1000UL) { \
+    DBUGF(">> Slow " #x " %lums", (unsigned long)(profile_ ## x ## _diff / 1000));\
   }
 
 #endif
 
 #else // ENABLE_PROFILE
 
-#define Profile_Start(x)
-#define Profile_End(x, min)
+#define Profile_Start(x) \
+  Profile_Enter(x)
+
+#define Profile_End(x, max) \
+  Profile_Record(x)
 
 #endif // ENABLE_PROFILE
 
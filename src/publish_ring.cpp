@@ -0,0 +1,87 @@
+#include "publish_ring.h"
+
+PublishCursor::PublishCursor(uint32_t interval) :
+  next(0),
+  last(0),
+  interval(interval),
+  sent(0),
+  skipped(0),
+  dropped(0)
+{
+}
+
+PublishRing::PublishRing() :
+  _len(),
+  _head(0),
+  _count(0),
+  _oversize(0)
+{
+}
+
+bool PublishRing::commit(size_t len)
+{
+  if(0 == len || len >= PUBLISH_RING_SLOT_SIZE) {
+    _oversize++;
+    return false;
+  }
+
+  _slots[_head % PUBLISH_RING_SLOTS][len] = '\0';
+  _len[_head % PUBLISH_RING_SLOTS] = len;
+  _head++;
+  if(_count < PUBLISH_RING_SLOTS) {
+    _count++;
+  }
+  return true;
+}
+
+void PublishRing::catchUp(PublishCursor &cursor)
+{
+  uint32_t oldest = _head - _count;
+  if((int32_t)(cursor.next - oldest) < 0)
+  {
+    cursor.dropped += oldest - cursor.next;
+    cursor.next = oldest;
+  }
+}
+
+const char *PublishRing::next(PublishCursor &cursor, uint32_t now, size_t &len)
+{
+  catchUp(cursor);
+  if(cursor.next == _head) {
+    return nullptr;
+  }
+
+  if(cursor.interval > 0)
+  {
+    if(cursor.sent > 0 && now - cursor.last < cursor.interval) {
+      return nullptr;
+    }
+
+    // Only the latest is of interest
+    cursor.skipped += _head - 1 - cursor.next;
+    cursor.next = _head - 1;
+  }
+
+  uint32_t index = cursor.next % PUBLISH_RING_SLOTS;
+  len = _len[index];
+  return _slots[index];
+}
+
+void PublishRing::consumed(PublishCursor &cursor, uint32_t now)
+{
+  cursor.next++;
+  cursor.last = now;
+  cursor.sent++;
+}
+
+void PublishRing::discard(PublishCursor &cursor)
+{
+  catchUp(cursor);
+  cursor.dropped += _head - cursor.next;
+  cursor.next = _head;
+}
+
+void PublishRing::ignore(PublishCursor &cursor)
+{
+  cursor.next = _head;
+}
@@ -0,0 +1,78 @@
+#ifndef _OPENEVSE_PUBLISH_RING_H
+#define _OPENEVSE_PUBLISH_RING_H
+
+// Snapshots of the EVSE data waiting to be published.
+//
+// Each data update from the EVSE is serialized once into the next slot of
+// a fixed ring, overwriting the oldest. Every sink (WebSocket, MQTT,
+// emoncms, ...) keeps its own cursor into the ring and reads at its own
+// pace, so a slow sink never holds up the EVSE side or the other sinks.
+// Instead it loses the snapshots that were overwritten before it got to
+// them, and those are counted.
+//
+// A sink with an interval only takes the latest snapshot once the interval
+// has passed, the ones in between are counted as skipped rather than
+// dropped.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef PUBLISH_RING_SLOTS
+#define PUBLISH_RING_SLOTS 4
+#endif
+
+#ifndef PUBLISH_RING_SLOT_SIZE
+#define PUBLISH_RING_SLOT_SIZE 1536
+#endif
+
+struct PublishCursor
+{
+  uint32_t next;      // sequence number of the next snapshot to read
+  uint32_t last;      // ms, when one was last read
+  uint32_t interval;  // ms, 0 for every snapshot
+  uint32_t sent;
+  uint32_t skipped;   // passed over to keep to the interval
+  uint32_t dropped;   // lost before the sink could take them
+
+  PublishCursor(uint32_t interval = 0);
+};
+
+class PublishRing
+{
+  public:
+    PublishRing();
+
+    // The slot the next snapshot is written to, PUBLISH_RING_SLOT_SIZE bytes
+    char *slot() { return _slots[_head % PUBLISH_RING_SLOTS]; }
+    // Publish what was written to slot(). A snapshot of len 0 or that did
+    // not fit is not published, only counted.
+    bool commit(size_t len);
+
+    // The snapshot the sink should publish now, nullptr if there is nothing
+    // new or its interval has not passed. Call consumed() once published.
+    const char *next(PublishCursor &cursor, uint32_t now, size_t &len);
+    void consumed(PublishCursor &cursor, uint32_t now);
+
+    // Pass over everything waiting, counted as dropped. For sinks that can
+    // not take anything at the moment, eg not connected.
+    void discard(PublishCursor &cursor);
+    // Pass over everything waiting without counting it. For sinks that are
+    // turned off, so nothing was lost.
+    void ignore(PublishCursor &cursor);
+
+    uint32_t head() const { return _head; }
+    uint32_t oversize() const { return _oversize; }
+
+  private:
+    void catchUp(PublishCursor &cursor);
+
+    char _slots[PUBLISH_RING_SLOTS][PUBLISH_RING_SLOT_SIZE];
+    size_t _len[PUBLISH_RING_SLOTS];
+    uint32_t _head;     // sequence number of the next snapshot
+    uint32_t _count;    // snapshots held, up to PUBLISH_RING_SLOTS
+    uint32_t _oversize;
+};
+
+#endif // _OPENEVSE_PUBLISH_RING_H
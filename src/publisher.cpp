@@ -0,0 +1,143 @@
+#if defined(ENABLE_DEBUG) && !defined(ENABLE_DEBUG_PUBLISHER)
+#undef ENABLE_DEBUG
+#endif
+
+#include <Arduino.h>
+
+#include "emonesp.h"
+#include "publisher.h"
+#include "app_config.h"
+#include "web_server.h"
+#include "mqtt.h"
+#include "emoncms.h"
+#include "tesla_client.h"
+#include "evse_man.h"
+#include "pooled_json.h"
+#include "profile.h"
+
+// Room to parse a snapshot back into, the strings are copied as the
+// snapshot is shared between the sinks
+#define PUBLISHER_DOCUMENT_SIZE 4096
+
+Publisher publisher;
+
+Publisher::Publisher() :
+  _ring(),
+  _ws(),
+  _mqtt(),
+  _emoncms(),
+  _energy_meter()
+{
+}
+
+void Publisher::begin()
+{
+  setMqttInterval(mqtt_publish_interval);
+}
+
+void Publisher::setMqttInterval(uint32_t interval)
+{
+  _mqtt.interval = interval * 1000;
+}
+
+bool Publisher::snapshot(JsonDocument &data)
+{
+  size_t len = measureJson(data);
+  if(len < PUBLISH_RING_SLOT_SIZE) {
+    serializeJson(data, _ring.slot(), PUBLISH_RING_SLOT_SIZE);
+  } else {
+    DBUGF("EVSE data too big to publish: %u", len);
+  }
+
+  // Counted as oversize if it did not fit
+  return _ring.commit(len);
+}
+
+void Publisher::loop()
+{
+  uint32_t now = millis();
+
+  Profile_Start(Publisher_ws);
+  publishWs(now);
+  Profile_End(Publisher_ws, 5);
+
+  Profile_Start(Publisher_mqtt);
+  publishMqtt(now);
+  Profile_End(Publisher_mqtt, 10);
+
+  Profile_Start(Publisher_emoncms);
+  publishEmonCms(now);
+  Profile_End(Publisher_emoncms, 5);
+
+  Profile_Start(Publisher_energy_meter);
+  publishEnergyMeter(now);
+  Profile_End(Publisher_energy_meter, 10);
+}
+
+void Publisher::publishWs(uint32_t now)
+{
+  size_t len;
+  const char *json = _ring.next(_ws, now, len);
+  if(json)
+  {
+    DBUGLN(json);
+    web_server_event(json, len);
+    _ring.consumed(_ws, now);
+  }
+}
+
+void Publisher::publishMqtt(uint32_t now)
+{
+  if(!config_mqtt_enabled()) {
+    // Turned off, not lost
+    _ring.ignore(_mqtt);
+    return;
+  }
+
+  if(!mqtt.isConnected()) {
+    // Nothing to send it to, the latest will go when (re)connected
+    _ring.discard(_mqtt);
+    return;
+  }
+
+  size_t len;
+  const char *json = _ring.next(_mqtt, now, len);
+  if(json)
+  {
+    PooledJsonDocument data(PUBLISHER_DOCUMENT_SIZE);
+    if(DeserializationError::Ok == deserializeJson(data, json, len)) {
+      mqtt.publishData(data);
+    }
+    _ring.consumed(_mqtt, now);
+  }
+}
+
+void Publisher::publishEmonCms(uint32_t now)
+{
+  size_t len;
+  const char *json = _ring.next(_emoncms, now, len);
+  if(json)
+  {
+    PooledJsonDocument data(PUBLISHER_DOCUMENT_SIZE);
+    if(DeserializationError::Ok == deserializeJson(data, json, len))
+    {
+      // Only wanted by emoncms, the Tesla client events it to the others
+      teslaClient.getChargeInfoJson(data);
+      emoncms_publish(data);
+    }
+    _ring.consumed(_emoncms, now);
+  }
+}
+
+void Publisher::publishEnergyMeter(uint32_t now)
+{
+  size_t len;
+  if(_ring.next(_energy_meter, now, len))
+  {
+    // While charging the energy meter publishes as it updates
+    if(!evse.isCharging()) {
+      evse.publishEnergyMeter();
+    }
+    _ring.consumed(_energy_meter, now);
+  }
+}
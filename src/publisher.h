@@ -0,0 +1,52 @@
+#ifndef _OPENEVSE_PUBLISHER_H
+#define _OPENEVSE_PUBLISHER_H
+
+// -------------------------------------------------------------------
+// Publishes the EVSE data to the WebSocket clients, MQTT, emoncms and the
+// energy meter topics.
+//
+// The data-ready handler only takes a snapshot, see publish_ring.h. The
+// sinks are run from the network side of the main loop, each taking at
+// most one snapshot per pass, so a slow broker or a busy WebSocket no
+// longer holds up the EVSE control.
+// -------------------------------------------------------------------
+
+#include <ArduinoJson.h>
+
+#include "publish_ring.h"
+
+class Publisher
+{
+  private:
+    PublishRing _ring;
+    PublishCursor _ws;
+    PublishCursor _mqtt;
+    PublishCursor _emoncms;
+    PublishCursor _energy_meter;
+
+    void publishWs(uint32_t now);
+    void publishMqtt(uint32_t now);
+    void publishEmonCms(uint32_t now);
+    void publishEnergyMeter(uint32_t now);
+
+  public:
+    Publisher();
+
+    void begin();
+    void loop();
+
+    // Queue the EVSE data for the sinks, false if it could not be
+    bool snapshot(JsonDocument &data);
+
+    // Seconds, 0 to publish every update to MQTT
+    void setMqttInterval(uint32_t interval);
+
+    const PublishCursor &ws() const { return _ws; }
+    const PublishCursor &mqtt() const { return _mqtt; }
+    const PublishCursor &emoncms() const { return _emoncms; }
+    const PublishRing &ring() const { return _ring; }
+};
+
+extern Publisher publisher;
+
+#endif // _OPENEVSE_PUBLISHER_H
@@ -10,6 +10,7 @@
 #include "rfid.h"
 
 #include "debug.h"
+#include "profile.h"
 #include "mqtt.h"
 #include "lcd.h"
 #include "app_config.h"
@@ -90,6 +91,7 @@ void RfidTask::scanCard(String& uid){
 }
 
 unsigned long RfidTask::loop(MicroTasks::WakeReason reason){
+    Profile_Scope("RfidTask");
 
     if (_evse->isVehicleConnected() && !vehicleConnected) {
         vehicleConnected = _evse->isVehicleConnected();
@@ -218,6 +218,7 @@ void Scheduler::setup()
 
 unsigned long Scheduler::loop(MicroTasks::WakeReason reason)
 {
+  Profile_Scope("Scheduler");
   DBUG("Scheduler woke: ");
   DBUGLN(WakeReason_Scheduled == reason ? "WakeReason_Scheduled" :
          WakeReason_Event == reason ? "WakeReason_Event" :
@@ -831,7 +832,7 @@ bool Scheduler::serialize(Stream &stream)
   return false;
 }
 
-bool Scheduler::serialize(DynamicJsonDocument &doc)
+bool Scheduler::serialize(JsonDocument &doc)
 {
   doc.to<JsonArray>();
 
@@ -865,7 +866,7 @@ bool Scheduler::serialize(String& json, uint32_t event)
   return false;
 }
 
-bool Scheduler::serialize(DynamicJsonDocument &doc, uint32_t event)
+bool Scheduler::serialize(JsonDocument &doc, uint32_t event)
 {
   JsonObject object = doc.to<JsonObject>();
   return serialize(object, event);
@@ -924,7 +925,7 @@ void Scheduler::serializeEventInstance(JsonObject &object, Scheduler::EventInsta
   object["duration"] = e->getDuration();
 }
 
-bool Scheduler::serializePlan(DynamicJsonDocument &doc)
+bool Scheduler::serializePlan(JsonDocument &doc)
 {
   JsonObject root = doc.to<JsonObject>();
 
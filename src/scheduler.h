@@ -321,14 +321,14 @@ class Scheduler : public MicroTasks::Task
     bool deserialize(JsonObject &obj, uint32_t event);
 
     bool serialize(String& json);
-    bool serialize(DynamicJsonDocument &doc);
+    bool serialize(JsonDocument &doc);
     bool serialize(Stream &stream);
 
     bool serialize(String& json, uint32_t event);
-    bool serialize(DynamicJsonDocument &doc, uint32_t event);
+    bool serialize(JsonDocument &doc, uint32_t event);
     bool serialize(JsonObject &obj, uint32_t event);
 
-    bool serializePlan(DynamicJsonDocument &doc);
+    bool serializePlan(JsonDocument &doc);
 
     // JSON document capacity sufficient to serialize the whole stored
     // schedule.  Scales with the event count: the per-event feature/limit
@@ -3,16 +3,18 @@
 
 #include <TFT_eSPI.h>
 #include <PNGdec.h>
-#include "evse_man.h"
+#include "display_model.h"
 #include "scheduler.h"
 #include "manual.h"
 
+// The screens draw from the LcdTask's DisplayState, captured once per EVSE
+// event, rather than asking EvseManager for each value
 class ScreenBase
 {
 public:
-  ScreenBase(TFT_eSPI &screen, EvseManager &evse, Scheduler &scheduler, ManualOverride &manual) :
+  ScreenBase(TFT_eSPI &screen, const DisplayState &state, Scheduler &scheduler, ManualOverride &manual) :
     _screen(screen),
-    _evse(evse),
+    _state(state),
     _scheduler(scheduler),
     _manual(manual),
     _full_update(true) {}
@@ -22,8 +24,10 @@ public:
   // Initialize the screen, called once when screen becomes active
   virtual void init() { _full_update = true; }
 
-  // Update/render the screen, returns milliseconds until next update
-  virtual unsigned long update() = 0;
+  // Update/render the screen, returns milliseconds until next update.
+  // changed holds the DISPLAY_CHANGED_* bits since the last update, only
+  // what they cover, and the clock, needs drawing again.
+  virtual unsigned long update(uint32_t changed) = 0;
 
   // Handle any user input events
   virtual void handleEvent(uint8_t event) {}
@@ -39,7 +43,7 @@ public:
 
 protected:
   TFT_eSPI &_screen;
-  EvseManager &_evse;
+  const DisplayState &_state;
   Scheduler &_scheduler;
   ManualOverride &_manual;
   bool _full_update;
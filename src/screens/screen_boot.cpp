@@ -8,7 +8,7 @@
 #include "screens/screen_boot.h"
 #include "lcd_common.h"
 
-unsigned long BootScreen::update()
+unsigned long BootScreen::update(uint32_t changed)
 {
   if(_full_update)
   {
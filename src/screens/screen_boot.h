@@ -12,8 +12,8 @@
 class BootScreen : public ScreenBase
 {
 public:
-  BootScreen(TFT_eSPI &screen, EvseManager &evse, Scheduler &scheduler, ManualOverride &manual) :
-    ScreenBase(screen, evse, scheduler, manual),
+  BootScreen(TFT_eSPI &screen, const DisplayState &state, Scheduler &scheduler, ManualOverride &manual) :
+    ScreenBase(screen, state, scheduler, manual),
     _boot_progress(0) {}
 
   void init() override {
@@ -21,7 +21,7 @@ public:
     _boot_progress = 0;
   }
 
-  unsigned long update() override;
+  unsigned long update(uint32_t changed) override;
 
   // Checks if boot is complete
   bool isBootComplete() const { return _boot_progress >= 300; }
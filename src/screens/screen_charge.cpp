@@ -34,7 +34,7 @@
 void ChargeScreen::init()
 {
   ScreenBase::init();
-  _previous_evse_state = _evse.getEvseState();
+  _previous_evse_state = _state.evse_state;
 }
 
 bool ChargeScreen::setWifiMode(bool client, bool connected)
@@ -48,28 +48,13 @@ bool ChargeScreen::setWifiMode(bool client, bool connected)
   return false;
 }
 
-unsigned long ChargeScreen::update()
+void ChargeScreen::drawStatus(uint8_t evse_state)
 {
-  uint8_t evse_state = _evse.getEvseState();
-
-  //redraw when going in or out of charging state to switch between pilot and power display
-  if ((evse_state == OPENEVSE_STATE_CHARGING || _previous_evse_state == OPENEVSE_STATE_CHARGING)
-      && evse_state != _previous_evse_state) {
-    _full_update = true;
-  }
-
-  if(_full_update)
-  {
-    _screen.fillRect(DISPLAY_AREA_X, DISPLAY_AREA_Y, DISPLAY_AREA_WIDTH, DISPLAY_AREA_HEIGHT, TFT_OPENEVSE_BACK);
-    _screen.fillSmoothRoundRect(WHITE_AREA_X, WHITE_AREA_Y, WHITE_AREA_WIDTH, WHITE_AREA_HEIGHT, 6, TFT_WHITE);
-    render_image("/button_bar.png", BUTTON_BAR_X, BUTTON_BAR_Y, _screen);
-  }
-
   String status_icon = "/disabled.png";
   String car_icon = "/car_disconnected.png";
   String wifi_icon = "/no_wifi.png";
 
-  if(_evse.isVehicleConnected()) {
+  if(_state.vehicle_connected) {
     car_icon = "/car_connected.png";
   }
 
@@ -130,7 +115,7 @@ unsigned long ChargeScreen::update()
   render_image(wifi_icon.c_str(), 16, 132, _screen);
 
   if (evse_state == OPENEVSE_STATE_CHARGING) {
-    float power = _evse.getPower() / 1000.0;  //kW
+    float power = _state.power / 1000.0;  //kW
     if (power < 10) {
       snprintf(buffer, sizeof(buffer), "%.2f", power);
     } else if (power < 100) {
@@ -141,22 +126,22 @@ unsigned long ChargeScreen::update()
     render_left_text_box(buffer, 66, 157, 188, &FreeSans24pt7b, TFT_BLACK, TFT_WHITE, !_full_update, 2, _screen);
     render_left_text_box("kW", 224, 165, 34, &FreeSans9pt7b, TFT_BLACK, TFT_WHITE, false, 1, _screen);
   } else {
-    snprintf(buffer, sizeof(buffer), "%d", _evse.getChargeCurrent());
+    snprintf(buffer, sizeof(buffer), "%ld", _state.charge_current);
     render_right_text_box(buffer, 66, 175, 154, &FreeSans24pt7b, TFT_BLACK, TFT_WHITE, !_full_update, 2, _screen);
     if (_full_update) {
       render_left_text_box("A", 224, 165, 34, &FreeSans24pt7b, TFT_BLACK, TFT_WHITE, false, 1, _screen);
     }
   }
-  if (_evse.isTemperatureValid(EVSE_MONITOR_TEMP_MONITOR)) {
-    snprintf(buffer, sizeof(buffer), "%.1fC", _evse.getTemperature(EVSE_MONITOR_TEMP_MONITOR));
+  if (_state.temperature_valid) {
+    snprintf(buffer, sizeof(buffer), "%.1fC", _state.temperature);
     render_right_text_box(buffer, 415, 30, 50, &FreeSans9pt7b, TFT_WHITE, TFT_OPENEVSE_BACK, false, 1, _screen);
   }
 
-  snprintf(buffer, sizeof(buffer), "%.1f V  %.2f A", _evse.getVoltage(), _evse.getAmps());
+  snprintf(buffer, sizeof(buffer), "%.1f V  %.2f A", _state.voltage, _state.amps);
   if (evse_state == OPENEVSE_STATE_CHARGING) {
-    snprintf(buffer2, sizeof(buffer2), "Pilot: %dA", _evse.getChargeCurrent());
+    snprintf(buffer2, sizeof(buffer2), "Pilot: %ldA", _state.charge_current);
   } else {
-    get_scaled_number_value(_evse.getPower(), 2, "W", buffer2, sizeof(buffer2));
+    get_scaled_number_value(_state.power, 2, "W", buffer2, sizeof(buffer2));
   }
   render_data_box(buffer2, buffer, 66, 175, INFO_BOX_WIDTH, INFO_BOX_HEIGHT, _full_update, _screen);
 
@@ -169,16 +154,40 @@ unsigned long ChargeScreen::update()
   line = get_message_line(1);
   render_centered_text_box(line.c_str(), INFO_BOX_X, 96, INFO_BOX_WIDTH, &FreeSans9pt7b, TFT_OPENEVSE_TEXT, TFT_WHITE, !_full_update, 1, _screen);
 
-  uint32_t elapsed = _evse.getSessionElapsed();
+  uint32_t elapsed = _state.session_elapsed;
   uint32_t hours = elapsed / 3600;
   uint32_t minutes = (elapsed % 3600) / 60;
   uint32_t seconds = elapsed % 60;
   snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", hours, minutes, seconds);
   render_info_box("ELAPSED", buffer, INFO_BOX_X, 110, INFO_BOX_WIDTH, INFO_BOX_HEIGHT, _full_update, _screen);
 
-  get_scaled_number_value(_evse.getSessionEnergy(), 0, "Wh", buffer, sizeof(buffer));
+  get_scaled_number_value(_state.session_energy, 0, "Wh", buffer, sizeof(buffer));
   render_info_box("DELIVERED", buffer, INFO_BOX_X, 175, INFO_BOX_WIDTH, INFO_BOX_HEIGHT, _full_update, _screen);
+}
+
+unsigned long ChargeScreen::update(uint32_t changed)
+{
+  uint8_t evse_state = _state.evse_state;
+
+  //redraw when going in or out of charging state to switch between pilot and power display
+  if ((evse_state == OPENEVSE_STATE_CHARGING || _previous_evse_state == OPENEVSE_STATE_CHARGING)
+      && evse_state != _previous_evse_state) {
+    _full_update = true;
+  }
+
+  if(_full_update)
+  {
+    _screen.fillRect(DISPLAY_AREA_X, DISPLAY_AREA_Y, DISPLAY_AREA_WIDTH, DISPLAY_AREA_HEIGHT, TFT_OPENEVSE_BACK);
+    _screen.fillSmoothRoundRect(WHITE_AREA_X, WHITE_AREA_Y, WHITE_AREA_WIDTH, WHITE_AREA_HEIGHT, 6, TFT_WHITE);
+    render_image("/button_bar.png", BUTTON_BAR_X, BUTTON_BAR_Y, _screen);
+  }
+
+  // Only the clock moves between model changes
+  if(_full_update || 0 != changed) {
+    drawStatus(evse_state);
+  }
 
+  char buffer[32];
   timeval local_time;
   gettimeofday(&local_time, NULL);
   struct tm timeinfo;
@@ -7,17 +7,19 @@
 class ChargeScreen : public ScreenBase
 {
 public:
-  ChargeScreen(TFT_eSPI &screen, EvseManager &evse, Scheduler &scheduler, ManualOverride &manual) :
-    ScreenBase(screen, evse, scheduler, manual),
+  ChargeScreen(TFT_eSPI &screen, const DisplayState &state, Scheduler &scheduler, ManualOverride &manual) :
+    ScreenBase(screen, state, scheduler, manual),
     _previous_evse_state(0),
     wifi_client(false),
     wifi_connected(false) {}
 
   void init() override;
-  unsigned long update() override;
+  unsigned long update(uint32_t changed) override;
   bool setWifiMode(bool client, bool connected);
 
 private:
+  void drawStatus(uint8_t evse_state);
+
   uint8_t _previous_evse_state;
   bool wifi_client;
   bool wifi_connected;
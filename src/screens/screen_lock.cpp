@@ -15,8 +15,8 @@
 #define LOCK_MESSAGE_X          ((TFT_SCREEN_WIDTH - LOCK_MESSAGE_WIDTH) / 2)
 #define LOCK_MESSAGE_Y          200
 
-LockScreen::LockScreen(TFT_eSPI &screen, EvseManager &evse, Scheduler &scheduler, ManualOverride &manual) :
-  ScreenBase(screen, evse, scheduler, manual),
+LockScreen::LockScreen(TFT_eSPI &screen, const DisplayState &state, Scheduler &scheduler, ManualOverride &manual) :
+  ScreenBase(screen, state, scheduler, manual),
   _lockMessage(LOCK_SCREEN_MESSAGE)
 {
 }
@@ -26,7 +26,7 @@ void LockScreen::init()
   ScreenBase::init();
 }
 
-unsigned long LockScreen::update()
+unsigned long LockScreen::update(uint32_t changed)
 {
   if (_full_update)
   {
@@ -68,8 +68,9 @@ unsigned long LockScreen::update()
 
   _full_update = false;
 
-  // Update every second to keep the time current
-  return 1000;
+  // Nothing else here changes, wake on the next whole second for the clock
+  gettimeofday(&local_time, NULL);
+  return 1000 - local_time.tv_usec / 1000;
 }
 
 #endif // ENABLE_SCREEN_LCD_TFT
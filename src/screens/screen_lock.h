@@ -7,11 +7,11 @@
 class LockScreen : public ScreenBase
 {
 public:
-  LockScreen(TFT_eSPI &screen, EvseManager &evse, Scheduler &scheduler, ManualOverride &manual);
+  LockScreen(TFT_eSPI &screen, const DisplayState &state, Scheduler &scheduler, ManualOverride &manual);
   ~LockScreen() = default;
 
   void init() override;
-  unsigned long update() override;
+  unsigned long update(uint32_t changed) override;
 
   // Set the lock message to display
   void setLockMessage(const char* message) { _lockMessage = message; }
@@ -11,9 +11,9 @@
 #include "screens/screen_lock.h"
 #include "lcd_common.h"
 
-ScreenManager::ScreenManager(TFT_eSPI &screen, EvseManager &evse, Scheduler &scheduler, ManualOverride &manual) :
+ScreenManager::ScreenManager(TFT_eSPI &screen, const DisplayState &state, Scheduler &scheduler, ManualOverride &manual) :
   _screen(screen),
-  _evse(evse),
+  _state(state),
   _scheduler(scheduler),
   _manual(manual),
   _current_screen(SCREEN_BOOT)
@@ -45,9 +45,9 @@ ScreenManager::~ScreenManager()
 
 void ScreenManager::initializeScreens()
 {
-  _screens[SCREEN_BOOT] = new BootScreen(_screen, _evse, _scheduler, _manual);
-  _screens[SCREEN_CHARGE] = new ChargeScreen(_screen, _evse, _scheduler, _manual);
-  _screens[SCREEN_LOCK] = new LockScreen(_screen, _evse, _scheduler, _manual);
+  _screens[SCREEN_BOOT] = new BootScreen(_screen, _state, _scheduler, _manual);
+  _screens[SCREEN_CHARGE] = new ChargeScreen(_screen, _state, _scheduler, _manual);
+  _screens[SCREEN_LOCK] = new LockScreen(_screen, _state, _scheduler, _manual);
   // Initialize additional screens as needed
 }
 
@@ -64,7 +64,7 @@ void ScreenManager::setScreen(ScreenType screen)
   }
 }
 
-unsigned long ScreenManager::update()
+unsigned long ScreenManager::update(uint32_t changed)
 {
   unsigned long nextUpdate = 1000; // Default to 1 second
 
@@ -81,12 +81,12 @@ unsigned long ScreenManager::update()
   // Check if EVSE has entered or exited the active state
 
   // If EVSE is not active and we're not on the lock screen, switch to it
-  if (!_evse.isActive() && _current_screen != SCREEN_LOCK && _current_screen != SCREEN_BOOT) {
+  if (!_state.active && _current_screen != SCREEN_LOCK && _current_screen != SCREEN_BOOT) {
     DBUGF("EVSE not active, switching to lock screen");
     setScreen(SCREEN_LOCK);
   }
   // If EVSE is active again and we're on the lock screen, switch back to charge screen
-  else if (_evse.isActive() && _current_screen == SCREEN_LOCK) {
+  else if (_state.active && _current_screen == SCREEN_LOCK) {
     DBUGF("EVSE active, switching back to charge screen");
     setScreen(SCREEN_CHARGE);
   }
@@ -94,12 +94,12 @@ unsigned long ScreenManager::update()
 
   // Update the current screen
   if (_screens[_current_screen]) {
-    nextUpdate = _screens[_current_screen]->update();
+    nextUpdate = _screens[_current_screen]->update(changed);
   }
 
 #ifdef TFT_BACKLIGHT_TIMEOUT_MS
-  bool vehicle_state = _evse.isVehicleConnected();
-  uint8_t evse_state = _evse.getEvseState();
+  bool vehicle_state = _state.vehicle_connected;
+  uint8_t evse_state = _state.evse_state;
 
   if (_previous_evse_state != evse_state || _previous_vehicle_state != vehicle_state) {
     wakeBacklight();
@@ -120,7 +120,7 @@ void ScreenManager::handleEvent(uint8_t event)
   }
 }
 
-void ScreenManager::setWifiMode(bool client, bool connected)
+bool ScreenManager::setWifiMode(bool client, bool connected)
 {
   // Currently only the charge screen needs to know about WiFi mode
   ChargeScreen* chargeScreen = static_cast<ChargeScreen*>(_screens[SCREEN_CHARGE]);
@@ -130,8 +130,11 @@ void ScreenManager::setWifiMode(bool client, bool connected)
       #ifdef TFT_BACKLIGHT_TIMEOUT_MS
       wakeBacklight();
       #endif //TFT_BACKLIGHT_TIMEOUT_MS
+      return true;
     }
   }
+
+  return false;
 }
 
 // Add backlight management implementations
@@ -157,8 +160,8 @@ void ScreenManager::updateBacklight()
   DBUGF("Backlight timeout in %lu ms", _backlight_timeout - millis());
 
   bool timeout = true;
-  if (_evse.isVehicleConnected()) {
-    switch (_evse.getEvseState()) {
+  if (_state.vehicle_connected) {
+    switch (_state.evse_state) {
       case OPENEVSE_STATE_STARTING:
       case OPENEVSE_STATE_VENT_REQUIRED:
       case OPENEVSE_STATE_DIODE_CHECK_FAILED:
@@ -178,7 +181,7 @@ void ScreenManager::updateBacklight()
         break;
       case OPENEVSE_STATE_CHARGING:
 #ifdef TFT_BACKLIGHT_CHARGING_THRESHOLD
-        if (_evse.getAmps() >= TFT_BACKLIGHT_CHARGING_THRESHOLD) {
+        if (_state.amps >= TFT_BACKLIGHT_CHARGING_THRESHOLD) {
           wakeBacklight();
           timeout = false;
         }
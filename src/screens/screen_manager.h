@@ -15,7 +15,7 @@ enum ScreenType {
 
 class ScreenManager {
 public:
-  ScreenManager(TFT_eSPI &screen, EvseManager &evse, Scheduler &scheduler, ManualOverride &manual);
+  ScreenManager(TFT_eSPI &screen, const DisplayState &state, Scheduler &scheduler, ManualOverride &manual);
   ~ScreenManager();
 
   // Set the active screen
@@ -24,14 +24,15 @@ public:
   // Get the current active screen
   ScreenType getCurrentScreen() const { return _current_screen; }
 
-  // Update the current screen, returns time until next update
-  unsigned long update();
+  // Update the current screen with the DISPLAY_CHANGED_* bits since the
+  // last update, returns time until next update
+  unsigned long update(uint32_t changed);
 
   // Handle events (button presses, etc)
   void handleEvent(uint8_t event);
 
-  // Set WiFi mode on the charge screen
-  void setWifiMode(bool client, bool connected);
+  // Set WiFi mode on the charge screen, true if it changed
+  bool setWifiMode(bool client, bool connected);
 
 #ifdef TFT_BACKLIGHT_TIMEOUT_MS
   void wakeBacklight();
@@ -41,7 +42,7 @@ public:
 
 private:
   TFT_eSPI &_screen;
-  EvseManager &_evse;
+  const DisplayState &_state;
   Scheduler &_scheduler;
   ManualOverride &_manual;
 
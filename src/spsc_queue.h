@@ -0,0 +1,118 @@
+#ifndef _OPENEVSE_SPSC_QUEUE_H
+#define _OPENEVSE_SPSC_QUEUE_H
+
+// Fixed size, lock-free queue for one producer and one consumer thread.
+//
+// push() is only ever called from the producer and pop() from the consumer,
+// each side owns one index and only reads the other, so no lock is needed.
+// Holds up to SIZE - 1 items, one slot is kept free to tell full from empty.
+// Large items can be built and read in place with back()/commit() and
+// front()/release() rather than copied in and out.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+
+#include <stddef.h>
+#include <atomic>
+
+template <typename T, size_t SIZE>
+class SpscQueue
+{
+  static_assert(SIZE >= 2, "SpscQueue needs at least two slots");
+
+  private:
+    T _items[SIZE];
+    std::atomic<size_t> _head;  // next slot to pop, written by the consumer
+    std::atomic<size_t> _tail;  // next slot to push, written by the producer
+    std::atomic<size_t> _dropped;
+
+    static size_t next(size_t index) {
+      return index + 1 == SIZE ? 0 : index + 1;
+    }
+
+  public:
+    SpscQueue() : _items(), _head(0), _tail(0), _dropped(0) {
+    }
+
+    // Producer only, false (and counted as dropped) if the queue is full
+    bool push(const T &item)
+    {
+      size_t tail = _tail.load(std::memory_order_relaxed);
+      size_t following = next(tail);
+      if(following == _head.load(std::memory_order_acquire)) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+
+      _items[tail] = item;
+      _tail.store(following, std::memory_order_release);
+      return true;
+    }
+
+    // Consumer only, false if the queue is empty
+    bool pop(T &item)
+    {
+      size_t head = _head.load(std::memory_order_relaxed);
+      if(head == _tail.load(std::memory_order_acquire)) {
+        return false;
+      }
+
+      item = _items[head];
+      _head.store(next(head), std::memory_order_release);
+      return true;
+    }
+
+    // Producer only, the free slot to fill in place before commit(),
+    // nullptr (and counted as dropped) if the queue is full
+    T *back()
+    {
+      size_t tail = _tail.load(std::memory_order_relaxed);
+      if(next(tail) == _head.load(std::memory_order_acquire)) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+      return &_items[tail];
+    }
+
+    // Producer only, queue the slot from back()
+    void commit() {
+      _tail.store(next(_tail.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    // Consumer only, the oldest item left in place until release(),
+    // nullptr if the queue is empty
+    T *front()
+    {
+      size_t head = _head.load(std::memory_order_relaxed);
+      if(head == _tail.load(std::memory_order_acquire)) {
+        return nullptr;
+      }
+      return &_items[head];
+    }
+
+    // Consumer only, free the slot from front()
+    void release() {
+      _head.store(next(_head.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    // Either side, a snapshot that may be out of date by the time it is used
+    bool empty() const {
+      return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    size_t size() const
+    {
+      size_t head = _head.load(std::memory_order_acquire);
+      size_t tail = _tail.load(std::memory_order_acquire);
+      return tail >= head ? tail - head : SIZE - head + tail;
+    }
+
+    static constexpr size_t capacity() {
+      return SIZE - 1;
+    }
+
+    size_t dropped() const {
+      return _dropped.load(std::memory_order_relaxed);
+    }
+};
+
+#endif // _OPENEVSE_SPSC_QUEUE_H
@@ -0,0 +1,172 @@
+#include "status_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// FNV-1a, plenty to tell successive snapshots apart
+static uint32_t fnv1a(uint32_t hash, const char *data, size_t len)
+{
+  for(size_t i = 0; i < len; i++) {
+    hash ^= (uint8_t)data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// End of the JSON value starting at p: past a string, object or array, or
+// at the comma or brace that ends a number or literal
+static const char *valueEnd(const char *p, const char *end)
+{
+  int depth = 0;
+  bool inString = false;
+  for(; p < end; p++)
+  {
+    char c = *p;
+    if(inString) {
+      if('\\' == c) {
+        p++;
+      } else if('"' == c) {
+        inString = false;
+        if(0 == depth) {
+          return p + 1;
+        }
+      }
+    } else if('"' == c) {
+      inString = true;
+    } else if('{' == c || '[' == c) {
+      depth++;
+    } else if('}' == c || ']' == c) {
+      if(0 == depth) {
+        return p;
+      }
+      if(0 == --depth) {
+        return p + 1;
+      }
+    } else if(',' == c && 0 == depth) {
+      return p;
+    }
+  }
+  return end;
+}
+
+static bool isVolatile(const char *key, size_t len, const char *const *keys)
+{
+  for(; *keys; keys++) {
+    if(0 == strncmp(*keys, key, len) && '\0' == (*keys)[len]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Hash of a flat JSON object without the members named in `skip`
+static uint32_t contentHash(const std::string &json, const char *const *skip)
+{
+  uint32_t hash = 2166136261u;
+  const char *p = json.data();
+  const char *end = p + json.length();
+  if(nullptr == skip || p == end || '{' != *p) {
+    return fnv1a(hash, p, end - p);
+  }
+
+  hash = fnv1a(hash, p++, 1);
+  while(p < end && '"' == *p)
+  {
+    const char *keyEnd = valueEnd(p, end);
+    if(keyEnd >= end || ':' != *keyEnd) {
+      break;
+    }
+    const char *next = valueEnd(keyEnd + 1, end);
+    if(next < end && ',' == *next) {
+      next++;
+    }
+    if(!isVolatile(p + 1, keyEnd - p - 2, skip)) {
+      hash = fnv1a(hash, p, next - p);
+    }
+    p = next;
+  }
+  return fnv1a(hash, p, end - p);
+}
+
+bool StatusCache::valid(uint32_t now) const
+{
+  bool valid = _hasSnapshot &&
+               _builtGeneration == _generation &&
+               now - _built < STATUS_CACHE_MAX_AGE;
+  if(valid) {
+    _hits++;
+  }
+  return valid;
+}
+
+void StatusCache::update(std::string &json, uint32_t now)
+{
+  _json.swap(json);
+  _hash = contentHash(_json, _volatileKeys);
+  _builtGeneration = _generation;
+  _built = now;
+  _hasSnapshot = true;
+  _rebuilds++;
+}
+
+void StatusCache::etag(char out[STATUS_ETAG_SIZE]) const
+{
+  format(out, _hash);
+}
+
+void StatusCache::etag(char out[STATUS_ETAG_SIZE], const std::string &body) const
+{
+  format(out, contentHash(body, _volatileKeys));
+}
+
+void StatusCache::format(char out[STATUS_ETAG_SIZE], uint32_t hash) const
+{
+  snprintf(out, STATUS_ETAG_SIZE, _volatileKeys ? "W/\"%08x\"" : "\"%08x\"", (unsigned)hash);
+}
+
+bool StatusCache::etagMatches(const char *ifNoneMatch, const char *etag)
+{
+  if(NULL == ifNoneMatch || NULL == etag) {
+    return false;
+  }
+
+  if(0 == strncmp(etag, "W/", 2)) {
+    etag += 2;
+  }
+  size_t etagLen = strlen(etag);
+  const char *p = ifNoneMatch;
+  while(*p)
+  {
+    while(' ' == *p || '\t' == *p || ',' == *p) {
+      p++;
+    }
+    if('\0' == *p) {
+      break;
+    }
+
+    const char *end = strchr(p, ',');
+    if(NULL == end) {
+      end = p + strlen(p);
+    }
+    const char *last = end;
+    while(last > p && (' ' == last[-1] || '\t' == last[-1])) {
+      last--;
+    }
+
+    // Weak comparison, the opaque tags without any W/
+    if(0 == strncmp(p, "W/", 2)) {
+      p += 2;
+    }
+
+    size_t len = last - p;
+    if((1 == len && '*' == *p) ||
+       (len == etagLen && 0 == strncmp(p, etag, len)))
+    {
+      return true;
+    }
+
+    p = end;
+  }
+
+  return false;
+}
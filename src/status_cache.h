@@ -0,0 +1,87 @@
+#ifndef STATUS_CACHE_H
+#define STATUS_CACHE_H
+
+// -------------------------------------------------------------------
+// Serialized /status snapshot
+//
+// /status is rebuilt once the snapshot is older than STATUS_CACHE_MAX_AGE,
+// which bounds how stale anything it reports can get, or after a change made
+// through /status itself (invalidate()). Repeat polls are served from the
+// serialized copy, and the entity tag lets a poller skip the body entirely
+// with If-None-Match.
+//
+// Given a list of volatile keys, the values that change every second on
+// their own (clock, uptime, free heap, ...), the tag leaves them out so a
+// rebuild that only moved those is still a match. As the body may then
+// differ for the same tag it is a weak one, W/"...". Without a list the tag
+// is a strong one over the exact bytes served.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+// -------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#ifndef STATUS_CACHE_MAX_AGE
+#define STATUS_CACHE_MAX_AGE 1000
+#endif
+
+// ?fields= projection limits: request length and number of keys
+#ifndef STATUS_FIELDS_LEN
+#define STATUS_FIELDS_LEN 256
+#endif
+#ifndef STATUS_FIELDS_MAX
+#define STATUS_FIELDS_MAX 32
+#endif
+
+// W/ and a quoted 8 digit hex tag plus NUL
+#define STATUS_ETAG_SIZE 13
+
+class StatusCache
+{
+  public:
+    // volatileKeys, a nullptr terminated list of top level keys left out of
+    // the entity tag
+    explicit StatusCache(const char *const *volatileKeys = nullptr) :
+      _volatileKeys(volatileKeys) {}
+
+    // Changed through /status, rebuild now rather than when it ages out
+    void invalidate() { _generation++; }
+    uint32_t generation() const { return _generation; }
+
+    // True if the snapshot can be served as is at `now` (ms)
+    bool valid(uint32_t now) const;
+    // Store a freshly built snapshot, takes the contents of json
+    void update(std::string &json, uint32_t now);
+
+    const std::string &json() const { return _json; }
+
+    // Entity tag of the snapshot. Only changes when the content, other than
+    // the volatile keys, does.
+    void etag(char out[STATUS_ETAG_SIZE]) const;
+    // Entity tag of another body served from it, such as a ?fields= projection
+    void etag(char out[STATUS_ETAG_SIZE], const std::string &body) const;
+
+    // RFC 7232 If-None-Match: a comma separated list of (possibly weak) tags,
+    // or *, compared weakly as GET allows
+    static bool etagMatches(const char *ifNoneMatch, const char *etag);
+
+    uint32_t hits() const { return _hits; }
+    uint32_t rebuilds() const { return _rebuilds; }
+
+  private:
+    void format(char out[STATUS_ETAG_SIZE], uint32_t hash) const;
+
+    const char *const *_volatileKeys;
+    std::string _json;
+    uint32_t _hash = 0;
+    uint32_t _generation = 0;
+    uint32_t _builtGeneration = 0;
+    uint32_t _built = 0;
+    bool _hasSnapshot = false;
+    mutable uint32_t _hits = 0;
+    uint32_t _rebuilds = 0;
+};
+
+#endif // STATUS_CACHE_H
@@ -0,0 +1,150 @@
+#include <string.h>
+#include <new>
+
+#include "task_profiler.h"
+
+TaskProfiler profiler;
+
+// The running section, per thread as with ENABLE_DUAL_CORE the control and
+// network sides each have their own. Plain pointer so it needs no
+// constructor, which keeps it usable from the allocator hooks at any time.
+static thread_local ProfileEntry *current_entry = nullptr;
+
+void ProfileEntry::clearTimes()
+{
+  count = 0;
+  total_us = 0;
+  max_us = 0;
+  memset(histogram, 0, sizeof(histogram));
+}
+
+void ProfileEntry::clearHeap()
+{
+  allocs = 0;
+  alloc_bytes = 0;
+  frees = 0;
+  free_bytes = 0;
+}
+
+TaskProfiler::TaskProfiler() :
+  _entries(),
+  _count(0),
+  _since(0),
+  _heap_since(0)
+{
+}
+
+TaskProfiler::~TaskProfiler()
+{
+  for(size_t i = 0; i < _count; i++) {
+    delete _entries[i];
+  }
+}
+
+ProfileEntry *TaskProfiler::entry(const char *name)
+{
+  // Callers normally pass the same pointer every time
+  for(size_t i = 0; i < _count; i++) {
+    if(_entries[i]->name == name) {
+      return _entries[i];
+    }
+  }
+  for(size_t i = 0; i < _count; i++) {
+    if(0 == strcmp(_entries[i]->name, name)) {
+      return _entries[i];
+    }
+  }
+
+  if(_count >= PROFILE_MAX_ENTRIES) {
+    return nullptr;
+  }
+
+  ProfileEntry *entry = new (std::nothrow) ProfileEntry;
+  if(nullptr == entry) {
+    return nullptr;
+  }
+  entry->name = name;
+  entry->clearTimes();
+  entry->clearHeap();
+  _entries[_count++] = entry;
+  return entry;
+}
+
+void TaskProfiler::record(ProfileEntry *entry, uint32_t us)
+{
+  if(nullptr == entry) {
+    return;
+  }
+
+  entry->count++;
+  entry->total_us += us;
+  if(us > entry->max_us) {
+    entry->max_us = us;
+  }
+  entry->histogram[bucket(us)]++;
+}
+
+ProfileEntry *TaskProfiler::enter(ProfileEntry *entry)
+{
+  ProfileEntry *previous = current_entry;
+  current_entry = entry;
+  return previous;
+}
+
+void TaskProfiler::leave(ProfileEntry *previous)
+{
+  current_entry = previous;
+}
+
+ProfileEntry *TaskProfiler::current()
+{
+  return current_entry;
+}
+
+void TaskProfiler::recordAlloc(size_t bytes)
+{
+  ProfileEntry *entry = current_entry;
+  if(entry) {
+    entry->allocs++;
+    entry->alloc_bytes += bytes;
+  }
+}
+
+void TaskProfiler::recordFree(size_t bytes)
+{
+  ProfileEntry *entry = current_entry;
+  if(entry) {
+    entry->frees++;
+    entry->free_bytes += bytes;
+  }
+}
+
+void TaskProfiler::reset(uint32_t now)
+{
+  for(size_t i = 0; i < _count; i++) {
+    _entries[i]->clearTimes();
+  }
+  _since = now;
+}
+
+void TaskProfiler::resetHeap(uint32_t now)
+{
+  for(size_t i = 0; i < _count; i++) {
+    _entries[i]->clearHeap();
+  }
+  _heap_since = now;
+}
+
+uint8_t TaskProfiler::bucket(uint32_t us)
+{
+  uint8_t bucket = 0;
+  for(uint32_t start = PROFILE_BUCKET_MIN_US; us >= start && bucket < PROFILE_BUCKETS - 1; start <<= 1) {
+    bucket++;
+  }
+  return bucket;
+}
+
+uint32_t TaskProfiler::bucketStart(uint8_t bucket)
+{
+  return 0 == bucket ? 0 : PROFILE_BUCKET_MIN_US << (bucket - 1);
+}
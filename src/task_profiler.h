@@ -0,0 +1,105 @@
+#ifndef _OPENEVSE_TASK_PROFILER_H
+#define _OPENEVSE_TASK_PROFILER_H
+
+// -------------------------------------------------------------------
+// Run time statistics for the main loop
+//
+// Each named section (a MicroTask, an HTTP handler, Mongoose.poll, ...) gets
+// an entry, created the first time it runs, counting calls, total and
+// longest run time and a log2 histogram of run times. Always built in so a
+// stalled loop can be traced on production units, see /debug/profile.
+//
+// With ENABLE_HEAP_TRACKING the heap allocations and frees made while a
+// section runs are counted against it as well, see heap_monitor.h.
+//
+// Names must stay valid for the life of the profiler, string literals or
+// registered URIs. Not thread safe: with ENABLE_DUAL_CORE the sections run
+// under the dual core lock.
+//
+// No Arduino dependency so it can be unit-tested on the build host.
+// -------------------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef PROFILE_MAX_ENTRIES
+#define PROFILE_MAX_ENTRIES 96
+#endif
+
+// Histogram buckets, the first is anything under PROFILE_BUCKET_MIN_US,
+// then each doubles, the last is open ended (a little over 2s by default)
+#ifndef PROFILE_BUCKETS
+#define PROFILE_BUCKETS 20
+#endif
+
+#define PROFILE_BUCKET_MIN_US 8
+
+struct ProfileEntry
+{
+  const char *name;
+  uint32_t count;
+  uint64_t total_us;
+  uint32_t max_us;
+  uint32_t histogram[PROFILE_BUCKETS];
+
+  // Heap use while running, innermost section only
+  uint32_t allocs;
+  uint64_t alloc_bytes;
+  uint32_t frees;
+  uint64_t free_bytes;
+
+  void clearTimes();
+  void clearHeap();
+};
+
+class TaskProfiler
+{
+  public:
+    TaskProfiler();
+    ~TaskProfiler();
+
+    // The entry for name, added if new. nullptr once PROFILE_MAX_ENTRIES
+    // sections have been seen or if out of memory.
+    ProfileEntry *entry(const char *name);
+
+    static void record(ProfileEntry *entry, uint32_t us);
+    void record(const char *name, uint32_t us) {
+      record(entry(name), us);
+    }
+
+    // Make entry the section running on this thread, returns the one to
+    // restore with leave() when it ends
+    static ProfileEntry *enter(ProfileEntry *entry);
+    static void leave(ProfileEntry *previous);
+    static ProfileEntry *current();
+
+    // Count a heap allocation or free against the running section, if any
+    static void recordAlloc(size_t bytes);
+    static void recordFree(size_t bytes);
+
+    // Clear the run time statistics, keeps the entries. now is when the new
+    // period started, in ms.
+    void reset(uint32_t now);
+    uint32_t since() const { return _since; }
+
+    // Clear the heap statistics. now as for reset().
+    void resetHeap(uint32_t now);
+    uint32_t heapSince() const { return _heap_since; }
+
+    size_t count() const { return _count; }
+    const ProfileEntry *get(size_t index) const { return _entries[index]; }
+
+    // Bucket a run time falls in, and the lowest run time in a bucket
+    static uint8_t bucket(uint32_t us);
+    static uint32_t bucketStart(uint8_t bucket);
+
+  private:
+    ProfileEntry *_entries[PROFILE_MAX_ENTRIES];
+    size_t _count;
+    uint32_t _since;
+    uint32_t _heap_since;
+};
+
+extern TaskProfiler profiler;
+
+#endif // _OPENEVSE_TASK_PROFILER_H
@@ -2,12 +2,17 @@
 
 TempThrottleTask tempThrottle;
 
-TempThrottleTask::TempThrottleTask() : MicroTasks::Task() {
+TempThrottleTask::TempThrottleTask() :
+  MicroTasks::Task(),
+  _temperatureListener(this),
+  _stateListener(this)
+{
   _evse             = nullptr;
   _enabled          = false;
   _setpoint         = TEMP_THROTTLE_SETPOINT_DEFAULT;
   _start_current    = 0;
   _throttled_current = 0;
+  _last_step        = 0;
 }
 
 TempThrottleTask::~TempThrottleTask() {
@@ -19,8 +24,14 @@ TempThrottleTask::~TempThrottleTask() {
 void TempThrottleTask::setup() {}
 
 unsigned long TempThrottleTask::loop(MicroTasks::WakeReason reason) {
+  Profile_Scope("TempThrottleTask");
+
+  // These only wake the task, everything is looked at again below
+  _temperatureListener.IsTriggered();
+  _stateListener.IsTriggered();
+
   if (!_evse) {
-    return TEMP_THROTTLE_LOOP_TIME;
+    return MicroTask.Infinate;
   }
   if (!_enabled) {
     if (_evse->clientHasClaim(EvseClient_OpenEVSE_TempThrottle)) {
@@ -28,11 +39,19 @@ unsigned long TempThrottleTask::loop(MicroTasks::WakeReason reason) {
       _start_current    = 0;
       _throttled_current = 0;
     }
-    return TEMP_THROTTLE_LOOP_TIME;
+    return MicroTask.Infinate;
   }
 
   if (!_evse->isTemperatureValid(EVSE_MONITOR_TEMP_MONITOR)) {
-    return TEMP_THROTTLE_LOOP_TIME;
+    return MicroTask.Infinate;
+  }
+
+  // An event between steps does not hurry the next one
+  unsigned long since_step = millis() - _last_step;
+  if (_evse->clientHasClaim(EvseClient_OpenEVSE_TempThrottle) &&
+      since_step < TEMP_THROTTLE_LOOP_TIME)
+  {
+    return TEMP_THROTTLE_LOOP_TIME - since_step;
   }
 
   double temp = _evse->getTemperature(EVSE_MONITOR_TEMP_MONITOR);
@@ -41,11 +60,11 @@ unsigned long TempThrottleTask::loop(MicroTasks::WakeReason reason) {
     if (_start_current == 0) {
       // Only engage if actively charging
       if (!_evse->isCharging()) {
-        return TEMP_THROTTLE_LOOP_TIME;
+        return MicroTask.Infinate;
       }
       uint32_t pilot = (uint32_t)_evse->getChargeCurrent();
       if (pilot == 0) {
-        return TEMP_THROTTLE_LOOP_TIME;
+        return MicroTask.Infinate;
       }
       _start_current    = pilot;
       _throttled_current = pilot;
@@ -64,6 +83,7 @@ unsigned long TempThrottleTask::loop(MicroTasks::WakeReason reason) {
     EvseProperties props;
     props.setChargeCurrent(_throttled_current);
     _evse->claim(EvseClient_OpenEVSE_TempThrottle, EvseManager_Priority_Safety, props);
+    _last_step = millis();
 
   } else {
     // Temperature below setpoint — recover
@@ -77,13 +97,17 @@ unsigned long TempThrottleTask::loop(MicroTasks::WakeReason reason) {
         EvseProperties props;
         props.setChargeCurrent(_throttled_current);
         _evse->claim(EvseClient_OpenEVSE_TempThrottle, EvseManager_Priority_Safety, props);
+        _last_step = millis();
       } else {
         // Fully recovered — release claim entirely
         DBUGF("TempThrottle: fully recovered, releasing claim");
         _evse->release(EvseClient_OpenEVSE_TempThrottle);
         _start_current    = 0;
         _throttled_current = 0;
+        return MicroTask.Infinate;
       }
+    } else {
+      return MicroTask.Infinate;
     }
   }
 
@@ -95,6 +119,8 @@ void TempThrottleTask::begin(EvseManager &evse) {
   _enabled  = config_temp_throttle_enabled();
   _setpoint = temp_throttle_setpoint;
   MicroTask.startTask(this);
+  _evse->onTemperatureChanged(&_temperatureListener);
+  _evse->onStateChange(&_stateListener);
   DBUGF("TempThrottle: started, enabled=%d setpoint=%u°C", _enabled, _setpoint);
 }
 
@@ -108,6 +134,9 @@ void TempThrottleTask::notifyConfigChanged(bool enabled, uint32_t setpoint) {
     _start_current    = 0;
     _throttled_current = 0;
   }
+  if (_evse) {
+    MicroTask.wakeTask(this);
+  }
 }
 
 bool TempThrottleTask::isThrottling() {
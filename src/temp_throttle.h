@@ -1,6 +1,8 @@
 #ifndef _OPENEVSE_TEMP_THROTTLE_H
 #define _OPENEVSE_TEMP_THROTTLE_H
 
+// Time between 1 A steps while throttling or recovering. Otherwise the task
+// sleeps until the temperature, the EVSE state or the config changes.
 #ifndef TEMP_THROTTLE_LOOP_TIME
 #define TEMP_THROTTLE_LOOP_TIME 30000
 #endif
@@ -30,6 +32,9 @@ class TempThrottleTask : public MicroTasks::Task
     uint32_t     _setpoint;
     uint32_t     _start_current;    // current captured when throttle first engaged; 0 = not throttling
     uint32_t     _throttled_current;
+    uint32_t     _last_step;        // millis() of the last claim while throttling
+    MicroTasks::EventListener _temperatureListener;
+    MicroTasks::EventListener _stateListener;
 
   protected:
     void setup();
@@ -11,6 +11,7 @@
 #endif
 
 #include "debug.h"
+#include "profile.h"
 #include "time_man.h"
 #include "input.h"
 #include "net_manager.h"
@@ -161,6 +162,7 @@ void TimeManager::setup()
 
 unsigned long TimeManager::loop(MicroTasks::WakeReason reason)
 {
+Profile_Scope("TimeManager");
 #ifdef ENABLE_DEBUG
   DBUG("Time manager woke: ");
   DBUGLN(WakeReason_Scheduled == reason ? "WakeReason_Scheduled" :
@@ -4,29 +4,34 @@
 #include "esp_tsdb.h"
 #include "energy_logger.h"   // MonthlyMetrics, AnnualMetrics, serialize/deserialize
 #include "debug.h"
+#include "profile.h"
 #include <LittleFS.h>
 #include <time.h>
 
 TsdbEnergyLogger tsdbEnergyLogger;
 
+// Room for the tsdbs on the LittleFS partition, reserving room for the other
+// users (config, certs, schedule, emeter, JSON energy logs). On the 16 MB
+// build this is more than TSDB_ENERGY_BYTES; on a small partition (e.g. the
+// 4 MB build's 128 KB) it shrinks the ring so it can't fill the FS.
+static size_t fs_budget() {
+  const size_t reserve  = 384u * 1024u;  // headroom for everything else
+  size_t       fs_total = LittleFS.totalBytes();
+  return fs_total > reserve ? fs_total - reserve : fs_total / 4;
+}
+
 bool TsdbEnergyLogger::init_db() {
   tsdb_config_t cfg = {};
   cfg.filepath     = TSDB_ENERGY_FILE;
   cfg.num_params   = TSDB_NUM_COLS;
   cfg.param_names  = TSDB_PARAM_NAMES;
-  // Clamp the on-disk ring to the actual LittleFS partition, reserving room for
-  // the other users (config, certs, schedule, emeter, JSON energy logs). On the
-  // 16 MB build this leaves the full TSDB_ENERGY_BYTES; on a small partition
-  // (e.g. the 4 MB build's 128 KB) it shrinks the ring so it can't fill the FS.
+  // Clamp the on-disk ring to the actual LittleFS partition
   {
-    const size_t reserve   = 384u * 1024u;  // headroom for everything else
-    size_t       fs_total  = LittleFS.totalBytes();
-    size_t       fs_budget = fs_total > reserve ? fs_total - reserve : fs_total / 4;
-    size_t       budget    = TSDB_ENERGY_BYTES;
-    if(budget > fs_budget) {
-      budget = fs_budget;
+    size_t budget = TSDB_ENERGY_BYTES;
+    if(budget > fs_budget()) {
+      budget = fs_budget();
       DEBUG_PORT.printf("[tsdb] ring clamped to %u bytes for %u byte FS\n",
-                        (unsigned)budget, (unsigned)fs_total);
+                        (unsigned)budget, (unsigned)LittleFS.totalBytes());
     }
     cfg.max_records = TSDB_CALC_MAX_RECORDS(budget, TSDB_NUM_COLS);
   }
@@ -62,6 +67,7 @@ void TsdbEnergyLogger::begin(EvseManager &evse) { _evse = &evse; MicroTask.start
 
 void TsdbEnergyLogger::setup() {
   _ready = init_db();
+  if (_ready) init_rollups();
   _last_session_wh = _evse ? _evse->getSessionEnergy() : 0;
 
   // Seed rollover tracker to TODAY so the first real rollup fires at the next
@@ -251,6 +257,24 @@ void TsdbEnergyLogger::rollup_yesterday() {
 }
 
 unsigned long TsdbEnergyLogger::loop(MicroTasks::WakeReason) {
+  Profile_Scope("TsdbEnergyLogger");
+
+  // Woken early while the rollups catch up, only sample when due
+  unsigned long now_ms = millis();
+  if ((long)(now_ms - _next_sample) >= 0) {
+    _next_sample = now_ms + sample();
+  }
+
+  // Back soon while the rollups are catching up. Without a clock they
+  // cannot, so look again at the sample cadence.
+  if (_rollup_cursor != 0 && catch_up_rollups() && _rollup_cursor != 0) {
+    return TSDB_ROLLUP_CATCHUP_MS;
+  }
+
+  return _next_sample - now_ms;
+}
+
+unsigned long TsdbEnergyLogger::sample() {
   // Throttle to the idle cadence whenever we are not actively charging.
   unsigned long next_ms = TSDB_ENERGY_SAMPLE_MS;
   if (_ready && _evse) {
@@ -308,8 +332,167 @@ unsigned long TsdbEnergyLogger::loop(MicroTasks::WakeReason) {
       tsdb_scale_sample(s, row);
       esp_err_t e = tsdb_write((uint32_t)now, row);
       if (e != ESP_OK) DBUGF("tsdb_write failed: %d", e);
+      // Once caught up the rollups follow the samples as they are written
+      else if (_rollup_cursor == 0) rollup_sample((uint32_t)now, row);
     }
   }
   return next_ms;
 }
+
+// ---------------------------------------------------------------------------
+// Hourly/daily rollups
+//
+// Each raw sample is added to the hour and the local day it falls in; the
+// row for a period is written once the first sample of the next arrives.
+// Hours are whole hours of epoch time, the same as local hours except in
+// the few half-hour timezones.
+//
+// The periods in progress are only in RAM. At boot the rollups are caught
+// up from the raw ring, from the day after the newest day written (or the
+// oldest raw sample, first time), which rebuilds the partial day as well.
+// Periods already written are skipped rather than written again.
+// ---------------------------------------------------------------------------
+
+static uint32_t start_of_day(uint32_t ts) {
+  time_t t = (time_t)ts;
+  struct tm tm_buf;
+  localtime_r(&t, &tm_buf);
+  tm_buf.tm_hour = 0;
+  tm_buf.tm_min  = 0;
+  tm_buf.tm_sec  = 0;
+  return (uint32_t)mktime(&tm_buf);
+}
+
+static tsdb_t *open_rollup(const char *path, size_t bytes) {
+  // A slice of what the raw ring gets on a small partition, but always room
+  // for a few blocks past the 2 KB header
+  size_t budget = fs_budget() / 16;
+  if (budget < 8 * 1024) budget = 8 * 1024;
+  if (budget > bytes) budget = bytes;
+
+  tsdb_config_t cfg = {};
+  cfg.filepath     = path;
+  cfg.num_params   = ROLLUP_NUM_COLS;
+  cfg.param_names  = ROLLUP_PARAM_NAMES;
+  cfg.max_records  = TSDB_CALC_MAX_RECORDS(budget, ROLLUP_NUM_COLS);
+  cfg.index_stride = 380;
+  // Rows only arrive once an hour, the minimum pool (3 blocks plus stream)
+  cfg.buffer_pool_size = 4 * 1024;
+#if defined(CONFIG_IDF_TARGET_ESP32P4)
+  cfg.alloc_strategy = TSDB_ALLOC_PSRAM;
+#else
+  cfg.alloc_strategy = TSDB_ALLOC_INTERNAL_RAM;
+#endif
+  tsdb_t *db = tsdb_open(&cfg);
+  if (db == nullptr) {
+    DEBUG_PORT.printf("[tsdb] rollup open failed: %s\n", path);
+  }
+  return db;
+}
+
+// Start of the newest period in a rollup, 0 if empty
+static uint32_t newest_rollup(tsdb_t *db) {
+  tsdb_stats_t stats;
+  if (db == nullptr || tsdb_get_stats_h(db, &stats) != ESP_OK || stats.total_records == 0) {
+    return 0;
+  }
+  return stats.newest_timestamp;
+}
+
+void TsdbEnergyLogger::init_rollups() {
+  _hourly_db = open_rollup(TSDB_ROLLUP_HOURLY_FILE, TSDB_ROLLUP_HOURLY_BYTES);
+  _daily_db  = open_rollup(TSDB_ROLLUP_DAILY_FILE, TSDB_ROLLUP_DAILY_BYTES);
+  _hourly_last = newest_rollup(_hourly_db);
+  _daily_last  = newest_rollup(_daily_db);
+
+  tsdb_stats_t raw;
+  if (tsdb_get_stats(&raw) != ESP_OK || raw.total_records == 0) {
+    return;   // nothing to catch up on
+  }
+
+  uint32_t from = raw.oldest_timestamp;
+  if (_daily_last != 0) {
+    // 36h on from the start of a day is always into the next, DST or not
+    uint32_t next_day = start_of_day(_daily_last + 86400 + 43200);
+    if (next_day > from) from = next_day;
+  }
+  if (from <= raw.newest_timestamp) {
+    _rollup_cursor = from;
+    DBUGF("[tsdb rollup] catching up from %lu", (unsigned long)from);
+  }
+}
+
+void TsdbEnergyLogger::write_rollup(tsdb_t *db, const RollupPeriod &period, uint32_t &last) {
+  if (db == nullptr || period.start <= last) return;
+
+  int16_t row[ROLLUP_NUM_COLS];
+  period.toRow(row);
+  esp_err_t e = tsdb_write_h(db, period.start, row);
+  if (e != ESP_OK) {
+    DBUGF("[tsdb rollup] write failed: %d", e);
+    return;
+  }
+  last = period.start;
+  // Commit the file now and then, see tsdb_sync_h(), not for every row
+  // written while catching up
+  if (_rollup_cursor == 0) tsdb_sync_h(db);
+}
+
+void TsdbEnergyLogger::rollup_sample(uint32_t ts, const int16_t *row) {
+  // The clock has been set back, start the periods again from here
+  if (ts < _hourly.current().start || ts < _day_start) {
+    _hourly.reset();
+    _daily.reset();
+    _day_start = _day_end = 0;
+  }
+
+  if (ts >= _day_end) {
+    _day_start = start_of_day(ts);
+    _day_end   = start_of_day(_day_start + 86400 + 43200);
+  }
+
+  if (_hourly.add(ts - ts % 3600, ts, row)) {
+    write_rollup(_hourly_db, _hourly.completed(), _hourly_last);
+  }
+  if (_daily.add(_day_start, ts, row)) {
+    write_rollup(_daily_db, _daily.completed(), _daily_last);
+  }
+}
+
+bool TsdbEnergyLogger::catch_up_rollups() {
+  Profile_Start(TsdbRollupCatchUp);
+
+  // Until the clock is set there is no telling where the raw samples end
+  uint32_t now = (uint32_t)time(NULL);
+  if ((unsigned long)now < TSDB_TIME_VALID_FLOOR) {
+    Profile_End(TsdbRollupCatchUp, 50);
+    return false;
+  }
+
+  uint32_t end = _rollup_cursor + TSDB_ROLLUP_CATCHUP_SECS - 1;
+  bool caught_up = end >= now;
+  if (caught_up) end = now;
+
+  tsdb_query_t q;
+  if (end >= _rollup_cursor &&
+      tsdb_query_init(&q, _rollup_cursor, end, NULL, TSDB_NUM_COLS) == ESP_OK) {
+    uint32_t ts;
+    int16_t  v[TSDB_NUM_COLS];
+    while (tsdb_query_next(&q, &ts, v) == ESP_OK) {
+      rollup_sample(ts, v);
+    }
+    tsdb_query_close(&q);
+  }
+  _rollup_cursor = end + 1;
+
+  if (caught_up) {
+    _rollup_cursor = 0;
+    DBUGLN("[tsdb rollup] caught up");
+  }
+  if (_hourly_db) tsdb_sync_h(_hourly_db);
+  if (_daily_db) tsdb_sync_h(_daily_db);
+
+  Profile_End(TsdbRollupCatchUp, 50);
+  return true;
+}
 #endif
@@ -4,6 +4,9 @@
 #include <Arduino.h>
 #include <MicroTasks.h>
 #include "evse_man.h"
+#include "tsdb_rollup.h"
+
+struct tsdb_s;   // tsdb_t, esp_tsdb.h
 
 #define TSDB_ENERGY_FILE          "/littlefs/energy.tsdb"
 // Sample cadence and on-disk budget. Overridable via build flags so a debug
@@ -25,6 +28,23 @@
 // tsdb timestamp; writing a pre-NTP ~1970 epoch would corrupt the time index.
 #define TSDB_TIME_VALID_FLOOR     1700000000UL
 
+// Hourly and daily rollups (tsdb_rollup.h), each in a tsdb handle of its own.
+// Default budgets keep ~1 year of hours and ~5 years of days.
+#define TSDB_ROLLUP_HOURLY_FILE   "/littlefs/energy_hourly.tsdb"
+#define TSDB_ROLLUP_DAILY_FILE    "/littlefs/energy_daily.tsdb"
+#ifndef TSDB_ROLLUP_HOURLY_BYTES
+#define TSDB_ROLLUP_HOURLY_BYTES  (160UL * 1024UL)
+#endif
+#ifndef TSDB_ROLLUP_DAILY_BYTES
+#define TSDB_ROLLUP_DAILY_BYTES   (32UL * 1024UL)
+#endif
+// Rolling up the raw samples the rollups do not have yet (first boot after
+// an upgrade, or the partial day before a reboot) is done this much at a
+// time, every TSDB_ROLLUP_CATCHUP_MS, so it does not hold up the loop. Until
+// the clock is set it waits at the sample cadence instead.
+#define TSDB_ROLLUP_CATCHUP_SECS  (6UL * 3600UL)
+#define TSDB_ROLLUP_CATCHUP_MS    50
+
 // Monthly/annual rollups reuse the legacy on-disk paths/format
 // (ENERGY_LOGGER_MONTHLY_DIR / ENERGY_LOGGER_ANNUAL_FILE from energy_logger.h)
 // so the /energy/monthly + /energy/annual handlers just stream the files.
@@ -41,8 +61,27 @@ private:
   int          _last_rolled_yday = -1; // tm_yday of the last rollup
   int          _last_rolled_year = -1; // tm_year of the last rollup
 
+  // Rollups: _rollup_cursor is the next raw timestamp to roll up while
+  // catching up, 0 once samples are rolled up as they are written
+  tsdb_s      *_hourly_db = nullptr;
+  tsdb_s      *_daily_db  = nullptr;
+  RollupSeries _hourly { TSDB_ENERGY_SAMPLE_MS / 1000 };
+  RollupSeries _daily  { TSDB_ENERGY_SAMPLE_MS / 1000 };
+  uint32_t     _hourly_last = 0;       // start of the newest hour written
+  uint32_t     _daily_last  = 0;       // start of the newest day written
+  uint32_t     _rollup_cursor = 0;
+  uint32_t     _day_start = 0;         // local day the last sample fell in
+  uint32_t     _day_end   = 0;
+  unsigned long _next_sample = 0;      // millis() of the next raw sample
+
   bool init_db();
+  void init_rollups();
   void rollup_yesterday();
+  unsigned long sample();
+  void rollup_sample(uint32_t ts, const int16_t *row);
+  void write_rollup(tsdb_s *db, const RollupPeriod &period, uint32_t &last);
+  // Roll up the next slice, false if it could not (no clock yet)
+  bool catch_up_rollups();
 protected:
   void setup();
   unsigned long loop(MicroTasks::WakeReason reason);
@@ -50,6 +89,18 @@ public:
   void begin(EvseManager &evse);
   bool isReady() { return _ready; }
   int  initError() { return _init_err; }   // esp_err_t from tsdb_init (0 = OK)
+
+  // Rollup handles, nullptr if they could not be opened
+  tsdb_s *hourlyRollup() { return _hourly_db; }
+  tsdb_s *dailyRollup() { return _daily_db; }
+  // The periods in progress, not written yet
+  const RollupPeriod &currentHour() const { return _hourly.current(); }
+  const RollupPeriod &currentDay() const { return _daily.current(); }
+  // Days starting before this are all in the daily rollup, 0 while it is
+  // still catching up
+  uint32_t dailyRollupThrough() const {
+    return (_daily_db && _rollup_cursor == 0) ? _daily.current().start : 0;
+  }
 };
 
 extern TsdbEnergyLogger tsdbEnergyLogger;
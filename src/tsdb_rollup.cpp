@@ -0,0 +1,87 @@
+#include "tsdb_rollup.h"
+#include "tsdb_sample.h"
+
+const char *ROLLUP_PARAM_NAMES[ROLLUP_NUM_COLS] = {
+  "energy_lo", "energy_hi", "temp_max", "temp_min", "power_avg", "charge_min", "samples"
+};
+
+void RollupPeriod::begin(uint32_t period_start) {
+  *this = RollupPeriod();
+  start = period_start;
+}
+
+void RollupPeriod::add(const int16_t *raw, uint32_t charging_secs) {
+  int16_t temp = raw[TSDB_COL_TEMP];
+  if (samples == 0 || temp > temp_max) temp_max = temp;
+  if (samples == 0 || temp < temp_min) temp_min = temp;
+  energy += raw[TSDB_COL_ENERGY];
+  samples++;
+
+  // Current, power and pilot are only logged while charging
+  if (raw[TSDB_COL_AMPS] > 0) {
+    power_sum += raw[TSDB_COL_POWER];
+    power_samples++;
+    charge_secs += charging_secs;
+  }
+}
+
+int16_t RollupPeriod::powerAvg() const {
+  return power_samples > 0 ? (int16_t)(power_sum / (int32_t)power_samples) : 0;
+}
+
+uint16_t RollupPeriod::chargeMinutes() const {
+  return (uint16_t)((charge_secs + 30) / 60);
+}
+
+void RollupPeriod::toRow(int16_t *row) const {
+  uint32_t e = (uint32_t)energy;
+  row[ROLLUP_COL_ENERGY_LO]  = (int16_t)(uint16_t)(e & 0xffff);
+  row[ROLLUP_COL_ENERGY_HI]  = (int16_t)(uint16_t)(e >> 16);
+  row[ROLLUP_COL_TEMP_MAX]   = temp_max;
+  row[ROLLUP_COL_TEMP_MIN]   = temp_min;
+  row[ROLLUP_COL_POWER_AVG]  = powerAvg();
+  row[ROLLUP_COL_CHARGE_MIN] = (int16_t)chargeMinutes();
+  row[ROLLUP_COL_SAMPLES]    = (int16_t)(samples > 32767 ? 32767 : samples);
+}
+
+void RollupPeriod::fromRow(uint32_t period_start, const int16_t *row) {
+  begin(period_start);
+  energy = (int32_t)(((uint32_t)(uint16_t)row[ROLLUP_COL_ENERGY_HI] << 16) |
+                     (uint16_t)row[ROLLUP_COL_ENERGY_LO]);
+  temp_max = row[ROLLUP_COL_TEMP_MAX];
+  temp_min = row[ROLLUP_COL_TEMP_MIN];
+  samples  = (uint16_t)row[ROLLUP_COL_SAMPLES];
+  charge_secs = (uint32_t)(uint16_t)row[ROLLUP_COL_CHARGE_MIN] * 60;
+  // Only the mean survives, as one sample
+  if (row[ROLLUP_COL_POWER_AVG] != 0) {
+    power_sum = row[ROLLUP_COL_POWER_AVG];
+    power_samples = 1;
+  }
+}
+
+RollupSeries::RollupSeries(uint32_t max_gap) :
+  _max_gap(max_gap)
+{
+}
+
+bool RollupSeries::add(uint32_t period_start, uint32_t ts, const int16_t *raw) {
+  bool closed = false;
+  if (period_start != _current.start) {
+    if (_current.samples > 0) {
+      _completed = _current;
+      closed = true;
+    }
+    _current.begin(period_start);
+  }
+
+  uint32_t gap = (_last_ts != 0 && ts > _last_ts) ? ts - _last_ts : 0;
+  _current.add(raw, gap < _max_gap ? gap : _max_gap);
+  _last_ts = ts;
+
+  return closed;
+}
+
+void RollupSeries::reset() {
+  _current = RollupPeriod();
+  _last_ts = 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Hourly and daily rollups of the energy tsdb, kept up to date as the raw
+// samples are written (see TsdbEnergyLogger) in a tsdb of their own, with
+// one row per period timestamped at its start. An hour of charging is 60 raw
+// rows but one rollup row, so the rollups are kept for years after the raw
+// ring has wrapped.
+// ---------------------------------------------------------------------------
+
+// Fixed column order for the rollup tsdbs. Do NOT reorder (on-disk layout).
+enum {
+  ROLLUP_COL_ENERGY_LO = 0,  // Wh, low 16 bits of the period total
+  ROLLUP_COL_ENERGY_HI,      // Wh, high 16 bits (a day can exceed 32 kWh)
+  ROLLUP_COL_TEMP_MAX,       // deci-degC
+  ROLLUP_COL_TEMP_MIN,       // deci-degC
+  ROLLUP_COL_POWER_AVG,      // deca-watt, mean while charging
+  ROLLUP_COL_CHARGE_MIN,     // minutes spent charging
+  ROLLUP_COL_SAMPLES,        // raw samples in the period
+  ROLLUP_NUM_COLS
+};
+
+extern const char *ROLLUP_PARAM_NAMES[ROLLUP_NUM_COLS];   // {"energy_lo",...}
+
+struct RollupPeriod {
+  uint32_t start = 0;         // epoch of the start of the period
+  uint32_t samples = 0;
+  int32_t  energy = 0;        // Wh
+  int16_t  temp_max = 0;      // deci-degC
+  int16_t  temp_min = 0;
+  int32_t  power_sum = 0;     // deca-watt, over the charging samples
+  uint32_t power_samples = 0;
+  uint32_t charge_secs = 0;
+
+  void begin(uint32_t period_start);
+  // Add a raw sample (TSDB_NUM_COLS columns, see tsdb_sample.h)
+  void add(const int16_t *raw, uint32_t charging_secs);
+
+  int16_t powerAvg() const;     // deca-watt
+  uint16_t chargeMinutes() const;
+
+  // To and from a ROLLUP_NUM_COLS row
+  void toRow(int16_t *row) const;
+  void fromRow(uint32_t period_start, const int16_t *row);
+};
+
+// The period being accumulated for one rollup series
+class RollupSeries {
+public:
+  // `max_gap` caps the charging time credited to one sample, the time
+  // since the previous sample when it is longer than the charging cadence
+  explicit RollupSeries(uint32_t max_gap);
+
+  // Add a raw sample taken at `ts`, in the period starting `period_start`.
+  // Returns true if that closed the period before, now in completed().
+  bool add(uint32_t period_start, uint32_t ts, const int16_t *raw);
+
+  const RollupPeriod &current() const { return _current; }
+  const RollupPeriod &completed() const { return _completed; }
+
+  // Forget the period in progress, eg after the clock has been set back
+  void reset();
+
+private:
+  RollupPeriod _current;
+  RollupPeriod _completed;
+  uint32_t     _last_ts = 0;
+  uint32_t     _max_gap;
+};
@@ -1,5 +1,6 @@
 #include "tsdb_sample.h"
 #include <cmath>
+#include <cstdio>
 
 const char *TSDB_PARAM_NAMES[TSDB_NUM_COLS] =
   {"amps","volts","power","energy","temp","soc","pilot"};
@@ -29,3 +30,19 @@ double tsdb_unscale(uint8_t col, int16_t raw) {
     default:             return (double)raw;   // volts, energy, pilot
   }
 }
+
+int tsdb_sample_json(char *buf, size_t len, uint32_t ts, const int16_t *v, bool first) {
+  int soc = (int)tsdb_unscale(TSDB_COL_SOC, v[TSDB_COL_SOC]);   // -1 when invalid
+  return snprintf(buf, len,
+    "%s{\"ts\":%lu,\"a\":%.2f,\"t\":%.1f,\"e\":%.2f,\"s\":%d"
+    ",\"v\":%.1f,\"p\":%.1f,\"pilot\":%.1f}",
+    first ? "" : ",",
+    (unsigned long)ts,
+    tsdb_unscale(TSDB_COL_AMPS,   v[TSDB_COL_AMPS]),
+    tsdb_unscale(TSDB_COL_TEMP,   v[TSDB_COL_TEMP]),
+    tsdb_unscale(TSDB_COL_ENERGY, v[TSDB_COL_ENERGY]),
+    soc,
+    tsdb_unscale(TSDB_COL_VOLTS,  v[TSDB_COL_VOLTS]),
+    tsdb_unscale(TSDB_COL_POWER,  v[TSDB_COL_POWER]),
+    tsdb_unscale(TSDB_COL_PILOT,  v[TSDB_COL_PILOT]));
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 // Fixed column order for the energy tsdb. Do NOT reorder (on-disk layout).
@@ -29,3 +30,6 @@ struct EnergySample {
 void tsdb_scale_sample(const EnergySample &s, int16_t *out);
 // Unscale one column index back to engineering units (double). SoC stays -1 if invalid.
 double tsdb_unscale(uint8_t col, int16_t raw);
+// One /energy/raw sample as JSON, {"ts":..,"a":..,...}, with a leading comma
+// unless `first`. Returns the length as snprintf does; 192 bytes is plenty.
+int tsdb_sample_json(char *buf, size_t len, uint32_t ts, const int16_t *v, bool first);
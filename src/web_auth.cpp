@@ -1,63 +1,152 @@
 #include "web_auth.h"
 #include "crypto/hmac_sha256.h"
+#include <cstring>
 
-static std::string hex8(uint32_t v) {
-  static const char *H = "0123456789abcdef";
-  std::string s(8, '0');
-  for(int i = 7; i >= 0; i--) { s[i] = H[v & 0xf]; v >>= 4; }
-  return s;
-}
-static const std::string VER = "v1.";
+static const char *HEX = "0123456789abcdef";
+static const char VER[] = "v1.";
+static const size_t VER_LEN = sizeof(VER) - 1;
+static const size_t EXP_LEN = 8;
+static const size_t PAYLOAD_LEN = VER_LEN + EXP_LEN;
 static const size_t SIG_LEN = 32; // 128-bit truncated hex
 
+static_assert(PAYLOAD_LEN + 1 + SIG_LEN == SESSION_TOKEN_LEN, "token layout");
+
+// Parse "v1." + 8 hex exp + "." + 32 hex sig, without allocating.
+static bool token_parse(AuthSpan token, uint32_t &exp) {
+  if(token.len != SESSION_TOKEN_LEN) return false;
+  if(std::memcmp(token.data, VER, VER_LEN) != 0) return false;
+  if(token.data[PAYLOAD_LEN] != '.') return false;
+  exp = 0;
+  for(size_t i = VER_LEN; i < PAYLOAD_LEN; i++) {
+    char c = token.data[i];
+    exp <<= 4;
+    if(c >= '0' && c <= '9') exp |= (c - '0');
+    else if(c >= 'a' && c <= 'f') exp |= (c - 'a' + 10);
+    else return false;
+  }
+  return true;
+}
+
+// Truncated hex HMAC of the token payload ("v1." + exp hex).
+static void token_sign(const HmacSha256Key &key, const char *payload, char sig[SIG_LEN]) {
+  uint8_t mac[32];
+  hmac_sha256_with_key(key, (const uint8_t *)payload, PAYLOAD_LEN, mac);
+  for(size_t i = 0; i < SIG_LEN / 2; i++) {
+    sig[i * 2] = HEX[mac[i] >> 4];
+    sig[i * 2 + 1] = HEX[mac[i] & 0xf];
+  }
+}
+
 std::string session_token_mint(const std::string &secret, uint32_t exp) {
-  std::string payload = VER + hex8(exp);
-  std::string sig = hmac_sha256_hex(secret, payload).substr(0, SIG_LEN);
-  return payload + "." + sig;
+  SessionVerifier verifier;
+  verifier.setSecret(secret.data(), secret.size());
+  return verifier.mint(exp);
 }
 
-bool auth_constant_time_equals(const std::string &a, const std::string &b) {
-  size_t diff = a.size() ^ b.size();
-  size_t n = a.size() < b.size() ? a.size() : b.size();
-  for(size_t i = 0; i < n; i++) diff |= (unsigned char)(a[i] ^ b[i]);
+bool session_token_verify(const std::string &secret, const std::string &token, uint32_t now) {
+  SessionVerifier verifier;
+  verifier.setSecret(secret.data(), secret.size());
+  return verifier.verify(AuthSpan(token), now);
+}
+
+bool auth_constant_time_equals(AuthSpan a, AuthSpan b) {
+  size_t diff = a.len ^ b.len;
+  size_t n = a.len < b.len ? a.len : b.len;
+  for(size_t i = 0; i < n; i++) diff |= (unsigned char)(a.data[i] ^ b.data[i]);
   return diff == 0;
 }
 
+bool auth_constant_time_equals(const std::string &a, const std::string &b) {
+  return auth_constant_time_equals(AuthSpan(a), AuthSpan(b));
+}
+
+AuthSpan cookie_find(AuthSpan hdr, AuthSpan name) {
+  const char *p = hdr.data;
+  const char *end = hdr.data + hdr.len;
+  while(p < end) {
+    while(p < end && (*p == ' ' || *p == ';')) p++;
+    const char *eq = (const char *)std::memchr(p, '=', end - p);
+    if(eq == nullptr) break;
+    const char *val = eq + 1;
+    const char *semi = (const char *)std::memchr(val, ';', end - val);
+    const char *val_end = semi ? semi : end;
+    if((size_t)(eq - p) == name.len && std::memcmp(p, name.data, name.len) == 0) {
+      return AuthSpan(val, val_end - val);
+    }
+    if(semi == nullptr) break;
+    p = semi + 1;
+  }
+  return AuthSpan();
+}
+
 std::string cookie_extract(const std::string &hdr, const std::string &name) {
-  size_t i = 0;
-  while(i < hdr.size()) {
-    while(i < hdr.size() && (hdr[i] == ' ' || hdr[i] == ';')) i++;
-    size_t eq = hdr.find('=', i);
-    if(eq == std::string::npos) break;
-    std::string key = hdr.substr(i, eq - i);
-    size_t end = hdr.find(';', eq + 1);
-    std::string val = hdr.substr(eq + 1, (end == std::string::npos ? hdr.size() : end) - (eq + 1));
-    if(key == name) return val;
-    if(end == std::string::npos) break;
-    i = end + 1;
+  AuthSpan val = cookie_find(AuthSpan(hdr), AuthSpan(name));
+  return std::string(val.data ? val.data : "", val.len);
+}
+
+// -------------------------------------------------------------------
+// Session token verifier (see web_auth.h)
+// -------------------------------------------------------------------
+void SessionVerifier::setSecret(const char *secret, size_t len) {
+  invalidate();
+  hmac_sha256_key_init(_key, (const uint8_t *)secret, len);
+  _keyed = true;
+}
+
+void SessionVerifier::invalidate() {
+  std::memset(&_key, 0, sizeof(_key));
+  _keyed = false;
+  for(CacheEntry &entry : _cache) {
+    std::memset(entry.token, 0, sizeof(entry.token));
+    entry.exp = 0;
   }
-  return "";
+  _next = 0;
 }
 
-bool session_token_verify(const std::string &secret, const std::string &token, uint32_t now) {
-  // expect "v1." + 8 hex + "." + 32 hex  => length 3 + 8 + 1 + 32 = 44
-  if(token.size() != VER.size() + 8 + 1 + SIG_LEN) return false;
-  if(token.compare(0, VER.size(), VER) != 0) return false;
-  std::string exphex = token.substr(VER.size(), 8);
-  if(token[VER.size() + 8] != '.') return false;
-  std::string sig = token.substr(VER.size() + 9);
-  // parse exp
+std::string SessionVerifier::mint(uint32_t exp) const {
+  char token[SESSION_TOKEN_LEN];
+  std::memcpy(token, VER, VER_LEN);
+  for(int i = EXP_LEN - 1; i >= 0; i--) { token[VER_LEN + i] = HEX[exp & 0xf]; exp >>= 4; }
+  token[PAYLOAD_LEN] = '.';
+  token_sign(_key, token, token + PAYLOAD_LEN + 1);
+  return std::string(token, SESSION_TOKEN_LEN);
+}
+
+bool SessionVerifier::verify(AuthSpan token, uint32_t now) {
+  if(!_keyed) return false;
   uint32_t exp = 0;
-  for(char c : exphex) {
-    exp <<= 4;
-    if(c >= '0' && c <= '9') exp |= (c - '0');
-    else if(c >= 'a' && c <= 'f') exp |= (c - 'a' + 10);
-    else return false;
+  if(!token_parse(token, exp)) return false;
+  // exp is carried in clear in the token, so rejecting on it before the MAC
+  // leaks nothing; a forged exp still fails the signature below.
+  if(now >= exp) return false;
+
+  // A cached token was verified under the current secret. The whole table is
+  // scanned with the constant-time compare so a hit can't be timed.
+  bool hit = false;
+  for(const CacheEntry &entry : _cache) {
+    if(entry.exp != 0 &&
+       auth_constant_time_equals(AuthSpan(entry.token, SESSION_TOKEN_LEN), token)) {
+      hit = true;
+    }
+  }
+  if(hit) {
+    _hits++;
+    return true;
   }
-  std::string payload = VER + exphex;
-  std::string expected = hmac_sha256_hex(secret, payload).substr(0, SIG_LEN);
-  if(!auth_constant_time_equals(sig, expected)) return false;
-  return now < exp;
+  _misses++;
+
+  char expected[SIG_LEN];
+  token_sign(_key, token.data, expected);
+  if(!auth_constant_time_equals(AuthSpan(token.data + PAYLOAD_LEN + 1, SIG_LEN),
+                                AuthSpan(expected, SIG_LEN))) {
+    return false;
+  }
+
+  CacheEntry &slot = _cache[_next];
+  std::memcpy(slot.token, token.data, SESSION_TOKEN_LEN);
+  slot.exp = exp;
+  _next = (_next + 1) % SESSION_VERIFY_CACHE_SIZE;
+  return true;
 }
 
 // -------------------------------------------------------------------
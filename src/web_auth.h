@@ -2,11 +2,69 @@
 #define OEVSE_WEB_AUTH_H
 #include <string>
 #include <cstdint>
+#include <cstddef>
+#include "crypto/hmac_sha256.h"
+
+// Borrowed, not NUL-terminated view of a string (e.g. straight into a Mongoose
+// header buffer). Stand-in for std::string_view, which the core-2.x builds lack.
+struct AuthSpan {
+  const char *data = nullptr;
+  size_t len = 0;
+  AuthSpan() {}
+  AuthSpan(const char *d, size_t l) : data(d), len(l) {}
+  AuthSpan(const std::string &s) : data(s.data()), len(s.size()) {}
+  bool empty() const { return len == 0; }
+};
 
 std::string session_token_mint(const std::string &secret, uint32_t exp);
 bool session_token_verify(const std::string &secret, const std::string &token, uint32_t now);
 bool auth_constant_time_equals(const std::string &a, const std::string &b);
+bool auth_constant_time_equals(AuthSpan a, AuthSpan b);
 std::string cookie_extract(const std::string &cookie_header, const std::string &name);
+// Allocation-free cookie lookup: returns a span into cookie_header, empty when
+// the cookie is not present.
+AuthSpan cookie_find(AuthSpan cookie_header, AuthSpan name);
+
+// -------------------------------------------------------------------
+// Session token verifier with a cached key schedule
+//
+// Holds the HMAC ipad/opad midstates for the current secret, so verifying a
+// token costs two SHA-256 block transforms and no heap allocation, plus a
+// small cache of recently verified tokens so the GUI's steady polling skips
+// the MAC entirely. setSecret()/invalidate() must be called whenever the
+// secret changes (web_auth_rotate_secret) and drop every cached token.
+// -------------------------------------------------------------------
+#ifndef SESSION_VERIFY_CACHE_SIZE
+#define SESSION_VERIFY_CACHE_SIZE 4
+#endif
+
+constexpr size_t SESSION_TOKEN_LEN = 3 + 8 + 1 + 32;  // "v1." + exp + "." + sig
+
+class SessionVerifier {
+  public:
+    void setSecret(const char *secret, size_t len);
+    void invalidate();
+    bool hasSecret() const { return _keyed; }
+
+    bool verify(AuthSpan token, uint32_t now);
+    std::string mint(uint32_t exp) const;
+
+    uint32_t cacheHits() const { return _hits; }
+    uint32_t cacheMisses() const { return _misses; }
+
+  private:
+    struct CacheEntry {
+      char token[SESSION_TOKEN_LEN];
+      uint32_t exp = 0;   // 0 = empty slot
+    };
+
+    HmacSha256Key _key;
+    bool _keyed = false;
+    CacheEntry _cache[SESSION_VERIFY_CACHE_SIZE];
+    uint8_t _next = 0;
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+};
 
 // -------------------------------------------------------------------
 // Decaying failed-authentication throttle
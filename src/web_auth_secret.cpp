@@ -2,6 +2,8 @@
 #include "app_config.h"
 #include <esp_random.h>
 
+static uint32_t secret_generation = 0;
+
 // Generate a 64-character lowercase hex string backed by 32 bytes of hardware
 // entropy via esp_fill_random(). On ESP32/C3, esp_fill_random() draws from
 // the Wi-Fi-seeded HWRNG; on P4 it draws from the SAR-ADC noise source
@@ -36,7 +38,18 @@ void web_auth_ensure_secret()
 void web_auth_rotate_secret()
 {
   server_secret = randomHex32();
+  web_auth_secret_changed();
   // Persist via config_user_commit() — not config_commit(), which also sets
   // the factory_write_lock flag.
   config_user_commit();
 }
+
+uint32_t web_auth_secret_generation()
+{
+  return secret_generation;
+}
+
+void web_auth_secret_changed()
+{
+  secret_generation++;
+}
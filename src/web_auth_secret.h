@@ -16,3 +16,11 @@ void web_auth_ensure_secret();
 // Call whenever web credentials change so that all outstanding sessions are
 // invalidated.
 void web_auth_rotate_secret();
+
+// Incremented every time the secret is (re)generated. Holders of derived key
+// material (the cached HMAC key schedule) compare it to know when to re-key.
+uint32_t web_auth_secret_generation();
+
+// Note an out-of-band change to server_secret (e.g. written via the config
+// API) so derived key material is refreshed.
+void web_auth_secret_changed();
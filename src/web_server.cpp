@@ -45,11 +45,15 @@ typedef const __FlashStringHelper *fstr_t;
 #include "scheduler.h"
 #include "rfid.h"
 #include "current_shaper.h"
+#include "load_balancer.h"
 #include "home_battery.h"
 #include "evse_man.h"
 #include "limit.h"
 #include "web_auth.h"
 #include "web_auth_secret.h"
+#include "status_cache.h"
+#include "pooled_json.h"
+#include "publisher.h"
 
 MongooseHttpServer server;          // Create class for Web server
 MongooseHttpServer redirect;        // Server to redirect to HTTPS if enabled
@@ -74,6 +78,7 @@ const char _CONTENT_TYPE_ICO[]      PROGMEM = "image/vnd.microsoft.icon";
 const char _CONTENT_TYPE_WOFF[]     PROGMEM = "font/woff";
 const char _CONTENT_TYPE_WOFF2[]    PROGMEM = "font/woff2";
 const char _CONTENT_TYPE_MANIFEST[] PROGMEM = "application/manifest+json";
+const char _CONTENT_TYPE_OCTET[]    PROGMEM = "application/octet-stream";
 
 #define RAPI_RESPONSE_BLOCKED             -300
 
@@ -91,6 +96,9 @@ void handleMigrateExpand16mb(MongooseHttpServerRequest *request);
 void handleMigrateStatus(MongooseHttpServerRequest *request);
 void handleMigrateCoredump(MongooseHttpServerRequest *request);
 
+void handleProfile(MongooseHttpServerRequest *request);
+void handleHeap(MongooseHttpServerRequest *request);
+
 void handleTime(MongooseHttpServerRequest *request);
 void handleTimePost(MongooseHttpServerRequest *request, MongooseHttpServerResponseStream *response);
 void handleMqttAction(MongooseHttpServerRequest *request);
@@ -104,6 +112,8 @@ void handleEnergyAnnual(MongooseHttpServerRequest *request);
 void handleEnergyRaw(MongooseHttpServerRequest *request);
 void handleEnergyDaily(MongooseHttpServerRequest *request);
 void handleEnergyWeekly(MongooseHttpServerRequest *request);
+void handleEnergyHourly(MongooseHttpServerRequest *request);
+void handleEnergyExport(MongooseHttpServerRequest *request);
 void handleEnergyMonthly(MongooseHttpServerRequest *request);
 void handleEnergyAnnual(MongooseHttpServerRequest *request);
 #endif // ENABLE_TSDB
@@ -224,6 +234,33 @@ static String effectiveAdminUser()
   return www_username.length() > 0 ? www_username : String("openevseadmin");
 }
 
+// -------------------------------------------------------------------
+// Cached session key schedule
+//
+// Re-derives the HMAC midstates only when web_auth_rotate_secret() has issued
+// a new secret (tracked by its generation), rather than on every request.
+// -------------------------------------------------------------------
+#define SESSION_COOKIE_NAME "oevse_session"
+
+static SessionVerifier sessionVerifier;
+static uint32_t sessionVerifierGeneration = 0;
+
+static bool sessionKeyCurrent()
+{
+  uint32_t generation = web_auth_secret_generation();
+  if(!sessionVerifier.hasSecret() || generation != sessionVerifierGeneration)
+  {
+    String secret = web_auth_get_secret();
+    if(secret.length() == 0) {
+      sessionVerifier.invalidate();
+      return false;
+    }
+    sessionVerifier.setSecret(secret.c_str(), secret.length());
+    sessionVerifierGeneration = generation;
+  }
+  return true;
+}
+
 // -------------------------------------------------------------------
 // Session-cookie auth helper (browser UI)
 //
@@ -240,21 +277,19 @@ static bool hasValidSessionCookie(MongooseHttpServerRequest *request)
   if(!clockIsSane()) {
     return false;
   }
-  String secret = web_auth_get_secret();
-  if(secret.length() == 0) {
+  if(!sessionKeyCurrent()) {
     return false;  // no secret yet — fail closed
   }
   MongooseString cookieHdr = request->headers("Cookie");
   if(!cookieHdr) {
     return false;
   }
-  std::string tok = cookie_extract(
-    std::string(cookieHdr.c_str(), cookieHdr.length()), "oevse_session");
+  AuthSpan tok = cookie_find(AuthSpan(cookieHdr.c_str(), cookieHdr.length()),
+                             AuthSpan(SESSION_COOKIE_NAME, sizeof(SESSION_COOKIE_NAME) - 1));
   if(tok.empty()) {
     return false;
   }
-  return session_token_verify(
-    std::string(secret.c_str()), tok, (uint32_t)time(nullptr));
+  return sessionVerifier.verify(tok, (uint32_t)time(nullptr));
 }
 
 // -------------------------------------------------------------------
@@ -338,7 +373,7 @@ void handleLogin(MongooseHttpServerRequest *request)
   }
 
   String body = request->body().toString();
-  DynamicJsonDocument doc(512);
+  PooledJsonDocument doc(512);
   if(deserializeJson(doc, body)) {
     response->setCode(400);
     response->print(F("{\"msg\":\"bad json\"}"));
@@ -396,15 +431,14 @@ void handleLogin(MongooseHttpServerRequest *request)
     return;
   }
 
-  String secret = web_auth_get_secret();
-  if(secret.length() == 0) {
+  if(!sessionKeyCurrent()) {
     response->setCode(503);
     response->print(F("{\"msg\":\"not ready\"}"));
     request->send(response);
     return;
   }
   uint32_t exp = (uint32_t)time(nullptr) + (remember ? REMEMBER_TTL : SESSION_TTL);
-  std::string token = session_token_mint(std::string(secret.c_str()), exp);
+  std::string token = sessionVerifier.mint(exp);
 
   String cookie = "oevse_session=";
   cookie += token.c_str();
@@ -532,18 +566,7 @@ static String html_escape(const String &input) {
 // Build status data
 // --------------------------------------------------------------------
 
-void buildStatus(DynamicJsonDocument &doc) {
-
-  // Get the current time
-  struct timeval local_time;
-  gettimeofday(&local_time, NULL);
-
-  struct tm * timeinfo = gmtime(&local_time.tv_sec);
-
-  char time[64];
-  char offset[8];
-  strftime(time, sizeof(time), "%FT%TZ", timeinfo);
-  strftime(offset, sizeof(offset), "%z", timeinfo);
+void buildStatus(JsonDocument &doc) {
 
   if (net.isWiredConnected()) {
     doc["mode"] = "Wired";
@@ -565,6 +588,9 @@ void buildStatus(DynamicJsonDocument &doc) {
   doc["emoncms_connected"] = (int)emoncms_connected;
   doc["packets_sent"] = packets_sent;
   doc["packets_success"] = packets_success;
+  doc["emoncms_queued"] = emoncms_queued();
+  doc["emoncms_dropped"] = packets_dropped;
+  doc["emoncms_backfilled"] = packets_backfilled;
 
   doc["mqtt_connected"] = (int)mqtt.isConnected();
   doc["mqtt_status"]    = mqtt.getMqttStatus();
@@ -576,6 +602,11 @@ void buildStatus(DynamicJsonDocument &doc) {
     doc["mqtt_connected_since"] = (uint32_t)mqtt.getConnectedSince();
   if (mqtt.getLastRxTime() > 0)
     doc["mqtt_last_rx"]         = (uint32_t)mqtt.getLastRxTime();
+  // EVSE data updates not published, see publisher.h
+  doc["mqtt_skipped"] = publisher.mqtt().skipped;
+  doc["mqtt_dropped"] = publisher.mqtt().dropped;
+  doc["ws_dropped"] = publisher.ws().dropped;
+  doc["publish_oversize"] = publisher.ring().oversize();
   if (mqtt.getErrorCategory()[0] != '\0') {
     doc["mqtt_error"]        = mqtt.getErrorCategory();
     doc["mqtt_error_detail"] = mqtt.getErrorDetail();
@@ -610,11 +641,24 @@ void buildStatus(DynamicJsonDocument &doc) {
   doc["charge_rate"] = divert.getChargeRate();
   doc["divert_update"] = (millis() - divert.getLastUpdate()) / 1000;
   doc["divert_active"] = divert.isActive();
+  doc["divert_pilot_changes"] = divert.pilotChanges();
+  doc["divert_pilot_changes_avoided"] = divert.pilotChangesAvoided();
   doc["shaper"] = shaper.getState()?1:0;
   doc["shaper_live_pwr"] = shaper.getLivePwr();
   // doc["shaper_cur"] = shaper.getChgCur();
   doc["shaper_cur"] = shaper.getMaxCur();
   doc["shaper_updated"] = shaper.isUpdated();
+  if (shaper.hasPhaseData()) {
+    doc["shaper_live_current_l1"] = shaper.getLivePhaseCurrent(1);
+    doc["shaper_live_current_l2"] = shaper.getLivePhaseCurrent(2);
+    doc["shaper_live_current_l3"] = shaper.getLivePhaseCurrent(3);
+    doc["shaper_limiting_phase"] = shaper.getLimitingPhase();
+  }
+  doc["load_balancing"] = loadBalancer.isEnabled()?1:0;
+  doc["load_balancing_allocation"] = loadBalancer.getAllocation();
+  doc["load_balancing_budget"] = loadBalancer.getBudget();
+  doc["load_balancing_peers"] = loadBalancer.getPeerCount();
+  doc["load_balancing_failsafe"] = loadBalancer.isFailsafe();
   doc["service_level"] = static_cast<uint8_t>(evse.getActualServiceLevel());
   doc["limit"] = limit.hasLimit();
 
@@ -836,7 +880,7 @@ void handleStatusPost(MongooseHttpServerRequest *request, MongooseHttpServerResp
   String body = request->body().toString();
   // Deserialize the JSON document
   const size_t capacity = JSON_OBJECT_SIZE(32) + 1024;
-  DynamicJsonDocument doc(capacity);
+  PooledJsonDocument doc(capacity);
   DeserializationError error = deserializeJson(doc, body);
   if(!error)
   {
@@ -854,6 +898,25 @@ void handleStatusPost(MongooseHttpServerRequest *request, MongooseHttpServerResp
       shaper.setLivePwr(shaper_live_pwr);
       DBUGF("shaper: live power:%dW", shaper.getLivePwr());
     }
+    // Per-phase site load, in W or A, for three-phase installations
+    static const char *phase_pwr[] = { "shaper_live_pwr_l1", "shaper_live_pwr_l2", "shaper_live_pwr_l3" };
+    static const char *phase_cur[] = { "shaper_live_current_l1", "shaper_live_current_l2", "shaper_live_current_l3" };
+    for(uint8_t phase = 1; phase <= 3; phase++)
+    {
+      if(doc.containsKey(phase_pwr[phase - 1])) {
+        int live_pwr = doc[phase_pwr[phase - 1]];
+        if(divert_type == DIVERT_TYPE_GRID) {
+          divert.setGridIePhase(phase, live_pwr);
+        }
+        shaper.setLivePhasePwr(phase, live_pwr);
+      } else if(doc.containsKey(phase_cur[phase - 1])) {
+        double live_current = doc[phase_cur[phase - 1]];
+        if(divert_type == DIVERT_TYPE_GRID) {
+          divert.setGridIePhase(phase, live_current * evse.getVoltage());
+        }
+        shaper.setLivePhaseCurrent(phase, live_current);
+      }
+    }
     if(doc.containsKey("solar")) {
       divert.setSolar(doc["solar"]);
       DBUGF("solar:%dW", divert.getSolar());
@@ -924,6 +987,48 @@ void handleStatusPost(MongooseHttpServerRequest *request, MongooseHttpServerResp
 }
 
 
+// Free running values, a change in these alone does not change the (weak) ETag
+static const char *const statusVolatileKeys[] = {
+  "time", "local_time", "uptime", "elapsed", "session_elapsed",
+  "free_heap", "freeram", "srssi", "littlefs_free", "littlefs_used",
+  "comm_sent", "comm_success", "packets_sent", "packets_success", "mqtt_skipped",
+  "divert_update", "vehicle_state_update", "mqtt_last_rx", nullptr
+};
+static StatusCache statusCache(statusVolatileKeys);
+
+static const std::string &statusSnapshot()
+{
+  uint32_t now = millis();
+  if(!statusCache.valid(now))
+  {
+    Profile_Start(buildStatus);
+    const size_t capacity = JSON_OBJECT_SIZE(128) + 2048;
+    PooledJsonDocument doc(capacity);
+    buildStatus(doc);
+    std::string json;
+    serializeJson(doc, json);
+    statusCache.update(json, now);
+    Profile_End(buildStatus, 5);
+  }
+
+  return statusCache.json();
+}
+
+// Just the comma separated `fields` of the snapshot
+static void statusProjection(const std::string &json, char *fields, std::string &out)
+{
+  PooledJsonDocument filter(JSON_OBJECT_SIZE(STATUS_FIELDS_MAX) + strlen(fields) + STATUS_FIELDS_MAX);
+  size_t count = 0;
+  for(char *field = strtok(fields, ", "); field && count < STATUS_FIELDS_MAX; field = strtok(NULL, ", ")) {
+    filter[field] = true;
+    count++;
+  }
+
+  PooledJsonDocument doc(JSON_OBJECT_SIZE(count) + json.length());
+  deserializeJson(doc, json.data(), json.length(), DeserializationOption::Filter(filter));
+  serializeJson(doc, out);
+}
+
 void
 handleStatus(MongooseHttpServerRequest *request)
 {
@@ -935,14 +1040,35 @@ handleStatus(MongooseHttpServerRequest *request)
 
   if(HTTP_GET == request->method()) {
 
-    const size_t capacity = JSON_OBJECT_SIZE(128) + 2048;
-    DynamicJsonDocument doc(capacity);
-    buildStatus(doc);
-    response->setCode(200);
-    serializeJson(doc, *response);
+    char fields[STATUS_FIELDS_LEN];
+    bool project = request->getParam("fields", fields, sizeof(fields)) > 0;
+
+    // Tagged by what is actually sent
+    const std::string &json = statusSnapshot();
+    std::string projection;
+    char etag[STATUS_ETAG_SIZE];
+    if(project) {
+      statusProjection(json, fields, projection);
+      statusCache.etag(etag, projection);
+    } else {
+      statusCache.etag(etag);
+    }
+    response->addHeader(F("ETag"), etag);
+
+    MongooseString ifNoneMatch = request->headers("If-None-Match");
+    if(ifNoneMatch.length() > 0 &&
+       StatusCache::etagMatches(ifNoneMatch.toString().c_str(), etag))
+    {
+      response->setCode(304);
+    } else {
+      response->setCode(200);
+      const std::string &body = project ? projection : json;
+      response->write((const uint8_t *)body.data(), body.length());
+    }
 
   } else if(HTTP_POST == request->method()) {
     handleStatusPost(request, response);
+    statusCache.invalidate();
   } else {
     response->setCode(405);
     response->print("{\"msg\":\"Method not allowed\"}");
@@ -960,7 +1086,7 @@ handleScheduleGet(MongooseHttpServerRequest *request, MongooseHttpServerResponse
 {
   // Sized from the stored event count — a fixed budget silently truncated
   // multi-rule schedules (serialize() drops events once the doc overflows).
-  DynamicJsonDocument doc(scheduler.scheduleJsonCapacity());
+  PooledJsonDocument doc(scheduler.scheduleJsonCapacity());
 
   bool success = (SCHEDULER_EVENT_NULL == event) ?
     scheduler.serialize(doc) :
@@ -1055,7 +1181,7 @@ handleSchedulePlan(MongooseHttpServerRequest *request)
   }
 
   const size_t capacity = JSON_OBJECT_SIZE(40) + 2048;
-  DynamicJsonDocument doc(capacity);
+  PooledJsonDocument doc(capacity);
 
   scheduler.serializePlan(doc);
   response->setCode(200);
@@ -1140,7 +1266,7 @@ void handleLimit(MongooseHttpServerRequest *request)
 void handleEmeterDelete(MongooseHttpServerRequest *request, MongooseHttpServerResponseStream *response)
 {
   String body = request->body().toString();
-  DynamicJsonDocument doc(512);
+  PooledJsonDocument doc(512);
   DeserializationError err = deserializeJson(doc, body);
   if (DeserializationError::Code::Ok == err) {
     if (doc.containsKey("hard") && doc.containsKey("import")) {
@@ -1324,7 +1450,7 @@ handleRestart(MongooseHttpServerRequest *request) {
     String body = request->body().toString();
     // Deserialize the JSON document
     const size_t capacity = JSON_OBJECT_SIZE(1) + 16;
-    DynamicJsonDocument doc(capacity);
+    PooledJsonDocument doc(capacity);
     DeserializationError error = deserializeJson(doc, body);
     if(!error)
     {
@@ -1570,7 +1696,7 @@ void onWsFrame(MongooseHttpWebSocketConnection *connection, int flags, uint8_t *
 {
   DBUGF("Got message %.*s", len, (const char *)data);
   const size_t capacity = JSON_OBJECT_SIZE(1) + 16;
-  DynamicJsonDocument doc(capacity);
+  PooledJsonDocument doc(capacity);
   DeserializationError error = deserializeJson(doc, data, len);
   if (!error) {
     if (doc.containsKey("ping") && doc["ping"].is<int8_t>())
@@ -1607,7 +1733,7 @@ void onWsConnect(MongooseHttpWebSocketConnection *connection)
   DBUGF("New client connected over ws");
   // pushing states to client
   const size_t capacity = JSON_OBJECT_SIZE(40) + 1024;
-  DynamicJsonDocument doc(capacity);
+  PooledJsonDocument doc(capacity);
   buildStatus(doc);
   web_server_event(doc);
 }
@@ -1630,7 +1756,7 @@ void handleMqttAction(MongooseHttpServerRequest *request) {
   if (false == requestPreProcess(request, response)) return;
 
   if (HTTP_GET == request->method()) {
-    DynamicJsonDocument doc(JSON_OBJECT_SIZE(8) + 384);
+    PooledJsonDocument doc(JSON_OBJECT_SIZE(8) + 384);
     doc["mqtt_connected"] = (int)mqtt.isConnected();
     doc["mqtt_status"]    = mqtt.getMqttStatus();
     if (mqtt.getBrokerIp()[0] != '\0')
@@ -1658,6 +1784,16 @@ void handleMqttAction(MongooseHttpServerRequest *request) {
   request->send(response);
 }
 
+// Register a handler, timing each request under its URI in the run time
+// statistics, see /debug/profile
+static void profiledOn(const char *uri, void (*handler)(MongooseHttpServerRequest *request))
+{
+  server.on(uri, [uri, handler](MongooseHttpServerRequest *request) {
+    ProfileScope scope(profiler.entry(uri));
+    handler(request);
+  });
+}
+
 void web_server_setup()
 {
   bool use_ssl = false;
@@ -1683,54 +1819,56 @@ void web_server_setup()
   }
 
   // Session management (no auth gate — user must reach these unauthenticated)
-  server.on("/login$", handleLogin);
-  server.on("/logout$", handleLogout);
+  profiledOn("/login$", handleLogin);
+  profiledOn("/logout$", handleLogout);
 
   // Handle status updates
-  server.on("/status$", handleStatus);
-  server.on("/config$", handleConfig);
+  profiledOn("/status$", handleStatus);
+  profiledOn("/config$", handleConfig);
 
   // Handle HTTP web interface button presses
-  server.on("/teslaveh$", handleTeslaVeh);
-  server.on("/tesla/vehicles$", handleTeslaVeh);
-  server.on("/settime$", handleSetTime);
-  server.on("/reset$", handleRst);
-  server.on("/restart$", handleRestart);
-  server.on("/rapi$", handleRapi);
-  server.on("/r$", handleRapi);
-  server.on("/scan$", handleScan);
-  server.on("/apoff$", handleAPOff);
-  server.on("/divertmode$", handleDivertMode);
-  server.on("/shaper$", handleCurrentShaper);
-  server.on("/emoncms/describe$", handleDescribe);
-  server.on("/rfid/add$", handleAddRFID);
-
-  server.on("/schedule/plan$", handleSchedulePlan);
-  server.on("/schedule", handleSchedule);
-
-  server.on("/claims/target$", handleEvseClaimsTarget);
-  server.on("/claims", handleEvseClaims);
-
-  server.on("/override$", handleOverride);
-
-  server.on("/logs", handleEventLogs);
-  server.on("/certificates", handleCertificates);
-  server.on("/limit", handleLimit);
-  server.on("/emeter", handleEmeter);
-  server.on("/time", handleTime);
-  server.on("/mqtt$", handleMqttAction);
+  profiledOn("/teslaveh$", handleTeslaVeh);
+  profiledOn("/tesla/vehicles$", handleTeslaVeh);
+  profiledOn("/settime$", handleSetTime);
+  profiledOn("/reset$", handleRst);
+  profiledOn("/restart$", handleRestart);
+  profiledOn("/rapi$", handleRapi);
+  profiledOn("/r$", handleRapi);
+  profiledOn("/scan$", handleScan);
+  profiledOn("/apoff$", handleAPOff);
+  profiledOn("/divertmode$", handleDivertMode);
+  profiledOn("/shaper$", handleCurrentShaper);
+  profiledOn("/emoncms/describe$", handleDescribe);
+  profiledOn("/rfid/add$", handleAddRFID);
+
+  profiledOn("/schedule/plan$", handleSchedulePlan);
+  profiledOn("/schedule", handleSchedule);
+
+  profiledOn("/claims/target$", handleEvseClaimsTarget);
+  profiledOn("/claims", handleEvseClaims);
+
+  profiledOn("/override$", handleOverride);
+
+  profiledOn("/logs", handleEventLogs);
+  profiledOn("/certificates", handleCertificates);
+  profiledOn("/limit", handleLimit);
+  profiledOn("/emeter", handleEmeter);
+  profiledOn("/time", handleTime);
+  profiledOn("/mqtt$", handleMqttAction);
 
 #ifndef ENABLE_TSDB
-  server.on("/energy/raw$", handleEnergyRaw);
-  server.on("/energy/daily$", handleEnergyDaily);
-  server.on("/energy/monthly$", handleEnergyMonthly);
-  server.on("/energy/annual$", handleEnergyAnnual);
+  profiledOn("/energy/raw$", handleEnergyRaw);
+  profiledOn("/energy/daily$", handleEnergyDaily);
+  profiledOn("/energy/monthly$", handleEnergyMonthly);
+  profiledOn("/energy/annual$", handleEnergyAnnual);
 #else // ENABLE_TSDB
-  server.on("/energy/raw$", handleEnergyRaw);
-  server.on("/energy/daily$", handleEnergyDaily);
-  server.on("/energy/weekly$", handleEnergyWeekly);
-  server.on("/energy/monthly$", handleEnergyMonthly);
-  server.on("/energy/annual$", handleEnergyAnnual);
+  profiledOn("/energy/raw$", handleEnergyRaw);
+  profiledOn("/energy/daily$", handleEnergyDaily);
+  profiledOn("/energy/weekly$", handleEnergyWeekly);
+  profiledOn("/energy/hourly$", handleEnergyHourly);
+  profiledOn("/energy/export$", handleEnergyExport);
+  profiledOn("/energy/monthly$", handleEnergyMonthly);
+  profiledOn("/energy/annual$", handleEnergyAnnual);
 #endif // ENABLE_TSDB
 
   // Simple Firmware Update Form
@@ -1740,9 +1878,12 @@ void web_server_setup()
     onClose(handleUpdateClose);
 
   // In-place 16MB flash repartition (16MB module flashed with 4MB layout)
-  server.on("/migrate/expand16mb$", handleMigrateExpand16mb);
-  server.on("/migrate/status$", handleMigrateStatus);
-  server.on("/migrate/coredump$", handleMigrateCoredump);
+  profiledOn("/migrate/expand16mb$", handleMigrateExpand16mb);
+  profiledOn("/migrate/status$", handleMigrateStatus);
+  profiledOn("/migrate/coredump$", handleMigrateCoredump);
+
+  profiledOn("/debug/profile$", handleProfile);
+  profiledOn("/debug/heap$", handleHeap);
 
   server.on("/debug$", [](MongooseHttpServerRequest *request) {
     MongooseHttpServerResponseStream *response;
@@ -1799,7 +1940,11 @@ void web_server_setup()
     ->
     onConnect(onWsConnect);
 
-  server.onNotFound(handleNotFound);
+  // Static files and anything else unmatched
+  server.onNotFound([](MongooseHttpServerRequest *request) {
+    Profile_Scope("NotFound");
+    handleNotFound(request);
+  });
 
   DEBUG.println("Server started");
 }
@@ -1825,7 +1970,15 @@ web_server_loop() {
 
 void web_server_event(JsonDocument &event)
 {
-  String json;
-  serializeJson(event, json);
-  server.sendAll("/ws", json);
+  // Into a pooled buffer rather than a String, this runs for every event
+  JsonPoolLease json(measureJson(event) + 1);
+  if(json.data()) {
+    size_t len = serializeJson(event, json.data(), json.size());
+    server.sendAll("/ws", WEBSOCKET_OP_TEXT, (const uint8_t *)json.data(), len);
+  }
+}
+
+void web_server_event(const char *json, size_t len)
+{
+  server.sendAll("/ws", WEBSOCKET_OP_TEXT, (const uint8_t *)json, len);
 }
@@ -41,12 +41,16 @@ extern const char _CONTENT_TYPE_WOFF2[];
 extern const char _CONTENT_TYPE_MANIFEST[];
 #define CONTENT_TYPE_MANIFEST FPSTR(_CONTENT_TYPE_MANIFEST)
 
+extern const char _CONTENT_TYPE_OCTET[];
+#define CONTENT_TYPE_OCTET FPSTR(_CONTENT_TYPE_OCTET)
+
 extern MongooseHttpServer server;
 
 extern void web_server_setup();
 extern void web_server_loop();
 
 extern void web_server_event(JsonDocument &event);
+extern void web_server_event(const char *json, size_t len);
 
 typedef const __FlashStringHelper *fstr_t;
 
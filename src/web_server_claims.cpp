@@ -10,6 +10,7 @@ typedef const __FlashStringHelper *fstr_t;
 #include "web_server.h"
 #include "evse_man.h"
 #include "input.h"
+#include "pooled_json.h"
 
 // -------------------------------------------------------------------
 //
@@ -19,7 +20,7 @@ void
 handleEvseClaimsGet(MongooseHttpServerRequest *request, MongooseHttpServerResponseStream *response, uint32_t client)
 {
   const size_t capacity = JSON_OBJECT_SIZE(40) + 1024;
-  DynamicJsonDocument doc(capacity);
+  PooledJsonDocument doc(capacity);
 
   bool success = (EvseClient_NULL == client) ?
     evse.serializeClaims(doc) :
@@ -123,7 +124,7 @@ void handleEvseClaimsTarget(MongooseHttpServerRequest *request)
   }
 
   const size_t capacity = JSON_OBJECT_SIZE(40) + 1024;
-  DynamicJsonDocument doc(capacity);
+  PooledJsonDocument doc(capacity);
 
   evse.serializeTarget(doc);
 
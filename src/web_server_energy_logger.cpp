@@ -31,9 +31,6 @@ void handleEnergyRaw(MongooseHttpServerRequest *request)
   }
 
   if (HTTP_GET == request->method()) {
-    const size_t capacity = JSON_ARRAY_SIZE(ENERGY_LOGGER_BUFFER_SIZE) + ENERGY_LOGGER_BUFFER_SIZE * JSON_OBJECT_SIZE(4) + 256;
-    DynamicJsonDocument doc(capacity);
-
     char max_buf[8]    = {0};
     char before_buf[12] = {0};
 
@@ -47,10 +44,9 @@ void handleEnergyRaw(MongooseHttpServerRequest *request)
       before_ts = (time_t)atol(before_buf);
     }
 
-    energyLogger.getRawSamples(doc, max_samples, before_ts);
-
+    // Streamed straight from the ring file, same JSON as the tsdb handler
     response->setCode(200);
-    serializeJson(doc, *response);
+    energyLogger.getRawSamples(*response, max_samples, before_ts);
   } else if (HTTP_OPTIONS == request->method()) {
     response->setCode(200);
   } else {
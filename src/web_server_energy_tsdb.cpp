@@ -8,11 +8,15 @@
 #include "web_server.h"
 #include "esp_tsdb.h"
 #include "tsdb_sample.h"
+#include "energy_day_cache.h"
+#include "tsdb_rollup.h"
+#include "energy_export.h"
 #include "energy_logger.h"        // ENERGY_LOGGER_MONTHLY_DIR, ENERGY_LOGGER_ANNUAL_FILE (legacy rollup paths)
 #include "tsdb_energy_logger.h"   // tsdbEnergyLogger.isReady() guard
 #include "debug.h"
 #include <time.h>
 #include <stdio.h>
+#include <string.h>
 #include <LittleFS.h>
 
 // ---------------------------------------------------------------------------
@@ -96,31 +100,8 @@ void handleEnergyRaw(MongooseHttpServerRequest *request)
       while (tsdb_query_next(&q, &ts, v) == ESP_OK) {
         if (max_samples > 0 && count >= max_samples) break;
 
-        double amps     = tsdb_unscale(TSDB_COL_AMPS,   v[TSDB_COL_AMPS]);
-        double volts    = tsdb_unscale(TSDB_COL_VOLTS,  v[TSDB_COL_VOLTS]);
-        double power_w  = tsdb_unscale(TSDB_COL_POWER,  v[TSDB_COL_POWER]);
-        double energy   = tsdb_unscale(TSDB_COL_ENERGY, v[TSDB_COL_ENERGY]);
-        double temp_c   = tsdb_unscale(TSDB_COL_TEMP,   v[TSDB_COL_TEMP]);
-        double soc_d    = tsdb_unscale(TSDB_COL_SOC,    v[TSDB_COL_SOC]);
-        double pilot_a  = tsdb_unscale(TSDB_COL_PILOT,  v[TSDB_COL_PILOT]);
-        int    soc      = (int)soc_d;   // -1 when tsdb_unscale returns -1.0
-
         char buf[192];
-        if (soc >= 0) {
-          snprintf(buf, sizeof(buf),
-            "%s{\"ts\":%lu,\"a\":%.2f,\"t\":%.1f,\"e\":%.2f,\"s\":%d"
-            ",\"v\":%.1f,\"p\":%.1f,\"pilot\":%.1f}",
-            first ? "" : ",",
-            (unsigned long)ts, amps, temp_c, energy, soc,
-            volts, power_w, pilot_a);
-        } else {
-          snprintf(buf, sizeof(buf),
-            "%s{\"ts\":%lu,\"a\":%.2f,\"t\":%.1f,\"e\":%.2f,\"s\":-1"
-            ",\"v\":%.1f,\"p\":%.1f,\"pilot\":%.1f}",
-            first ? "" : ",",
-            (unsigned long)ts, amps, temp_c, energy,
-            volts, power_w, pilot_a);
-        }
+        tsdb_sample_json(buf, sizeof(buf), ts, v, first);
         response->print(buf);
         first = false;
         count++;
@@ -143,6 +124,125 @@ void handleEnergyRaw(MongooseHttpServerRequest *request)
 }
 
 
+// ---------------------------------------------------------------------------
+// /energy/export  –  bulk export of the raw tsdb or a rollup, binary
+//
+// For syncing the whole history to a backend. Streams the stored int16
+// columns as they are, delta/varint encoded, see energy_export.h for the
+// format. Records after `since` are returned oldest first, up to `max`; the
+// footer gives the cursor to pass as `since` for the next page. The response
+// is built in RAM before it is sent, so pages are kept to a few KB.
+//
+// Query params:
+//   since=T    only records after epoch T (default 0, from the oldest)
+//   max=N      records per response (default 256, at most 512)
+//   series=S   raw (default, TSDB_COL_* columns), hourly or daily
+//              (ROLLUP_COL_* columns, see tsdb_rollup.h)
+// ---------------------------------------------------------------------------
+
+#define ENERGY_EXPORT_DEFAULT_MAX  256
+#define ENERGY_EXPORT_LIMIT        512      // ~5 KB typical, 13 KB worst case
+
+void handleEnergyExport(MongooseHttpServerRequest *request)
+{
+  MongooseHttpServerResponseStream *response = nullptr;
+
+  if (false == requestPreProcess(request, response, CONTENT_TYPE_OCTET)) {
+    return;
+  }
+
+  if (HTTP_GET == request->method()) {
+    char since_buf[12]  = {0};
+    char max_buf[8]     = {0};
+    char series_buf[8]  = {0};
+
+    uint32_t since = 0;
+    if (request->getParam("since", since_buf, sizeof(since_buf)) >= 0 && since_buf[0] != '\0') {
+      since = (uint32_t)strtoul(since_buf, NULL, 10);
+    }
+    uint32_t max_records = ENERGY_EXPORT_DEFAULT_MAX;
+    if (request->getParam("max", max_buf, sizeof(max_buf)) >= 0 && max_buf[0] != '\0') {
+      int m = atoi(max_buf);
+      if (m >= 1 && m <= ENERGY_EXPORT_LIMIT) max_records = (uint32_t)m;
+    }
+
+    tsdb_t *db = NULL;      // NULL for the raw tsdb
+    uint8_t cols = TSDB_NUM_COLS;
+    if (request->getParam("series", series_buf, sizeof(series_buf)) >= 0 && series_buf[0] != '\0') {
+      bool rollup = true;
+      if (0 == strcmp(series_buf, "hourly")) {
+        db = tsdbEnergyLogger.hourlyRollup();
+      } else if (0 == strcmp(series_buf, "daily")) {
+        db = tsdbEnergyLogger.dailyRollup();
+      } else if (0 == strcmp(series_buf, "raw")) {
+        rollup = false;
+      } else {
+        response->setCode(400);
+        request->send(response);
+        return;
+      }
+      if (rollup) {
+        // Not opened, eg no room on the partition
+        if (db == NULL) {
+          response->setCode(404);
+          request->send(response);
+          return;
+        }
+        cols = ROLLUP_NUM_COLS;
+      }
+    }
+
+    response->setCode(200);
+
+    EnergyExportEncoder encoder(cols);
+    uint8_t buf[512];
+    size_t  len = encoder.header(buf);
+    bool    more = false;
+
+    // Guard on isReady(): if tsdb_init failed, the global DB handle is invalid
+    tsdb_query_t q;
+    uint32_t end = (uint32_t)time(NULL);
+    esp_err_t err = ESP_FAIL;
+    if (tsdbEnergyLogger.isReady() && since < end) {
+      err = db ? tsdb_query_init_h(db, &q, since + 1, end, NULL, cols)
+               : tsdb_query_init(&q, since + 1, end, NULL, cols);
+    }
+    if (err == ESP_OK) {
+      uint32_t ts;
+      int16_t  v[ENERGY_EXPORT_MAX_COLS];
+      while (tsdb_query_next(&q, &ts, v) == ESP_OK) {
+        // Records sharing the last timestamp go in the same page, the next
+        // page starts after it
+        if (encoder.count() >= max_records && ts != encoder.last()) {
+          more = true;
+          break;
+        }
+        if (len + ENERGY_EXPORT_MAX_RECORD(cols) > sizeof(buf)) {
+          response->write(buf, len);
+          len = 0;
+        }
+        len += encoder.record(buf + len, ts, v);
+      }
+      tsdb_query_close(&q);
+    }
+
+    if (len + ENERGY_EXPORT_MAX_FOOTER > sizeof(buf)) {
+      response->write(buf, len);
+      len = 0;
+    }
+    len += encoder.footer(buf + len, more);
+    response->write(buf, len);
+
+  } else if (HTTP_OPTIONS == request->method()) {
+    response->setCode(200);
+  } else {
+    response->setCode(405);
+  }
+
+  request->send(response);
+}
+
+
 // ---------------------------------------------------------------------------
 // Shared bucketed-aggregate helper
 //
@@ -155,9 +255,12 @@ void handleEnergyRaw(MongooseHttpServerRequest *request)
 // This is the EXACT per-entry shape of the legacy EnergyLogger /energy/daily
 // response (wrapper is supplied by the caller).
 //
-// `date_key_is_bucket_start`:
-//   true  → "dt" = date of bucket start (used for daily where bucket ≡ day)
-//   false → "dt" = date of bucket start (same; weekly also uses start of week)
+// "dt" is the date of the bucket start (weekly also uses the start of week).
+//
+// Completed days are cached in RAM (energy_day_cache.h) so a repeat request
+// only touches the TSDB for days it has not seen; the cache is lost on a
+// reboot, and days that have since aged out of the TSDB ring are still
+// reported from it.
 //
 // Temp stored as deci-degC (x10) in TSDB_COL_TEMP, so divide by 10 for degC.
 // Energy stored as Wh delta per sample; SUM over bucket = total Wh.
@@ -188,10 +291,95 @@ static void format_date_buf(time_t t, char *buf, size_t len)
     tm_buf.tm_mday);
 }
 
+// Past days, aggregated once. See energy_day_cache.h
+static EnergyDayCache energy_day_cache;
+
+// Aggregate `days` consecutive days from `d0` into the cache in a single
+// streaming pass over the TSDB, fetching only the energy and temp columns.
+//
+// NOTE: the temp MIN includes no-sensor samples (stored as 0 deci-degC), so
+// on a day with any invalid-temp minute the reported "mn" can read 0.0. A
+// sentinel that fixed MIN would poison MAX. In practice the onboard MONITOR
+// thermistor is valid except for a brief boot transient (which the logger's
+// NTP write-guard usually skips), so this is a rare, secondary-display edge.
+// Accepted limitation, the same as the TSDB_AGG_MIN the rollups use.
+// Days the daily rollup (tsdb_rollup.h) has are read from it instead, one
+// row a day. Its rows are at local midnight, which the fixed 86400s steps
+// back from today drift an hour from across a DST change, so each row goes
+// to the nearest day.
+static bool read_rollup_days(uint32_t d0, uint32_t days)
+{
+  tsdb_t *db = tsdbEnergyLogger.dailyRollup();
+  uint32_t end = d0 + days * ENERGY_DAY_SECS;
+  if (db == nullptr || end > tsdbEnergyLogger.dailyRollupThrough()) {
+    return false;
+  }
+
+  tsdb_query_t q;
+  const uint32_t half_day = ENERGY_DAY_SECS / 2;
+  if (tsdb_query_init_h(db, &q, d0 - half_day, end - half_day - 1, NULL, ROLLUP_NUM_COLS) != ESP_OK) {
+    return false;
+  }
+
+  // Days without a row had no samples
+  for (uint32_t day = 0; day < days; day++) {
+    EnergyDay empty;
+    empty.begin(d0 + day * ENERGY_DAY_SECS);
+    energy_day_cache.store(empty);
+  }
+
+  uint32_t ts;
+  int16_t  v[ROLLUP_NUM_COLS];
+  while (tsdb_query_next(&q, &ts, v) == ESP_OK) {
+    RollupPeriod period;
+    period.fromRow(ts, v);
+
+    EnergyDay day;
+    day.begin(d0 + ((ts + half_day - d0) / ENERGY_DAY_SECS) * ENERGY_DAY_SECS);
+    day.count    = period.samples;
+    day.energy   = period.energy;
+    day.temp_max = period.temp_max;
+    day.temp_min = period.temp_min;
+    energy_day_cache.store(day);
+  }
+  tsdb_query_close(&q);
+
+  return true;
+}
+
+static void scan_days(uint32_t d0, uint32_t days)
+{
+  // Guard on isReady(): if tsdb_init failed, the global DB handle is invalid
+  if (!tsdbEnergyLogger.isReady()) return;
+
+  if (read_rollup_days(d0, days)) return;
+
+  static const uint8_t cols[2] = { TSDB_COL_ENERGY, TSDB_COL_TEMP };
+  tsdb_query_t q;
+  // tsdb range end_time is INCLUSIVE
+  if (tsdb_query_init(&q, d0, d0 + days * ENERGY_DAY_SECS - 1, cols, 2) != ESP_OK) {
+    return;
+  }
+
+  EnergyDayScan scan(energy_day_cache, d0, days);
+  uint32_t ts;
+  int16_t  v[2];
+  while (tsdb_query_next(&q, &ts, v) == ESP_OK) {
+    scan.add(ts, v[0], v[1]);
+  }
+  tsdb_query_close(&q);
+
+  scan.finish();
+}
+
 // Emit a bucketed daily-shaped JSON array into the streaming response.
 // `bucket_days` controls the bucket width (1 = daily, 7 = weekly).
 // `num_buckets` controls how many buckets to generate (window = num_buckets
 //  buckets immediately before now, aligned to bucket boundaries).
+//
+// Buckets are merged from cached days; the days not cached yet are scanned
+// in as few passes as possible, usually one on the first request and then
+// just yesterday's once a day.
 static void emit_bucketed_daily(MongooseHttpServerResponseStream *response,
                                 int bucket_days,
                                 int num_buckets)
@@ -202,45 +390,48 @@ static void emit_bucketed_daily(MongooseHttpServerResponseStream *response,
   // This ensures each bucket is a clean calendar-day multiple.
   time_t today_start = start_of_day(now_t);
   time_t window_start = today_start - (time_t)(num_buckets * bucket_days) * 86400;
+  uint32_t window_days = (uint32_t)(num_buckets * bucket_days);
+
+  energy_day_cache.setToday((uint32_t)today_start);
 
   bool first = true;
   response->print("[");
 
+  uint32_t days_per_bucket = (uint32_t)bucket_days;
+
   for (int i = 0; i < num_buckets; i++) {
-    uint32_t d0 = (uint32_t)(window_start + (time_t)(i * bucket_days) * 86400);
-    // tsdb range end_time is INCLUSIVE, so use d1_end = (next bucket start - 1)
-    // to avoid a sample landing exactly on the midnight boundary being counted
-    // in both adjacent buckets.
-    uint32_t d1_end = d0 + (uint32_t)(bucket_days) * 86400 - 1;
-
-    // --- check record count first to skip empty buckets cheaply ---
-    uint32_t cnt = 0;
-    if (tsdb_query_count(d0, d1_end, &cnt) != ESP_OK || cnt == 0) {
-      continue;
+    uint32_t first_day = (uint32_t)i * days_per_bucket;
+    uint32_t d0 = (uint32_t)window_start + first_day * ENERGY_DAY_SECS;
+
+    // Scan from the first day of this bucket not cached, on through the
+    // following days that are not cached either. Capped so the scan can not
+    // evict the days of this bucket from the cache.
+    for (uint32_t day = first_day; day < first_day + days_per_bucket; day++) {
+      uint32_t day_start = (uint32_t)window_start + day * ENERGY_DAY_SECS;
+      if (energy_day_cache.find(day_start)) continue;
+
+      uint32_t run = 1;
+      while (day + run < window_days &&
+             run < ENERGY_DAY_CACHE_DAYS - days_per_bucket &&
+             !energy_day_cache.find(day_start + run * ENERGY_DAY_SECS)) {
+        run++;
+      }
+      scan_days(day_start, run);
+      break;
     }
 
-    // --- three aggregations in one pass ---
-    // NOTE: TSDB_AGG_MIN on TEMP includes no-sensor samples (stored as 0 deci-degC),
-    // so on a day with any invalid-temp minute the reported "mn" can read 0.0. The
-    // engine's MIN/MAX cannot exclude invalid samples (a sentinel that fixes MIN
-    // would poison MAX). In practice the onboard MONITOR thermistor is valid except
-    // for a brief boot transient (which the logger's NTP write-guard usually skips),
-    // so this is a rare, secondary-display edge. Accepted limitation.
-    tsdb_agg_request_t reqs[3] = {
-      { TSDB_COL_ENERGY, TSDB_AGG_SUM, 0 },
-      { TSDB_COL_TEMP,   TSDB_AGG_MAX, 0 },
-      { TSDB_COL_TEMP,   TSDB_AGG_MIN, 0 },
-    };
-
-    uint32_t nscanned = 0;
-    esp_err_t err = tsdb_aggregate_multi(d0, d1_end, reqs, 3, &nscanned);
-    if (err != ESP_OK || nscanned == 0) {
+    EnergyDay bucket;
+    bucket.begin(d0);
+    for (uint32_t day = 0; day < days_per_bucket; day++) {
+      const EnergyDay *cached = energy_day_cache.find(d0 + day * ENERGY_DAY_SECS);
+      if (cached) bucket.merge(*cached);
+    }
+    if (bucket.count == 0) {
       continue;
     }
 
-    int32_t energy_wh = reqs[0].result;            // Wh (int32; sum of Wh deltas)
-    double  peak_c    = (double)reqs[1].result / 10.0; // deci-degC → degC
-    double  min_c     = (double)reqs[2].result / 10.0;
+    double peak_c = (double)bucket.temp_max / 10.0; // deci-degC → degC
+    double min_c  = (double)bucket.temp_min / 10.0;
 
     char dt_buf[12];
     format_date_buf((time_t)d0, dt_buf, sizeof(dt_buf));
@@ -252,7 +443,7 @@ static void emit_bucketed_daily(MongooseHttpServerResponseStream *response,
       dt_buf,
       peak_c,
       min_c,
-      (long)energy_wh);
+      (long)bucket.energy);
 
     response->print(obj_buf);
     first = false;
@@ -351,6 +542,94 @@ void handleEnergyWeekly(MongooseHttpServerRequest *request)
   request->send(response);
 }
 
+// ---------------------------------------------------------------------------
+// /energy/hourly  –  from the hourly rollup (NEW, no legacy equivalent)
+//
+// One entry per hour with samples, oldest first, the hour in progress last:
+//
+//   { "hourly": [
+//       { "ts": <hour_start_epoch>, "en": <wh>, "pk": <peak_c>, "mn": <min_c>,
+//         "p": <mean_power_w_while_charging>, "cm": <charging_minutes> },
+//       ...
+//   ]}
+//
+// Query params:
+//   hours=N   window size (default 48, the rollup keeps about a year)
+// ---------------------------------------------------------------------------
+
+#define ENERGY_HOURLY_DEFAULT_HOURS  48
+#define ENERGY_HOURLY_MAX_HOURS      (366 * 24)
+
+static void emit_hour(MongooseHttpServerResponseStream *response, const RollupPeriod &hour, bool first)
+{
+  char obj_buf[128];
+  snprintf(obj_buf, sizeof(obj_buf),
+    "%s{\"ts\":%lu,\"en\":%ld,\"pk\":%.1f,\"mn\":%.1f,\"p\":%d,\"cm\":%u}",
+    first ? "" : ",",
+    (unsigned long)hour.start,
+    (long)hour.energy,
+    (double)hour.temp_max / 10.0,
+    (double)hour.temp_min / 10.0,
+    (int)hour.powerAvg() * 10,          // deca-watt → W
+    (unsigned)hour.chargeMinutes());
+  response->print(obj_buf);
+}
+
+void handleEnergyHourly(MongooseHttpServerRequest *request)
+{
+  MongooseHttpServerResponseStream *response = nullptr;
+
+  if (false == requestPreProcess(request, response, CONTENT_TYPE_JSON)) {
+    return;
+  }
+
+  if (HTTP_GET == request->method()) {
+    char hours_buf[8] = {0};
+    int num_hours = ENERGY_HOURLY_DEFAULT_HOURS;
+    if (request->getParam("hours", hours_buf, sizeof(hours_buf)) >= 0 && hours_buf[0] != '\0') {
+      int h = atoi(hours_buf);
+      if (h >= 1 && h <= ENERGY_HOURLY_MAX_HOURS) num_hours = h;
+    }
+
+    uint32_t now = (uint32_t)time(NULL);
+    uint32_t start = now - (now % 3600) - (uint32_t)(num_hours - 1) * 3600;
+
+    response->setCode(200);
+    response->print("{\"hourly\":[");
+
+    bool first = true;
+    tsdb_t *db = tsdbEnergyLogger.hourlyRollup();
+    tsdb_query_t q;
+    if (db != nullptr &&
+        tsdb_query_init_h(db, &q, start, now, NULL, ROLLUP_NUM_COLS) == ESP_OK) {
+      uint32_t ts;
+      int16_t  v[ROLLUP_NUM_COLS];
+      while (tsdb_query_next(&q, &ts, v) == ESP_OK) {
+        RollupPeriod hour;
+        hour.fromRow(ts, v);
+        emit_hour(response, hour, first);
+        first = false;
+      }
+      tsdb_query_close(&q);
+    }
+
+    // Not written until the hour is over
+    const RollupPeriod &current = tsdbEnergyLogger.currentHour();
+    if (current.samples > 0 && current.start >= start) {
+      emit_hour(response, current, first);
+    }
+
+    response->print("]}");
+
+  } else if (HTTP_OPTIONS == request->method()) {
+    response->setCode(200);
+  } else {
+    response->setCode(405);
+  }
+
+  request->send(response);
+}
+
 // ---------------------------------------------------------------------------
 // /energy/monthly  –  tsdb path: stream the persisted daily-fed rollup JSON.
 //
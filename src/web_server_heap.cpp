@@ -0,0 +1,98 @@
+#if defined(ENABLE_DEBUG) && !defined(ENABLE_DEBUG_WEB)
+#undef ENABLE_DEBUG
+#endif
+
+#include <Arduino.h>
+
+#include "emonesp.h"
+#include "web_server.h"
+#include "heap_monitor.h"
+#include "task_profiler.h"
+#include "json_pool.h"
+
+// Written out by hand as for /debug/profile, a JsonDocument would itself
+// take a sizeable block from the heap being reported on
+static void handleHeapGet(MongooseHttpServerRequest *request, MongooseHttpServerResponseStream *response)
+{
+  const HeapTrend &trend = heapMonitor.trend();
+  uint32_t free = HeapMonitor::getFree();
+  uint32_t largest = HeapMonitor::getLargestFreeBlock();
+  HeapSample now = { millis(), free, largest };
+
+  response->setCode(200);
+  response->printf("{\"uptime\":%lu,\"free\":%lu,\"largest\":%lu,\"fragmentation\":%u,\"min_free\":%lu,\"min_largest\":%lu,\"interval\":%lu,\"tracking\":%s,\"since\":%lu,\"trend\":[",
+    (unsigned long)now.time, (unsigned long)free, (unsigned long)largest, now.fragmentation(),
+    (unsigned long)heapMonitor.getMinFree(),
+    (unsigned long)(trend.count() > 0 ? trend.minLargest() : largest),
+    (unsigned long)HEAP_MONITOR_INTERVAL,
+    HeapMonitor::isTracking() ? "true" : "false",
+    (unsigned long)profiler.heapSince());
+
+  // [time, free, largest, fragmentation]
+  for(size_t i = 0; i < trend.count(); i++)
+  {
+    const HeapSample &sample = trend.get(i);
+    response->printf("%s[%lu,%lu,%lu,%u]", i > 0 ? "," : "",
+      (unsigned long)sample.time, (unsigned long)sample.free,
+      (unsigned long)sample.largest, sample.fragmentation());
+  }
+  response->print("],\"sections\":[");
+
+  // Only sections that have touched the heap
+  bool first = true;
+  for(size_t i = 0; i < profiler.count(); i++)
+  {
+    const ProfileEntry *entry = profiler.get(i);
+    if(0 == entry->allocs && 0 == entry->frees) {
+      continue;
+    }
+    response->printf("%s{\"name\":\"%s\",\"allocs\":%lu,\"alloc_bytes\":%llu,\"frees\":%lu,\"free_bytes\":%llu}",
+      first ? "" : ",", entry->name,
+      (unsigned long)entry->allocs, (unsigned long long)entry->alloc_bytes,
+      (unsigned long)entry->frees, (unsigned long long)entry->free_bytes);
+    first = false;
+  }
+
+  // JSON document buffers, see json_pool.h
+  response->printf("],\"json_pool_misses\":%lu,\"json_pool_largest_miss\":%lu,\"json_pool\":[",
+    (unsigned long)jsonPool.misses(), (unsigned long)jsonPool.largestMiss());
+  for(uint8_t cls = 0; cls < JSON_POOL_CLASSES; cls++)
+  {
+    const JsonPoolStats &stats = jsonPool.stats(cls);
+    response->printf("%s{\"size\":%lu,\"blocks\":%u,\"in_use\":%u,\"high_water\":%u,\"leases\":%lu}",
+      cls > 0 ? "," : "", (unsigned long)stats.size, stats.blocks, stats.in_use,
+      stats.high_water, (unsigned long)stats.leases);
+  }
+
+  response->print("]}");
+}
+
+// -------------------------------------------------------------------
+// Heap telemetry
+// url: /debug/heap
+//   GET    free heap, largest free block and their recent trend, plus the
+//          allocations per profiled section with ENABLE_HEAP_TRACKING and
+//          the use of the JSON document pool
+//   DELETE clear the trend, allocation counts and pool high water marks
+// -------------------------------------------------------------------
+void handleHeap(MongooseHttpServerRequest *request)
+{
+  MongooseHttpServerResponseStream *response;
+  if(false == requestPreProcess(request, response, CONTENT_TYPE_JSON)) {
+    return;
+  }
+
+  if(HTTP_GET == request->method()) {
+    handleHeapGet(request, response);
+  } else if(HTTP_DELETE == request->method()) {
+    heapMonitor.reset();
+    jsonPool.resetStats();
+    response->setCode(200);
+    response->print("{\"msg\":\"done\"}");
+  } else {
+    response->setCode(405);
+    response->print("{\"msg\":\"Method not allowed\"}");
+  }
+
+  request->send(response);
+}
@@ -0,0 +1,73 @@
+#if defined(ENABLE_DEBUG) && !defined(ENABLE_DEBUG_WEB)
+#undef ENABLE_DEBUG
+#endif
+
+#include <Arduino.h>
+
+#include "emonesp.h"
+#include "web_server.h"
+#include "task_profiler.h"
+#include "lcd.h"
+
+// Written out by hand rather than through a JsonDocument, with every section
+// and its histogram the document would be several KB
+static void handleProfileGet(MongooseHttpServerRequest *request, MongooseHttpServerResponseStream *response)
+{
+  response->setCode(200);
+  response->printf("{\"since\":%lu,\"uptime\":%lu,\"buckets\":[",
+    (unsigned long)profiler.since(), (unsigned long)millis());
+  for(uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+    response->printf("%s%lu", b > 0 ? "," : "", (unsigned long)TaskProfiler::bucketStart(b));
+  }
+  response->print("],\"sections\":[");
+
+  for(size_t i = 0; i < profiler.count(); i++)
+  {
+    const ProfileEntry *entry = profiler.get(i);
+    response->printf("%s{\"name\":\"%s\",\"count\":%lu,\"total_us\":%llu,\"max_us\":%lu,\"histogram\":[",
+      i > 0 ? "," : "", entry->name,
+      (unsigned long)entry->count, (unsigned long long)entry->total_us, (unsigned long)entry->max_us);
+    for(uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+      response->printf("%s%lu", b > 0 ? "," : "", (unsigned long)entry->histogram[b]);
+    }
+    response->print("]}");
+  }
+  response->print("]");
+
+#if !ENABLE_SCREEN_LVGL_TFT && !ENABLE_SCREEN_LCD_TFT
+  // RAPI traffic to the character LCD since boot, not cleared by DELETE
+  const LcdShadowStats &lcdStats = lcd.getDisplayStats();
+  response->printf(",\"lcd\":{\"writes\":%lu,\"skipped\":%lu,\"commands\":%lu,\"chars\":%lu,\"failures\":%lu}",
+    (unsigned long)lcdStats.writes, (unsigned long)lcdStats.skipped, (unsigned long)lcdStats.commands,
+    (unsigned long)lcdStats.chars, (unsigned long)lcdStats.failures);
+#endif
+
+  response->print("}");
+}
+
+// -------------------------------------------------------------------
+// Main loop run time statistics
+// url: /debug/profile
+//   GET    the statistics since boot or the last reset
+//   DELETE clear the statistics
+// -------------------------------------------------------------------
+void handleProfile(MongooseHttpServerRequest *request)
+{
+  MongooseHttpServerResponseStream *response;
+  if(false == requestPreProcess(request, response, CONTENT_TYPE_JSON)) {
+    return;
+  }
+
+  if(HTTP_GET == request->method()) {
+    handleProfileGet(request, response);
+  } else if(HTTP_DELETE == request->method()) {
+    profiler.reset(millis());
+    response->setCode(200);
+    response->print("{\"msg\":\"done\"}");
+  } else {
+    response->setCode(405);
+    response->print("{\"msg\":\"Method not allowed\"}");
+  }
+
+  request->send(response);
+}
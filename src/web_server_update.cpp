@@ -9,6 +9,7 @@
 #include "web_server.h"
 #include "lcd.h"
 #include "http_update.h"
+#include "ota_signing.h"
 
 
 // -------------------------------------------------------------------
@@ -65,11 +66,22 @@ void handleUpdateFileFetch(MongooseHttpServerRequest *request)
   if(DeserializationError::Code::Ok == error)
   {
     String url = doc["url"];
+
+    // Optional digest of the image, checked as it is streamed to flash
+    if(!ota_expect_sha256(doc["sha256"] | ""))
+    {
+      response->setCode(400);
+      response->print(F("{\"msg\":\"invalid sha256\"}"));
+      request->send(response);
+      return;
+    }
+
     if(http_update_from_url(url,
       [](size_t complete, size_t total) {},
       [](int) { },
       [](int errorCode) {
         DEBUG_PORT.printf("HTTP OTA failed: %d\n", errorCode);
+        ota_expect_sha256(NULL);
         StaticJsonDocument<128> event;
         event["ota"] = "failed";
         event["ota_error"] = errorCode;
@@ -111,6 +123,11 @@ void handleUpdateRequest(MongooseHttpServerRequest *request)
 
 static void handleUpdateError(MongooseHttpServerRequest *request)
 {
+  // Already reported, later parts of the upload are ignored
+  if(NULL == upgradeResponse) {
+    return;
+  }
+
   upgradeResponse->setCode(500);
   upgradeResponse->printf("Error: %d", Update.getError());
   request->send(upgradeResponse);
@@ -120,6 +137,8 @@ static void handleUpdateError(MongooseHttpServerRequest *request)
 #ifdef ENABLE_DEBUG
   Update.printError(DEBUG_PORT);
 #endif
+
+  http_update_abort();
 }
 
 size_t handleUpdateUpload(MongooseHttpServerRequest *request, int ev, MongooseString filename, uint64_t index, uint8_t *data, size_t len)
@@ -133,7 +152,7 @@ size_t handleUpdateUpload(MongooseHttpServerRequest *request, int ev, MongooseSt
     }
   }
 
-  if(!Update.hasError())
+  if(http_update_running())
   {
     if(!http_update_write(data, len)) {
       handleUpdateError(request);
@@ -161,6 +180,8 @@ void handleUpdateClose(MongooseHttpServerRequest *request)
   DBUGLN("Update close");
 
   if(upgradeResponse) {
+    // Connection dropped part way through the upload
+    http_update_abort();
     delete upgradeResponse;
     upgradeResponse = NULL;
   }
@@ -0,0 +1,99 @@
+// Host-side tests for the certificate store index (certificate_index.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <string>
+#include <vector>
+
+#include "certificate_index.h"
+
+static CertificateIndexEntry entry(uint64_t id, uint8_t type, const char *name,
+                                   uint32_t cert_len, uint32_t key_len)
+{
+  CertificateIndexEntry e;
+  e.id = id;
+  e.type = type;
+  e.name = name;
+  e.cert_offset = 0;
+  e.cert_len = cert_len;
+  e.key_offset = cert_len;
+  e.key_len = key_len;
+  return e;
+}
+
+static bool decode(const std::string &data, std::vector<CertificateIndexEntry> &entries)
+{
+  return certificate_index_decode((const uint8_t *)data.data(), data.size(), entries);
+}
+
+TEST_CASE("entries survive a round trip") {
+  std::vector<CertificateIndexEntry> in;
+  in.push_back(entry(0x0123456789abcdefULL, 1, "Home CA", 1200, 0));
+  in.push_back(entry(0xfedcba9876543210ULL, 2, "MQTT client", 1300, 1700));
+  in.push_back(entry(42, 1, "", 900, 0));
+
+  std::string data;
+  certificate_index_encode(in, data);
+  CHECK(data.size() == CERTIFICATE_INDEX_HEADER_SIZE + 3 * CERTIFICATE_INDEX_RECORD_SIZE + 7 + 11);
+
+  std::vector<CertificateIndexEntry> out;
+  REQUIRE(decode(data, out));
+  REQUIRE(out.size() == in.size());
+  for(size_t i = 0; i < in.size(); i++) {
+    CHECK(out[i].id == in[i].id);
+    CHECK(out[i].type == in[i].type);
+    CHECK(out[i].name == in[i].name);
+    CHECK(out[i].cert_offset == in[i].cert_offset);
+    CHECK(out[i].cert_len == in[i].cert_len);
+    CHECK(out[i].key_offset == in[i].key_offset);
+    CHECK(out[i].key_len == in[i].key_len);
+  }
+}
+
+TEST_CASE("an empty store encodes to just the header") {
+  std::string data;
+  certificate_index_encode(std::vector<CertificateIndexEntry>(), data);
+  CHECK(data.size() == CERTIFICATE_INDEX_HEADER_SIZE);
+
+  std::vector<CertificateIndexEntry> out;
+  CHECK(decode(data, out));
+  CHECK(out.empty());
+}
+
+TEST_CASE("long names are truncated") {
+  std::vector<CertificateIndexEntry> in;
+  in.push_back(entry(1, 1, std::string(300, 'x').c_str(), 10, 0));
+
+  std::string data;
+  certificate_index_encode(in, data);
+  std::vector<CertificateIndexEntry> out;
+  REQUIRE(decode(data, out));
+  CHECK(out[0].name == std::string(CERTIFICATE_INDEX_NAME_MAX, 'x'));
+}
+
+TEST_CASE("corrupt indexes are rejected") {
+  std::vector<CertificateIndexEntry> in;
+  in.push_back(entry(1, 1, "root", 10, 0));
+  in.push_back(entry(2, 2, "client", 10, 20));
+  std::string data;
+  certificate_index_encode(in, data);
+
+  std::vector<CertificateIndexEntry> out;
+
+  // truncated anywhere
+  for(size_t len = 0; len < data.size(); len++) {
+    CHECK_FALSE(decode(data.substr(0, len), out));
+    CHECK(out.empty());
+  }
+
+  // trailing garbage
+  CHECK_FALSE(decode(data + "x", out));
+
+  std::string bad = data;
+  bad[0] = 'X';
+  CHECK_FALSE(decode(bad, out));
+
+  bad = data;
+  bad[4] = CERTIFICATE_INDEX_VERSION + 1;
+  CHECK_FALSE(decode(bad, out));
+}
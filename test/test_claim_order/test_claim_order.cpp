@@ -0,0 +1,149 @@
+// Host-side tests for the EvseManager claim order and winners (claim_order.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include "claim_order.h"
+
+#define SETS_STATE    CLAIM_SETS(CLAIM_PROPERTY_STATE)
+#define SETS_CHARGE   CLAIM_SETS(CLAIM_PROPERTY_CHARGE_CURRENT)
+#define SETS_MAX      CLAIM_SETS(CLAIM_PROPERTY_MAX_CURRENT)
+
+TEST_CASE("claims are ordered highest priority first") {
+  ClaimOrder order;
+  order.set(0, 50, SETS_STATE);
+  order.set(1, 1000, SETS_STATE);
+  order.set(2, 200, SETS_CHARGE);
+
+  REQUIRE(order.count() == 3);
+  CHECK(order.slot(0) == 1);
+  CHECK(order.slot(1) == 2);
+  CHECK(order.slot(2) == 0);
+
+  order.evaluate();
+  CHECK(order.winner(CLAIM_PROPERTY_STATE) == 1);
+  CHECK(order.winnerPriority(CLAIM_PROPERTY_STATE) == 1000);
+  CHECK(order.winner(CLAIM_PROPERTY_CHARGE_CURRENT) == 2);
+  CHECK(order.winner(CLAIM_PROPERTY_MAX_CURRENT) == CLAIM_SLOT_NONE);
+  CHECK(order.winnerPriority(CLAIM_PROPERTY_MAX_CURRENT) == 0);
+}
+
+TEST_CASE("equal priorities are won by the lowest slot") {
+  ClaimOrder order;
+  // Added out of slot order
+  order.set(3, 500, SETS_STATE | SETS_CHARGE);
+  order.set(1, 500, SETS_STATE);
+  order.set(2, 500, SETS_CHARGE);
+
+  CHECK(order.slot(0) == 1);
+  CHECK(order.slot(1) == 2);
+  CHECK(order.slot(2) == 3);
+
+  order.evaluate();
+  CHECK(order.winner(CLAIM_PROPERTY_STATE) == 1);
+  CHECK(order.winner(CLAIM_PROPERTY_CHARGE_CURRENT) == 2);
+
+  // A higher slot of the same priority could still win, a lower one too
+  CHECK(order.affects(3));
+  order.set(0, 500, SETS_CHARGE);
+  CHECK(order.affects(0));
+  order.evaluate();
+  CHECK(order.winner(CLAIM_PROPERTY_CHARGE_CURRENT) == 0);
+}
+
+TEST_CASE("a priority change on an existing claim moves it") {
+  ClaimOrder order;
+  order.set(0, 100, SETS_STATE);
+  order.set(1, 200, SETS_STATE);
+  order.evaluate();
+  CHECK(order.winner(CLAIM_PROPERTY_STATE) == 1);
+
+  order.set(0, 300, SETS_STATE);
+  REQUIRE(order.count() == 2);
+  CHECK(order.slot(0) == 0);
+  CHECK(order.slot(1) == 1);
+  CHECK(order.affects(0));
+  order.evaluate();
+  CHECK(order.winner(CLAIM_PROPERTY_STATE) == 0);
+  CHECK(order.winnerPriority(CLAIM_PROPERTY_STATE) == 300);
+
+  // Dropping back below gives it up again
+  order.set(0, 50, SETS_STATE);
+  CHECK(order.count() == 2);
+  CHECK(order.slot(1) == 0);
+  CHECK(order.affects(0));
+  order.evaluate();
+  CHECK(order.winner(CLAIM_PROPERTY_STATE) == 1);
+
+  // Only the properties changing keeps its place
+  order.set(0, 50, SETS_STATE | SETS_MAX);
+  CHECK(order.slot(1) == 0);
+  order.evaluate();
+  CHECK(order.winner(CLAIM_PROPERTY_MAX_CURRENT) == 0);
+}
+
+TEST_CASE("releasing the winning claim hands the property on") {
+  ClaimOrder order;
+  order.set(0, 10, SETS_STATE);
+  order.set(1, 1000, SETS_STATE | SETS_CHARGE);
+  order.set(2, 50, SETS_CHARGE);
+  order.evaluate();
+  REQUIRE(order.winner(CLAIM_PROPERTY_STATE) == 1);
+
+  // The winner must be evaluated away before it goes
+  CHECK(order.affects(1));
+  order.remove(1);
+  CHECK(order.count() == 2);
+  CHECK_FALSE(order.contains(1));
+  CHECK_FALSE(order.affects(1));
+
+  order.evaluate();
+  CHECK(order.winner(CLAIM_PROPERTY_STATE) == 0);
+  CHECK(order.winnerPriority(CLAIM_PROPERTY_STATE) == 10);
+  CHECK(order.winner(CLAIM_PROPERTY_CHARGE_CURRENT) == 2);
+
+  order.remove(0);
+  order.remove(2);
+  CHECK(order.count() == 0);
+  order.evaluate();
+  CHECK(order.winner(CLAIM_PROPERTY_STATE) == CLAIM_SLOT_NONE);
+  CHECK(order.winner(CLAIM_PROPERTY_CHARGE_CURRENT) == CLAIM_SLOT_NONE);
+}
+
+TEST_CASE("a claim that can't win anything does not affect the target") {
+  ClaimOrder order;
+  order.set(0, 1000, SETS_STATE | SETS_CHARGE | SETS_MAX);
+  order.set(1, 50, SETS_STATE | SETS_CHARGE);
+  order.set(2, 5000, 0);
+  order.set(3, 0, SETS_STATE);
+  order.evaluate();
+
+  // Outranked on everything it asks for
+  CHECK_FALSE(order.affects(1));
+  // Asks for nothing
+  CHECK_FALSE(order.affects(2));
+  // Priority 0 never wins
+  CHECK_FALSE(order.affects(3));
+  // Not a claim
+  CHECK_FALSE(order.affects(4));
+
+  // Asking for a property nothing has claimed does
+  order.set(1, 50, SETS_STATE);
+  CHECK_FALSE(order.affects(1));
+  order.remove(0);
+  order.evaluate();
+  CHECK(order.affects(1));
+  CHECK(order.winner(CLAIM_PROPERTY_STATE) == 1);
+  CHECK(order.winner(CLAIM_PROPERTY_MAX_CURRENT) == CLAIM_SLOT_NONE);
+  order.set(2, 5000, SETS_MAX);
+  CHECK(order.affects(2));
+}
+
+TEST_CASE("evaluation stops at priority 0") {
+  ClaimOrder order;
+  order.set(0, 0, SETS_STATE);
+  order.set(1, -10, SETS_CHARGE);
+  order.evaluate();
+  CHECK(order.winner(CLAIM_PROPERTY_STATE) == CLAIM_SLOT_NONE);
+  CHECK(order.winner(CLAIM_PROPERTY_CHARGE_CURRENT) == CLAIM_SLOT_NONE);
+  CHECK(order.count() == 2);
+}
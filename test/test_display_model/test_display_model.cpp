@@ -0,0 +1,133 @@
+// Host-side tests for the shared display model (display_model.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <string.h>
+
+#include "display_model.h"
+
+static void push(DisplayMessageQueue &queue, const char *text, int y, uint32_t time,
+                 uint32_t now, bool immediate = false, uint8_t priority = DISPLAY_PRIORITY_NORMAL)
+{
+  queue.push(text, 0, y, time, true, priority, immediate, now);
+}
+
+TEST_CASE("messages are shown in order, each for its time") {
+  DisplayMessageQueue queue;
+  DisplayMessage msg;
+  CHECK(queue.nextChange(0) == DISPLAY_MESSAGE_IDLE);
+
+  push(queue, "Hostname:", 0, 0, 1000);
+  push(queue, "openevse-55ad", 1, 5000, 1000);
+  push(queue, "IP Address:", 0, 0, 1000);
+  push(queue, "192.168.1.2", 1, 5000, 1000);
+  CHECK(queue.nextChange(1000) == 0);
+
+  REQUIRE(queue.pop(1000, msg));
+  CHECK(strcmp(msg.text, "Hostname:") == 0);
+  REQUIRE(queue.pop(1000, msg));
+  CHECK(strcmp(msg.text, "openevse-55ad") == 0);
+  CHECK(msg.y == 1);
+  CHECK_FALSE(queue.pop(1000, msg));
+  CHECK(queue.holding(5999));
+  CHECK(queue.nextChange(2000) == 4000);
+
+  REQUIRE(queue.pop(6000, msg));
+  CHECK(strcmp(msg.text, "IP Address:") == 0);
+  REQUIRE(queue.pop(6000, msg));
+  CHECK(queue.empty());
+  CHECK(queue.holding(10999));
+  CHECK_FALSE(queue.holding(11000));
+  CHECK(queue.nextChange(11000) == DISPLAY_MESSAGE_IDLE);
+}
+
+TEST_CASE("a message to an idle queue is shown straight away") {
+  DisplayMessageQueue queue;
+  DisplayMessage msg;
+  push(queue, "Tag detected", 1, 3000, 0);
+  REQUIRE(queue.pop(0, msg));
+
+  push(queue, "Card accepted", 1, 5000, 100);
+  REQUIRE(queue.pop(100, msg));
+  CHECK(strcmp(msg.text, "Card accepted") == 0);
+}
+
+TEST_CASE("now replaces queued messages of the same or lower priority") {
+  DisplayMessageQueue queue;
+  DisplayMessage msg;
+  push(queue, "Hostname:", 0, 0, 0);
+  push(queue, "openevse", 1, 5000, 0);
+  push(queue, "later", 1, 5000, 0);
+  REQUIRE(queue.pop(0, msg));
+  REQUIRE(queue.pop(0, msg));
+
+  push(queue, "Wrong Tag", 1, 5000, 100, true);
+  CHECK(queue.size() == 1);
+  REQUIRE(queue.pop(100, msg));
+  CHECK(strcmp(msg.text, "Wrong Tag") == 0);
+}
+
+TEST_CASE("a high priority message is not preempted") {
+  DisplayMessageQueue queue;
+  DisplayMessage msg;
+  push(queue, "Updating WiFi", 0, 0, 0, true, DISPLAY_PRIORITY_HIGH);
+  REQUIRE(queue.pop(0, msg));
+  push(queue, "10%", 1, 10000, 0, true, DISPLAY_PRIORITY_HIGH);
+  REQUIRE(queue.pop(0, msg));
+
+  // An RFID scan waits for the OTA message to finish
+  push(queue, "Tag detected", 0, 0, 100, true);
+  CHECK_FALSE(queue.pop(100, msg));
+  CHECK(queue.nextChange(100) == 9900);
+  REQUIRE(queue.pop(10000, msg));
+  CHECK(strcmp(msg.text, "Tag detected") == 0);
+
+  // and is superseded by more OTA progress
+  push(queue, "20%", 1, 10000, 10100, true, DISPLAY_PRIORITY_HIGH);
+  REQUIRE(queue.pop(10100, msg));
+  push(queue, "Scan badge again", 1, 1000, 10200, true);
+  push(queue, "30%", 1, 10000, 10300, true, DISPLAY_PRIORITY_HIGH);
+  REQUIRE(queue.pop(10300, msg));
+  CHECK(strcmp(msg.text, "30%") == 0);
+  CHECK(queue.empty());
+}
+
+TEST_CASE("stale and overflowing messages are dropped") {
+  DisplayMessageQueue queue;
+  DisplayMessage msg;
+  push(queue, "first", 1, DISPLAY_MESSAGE_EXPIRY + 1000, 0);
+  push(queue, "stale", 1, 1000, 0);
+  REQUIRE(queue.pop(0, msg));
+  CHECK_FALSE(queue.pop(DISPLAY_MESSAGE_EXPIRY, msg));
+  CHECK_FALSE(queue.pop(DISPLAY_MESSAGE_EXPIRY + 1000, msg));
+  CHECK(queue.dropped() == 1);
+  CHECK(queue.empty());
+
+  queue.clear();
+  for(int i = 0; i < DISPLAY_MESSAGE_QUEUE_SIZE + 2; i++) {
+    push(queue, "normal", 1, 1000, 0);
+  }
+  CHECK(queue.size() == DISPLAY_MESSAGE_QUEUE_SIZE);
+  push(queue, "Error", 1, 1000, 0, false, DISPLAY_PRIORITY_HIGH);
+  CHECK(queue.size() == DISPLAY_MESSAGE_QUEUE_SIZE);
+  REQUIRE(queue.pop(0, msg));
+  CHECK(strcmp(msg.text, "Error") == 0);
+}
+
+TEST_CASE("state snapshots report what changed") {
+  DisplayState a, b;
+  CHECK(a.diff(b) == 0);
+  b.amps = 16.2;
+  CHECK(a.diff(b) == DISPLAY_CHANGED_VALUES);
+  b.vehicle_connected = true;
+  CHECK(a.diff(b) == (DISPLAY_CHANGED_STATE | DISPLAY_CHANGED_VALUES));
+  a = b;
+  CHECK(a.diff(b) == 0);
+
+  // What the TFT screens use too
+  b.active = true;
+  CHECK(a.diff(b) == DISPLAY_CHANGED_STATE);
+  a = b;
+  b.total_day = 4.5;
+  CHECK(a.diff(b) == DISPLAY_CHANGED_VALUES);
+}
@@ -0,0 +1,90 @@
+// Host-side tests for the divert pilot planner (divert_planner.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include "divert_planner.h"
+
+TEST_CASE("without limits the pilot follows every reading") {
+  DivertPilotPlanner planner;
+  planner.configure(1.0, 0, 0, 0);
+
+  CHECK(planner.plan(8.2, 8.2, 0) == 8);
+  CHECK(planner.plan(9.1, 9.0, 10) == 9);
+  CHECK(planner.plan(7.9, 8.5, 20) == 7);
+  CHECK(planner.changes() == 2);
+  CHECK(planner.avoided() == 0);
+}
+
+TEST_CASE("the PV ratio decides when a part step rounds up") {
+  DivertPilotPlanner planner;
+  planner.configure(0.3, 0, 0, 0);
+  CHECK(planner.pilotFor(8.2) == 8);
+  CHECK(planner.pilotFor(8.4) == 9);
+  CHECK(planner.pilotFor(-1) == 0);
+
+  planner.configure(1.0, 0, 0, 0);
+  CHECK(planner.pilotFor(8.99) == 8);
+}
+
+TEST_CASE("the hysteresis band holds the pilot through small wobbles") {
+  DivertPilotPlanner planner;
+  planner.configure(1.0, 0.5, 0, 0);
+
+  REQUIRE(planner.plan(10.1, 10.1, 0) == 10);
+
+  // Not enough headroom to go up to 11
+  CHECK(planner.plan(11.3, 10.5, 10) == 10);
+  CHECK(planner.plan(10.8, 10.6, 20) == 10);
+  // Enough now
+  CHECK(planner.plan(11.6, 11.0, 30) == 11);
+  // Down as soon as the reading is below the pilot
+  CHECK(planner.plan(10.9, 11.0, 40) == 10);
+
+  CHECK(planner.changes() == 2);
+  CHECK(planner.avoided() == 2);
+}
+
+TEST_CASE("changes are rate limited, except a drop that imports") {
+  DivertPilotPlanner planner;
+  planner.configure(1.0, 0.5, 60, 0);
+
+  REQUIRE(planner.plan(10.2, 10.2, 0) == 10);
+
+  // Rises wait for the interval
+  CHECK(planner.plan(12.7, 11.0, 10) == 10);
+  CHECK(planner.plan(12.7, 12.0, 59) == 10);
+  CHECK(planner.plan(12.7, 12.5, 60) == 12);
+
+  // A small shortfall is ridden out until the interval is up
+  CHECK(planner.plan(11.8, 12.3, 70) == 12);
+  // A large one is not
+  CHECK(planner.plan(9.2, 11.9, 80) == 9);
+  CHECK(planner.changes() == 2);
+}
+
+TEST_CASE("the look-ahead follows the smoothed trend") {
+  DivertPilotPlanner planner;
+  planner.configure(1.0, 0, 0, 30);
+
+  REQUIRE(planner.plan(12.0, 12.0, 0) == 12);
+
+  // A spike in the reading is capped by the projected smoothed current
+  CHECK(planner.plan(16.0, 12.5, 10) == 14);
+  CHECK(planner.trend() == doctest::Approx(0.05));
+
+  // A steady fall in the smoothed current brings the pilot down early
+  CHECK(planner.plan(14.0, 12.0, 20) == 10);
+  CHECK(planner.trend() == doctest::Approx(-0.05));
+}
+
+TEST_CASE("reset takes the next reading as is, without counting it") {
+  DivertPilotPlanner planner;
+  planner.configure(1.0, 0.5, 300, 0);
+
+  REQUIRE(planner.plan(8.0, 8.0, 0) == 8);
+  planner.reset();
+  CHECK(planner.pilot() == -1);
+  CHECK(planner.plan(15.0, 10.0, 5) == 15);
+  CHECK(planner.changes() == 0);
+  CHECK(planner.avoided() == 0);
+}
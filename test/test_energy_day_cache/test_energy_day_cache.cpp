@@ -0,0 +1,94 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "energy_day_cache.h"
+
+static const uint32_t DAY0 = 1700006400;   // a multiple of ENERGY_DAY_SECS
+
+TEST_CASE("day aggregates energy and temperature range") {
+  EnergyDay d; d.begin(DAY0);
+  d.add(10, 250);
+  d.add(5, -30);
+  d.add(0, 300);
+  CHECK(d.count == 3);
+  CHECK(d.energy == 15);
+  CHECK(d.temp_max == 300);
+  CHECK(d.temp_min == -30);
+
+  EnergyDay week; week.begin(DAY0);
+  EnergyDay empty; empty.begin(DAY0 + ENERGY_DAY_SECS);
+  week.merge(empty);
+  CHECK(week.count == 0);
+  week.merge(d);
+  CHECK(week.temp_min == -30);
+  CHECK(week.temp_max == 300);
+  CHECK(week.energy == 15);
+}
+
+TEST_CASE("only past days are cached") {
+  EnergyDayCache *cache = new EnergyDayCache();
+  cache->setToday(DAY0 + 2 * ENERGY_DAY_SECS);
+
+  EnergyDay d; d.begin(DAY0 + ENERGY_DAY_SECS); d.add(7, 200);
+  cache->store(d);
+  EnergyDay today; today.begin(DAY0 + 2 * ENERGY_DAY_SECS); today.add(1, 200);
+  cache->store(today);
+
+  REQUIRE(cache->find(DAY0 + ENERGY_DAY_SECS) != nullptr);
+  CHECK(cache->find(DAY0 + ENERGY_DAY_SECS)->energy == 7);
+  CHECK(cache->find(DAY0 + 2 * ENERGY_DAY_SECS) == nullptr);
+  CHECK(cache->find(DAY0) == nullptr);
+
+  // A day ENERGY_DAY_CACHE_DAYS later takes the slot over
+  cache->setToday(DAY0 + (ENERGY_DAY_CACHE_DAYS + 2) * ENERGY_DAY_SECS);
+  EnergyDay later; later.begin(DAY0 + (ENERGY_DAY_CACHE_DAYS + 1) * ENERGY_DAY_SECS);
+  cache->store(later);
+  CHECK(cache->find(DAY0 + ENERGY_DAY_SECS) == nullptr);
+  CHECK(cache->find(later.start) != nullptr);
+  delete cache;
+}
+
+TEST_CASE("clock set back clears the cache") {
+  EnergyDayCache *cache = new EnergyDayCache();
+  cache->setToday(DAY0 + 5 * ENERGY_DAY_SECS);
+  EnergyDay d; d.begin(DAY0); d.add(3, 100);
+  cache->store(d);
+  cache->setToday(DAY0 + 5 * ENERGY_DAY_SECS);
+  CHECK(cache->find(DAY0) != nullptr);
+  cache->setToday(DAY0 + 4 * ENERGY_DAY_SECS);
+  CHECK(cache->find(DAY0) == nullptr);
+  delete cache;
+}
+
+TEST_CASE("scan splits samples into days in one pass") {
+  EnergyDayCache *cache = new EnergyDayCache();
+  cache->setToday(DAY0 + 10 * ENERGY_DAY_SECS);
+
+  EnergyDayScan scan(*cache, DAY0 + ENERGY_DAY_SECS, 4);
+  scan.add(DAY0 + 100, 50, 100);                          // before the range
+  scan.add(DAY0 + ENERGY_DAY_SECS, 10, 200);              // day 0, on the boundary
+  scan.add(DAY0 + 2 * ENERGY_DAY_SECS - 1, 20, 210);      // day 0, last second
+  scan.add(DAY0 + 3 * ENERGY_DAY_SECS + 60, 5, 150);      // day 2, day 1 empty
+  scan.add(DAY0 + 2 * ENERGY_DAY_SECS + 60, 99, 999);     // out of order, ignored
+  scan.add(DAY0 + 5 * ENERGY_DAY_SECS, 99, 999);          // past the range
+  scan.finish();
+
+  const EnergyDay *d0 = cache->find(DAY0 + ENERGY_DAY_SECS);
+  const EnergyDay *d1 = cache->find(DAY0 + 2 * ENERGY_DAY_SECS);
+  const EnergyDay *d2 = cache->find(DAY0 + 3 * ENERGY_DAY_SECS);
+  const EnergyDay *d3 = cache->find(DAY0 + 4 * ENERGY_DAY_SECS);
+  REQUIRE(d0 != nullptr);
+  REQUIRE(d1 != nullptr);
+  REQUIRE(d2 != nullptr);
+  REQUIRE(d3 != nullptr);
+  CHECK(d0->count == 2);
+  CHECK(d0->energy == 30);
+  CHECK(d0->temp_min == 200);
+  CHECK(d0->temp_max == 210);
+  CHECK(d1->count == 0);
+  CHECK(d2->count == 1);
+  CHECK(d2->energy == 5);
+  CHECK(d3->count == 0);
+  CHECK(cache->find(DAY0) == nullptr);
+  CHECK(cache->find(DAY0 + 5 * ENERGY_DAY_SECS) == nullptr);
+  delete cache;
+}
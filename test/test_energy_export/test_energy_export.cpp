@@ -0,0 +1,108 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "energy_export.h"
+
+#include <vector>
+
+// Reference decoder, as a client would write it
+struct Decoded {
+  uint8_t cols = 0;
+  std::vector<uint32_t> ts;
+  std::vector<std::vector<int16_t>> rows;
+  uint32_t count = 0, next = 0;
+  bool more = false;
+};
+
+static uint32_t get_varint(const uint8_t *&p) {
+  uint32_t v = 0; int shift = 0;
+  while (*p & 0x80) { v |= (uint32_t)(*p++ & 0x7f) << shift; shift += 7; }
+  v |= (uint32_t)(*p++) << shift;
+  return v;
+}
+
+static bool decode(const uint8_t *p, Decoded &d) {
+  if (p[0] != 'O' || p[1] != 'E' || p[2] != 'X' || p[3] != ENERGY_EXPORT_VERSION) return false;
+  d.cols = p[4]; p += ENERGY_EXPORT_HEADER_SIZE;
+  uint32_t ts = 0;
+  std::vector<int16_t> last(d.cols, 0);
+  for (;;) {
+    uint32_t dt = get_varint(p);
+    if (dt == 0) break;
+    ts += dt - 1;
+    for (uint8_t i = 0; i < d.cols; i++) {
+      uint32_t z = get_varint(p);
+      int32_t delta = (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+      last[i] = (int16_t)(last[i] + delta);
+    }
+    d.ts.push_back(ts);
+    d.rows.push_back(last);
+  }
+  d.count = get_varint(p);
+  d.next = get_varint(p);
+  d.more = *p != 0;
+  return true;
+}
+
+TEST_CASE("varint encodes LEB128") {
+  uint8_t buf[8];
+  CHECK(energy_export_varint(buf, 0) == 1);
+  CHECK(buf[0] == 0);
+  CHECK(energy_export_varint(buf, 127) == 1);
+  CHECK(energy_export_varint(buf, 300) == 2);
+  CHECK(buf[0] == 0xac);
+  CHECK(buf[1] == 0x02);
+  CHECK(energy_export_varint(buf, 0xffffffff) == 5);
+}
+
+TEST_CASE("records round-trip, extremes included") {
+  const uint8_t cols = 7;
+  EnergyExportEncoder enc(cols);
+  std::vector<uint8_t> out(1024);
+  size_t n = enc.header(out.data());
+
+  const int16_t rows[4][cols] = {
+    { 320, 240, 768, 128, 250, -1, 32 },
+    { 320, 240, 768, 127, 251, -1, 32 },
+    { 32767, -32768, 0, 0, -400, 100, 0 },
+    { -32768, 32767, 1, 0, 0, 0, 0 },
+  };
+  const uint32_t ts[4] = { 1700000000, 1700000060, 1700000060, 1700003600 };
+  for (int i = 0; i < 4; i++) {
+    n += enc.record(out.data() + n, ts[i], rows[i]);
+  }
+  n += enc.footer(out.data() + n, true);
+  CHECK(n < 5 + 4 * ENERGY_EXPORT_MAX_RECORD(cols) + ENERGY_EXPORT_MAX_FOOTER);
+
+  Decoded d;
+  REQUIRE(decode(out.data(), d));
+  CHECK(d.cols == cols);
+  REQUIRE(d.ts.size() == 4);
+  for (int i = 0; i < 4; i++) {
+    CHECK(d.ts[i] == ts[i]);
+    for (int c = 0; c < cols; c++) CHECK(d.rows[i][c] == rows[i][c]);
+  }
+  CHECK(d.count == 4);
+  CHECK(d.next == 1700003600);
+  CHECK(d.more);
+}
+
+TEST_CASE("steady samples take a byte a column") {
+  EnergyExportEncoder enc(7);
+  uint8_t buf[64];
+  const int16_t v[7] = { 320, 240, 768, 128, 250, 80, 32 };
+  enc.record(buf, 1700000000, v);
+  CHECK(enc.record(buf, 1700000060, v) == 8);
+}
+
+TEST_CASE("empty export is just header and footer") {
+  EnergyExportEncoder enc(7);
+  uint8_t buf[32];
+  size_t n = enc.header(buf);
+  n += enc.footer(buf + n, false);
+  Decoded d;
+  REQUIRE(decode(buf, d));
+  CHECK(d.ts.empty());
+  CHECK(d.count == 0);
+  CHECK(d.next == 0);
+  CHECK_FALSE(d.more);
+}
@@ -0,0 +1,251 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "energy_ring.h"
+
+#include <string.h>
+#include <map>
+#include <vector>
+
+// The segment files, as byte vectors that grow like LittleFS files would
+struct MemStorage : public EnergyRingStorage {
+  std::map<uint32_t, std::vector<uint8_t>> files;
+  int writes = 0;
+  int rewrites = 0;       // writes that did not start at the end of the file
+  bool fail = false;
+  size_t torn = 0;        // with fail, bytes that still get written
+
+  bool range(uint32_t &first, uint32_t &last) override {
+    if (files.empty()) return false;
+    first = files.begin()->first;
+    last = files.rbegin()->first;
+    return true;
+  }
+  size_t size(uint32_t segment) override {
+    auto it = files.find(segment);
+    return it == files.end() ? 0 : it->second.size();
+  }
+  bool read(uint32_t segment, uint32_t offset, uint8_t *out, size_t len) override {
+    auto it = files.find(segment);
+    if (it == files.end() || offset + len > it->second.size()) return false;
+    memcpy(out, it->second.data() + offset, len);
+    return true;
+  }
+  bool write(uint32_t segment, uint32_t offset, const uint8_t *in, size_t len) override {
+    if (0 != offset && files.find(segment) == files.end()) return false;
+    std::vector<uint8_t> &data = files[segment];
+    if (offset > data.size()) return false;   // no holes
+    if (offset != data.size()) rewrites++;
+    if (fail) len = torn < len ? torn : len;
+    if (offset + len > data.size()) data.resize(offset + len);
+    memcpy(data.data() + offset, in, len);
+    writes++;
+    return !fail;
+  }
+  bool remove(uint32_t segment) override {
+    return files.erase(segment) > 0;
+  }
+};
+
+static std::vector<uint32_t> query_ts(EnergyRing &ring, uint32_t start, uint32_t end) {
+  std::vector<uint32_t> out;
+  EnergyRingQuery q;
+  if (!ring.query(q, start, end)) return out;
+  uint32_t ts; int16_t v[3];
+  while (ring.next(q, ts, v)) {
+    CHECK(v[0] == (int16_t)(ts / 10));
+    CHECK(v[1] == -(int16_t)(ts / 10));
+    out.push_back(ts);
+  }
+  return out;
+}
+
+static void append(EnergyRing &ring, uint32_t ts) {
+  int16_t v[3] = { (int16_t)(ts / 10), (int16_t)-(int16_t)(ts / 10), 0x7fff };
+  CHECK(ring.append(ts, v));
+}
+
+TEST_CASE("sizes segments to a flash block and keeps one spare") {
+  MemStorage s;
+  EnergyRing small(3);
+  REQUIRE(small.begin(&s, 4));
+  CHECK(small.perSegment() == 4);
+  CHECK(small.maxSegments() == 2);
+
+  // 408 records of 10 bytes fit a segment, 1000 takes three of 334
+  EnergyRing large(3);
+  REQUIRE(large.begin(&s, 1000));
+  CHECK(large.perSegment() == 334);
+  CHECK(large.maxSegments() == 4);
+  CHECK(ENERGY_RING_HEADER_SIZE + 334 * large.recordSize() <= ENERGY_RING_SEGMENT_SIZE);
+}
+
+TEST_CASE("appends to the newest segment and deletes the oldest") {
+  MemStorage s;
+  EnergyRing ring(3);
+  REQUIRE(ring.begin(&s, 4));
+  CHECK(ring.created());
+  CHECK(s.files.empty());
+
+  for (uint32_t ts = 100; ts <= 130; ts += 10) append(ring, ts);
+  CHECK(ring.count() == 4);
+  CHECK(s.files.size() == 1);
+  CHECK(s.size(0) == ENERGY_RING_HEADER_SIZE + 4 * ring.recordSize());
+
+  for (uint32_t ts = 140; ts <= 170; ts += 10) append(ring, ts);
+  CHECK(ring.count() == 8);
+  CHECK(s.files.size() == 2);
+
+  append(ring, 180);
+  CHECK(ring.count() == 5);
+  CHECK(s.files.size() == 2);
+  CHECK(s.files.count(0) == 0);
+  CHECK(query_ts(ring, 0, 1000) == std::vector<uint32_t>{140, 150, 160, 170, 180});
+
+  // One small write a record, nothing written is ever written again
+  int before = s.writes;
+  append(ring, 190);
+  CHECK(s.writes == before + 1);
+  CHECK(s.rewrites == 0);
+}
+
+TEST_CASE("queries a time range across segments") {
+  MemStorage s;
+  EnergyRing ring(3);
+  REQUIRE(ring.begin(&s, 3));
+  for (uint32_t ts = 10; ts <= 80; ts += 10) append(ring, ts);   // 40..80 kept
+
+  CHECK(query_ts(ring, 0, 1000) == std::vector<uint32_t>{40, 50, 60, 70, 80});
+  CHECK(query_ts(ring, 55, 75) == std::vector<uint32_t>{60, 70});
+  CHECK(query_ts(ring, 60, 60) == std::vector<uint32_t>{60});
+  CHECK(query_ts(ring, 0, 45) == std::vector<uint32_t>{40});
+  CHECK(query_ts(ring, 81, 1000).empty());
+  CHECK(query_ts(ring, 70, 60).empty());
+}
+
+TEST_CASE("finds the head from the segments and refuses older samples") {
+  MemStorage s;
+  {
+    EnergyRing ring(3);
+    REQUIRE(ring.begin(&s, 3));
+    for (uint32_t ts = 10; ts <= 50; ts += 10) append(ring, ts);
+  }
+
+  EnergyRing ring(3);
+  REQUIRE(ring.begin(&s, 3));
+  CHECK_FALSE(ring.created());
+  CHECK(ring.count() == 5);
+  CHECK(ring.newest() == 50);
+
+  int16_t v[3] = {0, 0, 0};
+  CHECK_FALSE(ring.append(40, v));
+  append(ring, 50);                                     // same second is fine
+  CHECK(query_ts(ring, 0, 100) == std::vector<uint32_t>{10, 20, 30, 40, 50, 50});
+  CHECK(s.rewrites == 0);
+
+  CHECK(ring.clear());
+  CHECK(ring.count() == 0);
+  CHECK(s.files.empty());
+  CHECK(query_ts(ring, 0, 100).empty());
+  append(ring, 60);
+  CHECK(query_ts(ring, 0, 100) == std::vector<uint32_t>{60});
+}
+
+TEST_CASE("keeps the newest segments when made smaller") {
+  MemStorage s;
+  {
+    EnergyRing ring(3);
+    REQUIRE(ring.begin(&s, 1000));                       // 334 a segment, 4 kept
+    for (uint32_t ts = 1; ts <= 1300; ts++) append(ring, ts);
+    CHECK(ring.segments() == 4);
+  }
+
+  EnergyRing ring(3);
+  REQUIRE(ring.begin(&s, 668));                          // 334 a segment, 3 kept
+  CHECK_FALSE(ring.created());
+  CHECK(ring.segments() == 3);
+  CHECK(s.files.size() == 3);
+  CHECK(ring.newest() == 1300);
+  CHECK(ring.count() == 2 * 334 + 1300 - 3 * 334);
+}
+
+TEST_CASE("starts again on a different shape or a foreign file") {
+  MemStorage s;
+  {
+    EnergyRing ring(3);
+    REQUIRE(ring.begin(&s, 3));
+    append(ring, 10);
+  }
+
+  EnergyRing resized(3);
+  REQUIRE(resized.begin(&s, 6));
+  CHECK(resized.created());
+  CHECK(resized.count() == 0);
+  CHECK(s.files.empty());
+  append(resized, 20);
+
+  EnergyRing other_cols(2);
+  REQUIRE(other_cols.begin(&s, 6));
+  CHECK(other_cols.created());
+
+  MemStorage junk;
+  junk.files[7].assign(64, 0xff);
+  EnergyRing ring(3);
+  REQUIRE(ring.begin(&junk, 3));
+  CHECK(ring.created());
+  CHECK(junk.files.empty());
+  append(ring, 10);
+  CHECK(junk.files.count(8) == 1);                       // numbered on from the junk
+
+  MemStorage readonly;
+  readonly.fail = true;
+  EnergyRing closed(3);
+  REQUIRE(closed.begin(&readonly, 3));
+  int16_t v[3] = {0, 0, 0};
+  CHECK_FALSE(closed.append(10, v));
+  CHECK(closed.count() == 0);
+}
+
+TEST_CASE("an interrupted write is written over by the next record") {
+  MemStorage s;
+  EnergyRing ring(3);
+  REQUIRE(ring.begin(&s, 3));
+  append(ring, 10);
+
+  s.fail = true;
+  s.torn = 4;
+  int16_t v[3] = {0, 0, 0};
+  CHECK_FALSE(ring.append(20, v));
+  CHECK(ring.count() == 1);
+  CHECK(ring.newest() == 10);
+
+  s.fail = false;
+  append(ring, 30);
+  CHECK(query_ts(ring, 0, 100) == std::vector<uint32_t>{10, 30});
+
+  // And after a reboot part way through a record
+  s.fail = true;
+  CHECK_FALSE(ring.append(40, v));
+  s.fail = false;
+  EnergyRing reopened(3);
+  REQUIRE(reopened.begin(&s, 3));
+  CHECK(reopened.count() == 2);
+  CHECK(reopened.newest() == 30);
+}
+
+TEST_CASE("a new segment without its header is dropped") {
+  MemStorage s;
+  {
+    EnergyRing ring(3);
+    REQUIRE(ring.begin(&s, 3));
+    for (uint32_t ts = 10; ts <= 30; ts += 10) append(ring, ts);
+  }
+  s.files[1].assign(3, 'O');
+
+  EnergyRing ring(3);
+  REQUIRE(ring.begin(&s, 3));
+  CHECK_FALSE(ring.created());
+  CHECK(s.files.count(1) == 0);
+  CHECK(ring.count() == 3);
+  append(ring, 40);
+  CHECK(query_ts(ring, 0, 100) == std::vector<uint32_t>{10, 20, 30, 40});
+}
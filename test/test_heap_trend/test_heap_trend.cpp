@@ -0,0 +1,61 @@
+// Host-side tests for the heap sample series (heap_trend.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include "heap_trend.h"
+
+TEST_CASE("fragmentation is the free heap outside the largest block") {
+  HeapSample sample = { 0, 40000, 40000 };
+  CHECK(sample.fragmentation() == 0);
+
+  sample.largest = 10000;
+  CHECK(sample.fragmentation() == 75);
+
+  sample.free = 0;
+  sample.largest = 0;
+  CHECK(sample.fragmentation() == 0);
+}
+
+TEST_CASE("samples are kept oldest first") {
+  HeapTrend trend;
+  CHECK(trend.count() == 0);
+
+  trend.add(1000, 50000, 30000);
+  trend.add(2000, 48000, 20000);
+
+  REQUIRE(trend.count() == 2);
+  CHECK(trend.get(0).time == 1000);
+  CHECK(trend.get(1).time == 2000);
+  CHECK(trend.latest().free == 48000);
+  CHECK(trend.latest().fragmentation() == 59);
+}
+
+TEST_CASE("the oldest samples are dropped once full") {
+  HeapTrend trend;
+  for(uint32_t i = 0; i < HEAP_TREND_SAMPLES + 5; i++) {
+    trend.add(i, 50000 - i, 20000);
+  }
+
+  REQUIRE(trend.count() == HEAP_TREND_SAMPLES);
+  CHECK(trend.get(0).time == 5);
+  CHECK(trend.latest().time == HEAP_TREND_SAMPLES + 4);
+  for(size_t i = 1; i < trend.count(); i++) {
+    CHECK(trend.get(i).time == trend.get(i - 1).time + 1);
+  }
+}
+
+TEST_CASE("the low points outlive the samples") {
+  HeapTrend trend;
+  trend.add(0, 30000, 8000);
+  for(uint32_t i = 1; i <= HEAP_TREND_SAMPLES; i++) {
+    trend.add(i, 50000, 20000);
+  }
+
+  CHECK(trend.get(0).free == 50000);
+  CHECK(trend.minFree() == 30000);
+  CHECK(trend.minLargest() == 8000);
+
+  trend.clear();
+  CHECK(trend.count() == 0);
+  CHECK(trend.minFree() == UINT32_MAX);
+}
@@ -0,0 +1,106 @@
+// Host-side tests for the JSON document buffer pool (json_pool.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <string.h>
+
+#include "json_pool.h"
+
+TEST_CASE("requests get the smallest free block that fits") {
+  static JsonPool pool;
+
+  void *small = pool.allocate(100);
+  void *medium = pool.allocate(JSON_POOL_SMALL_SIZE + 1);
+  void *large = pool.allocate(JSON_POOL_LARGE_SIZE);
+
+  CHECK(pool.owns(small));
+  CHECK(pool.owns(medium));
+  CHECK(pool.owns(large));
+  CHECK(pool.stats(0).in_use == 1);
+  CHECK(pool.stats(1).in_use == 1);
+  CHECK(pool.stats(2).in_use == 1);
+  CHECK(pool.misses() == 0);
+
+  // Usable to the end of the class
+  memset(large, 0xaa, JSON_POOL_LARGE_SIZE);
+  memset(medium, 0x55, JSON_POOL_MEDIUM_SIZE);
+  CHECK(((uint8_t *)large)[0] == 0xaa);
+
+  pool.deallocate(small);
+  pool.deallocate(medium);
+  pool.deallocate(large);
+  CHECK(pool.stats(0).in_use == 0);
+  CHECK(pool.stats(1).in_use == 0);
+  CHECK(pool.stats(2).in_use == 0);
+  CHECK(pool.stats(0).high_water == 1);
+}
+
+TEST_CASE("a full class spills into the next") {
+  static JsonPool pool;
+  void *blocks[JSON_POOL_SMALL_BLOCKS];
+  for(int i = 0; i < JSON_POOL_SMALL_BLOCKS; i++) {
+    blocks[i] = pool.allocate(64);
+  }
+  CHECK(pool.stats(0).in_use == JSON_POOL_SMALL_BLOCKS);
+
+  void *next = pool.allocate(64);
+  CHECK(pool.owns(next));
+  CHECK(pool.stats(1).in_use == 1);
+
+  // Freed blocks are handed out again
+  pool.deallocate(blocks[1]);
+  CHECK(pool.allocate(64) == blocks[1]);
+}
+
+TEST_CASE("requests the pool can not meet go to the heap") {
+  static JsonPool pool;
+  void *huge = pool.allocate(JSON_POOL_LARGE_SIZE + 1);
+  REQUIRE(huge != nullptr);
+  CHECK_FALSE(pool.owns(huge));
+  CHECK(pool.misses() == 1);
+  CHECK(pool.largestMiss() == JSON_POOL_LARGE_SIZE + 1);
+  pool.deallocate(huge);
+
+  void *large[JSON_POOL_LARGE_BLOCKS];
+  for(int i = 0; i < JSON_POOL_LARGE_BLOCKS; i++) {
+    large[i] = pool.allocate(JSON_POOL_LARGE_SIZE);
+  }
+  void *spill = pool.allocate(JSON_POOL_LARGE_SIZE);
+  CHECK_FALSE(pool.owns(spill));
+  CHECK(pool.misses() == 2);
+  pool.deallocate(spill);
+  for(int i = 0; i < JSON_POOL_LARGE_BLOCKS; i++) {
+    pool.deallocate(large[i]);
+  }
+
+  pool.resetStats();
+  CHECK(pool.misses() == 0);
+  CHECK(pool.stats(2).high_water == 0);
+  CHECK(pool.stats(2).leases == 0);
+}
+
+TEST_CASE("shrinking keeps the block, growing moves it") {
+  static JsonPool pool;
+  char *ptr = (char *)pool.allocate(100);
+  strcpy(ptr, "hello");
+
+  CHECK(pool.reallocate(ptr, 10) == ptr);
+
+  char *bigger = (char *)pool.reallocate(ptr, JSON_POOL_SMALL_SIZE + 1);
+  CHECK(bigger != ptr);
+  CHECK(pool.owns(bigger));
+  CHECK(strcmp(bigger, "hello") == 0);
+  CHECK(pool.stats(0).in_use == 0);
+  CHECK(pool.stats(1).in_use == 1);
+  pool.deallocate(bigger);
+}
+
+TEST_CASE("leases return their block") {
+  {
+    JsonPoolLease lease(200);
+    CHECK(jsonPool.owns(lease.data()));
+    CHECK(lease.size() == 200);
+    CHECK(jsonPool.stats(0).in_use == 1);
+  }
+  CHECK(jsonPool.stats(0).in_use == 0);
+}
@@ -0,0 +1,123 @@
+// Host-side tests for the character LCD shadow buffer (lcd_shadow.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "lcd_shadow.h"
+
+struct Span
+{
+  int x;
+  int y;
+  std::string text;
+};
+
+static std::vector<Span> flush(LcdShadow &shadow)
+{
+  std::vector<Span> spans;
+  Span span;
+  char text[LCD_SHADOW_COLS + 1];
+  while(shadow.nextSpan(span.x, span.y, text, sizeof(text))) {
+    span.text = text;
+    spans.push_back(span);
+  }
+  return spans;
+}
+
+TEST_CASE("the first flush paints both lines within the space limit") {
+  LcdShadow shadow;
+  shadow.write(0, 0, "Charging", true);
+  shadow.write(0, 1, "Energy 1,018Wh", true);
+
+  std::vector<Span> spans = flush(shadow);
+  REQUIRE(spans.size() == 3);
+  CHECK(spans[0].x == 0);
+  CHECK(spans[0].y == 0);
+  CHECK(spans[0].text == "Charging      ");
+  CHECK(spans[1].x == 14);
+  CHECK(spans[1].text == "  ");
+  CHECK(spans[2].y == 1);
+  CHECK(spans[2].text == "Energy 1,018Wh  ");
+  CHECK_FALSE(shadow.dirty());
+
+  for(const Span &span : spans) {
+    size_t spaces = 0;
+    for(char c : span.text) {
+      spaces += ' ' == c;
+    }
+    CHECK(spaces <= LCD_SHADOW_MAX_SPACES);
+  }
+}
+
+TEST_CASE("redrawing unchanged text sends nothing") {
+  LcdShadow shadow;
+  shadow.write(0, 1, "Time 03:14PM", true);
+  flush(shadow);
+  uint32_t commands = shadow.stats().commands;
+
+  shadow.write(0, 1, "Time 03:14PM", true);
+  CHECK_FALSE(shadow.dirty());
+  CHECK(flush(shadow).empty());
+  CHECK(shadow.stats().commands == commands);
+  CHECK(shadow.stats().skipped == 1);
+}
+
+TEST_CASE("only the changed characters are resent") {
+  LcdShadow shadow;
+  shadow.write(0, 1, "Energy 1,018Wh", true);
+  flush(shadow);
+
+  shadow.write(0, 1, "Energy 1,019Wh", true);
+  std::vector<Span> spans = flush(shadow);
+  REQUIRE(spans.size() == 1);
+  CHECK(spans[0].x == 11);
+  CHECK(spans[0].text == "9");
+
+  // Nearby changes are merged, distant ones are sent separately
+  shadow.write(0, 1, "Energy 2,029Wh", true);
+  spans = flush(shadow);
+  REQUIRE(spans.size() == 1);
+  CHECK(spans[0].x == 7);
+  CHECK(spans[0].text == "2,02");
+
+  shadow.write(0, 1, "Xnergy 2,029Wx", true);
+  spans = flush(shadow);
+  REQUIRE(spans.size() == 2);
+  CHECK(spans[0].text == "X");
+  CHECK(spans[1].x == 13);
+  CHECK(spans[1].text == "x");
+}
+
+TEST_CASE("a failed command resends the whole display") {
+  LcdShadow shadow;
+  shadow.write(0, 0, "zzZ Sleeping Zzz", false);
+  shadow.write(0, 1, "Hostname", true);
+  flush(shadow);
+
+  shadow.failed();
+  CHECK(shadow.stats().failures == 1);
+  std::vector<Span> spans = flush(shadow);
+  std::string line0, line1;
+  for(const Span &span : spans) {
+    (0 == span.y ? line0 : line1) += span.text;
+  }
+  CHECK(line0 == "zzZ Sleeping Zzz");
+  CHECK(line1 == "Hostname        ");
+}
+
+TEST_CASE("writes are clipped to the display") {
+  LcdShadow shadow;
+  shadow.write(10, 0, "0123456789", false);
+  CHECK(strcmp(shadow.line(0), "          012345") == 0);
+  shadow.write(0, 2, "off screen", true);
+  shadow.write(-1, 0, "off screen", true);
+  CHECK(strcmp(shadow.line(0), "          012345") == 0);
+
+  char small[4];
+  int x, y;
+  REQUIRE(shadow.nextSpan(x, y, small, sizeof(small)));
+  CHECK(strlen(small) == 3);
+}
@@ -0,0 +1,93 @@
+// Host-side tests for the status LED frame tables (led_animation.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include "led_animation.h"
+
+static LedFrame colour(uint8_t r, uint8_t g, uint8_t b, bool wifiLed = false)
+{
+  LedFrame frame = { { r, g, b }, { r, g, b }, wifiLed };
+  return frame;
+}
+
+TEST_CASE("a steady colour never needs another frame") {
+  LedAnimation animation;
+  animation.steady(colour(0, 255, 0));
+  CHECK_FALSE(animation.animated());
+
+  LedAnimationPlayer player;
+  CHECK(player.start(animation, 1000));
+  CHECK(player.frame() == colour(0, 255, 0));
+  CHECK(player.nextChange(1000) == LED_ANIMATION_STATIC);
+  CHECK_FALSE(player.update(100000));
+  CHECK(player.frame() == colour(0, 255, 0));
+}
+
+TEST_CASE("a flash alternates frames on the frame time") {
+  LedAnimation animation;
+  animation.flash(colour(255, 255, 0, true), colour(0, 0, 0), 450);
+  CHECK(animation.animated());
+
+  LedAnimationPlayer player;
+  REQUIRE(player.start(animation, 1000));
+  CHECK(player.frame() == colour(255, 255, 0, true));
+  CHECK(player.nextChange(1000) == 450);
+  CHECK(player.nextChange(1400) == 50);
+
+  CHECK_FALSE(player.update(1449));
+  CHECK(player.update(1450));
+  CHECK(player.frame() == colour(0, 0, 0));
+  CHECK(player.nextChange(1450) == 450);
+
+  CHECK(player.update(1900));
+  CHECK(player.frame() == colour(255, 255, 0, true));
+}
+
+TEST_CASE("a late wake lands on the frame due, without drift") {
+  LedAnimation animation;
+  animation.flash(colour(0, 255, 255), colour(0, 0, 0), 250);
+
+  LedAnimationPlayer player;
+  player.start(animation, 0);
+
+  // Three frame times late: frame 1, and the next change still on the grid
+  CHECK(player.update(760));
+  CHECK(player.frame() == colour(0, 0, 0));
+  CHECK(player.nextChange(760) == 240);
+
+  // Four frame times is back on frame 0
+  CHECK(player.update(1000));
+  CHECK(player.frame() == colour(0, 255, 255));
+}
+
+TEST_CASE("restarting the same animation keeps its timing") {
+  LedAnimation animation;
+  animation.flash(colour(255, 0, 255), colour(0, 0, 0), 250);
+
+  LedAnimationPlayer player;
+  REQUIRE(player.start(animation, 0));
+  CHECK(player.update(300));
+  CHECK_FALSE(player.start(animation, 300));
+  CHECK(player.frame() == colour(0, 0, 0));
+  CHECK(player.nextChange(300) == 200);
+
+  LedAnimation other;
+  other.steady(colour(255, 0, 0));
+  CHECK(other != animation);
+  CHECK(player.start(other, 400));
+  CHECK(player.frame() == colour(255, 0, 0));
+  CHECK(player.nextChange(400) == LED_ANIMATION_STATIC);
+}
+
+TEST_CASE("the timing survives millis() wrapping") {
+  LedAnimation animation;
+  animation.flash(colour(255, 255, 0), colour(0, 0, 0), 450);
+
+  LedAnimationPlayer player;
+  player.start(animation, UINT32_MAX - 100);
+  CHECK(player.nextChange(UINT32_MAX - 100) == 450);
+  CHECK_FALSE(player.update(200));
+  CHECK(player.nextChange(200) == 149);
+  CHECK(player.update(349));
+  CHECK(player.frame() == colour(0, 0, 0));
+}
@@ -0,0 +1,145 @@
+// Host-side tests for the site load sharing allocation (load_share.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <string.h>
+
+#include "load_share.h"
+
+static LoadSharePeer peer(const char *id, bool demand, uint32_t min = 6, uint32_t max = 32,
+                          int32_t priority = 0, bool charging = false,
+                          uint32_t budget = 1000, LoadSharePolicy policy = LoadSharePolicy::Fair)
+{
+  LoadSharePeer p;
+  memset(&p, 0, sizeof(p));
+  strncpy(p.id, id, sizeof(p.id) - 1);
+  p.demand = demand;
+  p.charging = charging;
+  p.min_current = min;
+  p.max_current = max;
+  p.priority = priority;
+  p.budget = budget;
+  p.policy = policy;
+  return p;
+}
+
+TEST_CASE("the budget is shared evenly between vehicles") {
+  LoadShareAllocator alloc;
+  CHECK(alloc.update(peer("a", true), 0));
+  CHECK(alloc.update(peer("b", true), 0));
+  CHECK(alloc.update(peer("c", false), 0));
+
+  alloc.allocate(40, LoadSharePolicy::Fair);
+  CHECK(alloc.allocation("a") == 20);
+  CHECK(alloc.allocation("b") == 20);
+  CHECK(alloc.allocation("c") == 0);
+  CHECK(alloc.allocated() == 40);
+
+  // An odd amp goes to the first in order
+  alloc.allocate(41, LoadSharePolicy::Fair);
+  CHECK(alloc.allocation("a") == 21);
+  CHECK(alloc.allocation("b") == 20);
+}
+
+TEST_CASE("what one peer cannot use goes to the others") {
+  LoadShareAllocator alloc;
+  alloc.update(peer("a", true, 6, 10), 0);
+  alloc.update(peer("b", true, 6, 32), 0);
+  alloc.update(peer("c", true, 6, 16), 0);
+
+  alloc.allocate(60, LoadSharePolicy::Fair);
+  CHECK(alloc.allocation("a") == 10);
+  CHECK(alloc.allocation("c") == 16);
+  CHECK(alloc.allocation("b") == 32);
+  CHECK(alloc.allocated() == 58);
+}
+
+TEST_CASE("a peer that does not fit its minimum is paused") {
+  LoadShareAllocator alloc;
+  alloc.update(peer("a", true), 0);
+  alloc.update(peer("b", true, 6, 32, 0, true), 0);
+  alloc.update(peer("c", true), 0);
+
+  // Room for two minimums, the running session keeps its place
+  alloc.allocate(16, LoadSharePolicy::Fair);
+  CHECK(alloc.allocation("b") == 8);
+  CHECK(alloc.allocation("a") == 8);
+  CHECK(alloc.allocation("c") == 0);
+}
+
+TEST_CASE("the priority policy fills the higher levels first") {
+  LoadShareAllocator alloc;
+  alloc.update(peer("a", true, 6, 32, 0, false, 1000, LoadSharePolicy::Priority), 0);
+  alloc.update(peer("b", true, 6, 32, 1, false, 1000, LoadSharePolicy::Priority), 0);
+  alloc.update(peer("c", true, 6, 32, 1, false, 1000, LoadSharePolicy::Priority), 0);
+
+  alloc.allocate(50, LoadSharePolicy::Priority);
+  CHECK(alloc.policy() == LoadSharePolicy::Priority);
+  CHECK(alloc.allocation("b") == 22);
+  CHECK(alloc.allocation("c") == 22);
+  CHECK(alloc.allocation("a") == 6);
+
+  alloc.allocate(12, LoadSharePolicy::Priority);
+  CHECK(alloc.allocation("b") == 6);
+  CHECK(alloc.allocation("c") == 6);
+  CHECK(alloc.allocation("a") == 0);
+}
+
+TEST_CASE("the most conservative announcement wins") {
+  LoadShareAllocator alloc;
+  alloc.update(peer("a", true, 6, 32, 0, false, 40, LoadSharePolicy::Priority), 0);
+  alloc.update(peer("b", true, 6, 32, 5, false, 24, LoadSharePolicy::Fair), 0);
+
+  alloc.allocate(40, LoadSharePolicy::Priority);
+  CHECK(alloc.budget() == 24);
+  CHECK(alloc.policy() == LoadSharePolicy::Fair);
+  CHECK(alloc.allocation("a") == 12);
+  CHECK(alloc.allocation("b") == 12);
+}
+
+TEST_CASE("updates report only changes that matter") {
+  LoadShareAllocator alloc;
+  REQUIRE(alloc.update(peer("a", false), 0));
+  CHECK_FALSE(alloc.update(peer("a", false), 1000));
+  CHECK(alloc.find("a")->seen == 1000);
+  CHECK(alloc.update(peer("a", true), 2000));
+  CHECK(alloc.count() == 1);
+}
+
+TEST_CASE("silent peers expire, apart from ourselves") {
+  LoadShareAllocator alloc;
+  alloc.update(peer("a", true), 0);
+  alloc.update(peer("b", true), 0);
+  alloc.update(peer("c", true), 50000);
+
+  CHECK_FALSE(alloc.expire(60000, 60000, "a"));
+  CHECK(alloc.expire(60001, 60000, "a"));
+  CHECK(alloc.count() == 2);
+  CHECK(alloc.find("a") != nullptr);
+  CHECK(alloc.find("b") == nullptr);
+
+  CHECK(alloc.remove("c"));
+  CHECK_FALSE(alloc.remove("c"));
+  CHECK(alloc.count() == 1);
+}
+
+TEST_CASE("every unit gets the same answer whatever order it heard in") {
+  LoadShareAllocator one;
+  LoadShareAllocator two;
+  one.update(peer("x", true, 6, 32), 0);
+  one.update(peer("y", true, 10, 16), 0);
+  one.update(peer("z", true, 6, 20, 0, true), 0);
+  two.update(peer("z", true, 6, 20, 0, true), 0);
+  two.update(peer("x", true, 6, 32), 0);
+  two.update(peer("y", true, 10, 16), 0);
+
+  for(uint32_t budget = 0; budget < 80; budget++)
+  {
+    one.allocate(budget, LoadSharePolicy::Fair);
+    two.allocate(budget, LoadSharePolicy::Fair);
+    CHECK(one.allocated() <= budget);
+    CHECK(one.allocation("x") == two.allocation("x"));
+    CHECK(one.allocation("y") == two.allocation("y"));
+    CHECK(one.allocation("z") == two.allocation("z"));
+  }
+}
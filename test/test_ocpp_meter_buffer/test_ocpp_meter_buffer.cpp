@@ -0,0 +1,187 @@
+// Host-side tests for the OCPP meter sample ring (ocpp_meter_buffer.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <string.h>
+#include <vector>
+
+#include "ocpp_meter_buffer.h"
+
+// Storage backed by a byte vector, grows on write like a file
+struct MemoryStorage
+{
+  std::vector<uint8_t> data;
+  bool fail_writes = false;
+
+  OcppMeterBuffer::Reader reader() {
+    return [this](uint32_t offset, uint8_t *out, size_t len) {
+      if(offset + len > data.size()) {
+        return false;
+      }
+      memcpy(out, data.data() + offset, len);
+      return true;
+    };
+  }
+
+  OcppMeterBuffer::Writer writer() {
+    return [this](uint32_t offset, const uint8_t *in, size_t len) {
+      if(fail_writes) {
+        return false;
+      }
+      if(offset + len > data.size()) {
+        data.resize(offset + len);
+      }
+      memcpy(data.data() + offset, in, len);
+      return true;
+    };
+  }
+};
+
+static OcppMeterSample sample(uint32_t timestamp, double energy)
+{
+  OcppMeterSample s;
+  s.timestamp = timestamp;
+  s.transaction_id = 7;
+  s.energy = energy;
+  s.power = 7200.5f;
+  s.current = 30.0f;
+  s.offered = 32.0f;
+  s.voltage = 240.0f;
+  s.temperature = 31.5f;
+  return s;
+}
+
+TEST_CASE("samples are returned oldest first and survive a reload") {
+  MemoryStorage storage;
+  OcppMeterBuffer buffer(8);
+  buffer.begin(storage.reader(), storage.writer());
+  CHECK(buffer.empty());
+
+  for(uint32_t i = 0; i < 3; i++) {
+    REQUIRE(buffer.push(sample(1000 + i * 60, 123456789.125 + i)));
+  }
+  CHECK(buffer.size() == 3);
+  CHECK(storage.data.size() <= OcppMeterBuffer::storageSize(8));
+
+  OcppMeterBuffer reloaded(8);
+  reloaded.begin(storage.reader(), storage.writer());
+  REQUIRE(reloaded.size() == 3);
+
+  OcppMeterSample s;
+  REQUIRE(reloaded.peek(0, s));
+  CHECK(s.timestamp == 1000);
+  CHECK(s.transaction_id == 7);
+  CHECK(s.energy == 123456789.125);
+  CHECK(s.power == 7200.5f);
+  CHECK(s.temperature == 31.5f);
+  REQUIRE(reloaded.peek(2, s));
+  CHECK(s.timestamp == 1120);
+  CHECK_FALSE(reloaded.peek(3, s));
+}
+
+TEST_CASE("a full ring overwrites the oldest sample") {
+  MemoryStorage storage;
+  OcppMeterBuffer buffer(4);
+  buffer.begin(storage.reader(), storage.writer());
+
+  for(uint32_t i = 0; i < 6; i++) {
+    REQUIRE(buffer.push(sample(i, i)));
+  }
+  CHECK(buffer.size() == 4);
+  CHECK(buffer.dropped() == 2);
+
+  OcppMeterSample s;
+  REQUIRE(buffer.peek(0, s));
+  CHECK(s.timestamp == 2);
+  REQUIRE(buffer.peek(3, s));
+  CHECK(s.timestamp == 5);
+
+  REQUIRE(buffer.pop(3));
+  REQUIRE(buffer.size() == 1);
+  REQUIRE(buffer.peek(0, s));
+  CHECK(s.timestamp == 5);
+
+  REQUIRE(buffer.pop(10));
+  CHECK(buffer.empty());
+}
+
+TEST_CASE("a batch is confirmed by sequence across overwrites") {
+  MemoryStorage storage;
+  OcppMeterBuffer buffer(4);
+  buffer.begin(storage.reader(), storage.writer());
+
+  for(uint32_t i = 0; i < 4; i++) {
+    REQUIRE(buffer.push(sample(i, i)));
+  }
+  CHECK(buffer.firstSequence() == 0);
+
+  // Send the oldest two, then two more samples push the oldest two out
+  // before the confirmation arrives
+  uint32_t last = buffer.firstSequence() + 2 - 1;
+  REQUIRE(buffer.push(sample(4, 4)));
+  REQUIRE(buffer.push(sample(5, 5)));
+  CHECK(buffer.firstSequence() == 2);
+
+  REQUIRE(buffer.popThrough(last));
+  CHECK(buffer.size() == 4);
+
+  OcppMeterSample s;
+  REQUIRE(buffer.peek(0, s));
+  CHECK(s.timestamp == 2);
+
+  // Partly overwritten: only the ones still held go
+  last = buffer.firstSequence() + 3 - 1;
+  REQUIRE(buffer.push(sample(6, 6)));
+  REQUIRE(buffer.popThrough(last));
+  CHECK(buffer.size() == 2);
+  REQUIRE(buffer.peek(0, s));
+  CHECK(s.timestamp == 5);
+
+  // Kept over a reload and a clear
+  OcppMeterBuffer reloaded(4);
+  reloaded.begin(storage.reader(), storage.writer());
+  CHECK(reloaded.firstSequence() == 5);
+  REQUIRE(reloaded.clear());
+  CHECK(reloaded.firstSequence() == 7);
+  REQUIRE(reloaded.popThrough(6));
+  CHECK(reloaded.empty());
+}
+
+TEST_CASE("storage from another layout is discarded") {
+  MemoryStorage storage;
+  OcppMeterBuffer small(4);
+  small.begin(storage.reader(), storage.writer());
+  REQUIRE(small.push(sample(1, 1)));
+
+  OcppMeterBuffer large(8);
+  large.begin(storage.reader(), storage.writer());
+  CHECK(large.empty());
+
+  storage.data.assign(OcppMeterBuffer::storageSize(8), 0xff);
+  OcppMeterBuffer corrupt(8);
+  corrupt.begin(storage.reader(), storage.writer());
+  CHECK(corrupt.empty());
+  CHECK(0 == memcmp(storage.data.data(), OCPP_METER_BUFFER_MAGIC, 4));
+}
+
+TEST_CASE("a failed write leaves the ring unchanged") {
+  MemoryStorage storage;
+  OcppMeterBuffer buffer(4);
+  buffer.begin(storage.reader(), storage.writer());
+  REQUIRE(buffer.push(sample(1, 1)));
+
+  storage.fail_writes = true;
+  CHECK_FALSE(buffer.push(sample(2, 2)));
+  CHECK(buffer.size() == 1);
+}
+
+TEST_CASE("timestamps are formatted as UTC ISO 8601") {
+  char buf[32];
+  CHECK(OcppMeterBuffer::formatTimestamp(0, buf, sizeof(buf)) == 20);
+  CHECK(strcmp(buf, "1970-01-01T00:00:00Z") == 0);
+  OcppMeterBuffer::formatTimestamp(951782400, buf, sizeof(buf));
+  CHECK(strcmp(buf, "2000-02-29T00:00:00Z") == 0);
+  OcppMeterBuffer::formatTimestamp(1706702445, buf, sizeof(buf));
+  CHECK(strcmp(buf, "2024-01-31T12:00:45Z") == 0);
+  CHECK(OcppMeterBuffer::formatTimestamp(0, buf, 20) == 0);
+}
@@ -0,0 +1,215 @@
+// Host-side tests for the packed OTA image decoder (ota_decoder.cpp). The
+// packed vectors were produced by scripts/pack_firmware.py with
+// --window 8 --lookahead 4, from the images built by base_image()/new_image().
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "ota_decoder.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static Bytes image(const char *version, const char *extra)
+{
+  std::string text;
+  for(int i = 0; i < 4; i++) {
+    text += std::string("OpenEVSE WiFi firmware ") + version + " ";
+  }
+  Bytes out(text.begin(), text.end());
+  for(int i = 0; i < 64; i++) {
+    out.push_back((uint8_t)i);
+  }
+  out.insert(out.end(), extra, extra + strlen(extra));
+  return out;
+}
+
+static Bytes base_image() { return image("5.1.0", ""); }
+static Bytes new_image() { return image("5.1.1", "new section"); }
+
+static const uint8_t PACKED_FULL[] = {
+  0x4f, 0x45, 0x56, 0x5a, 0x01, 0x01, 0x08, 0x04, 0xbf, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0xa7, 0xdc, 0x2c, 0xb6, 0xea, 0x2d, 0x5a, 0xa7, 0x45, 0x90, 0x55, 0xed, 0x34, 0x6b, 0x4c, 0x82,
+  0xcd, 0x69, 0xb9, 0x5b, 0x6e, 0xf6, 0x1b, 0x95, 0x96, 0x41, 0x35, 0x97, 0x4c, 0x40, 0x23, 0x20,
+  0x0e, 0x78, 0x73, 0xc3, 0x9e, 0x1c, 0xf0, 0xe7, 0x87, 0x1a, 0x01, 0x01, 0x81, 0x40, 0xe0, 0x90,
+  0x58, 0x34, 0x1e, 0x11, 0x09, 0x85, 0x42, 0xe1, 0x90, 0xd8, 0x74, 0x3e, 0x21, 0x11, 0x89, 0x44,
+  0xe2, 0x91, 0x58, 0xb4, 0x5e, 0x31, 0x19, 0x8d, 0x46, 0xe3, 0x91, 0xd8, 0xf4, 0x7e, 0x41, 0x21,
+  0x91, 0x48, 0xe4, 0x92, 0x59, 0x34, 0x9e, 0x51, 0x29, 0x95, 0x4a, 0xe5, 0x92, 0xd9, 0x74, 0xbe,
+  0x61, 0x31, 0x99, 0x4c, 0xe6, 0x93, 0x59, 0xb4, 0xde, 0x71, 0x39, 0x9d, 0x4e, 0xe7, 0x93, 0xd9,
+  0xf4, 0xfe, 0xdd, 0x65, 0xbb, 0xc8, 0x2e, 0x76, 0x5b, 0x1d, 0xd2, 0xd3, 0x6f, 0xb7, 0x00
+};
+
+static const uint8_t PACKED_DELTA[] = {
+  0x4f, 0x45, 0x56, 0x5a, 0x01, 0x03, 0x08, 0x04, 0xbf, 0x00, 0x00, 0x00, 0xb4, 0x00, 0x00, 0x00,
+  0x39, 0xa0, 0x88, 0x92, 0x60, 0x10, 0x2a, 0x34, 0x2e, 0xaf, 0xb7, 0x86, 0x9e, 0xc0, 0x94, 0xc0,
+  0x2a, 0x97, 0xb0, 0xb4, 0x98, 0x86, 0xf7, 0x81, 0xef, 0xfd, 0xcc, 0xba, 0xd9, 0x87, 0x81, 0xa1,
+  0x80, 0xc6, 0xe0, 0x10, 0x28, 0x0c, 0xc6, 0x03, 0x1c, 0x8e, 0x01, 0x7e, 0x83, 0x73, 0x81, 0x42,
+  0xed, 0xd6, 0x5b, 0xbc, 0x82, 0xe7, 0x65, 0xb1, 0xdd, 0x2d, 0x36, 0xfb, 0x70
+};
+
+struct DecodeResult {
+  bool ok = false;
+  int error = 0;
+  OtaImageInfo info;
+  bool header_seen = false;
+  Bytes out;
+};
+
+// Feed `in` to the decoder `chunk` bytes at a time
+static DecodeResult decode(const uint8_t *in, size_t len, size_t chunk, const Bytes *base = nullptr)
+{
+  DecodeResult result;
+  OtaImageDecoder decoder;
+  decoder.begin(
+    [&result](const OtaImageInfo &info) {
+      result.header_seen = true;
+      result.info = info;
+      return true;
+    },
+    [&result](const uint8_t *data, size_t len) {
+      CHECK(result.header_seen);
+      result.out.insert(result.out.end(), data, data + len);
+      return true;
+    },
+    base ? OtaImageDecoder::BaseReader([base](uint32_t offset, uint8_t *data, size_t len) {
+      if(offset + len > base->size()) {
+        return false;
+      }
+      memcpy(data, base->data() + offset, len);
+      return true;
+    }) : OtaImageDecoder::BaseReader());
+
+  bool ok = true;
+  for(size_t pos = 0; ok && pos < len; pos += chunk) {
+    ok = decoder.write(in + pos, pos + chunk < len ? chunk : len - pos);
+  }
+  result.ok = ok && decoder.end();
+  result.error = decoder.error();
+  return result;
+}
+
+TEST_CASE("plain images pass straight through") {
+  Bytes plain = new_image();
+  for(size_t chunk : { (size_t)1, (size_t)3, (size_t)4096 }) {
+    DecodeResult r = decode(plain.data(), plain.size(), chunk);
+    CHECK(r.ok);
+    CHECK_FALSE(r.info.packed);
+    CHECK(r.out == plain);
+  }
+}
+
+TEST_CASE("compressed images are inflated whatever the chunking") {
+  for(size_t chunk : { (size_t)1, (size_t)7, (size_t)48, (size_t)4096 }) {
+    DecodeResult r = decode(PACKED_FULL, sizeof(PACKED_FULL), chunk);
+    CHECK(r.ok);
+    CHECK(r.info.packed);
+    CHECK(r.info.image_size == new_image().size());
+    CHECK(r.out == new_image());
+  }
+}
+
+TEST_CASE("deltas are applied against the running image") {
+  Bytes base = base_image();
+  for(size_t chunk : { (size_t)1, (size_t)5, (size_t)4096 }) {
+    DecodeResult r = decode(PACKED_DELTA, sizeof(PACKED_DELTA), chunk, &base);
+    CHECK(r.ok);
+    CHECK((r.info.flags & OTA_PACK_FLAG_DELTA) != 0);
+    CHECK(r.out == new_image());
+  }
+}
+
+TEST_CASE("deltas are refused for any other running image") {
+  Bytes other = base_image();
+  other[10] ^= 1;
+  DecodeResult r = decode(PACKED_DELTA, sizeof(PACKED_DELTA), 4096, &other);
+  CHECK_FALSE(r.ok);
+  CHECK(r.error == OTA_DECODER_ERROR_BASE_MISMATCH);
+
+  r = decode(PACKED_DELTA, sizeof(PACKED_DELTA), 4096);
+  CHECK_FALSE(r.ok);
+  CHECK(r.error == OTA_DECODER_ERROR_BASE_MISMATCH);
+  CHECK_FALSE(r.header_seen);
+  CHECK(r.out.empty());
+}
+
+TEST_CASE("the running image is hashed a step at a time") {
+  Bytes base = base_image();
+  Bytes other = base;
+  other[base.size() - 1] ^= 1;
+
+  for(const Bytes *running : { &base, &other })
+  {
+    size_t reads = 0;
+    OtaImageDecoder decoder;
+    decoder.begin(nullptr, [](const uint8_t *, size_t) { return true; },
+      [running, &reads](uint32_t offset, uint8_t *data, size_t len) {
+        reads += len;
+        memcpy(data, running->data() + offset, len);
+        return true;
+      });
+
+    // Nothing is hashed when the header arrives
+    REQUIRE(decoder.write(PACKED_DELTA, OTA_PACK_HEADER_SIZE));
+    CHECK(decoder.verifying());
+    CHECK(reads == 0);
+
+    size_t steps = 0;
+    bool ok = true;
+    while(ok && decoder.verifying()) {
+      ok = decoder.verify(64);
+      steps++;
+    }
+    CHECK(steps == (base.size() + 63) / 64);
+
+    bool matches = running == &base;
+    CHECK(ok == matches);
+    CHECK(decoder.write(PACKED_DELTA + OTA_PACK_HEADER_SIZE, sizeof(PACKED_DELTA) - OTA_PACK_HEADER_SIZE) == matches);
+    CHECK(decoder.end() == matches);
+  }
+}
+
+TEST_CASE("truncated and corrupt images are rejected") {
+  DecodeResult r = decode(PACKED_FULL, sizeof(PACKED_FULL) - 20, 64);
+  CHECK_FALSE(r.ok);
+  CHECK(r.error == OTA_DECODER_ERROR_SIZE);
+
+  r = decode(PACKED_FULL, 20, 64);
+  CHECK_FALSE(r.ok);
+  CHECK(r.error == OTA_DECODER_ERROR_HEADER);
+
+  Bytes bad(PACKED_FULL, PACKED_FULL + sizeof(PACKED_FULL));
+  bad[4] = OTA_PACK_VERSION + 1;
+  r = decode(bad.data(), bad.size(), 64);
+  CHECK_FALSE(r.ok);
+  CHECK(r.error == OTA_DECODER_ERROR_HEADER);
+
+  bad.assign(PACKED_FULL, PACKED_FULL + sizeof(PACKED_FULL));
+  bad[6] = OTA_PACK_MAX_WINDOW_SZ2 + 1;
+  r = decode(bad.data(), bad.size(), 64);
+  CHECK_FALSE(r.ok);
+  CHECK(r.error == OTA_DECODER_ERROR_HEADER);
+
+  // Claims a smaller image than the payload decodes to
+  bad.assign(PACKED_FULL, PACKED_FULL + sizeof(PACKED_FULL));
+  bad[8] = 10;
+  bad[9] = 0;
+  r = decode(bad.data(), bad.size(), 64);
+  CHECK_FALSE(r.ok);
+  CHECK(r.error == OTA_DECODER_ERROR_SIZE);
+  CHECK(r.out.size() <= 10);
+}
+
+TEST_CASE("a refused header stops decoding") {
+  OtaImageDecoder decoder;
+  size_t output = 0;
+  decoder.begin(
+    [](const OtaImageInfo &) { return false; },
+    [&output](const uint8_t *, size_t len) { output += len; return true; });
+  CHECK_FALSE(decoder.write(PACKED_FULL, sizeof(PACKED_FULL)));
+  CHECK(decoder.error() == OTA_DECODER_ERROR_REJECTED);
+  CHECK(0 == output);
+}
@@ -0,0 +1,60 @@
+// Host-side tests for the optional whole-image SHA-256 check in
+// ota_signing.cpp (unsigned build), fed by the streaming OTA writer.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <string.h>
+
+#include "ota_signing.h"
+#include "crypto/sha256.h"
+
+static void digest_of(const char *text, uint8_t out[32])
+{
+  oevse_sha256_ctx ctx;
+  oevse_sha256_init(&ctx);
+  oevse_sha256_update(&ctx, (const uint8_t *)text, strlen(text));
+  oevse_sha256_final(&ctx, out);
+}
+
+// sha256("abc")
+static const char *ABC_HEX = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+
+TEST_CASE("no expectation accepts any image") {
+  uint8_t digest[32];
+  digest_of("abc", digest);
+  CHECK(ota_expect_sha256(NULL));
+  CHECK_FALSE(ota_sha256_expected());
+  CHECK(ota_check_sha256(digest));
+  CHECK(ota_expect_sha256(""));
+  CHECK_FALSE(ota_sha256_expected());
+}
+
+TEST_CASE("matching digest is accepted, in either case") {
+  uint8_t digest[32];
+  digest_of("abc", digest);
+  CHECK(ota_expect_sha256(ABC_HEX));
+  CHECK(ota_sha256_expected());
+  CHECK(ota_check_sha256(digest));
+
+  CHECK(ota_expect_sha256("BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD"));
+  CHECK(ota_check_sha256(digest));
+}
+
+TEST_CASE("mismatched digest is rejected and the expectation consumed") {
+  uint8_t digest[32];
+  digest_of("abd", digest);
+  CHECK(ota_expect_sha256(ABC_HEX));
+  CHECK_FALSE(ota_check_sha256(digest));
+  CHECK_FALSE(ota_sha256_expected());
+  // Next update is not held to the old digest
+  CHECK(ota_check_sha256(digest));
+}
+
+TEST_CASE("malformed digests are refused") {
+  CHECK_FALSE(ota_expect_sha256("ba7816bf"));
+  CHECK_FALSE(ota_sha256_expected());
+  CHECK_FALSE(ota_expect_sha256("zz7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+  CHECK_FALSE(ota_sha256_expected());
+  CHECK_FALSE(ota_expect_sha256("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad00"));
+  CHECK_FALSE(ota_sha256_expected());
+}
@@ -0,0 +1,94 @@
+// Host-side tests for the per-phase load headroom (phase_load.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include "phase_load.h"
+
+TEST_CASE("the most loaded phase sets the headroom") {
+  PhaseLoad load;
+  load.setCurrent(0, 8, 0);
+  load.setCurrent(1, 21, 0);
+  load.setCurrent(2, 12, 0);
+
+  uint8_t limiting = 99;
+  // 25 A fuses, EVSE on all three drawing 6 A
+  CHECK(load.available(25, 6, PhaseLoad::phaseMask(true, 1), &limiting) == doctest::Approx(10));
+  CHECK(limiting == 1);
+
+  // The same load in aggregate would suggest 23 A
+  CHECK((75 - load.total()) / 3 + 6 == doctest::Approx(17.333).epsilon(0.001));
+}
+
+TEST_CASE("a single-phase EVSE only looks at its own phase") {
+  PhaseLoad load;
+  load.setCurrent(0, 8, 0);
+  load.setCurrent(1, 21, 0);
+  load.setCurrent(2, 12, 0);
+
+  uint8_t limiting = 99;
+  CHECK(load.available(25, 0, PhaseLoad::phaseMask(false, 3), &limiting) == doctest::Approx(13));
+  CHECK(limiting == 2);
+
+  CHECK(PhaseLoad::phaseMask(false, 1) == 0x1);
+  CHECK(PhaseLoad::phaseMask(false, 2) == 0x2);
+  CHECK(PhaseLoad::phaseMask(false, 0) == 0x1);
+  CHECK(PhaseLoad::phaseMask(true, 2) == 0x7);
+}
+
+TEST_CASE("with no limit the least exporting phase sets what divert can use") {
+  PhaseLoad load;
+  // Exporting on every phase, least on L3, with the EVSE drawing 6 A
+  load.setPower(0, -2300, 230, 0);
+  load.setPower(1, -1840, 230, 0);
+  load.setPower(2, -460, 230, 0);
+
+  uint8_t limiting = 99;
+  CHECK(load.available(0, 6, PhaseLoad::phaseMask(true, 1), &limiting) == doctest::Approx(8));
+  CHECK(limiting == 2);
+  CHECK(load.total() == doctest::Approx(-20));
+}
+
+TEST_CASE("readings age out per phase") {
+  PhaseLoad load;
+  CHECK_FALSE(load.valid(0, 1000));
+  CHECK_FALSE(load.active(0, 1000));
+
+  load.setCurrent(0, 1, 100);
+  load.setCurrent(1, 1, 200);
+  CHECK_FALSE(load.valid(300, 1000));
+  CHECK(load.active(300, 1000));
+
+  load.setCurrent(2, 1, 300);
+  CHECK(load.valid(1100, 1000));
+  CHECK_FALSE(load.valid(1101, 1000));
+  CHECK(load.active(1101, 1000));
+  CHECK_FALSE(load.active(1301, 1000));
+
+  // Out of range phases and voltages are ignored
+  load.setCurrent(3, 50, 1400);
+  load.setPower(0, 1000, 0, 1400);
+  CHECK(load.current(0) == doctest::Approx(1));
+
+  load.clear();
+  CHECK_FALSE(load.active(1400, 1000));
+}
+
+TEST_CASE("a reading is complete once every phase is in") {
+  PhaseLoad load;
+  CHECK_FALSE(load.complete());
+
+  load.setCurrent(0, 1, 0);
+  load.setCurrent(2, 1, 0);
+  CHECK(load.updated(0));
+  CHECK_FALSE(load.updated(1));
+  CHECK_FALSE(load.complete());
+
+  load.setCurrent(1, 1, 0);
+  CHECK(load.complete());
+
+  load.takeReading();
+  CHECK_FALSE(load.complete());
+  CHECK_FALSE(load.updated(0));
+  CHECK(load.valid(0, 1000));                 // the values themselves are kept
+  CHECK_FALSE(load.updated(3));
+}
@@ -0,0 +1,126 @@
+// Host-side tests for the publish snapshot ring (publish_ring.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "publish_ring.h"
+
+static void push(PublishRing &ring, int value)
+{
+  int len = snprintf(ring.slot(), PUBLISH_RING_SLOT_SIZE, "{\"amp\":%d}", value);
+  REQUIRE(ring.commit(len));
+}
+
+static std::string read(PublishRing &ring, PublishCursor &cursor, uint32_t now)
+{
+  size_t len = 0;
+  const char *json = ring.next(cursor, now, len);
+  if(nullptr == json) {
+    return "";
+  }
+  std::string value(json, len);
+  ring.consumed(cursor, now);
+  return value;
+}
+
+TEST_CASE("each sink reads every snapshot at its own pace") {
+  static PublishRing ring;
+  PublishCursor ws;
+  PublishCursor mqtt;
+
+  push(ring, 1);
+  push(ring, 2);
+
+  CHECK(read(ring, ws, 0) == "{\"amp\":1}");
+  CHECK(read(ring, ws, 0) == "{\"amp\":2}");
+  CHECK(read(ring, ws, 0) == "");
+
+  CHECK(read(ring, mqtt, 0) == "{\"amp\":1}");
+  push(ring, 3);
+  CHECK(read(ring, mqtt, 0) == "{\"amp\":2}");
+  CHECK(read(ring, mqtt, 0) == "{\"amp\":3}");
+
+  CHECK(ws.sent == 2);
+  CHECK(mqtt.sent == 3);
+  CHECK(ws.dropped == 0);
+  CHECK(mqtt.dropped == 0);
+}
+
+TEST_CASE("a sink that falls behind loses the oldest snapshots") {
+  static PublishRing ring;
+  PublishCursor slow;
+
+  for(int i = 0; i < PUBLISH_RING_SLOTS + 3; i++) {
+    push(ring, i);
+  }
+
+  char expected[32];
+  snprintf(expected, sizeof(expected), "{\"amp\":%d}", 3);
+  CHECK(read(ring, slow, 0) == expected);
+  CHECK(slow.dropped == 3);
+  CHECK(slow.sent == 1);
+}
+
+TEST_CASE("a sink with an interval takes the latest once it is due") {
+  static PublishRing ring;
+  PublishCursor mqtt(30000);
+
+  push(ring, 1);
+  CHECK(read(ring, mqtt, 1000) == "{\"amp\":1}");
+
+  push(ring, 2);
+  push(ring, 3);
+  CHECK(read(ring, mqtt, 20000) == "");
+  CHECK(read(ring, mqtt, 31000) == "{\"amp\":3}");
+  CHECK(mqtt.skipped == 1);
+  CHECK(mqtt.dropped == 0);
+
+  // Nothing new, nothing sent even though due
+  CHECK(read(ring, mqtt, 90000) == "");
+}
+
+TEST_CASE("a sink that can not take anything drops what is waiting") {
+  static PublishRing ring;
+  PublishCursor mqtt;
+
+  push(ring, 1);
+  push(ring, 2);
+  ring.discard(mqtt);
+  CHECK(mqtt.dropped == 2);
+  CHECK(read(ring, mqtt, 0) == "");
+
+  push(ring, 3);
+  CHECK(read(ring, mqtt, 0) == "{\"amp\":3}");
+}
+
+TEST_CASE("a sink that is turned off passes over what is waiting uncounted") {
+  static PublishRing ring;
+  PublishCursor mqtt;
+
+  for(int i = 1; i <= PUBLISH_RING_SLOTS + 2; i++) {
+    push(ring, i);
+  }
+  ring.ignore(mqtt);
+  CHECK(mqtt.dropped == 0);
+  CHECK(mqtt.skipped == 0);
+  CHECK(read(ring, mqtt, 0) == "");
+
+  push(ring, 99);
+  CHECK(read(ring, mqtt, 0) == "{\"amp\":99}");
+  CHECK(mqtt.dropped == 0);
+}
+
+TEST_CASE("snapshots that do not fit are not published") {
+  static PublishRing ring;
+  PublishCursor ws;
+
+  memset(ring.slot(), 'x', PUBLISH_RING_SLOT_SIZE);
+  CHECK_FALSE(ring.commit(PUBLISH_RING_SLOT_SIZE));
+  CHECK_FALSE(ring.commit(0));
+  CHECK(ring.oversize() == 2);
+  CHECK(ring.head() == 0);
+  CHECK(read(ring, ws, 0) == "");
+}
@@ -0,0 +1,124 @@
+// Host-side tests for the single producer/consumer queue (spsc_queue.h).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <thread>
+
+#include "spsc_queue.h"
+
+TEST_CASE("items come out in the order they went in") {
+  SpscQueue<int, 4> queue;
+  int item = 0;
+
+  CHECK(queue.empty());
+  CHECK_FALSE(queue.pop(item));
+
+  CHECK(queue.push(1));
+  CHECK(queue.push(2));
+  CHECK(queue.size() == 2);
+
+  CHECK(queue.pop(item));
+  CHECK(item == 1);
+  CHECK(queue.pop(item));
+  CHECK(item == 2);
+  CHECK(queue.empty());
+}
+
+TEST_CASE("a full queue drops and counts new items") {
+  SpscQueue<int, 4> queue;
+  CHECK(queue.capacity() == 3);
+
+  CHECK(queue.push(1));
+  CHECK(queue.push(2));
+  CHECK(queue.push(3));
+  CHECK_FALSE(queue.push(4));
+  CHECK(queue.dropped() == 1);
+  CHECK(queue.size() == 3);
+
+  int item = 0;
+  CHECK(queue.pop(item));
+  CHECK(item == 1);
+  CHECK(queue.push(5));
+
+  CHECK(queue.pop(item));
+  CHECK(item == 2);
+  CHECK(queue.pop(item));
+  CHECK(item == 3);
+  CHECK(queue.pop(item));
+  CHECK(item == 5);
+  CHECK_FALSE(queue.pop(item));
+}
+
+TEST_CASE("indexes wrap around") {
+  SpscQueue<int, 3> queue;
+  int item = 0;
+
+  for(int i = 0; i < 10; i++)
+  {
+    CHECK(queue.push(i));
+    CHECK(queue.size() == 1);
+    CHECK(queue.pop(item));
+    CHECK(item == i);
+  }
+  CHECK(queue.empty());
+}
+
+TEST_CASE("slots can be filled and read in place") {
+  struct Slot { int len; char text[8]; };
+  SpscQueue<Slot, 3> queue;
+
+  Slot *slot = queue.back();
+  REQUIRE(slot != nullptr);
+  slot->len = 2;
+  CHECK(queue.empty());                       // not queued until committed
+  queue.commit();
+
+  slot = queue.back();
+  REQUIRE(slot != nullptr);
+  slot->len = 5;
+  queue.commit();
+  CHECK(queue.back() == nullptr);
+  CHECK(queue.dropped() == 1);
+
+  Slot *item = queue.front();
+  REQUIRE(item != nullptr);
+  CHECK(item->len == 2);
+  CHECK(queue.front() == item);               // still there until released
+  queue.release();
+
+  item = queue.front();
+  REQUIRE(item != nullptr);
+  CHECK(item->len == 5);
+  queue.release();
+  CHECK(queue.front() == nullptr);
+}
+
+TEST_CASE("a producer and consumer thread see every item once, in order") {
+  static SpscQueue<unsigned, 16> queue;
+  const unsigned count = 100000;
+
+  std::thread producer([&]() {
+    for(unsigned i = 0; i < count; i++) {
+      while(!queue.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  unsigned expected = 0;
+  bool in_order = true;
+  while(expected < count)
+  {
+    unsigned item;
+    if(queue.pop(item)) {
+      in_order = in_order && item == expected;
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  CHECK(in_order);
+  CHECK(queue.empty());
+}
@@ -0,0 +1,140 @@
+// Host-side tests for the /status snapshot cache (status_cache.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <string.h>
+#include <string>
+
+#include "status_cache.h"
+
+static void update(StatusCache &cache, const char *json, uint32_t now)
+{
+  std::string s(json);
+  cache.update(s, now);
+}
+
+static std::string etag(const StatusCache &cache)
+{
+  char tag[STATUS_ETAG_SIZE];
+  cache.etag(tag);
+  return tag;
+}
+
+static std::string etag(const StatusCache &cache, const char *body)
+{
+  char tag[STATUS_ETAG_SIZE];
+  cache.etag(tag, std::string(body));
+  return tag;
+}
+
+TEST_CASE("snapshot is reused until invalidated or too old") {
+  StatusCache cache;
+  CHECK_FALSE(cache.valid(0));
+
+  update(cache, "{\"amp\":0}", 1000);
+  CHECK(cache.json() == "{\"amp\":0}");
+  CHECK(cache.valid(1000));
+  CHECK(cache.valid(1000 + STATUS_CACHE_MAX_AGE - 1));
+  CHECK_FALSE(cache.valid(1000 + STATUS_CACHE_MAX_AGE));
+
+  update(cache, "{\"amp\":0}", 2000);
+  CHECK(cache.valid(2001));
+  cache.invalidate();
+  CHECK_FALSE(cache.valid(2001));
+
+  update(cache, "{\"amp\":1}", 2002);
+  CHECK(cache.valid(2003));
+  CHECK(cache.rebuilds() == 3);
+}
+
+TEST_CASE("age survives millis() wrapping") {
+  StatusCache cache;
+  update(cache, "{}", 0xffffff00u);
+  CHECK(cache.valid(0xffffff00u + 10));
+  CHECK(cache.valid(10));
+  CHECK_FALSE(cache.valid(STATUS_CACHE_MAX_AGE));
+}
+
+TEST_CASE("entity tag follows the content") {
+  StatusCache cache;
+  update(cache, "{\"amp\":0}", 0);
+  std::string first = etag(cache);
+  CHECK(first.size() == 10);                  // strong, nothing is left out
+  CHECK(first.front() == '"');
+  CHECK(first.back() == '"');
+
+  // Rebuilt with the same values: same tag
+  cache.invalidate();
+  update(cache, "{\"amp\":0}", 10);
+  CHECK(etag(cache) == first);
+
+  update(cache, "{\"amp\":6}", 20);
+  CHECK(etag(cache) != first);
+
+  // Other bodies are tagged by what they hold
+  CHECK(etag(cache, "{\"amp\":6}") == etag(cache));
+  CHECK(etag(cache, "{\"state\":1}") != etag(cache));
+}
+
+TEST_CASE("entity tag ignores the volatile keys") {
+  static const char *const keys[] = { "time", "free_heap", nullptr };
+  StatusCache cache(keys);
+
+  update(cache, "{\"amp\":0,\"time\":\"2024-01-01T00:00:00Z\",\"free_heap\":1000,\"state\":1}", 0);
+  std::string first = etag(cache);
+  CHECK(first.size() == STATUS_ETAG_SIZE - 1);
+  CHECK(first.compare(0, 3, "W/\"") == 0);     // weak, the body can differ
+
+  update(cache, "{\"amp\":0,\"time\":\"2024-01-01T00:00:01Z\",\"free_heap\":992,\"state\":1}", 10);
+  CHECK(etag(cache) == first);
+
+  // Last member volatile, nested values and strings that look like keys
+  update(cache, "{\"amp\":0,\"shaper\":{\"time\":1,\"a\":[1,{\"b\":\"},\\\"\"}]},\"time\":\"x\"}", 20);
+  std::string nested = etag(cache);
+  update(cache, "{\"amp\":0,\"shaper\":{\"time\":1,\"a\":[1,{\"b\":\"},\\\"\"}]},\"time\":\"y\"}", 30);
+  CHECK(etag(cache) == nested);
+  update(cache, "{\"amp\":0,\"shaper\":{\"time\":2,\"a\":[1,{\"b\":\"},\\\"\"}]},\"time\":\"y\"}", 40);
+  CHECK(etag(cache) != nested);
+
+  update(cache, "{\"amp\":6,\"time\":\"2024-01-01T00:00:01Z\",\"free_heap\":992,\"state\":1}", 50);
+  CHECK(etag(cache) != first);
+
+  // A projection is tagged by its own members
+  std::string projected = etag(cache, "{\"amp\":6,\"time\":\"a\"}");
+  CHECK(etag(cache, "{\"amp\":6,\"time\":\"b\"}") == projected);
+  CHECK(etag(cache, "{\"amp\":7,\"time\":\"b\"}") != projected);
+  CHECK(etag(cache, "{\"amp\":6}") != etag(cache));
+
+  // Keys are matched whole
+  update(cache, "{\"times\":1}", 60);
+  std::string times = etag(cache);
+  update(cache, "{\"times\":2}", 70);
+  CHECK(etag(cache) != times);
+
+  // Anything but an object is hashed as it is
+  update(cache, "[1]", 80);
+  std::string array = etag(cache);
+  update(cache, "[2]", 90);
+  CHECK(etag(cache) != array);
+}
+
+TEST_CASE("If-None-Match parsing") {
+  const char *tag = "\"0badf00d\"";
+  CHECK(StatusCache::etagMatches("\"0badf00d\"", tag));
+  CHECK(StatusCache::etagMatches("W/\"0badf00d\"", tag));
+  CHECK(StatusCache::etagMatches("\"12345678\", \"0badf00d\"", tag));
+  CHECK(StatusCache::etagMatches("\"12345678\",W/\"0badf00d\" ", tag));
+  CHECK(StatusCache::etagMatches("*", tag));
+
+  const char *weak = "W/\"0badf00d\"";
+  CHECK(StatusCache::etagMatches("W/\"0badf00d\"", weak));
+  CHECK(StatusCache::etagMatches("\"0badf00d\"", weak));
+  CHECK_FALSE(StatusCache::etagMatches("W/\"12345678\"", weak));
+
+  CHECK_FALSE(StatusCache::etagMatches("", tag));
+  CHECK_FALSE(StatusCache::etagMatches(nullptr, tag));
+  CHECK_FALSE(StatusCache::etagMatches("\"12345678\"", tag));
+  CHECK_FALSE(StatusCache::etagMatches("0badf00d", tag));
+  CHECK_FALSE(StatusCache::etagMatches("\"0badf00d", tag));
+  CHECK_FALSE(StatusCache::etagMatches("\"0badf00d\"x", tag));
+}
@@ -0,0 +1,126 @@
+// Host-side tests for the main loop run time statistics (task_profiler.cpp).
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <stdio.h>
+#include <string>
+
+#include "task_profiler.h"
+
+TEST_CASE("run times are bucketed by powers of two") {
+  CHECK(TaskProfiler::bucket(0) == 0);
+  CHECK(TaskProfiler::bucket(7) == 0);
+  CHECK(TaskProfiler::bucket(8) == 1);
+  CHECK(TaskProfiler::bucket(15) == 1);
+  CHECK(TaskProfiler::bucket(16) == 2);
+  CHECK(TaskProfiler::bucket(1000) == 7);
+  CHECK(TaskProfiler::bucket(UINT32_MAX) == PROFILE_BUCKETS - 1);
+
+  CHECK(TaskProfiler::bucketStart(0) == 0);
+  CHECK(TaskProfiler::bucketStart(1) == 8);
+  CHECK(TaskProfiler::bucketStart(7) == 512);
+  for(uint8_t b = 1; b < PROFILE_BUCKETS; b++) {
+    CHECK(TaskProfiler::bucket(TaskProfiler::bucketStart(b)) == b);
+    CHECK(TaskProfiler::bucket(TaskProfiler::bucketStart(b) - 1) == b - 1);
+  }
+}
+
+TEST_CASE("calls are counted per section") {
+  TaskProfiler p;
+  ProfileEntry *poll = p.entry("Mongoose.poll");
+  REQUIRE(poll != nullptr);
+
+  TaskProfiler::record(poll, 100);
+  TaskProfiler::record(poll, 3000);
+  p.record("EvseManager", 10);
+
+  CHECK(p.count() == 2);
+  CHECK(poll->count == 2);
+  CHECK(poll->total_us == 3100);
+  CHECK(poll->max_us == 3000);
+  CHECK(poll->histogram[TaskProfiler::bucket(100)] == 1);
+  CHECK(poll->histogram[TaskProfiler::bucket(3000)] == 1);
+  CHECK(p.get(1)->count == 1);
+}
+
+TEST_CASE("sections are found by name as well as by pointer") {
+  TaskProfiler p;
+  std::string a = "/status$";
+  std::string b = "/status$";
+
+  ProfileEntry *entry = p.entry(a.c_str());
+  CHECK(p.entry(a.c_str()) == entry);
+  CHECK(p.entry(b.c_str()) == entry);
+  CHECK(p.count() == 1);
+}
+
+TEST_CASE("reset clears the statistics but keeps the sections") {
+  TaskProfiler p;
+  ProfileEntry *entry = p.entry("Divert");
+  TaskProfiler::record(entry, 50);
+
+  p.reset(1234);
+  CHECK(p.since() == 1234);
+  CHECK(p.count() == 1);
+  CHECK(entry->count == 0);
+  CHECK(entry->total_us == 0);
+  CHECK(entry->max_us == 0);
+  CHECK(entry->histogram[TaskProfiler::bucket(50)] == 0);
+}
+
+TEST_CASE("new sections are ignored once the table is full") {
+  TaskProfiler p;
+  static char names[PROFILE_MAX_ENTRIES + 1][8];
+  for(int i = 0; i <= PROFILE_MAX_ENTRIES; i++) {
+    snprintf(names[i], sizeof(names[i]), "t%d", i);
+  }
+
+  for(int i = 0; i < PROFILE_MAX_ENTRIES; i++) {
+    CHECK(p.entry(names[i]) != nullptr);
+  }
+  CHECK(p.entry(names[PROFILE_MAX_ENTRIES]) == nullptr);
+
+  // Recording against a missing section is harmless
+  p.record(names[PROFILE_MAX_ENTRIES], 10);
+  CHECK(p.count() == PROFILE_MAX_ENTRIES);
+}
+
+TEST_CASE("heap use is counted against the innermost running section") {
+  TaskProfiler p;
+  ProfileEntry *poll = p.entry("Mongoose.poll");
+  ProfileEntry *status = p.entry("/status$");
+
+  // Nothing running
+  TaskProfiler::recordAlloc(100);
+
+  ProfileEntry *outer = TaskProfiler::enter(poll);
+  CHECK(outer == nullptr);
+  TaskProfiler::recordAlloc(64);
+
+  ProfileEntry *inner = TaskProfiler::enter(status);
+  CHECK(inner == poll);
+  TaskProfiler::recordAlloc(4096);
+  TaskProfiler::recordFree(4096);
+  TaskProfiler::leave(inner);
+
+  TaskProfiler::recordFree(64);
+  TaskProfiler::leave(outer);
+  CHECK(TaskProfiler::current() == nullptr);
+
+  CHECK(poll->allocs == 1);
+  CHECK(poll->alloc_bytes == 64);
+  CHECK(poll->frees == 1);
+  CHECK(poll->free_bytes == 64);
+  CHECK(status->allocs == 1);
+  CHECK(status->alloc_bytes == 4096);
+  CHECK(status->free_bytes == 4096);
+
+  // The heap and run time statistics are cleared separately
+  TaskProfiler::record(status, 10);
+  p.resetHeap(500);
+  CHECK(p.heapSince() == 500);
+  CHECK(status->allocs == 0);
+  CHECK(status->count == 1);
+  p.reset(600);
+  CHECK(status->count == 0);
+}
@@ -0,0 +1,74 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "tsdb_rollup.h"
+#include "tsdb_sample.h"
+
+static void raw_row(int16_t *v, int16_t amps, int16_t power, int16_t energy, int16_t temp) {
+  for (int i = 0; i < TSDB_NUM_COLS; i++) v[i] = 0;
+  v[TSDB_COL_AMPS]   = amps;
+  v[TSDB_COL_POWER]  = power;
+  v[TSDB_COL_ENERGY] = energy;
+  v[TSDB_COL_TEMP]   = temp;
+  v[TSDB_COL_SOC]    = -1;
+}
+
+TEST_CASE("period aggregates energy, temps and charging") {
+  RollupPeriod p; p.begin(3600);
+  int16_t v[TSDB_NUM_COLS];
+  raw_row(v, 0, 0, 0, 210);    p.add(v, 300);   // idle, no charge time
+  raw_row(v, 320, 768, 128, 250); p.add(v, 60);
+  raw_row(v, 160, 384, 64, 240);  p.add(v, 60);
+  CHECK(p.samples == 3);
+  CHECK(p.energy == 192);
+  CHECK(p.temp_max == 250);
+  CHECK(p.temp_min == 210);
+  CHECK(p.powerAvg() == 576);
+  CHECK(p.chargeMinutes() == 2);
+}
+
+TEST_CASE("row round-trips, energy beyond int16") {
+  RollupPeriod p; p.begin(86400);
+  p.energy = 70000;     // 70 kWh in a day
+  p.temp_max = 350; p.temp_min = -50;
+  p.samples = 1440;
+  p.power_sum = 2200 * 10; p.power_samples = 10;
+  p.charge_secs = 600 * 60;
+
+  int16_t row[ROLLUP_NUM_COLS];
+  p.toRow(row);
+  RollupPeriod q; q.fromRow(86400, row);
+  CHECK(q.start == 86400);
+  CHECK(q.energy == 70000);
+  CHECK(q.temp_max == 350);
+  CHECK(q.temp_min == -50);
+  CHECK(q.samples == 1440);
+  CHECK(q.powerAvg() == 2200);
+  CHECK(q.chargeMinutes() == 600);
+}
+
+TEST_CASE("series closes a period when the next one starts") {
+  RollupSeries s(60);
+  int16_t v[TSDB_NUM_COLS];
+  raw_row(v, 320, 768, 100, 250);
+
+  CHECK_FALSE(s.add(0, 10, v));
+  CHECK_FALSE(s.add(0, 70, v));
+  CHECK_FALSE(s.add(0, 3590, v));     // gap capped at 60s
+  CHECK(s.current().charge_secs == 120);
+
+  CHECK(s.add(3600, 3650, v));
+  CHECK(s.completed().start == 0);
+  CHECK(s.completed().energy == 300);
+  CHECK(s.completed().samples == 3);
+  CHECK(s.current().start == 3600);
+  CHECK(s.current().samples == 1);
+  CHECK(s.current().charge_secs == 60);
+
+  // An hour with no samples is skipped, nothing is closed twice
+  CHECK(s.add(3 * 3600, 3 * 3600 + 5, v));
+  CHECK(s.completed().start == 3600);
+
+  s.reset();
+  CHECK_FALSE(s.add(4 * 3600, 4 * 3600, v));
+  CHECK(s.current().charge_secs == 0);
+}
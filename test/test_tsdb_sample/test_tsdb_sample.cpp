@@ -36,3 +36,17 @@ TEST_CASE("param names match column count and order") {
   CHECK(std::string(TSDB_PARAM_NAMES[TSDB_COL_AMPS])  == "amps");
   CHECK(std::string(TSDB_PARAM_NAMES[TSDB_COL_PILOT]) == "pilot");
 }
+
+TEST_CASE("raw sample JSON") {
+  EnergySample s; s.amps=16.0; s.volts=230; s.power_w=3680; s.energy_wh_delta=61;
+  s.temp_c=21.5; s.soc=55; s.pilot_a=16;
+  int16_t v[TSDB_NUM_COLS]; tsdb_scale_sample(s, v);
+  char buf[192];
+  tsdb_sample_json(buf, sizeof(buf), 1700000000, v, true);
+  CHECK(std::string(buf) == "{\"ts\":1700000000,\"a\":16.00,\"t\":21.5,\"e\":61.00,\"s\":55"
+                            ",\"v\":230.0,\"p\":3680.0,\"pilot\":16.0}");
+  s.soc = -1; tsdb_scale_sample(s, v);
+  tsdb_sample_json(buf, sizeof(buf), 1700000060, v, false);
+  CHECK(std::string(buf).rfind(",{\"ts\":1700000060,", 0) == 0);
+  CHECK(std::string(buf).find("\"s\":-1,") != std::string::npos);
+}
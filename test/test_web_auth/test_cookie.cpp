@@ -15,3 +15,12 @@ TEST_CASE("cookie_extract finds the named value") {
   // must not match a suffix/substring key
   CHECK(cookie_extract("not_oevse_session=nope", "oevse_session") == "");
 }
+TEST_CASE("cookie_find returns a span into the header without copying") {
+  std::string hdr = "a=1; oevse_session=xyz; b=2";
+  AuthSpan v = cookie_find(AuthSpan(hdr), AuthSpan(std::string("oevse_session")));
+  CHECK(v.len == 3);
+  CHECK(v.data == hdr.data() + hdr.find("xyz"));
+  CHECK(cookie_find(AuthSpan(hdr), AuthSpan(std::string("missing"))).empty());
+  // header need not be NUL-terminated: the span stops at len
+  CHECK(std::string(cookie_find(AuthSpan(hdr.data(), 3), AuthSpan(std::string("a"))).data, 1) == "1");
+}
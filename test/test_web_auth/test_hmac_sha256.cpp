@@ -10,3 +10,16 @@ TEST_CASE("HMAC-SHA256 RFC 4231 test case 2") {
 TEST_CASE("HMAC-SHA256 differs on key change") {
   CHECK(hmac_sha256_hex("k1", "msg") != hmac_sha256_hex("k2", "msg"));
 }
+
+TEST_CASE("HMAC-SHA256 cached key schedule matches the one-shot MAC") {
+  const std::string key = "0011223344556677889900aabbccddee";
+  const std::string msg = "v1.0000abcd";
+  uint8_t once[32], cached[32];
+  hmac_sha256((const uint8_t*)key.data(), key.size(), (const uint8_t*)msg.data(), msg.size(), once);
+  HmacSha256Key schedule;
+  hmac_sha256_key_init(schedule, (const uint8_t*)key.data(), key.size());
+  // the schedule is reusable: a second MAC from the same midstates still matches
+  hmac_sha256_with_key(schedule, (const uint8_t*)msg.data(), msg.size(), cached);
+  hmac_sha256_with_key(schedule, (const uint8_t*)msg.data(), msg.size(), cached);
+  CHECK(std::string((char*)once, 32) == std::string((char*)cached, 32));
+}
@@ -30,3 +30,41 @@ TEST_CASE("garbage is rejected, not crashed") {
   CHECK(session_token_verify(SECRET, "", 1000) == false);
   CHECK(session_token_verify(SECRET, "v1.zzzz", 1000) == false);
 }
+
+TEST_CASE("verifier: minted token verifies and is then served from the cache") {
+  SessionVerifier v;
+  v.setSecret(SECRET.data(), SECRET.size());
+  std::string t = v.mint(2000);
+  CHECK(t == session_token_mint(SECRET, 2000));
+  CHECK(v.verify(AuthSpan(t), 1000));
+  CHECK(v.cacheMisses() == 1);
+  CHECK(v.verify(AuthSpan(t), 1001));
+  CHECK(v.cacheHits() == 1);
+}
+TEST_CASE("verifier: a cached token still expires") {
+  SessionVerifier v;
+  v.setSecret(SECRET.data(), SECRET.size());
+  std::string t = v.mint(2000);
+  CHECK(v.verify(AuthSpan(t), 1000));
+  CHECK_FALSE(v.verify(AuthSpan(t), 2000));
+}
+TEST_CASE("verifier: changing the secret drops cached tokens") {
+  SessionVerifier v;
+  v.setSecret(SECRET.data(), SECRET.size());
+  std::string t = v.mint(2000);
+  CHECK(v.verify(AuthSpan(t), 1000));
+  std::string other = "deadbeef";
+  v.setSecret(other.data(), other.size());
+  CHECK_FALSE(v.verify(AuthSpan(t), 1000));
+  v.invalidate();
+  CHECK_FALSE(v.hasSecret());
+  CHECK_FALSE(v.verify(AuthSpan(t), 1000));
+}
+TEST_CASE("verifier: tampered token is not matched against the cache") {
+  SessionVerifier v;
+  v.setSecret(SECRET.data(), SECRET.size());
+  std::string t = v.mint(2000);
+  CHECK(v.verify(AuthSpan(t), 1000));
+  t[t.size()-1] = (t[t.size()-1] == 'a') ? 'b' : 'a';
+  CHECK_FALSE(v.verify(AuthSpan(t), 1000));
+}